@@ -0,0 +1,72 @@
+/**
+ * alloc_count.c - malloc family interposer shared by the benchmarks
+ *
+ * Counts malloc/calloc/realloc calls (and requested bytes). Linked into
+ * bench_hot_paths, which reads the totals through bench_alloc_count() and
+ * bench_alloc_bytes(), and built as alloc_preload.so for bench_replay to
+ * LD_PRELOAD into an unmodified claude-c process. At exit the totals are
+ * written to the file named by BENCH_ALLOC_REPORT (if set) as
+ * "<allocs> <bytes>". glibc only; elsewhere the counters stay 0.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned long g_alloc_count = 0;
+static unsigned long g_alloc_bytes = 0;
+
+#ifdef __GLIBC__
+// glibc exports its allocator under these names so programs can interpose
+// malloc and still reach the real implementation. Counting here covers
+// allocations made inside shared libraries (cJSON, libc) as well.
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static void count_alloc(size_t size) {
+    __atomic_fetch_add(&g_alloc_count, 1UL, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_alloc_bytes, (unsigned long)size, __ATOMIC_RELAXED);
+}
+
+void *malloc(size_t size) {
+    count_alloc(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    count_alloc(nmemb * size);
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    count_alloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    __libc_free(ptr);
+}
+#endif
+
+unsigned long bench_alloc_count(void) {
+    return __atomic_load_n(&g_alloc_count, __ATOMIC_RELAXED);
+}
+
+unsigned long bench_alloc_bytes(void) {
+    return __atomic_load_n(&g_alloc_bytes, __ATOMIC_RELAXED);
+}
+
+__attribute__((destructor))
+static void write_alloc_report(void) {
+    const char *path = getenv("BENCH_ALLOC_REPORT");
+    if (!path || !*path) {
+        return;
+    }
+    FILE *f = fopen(path, "w");
+    if (f) {
+        fprintf(f, "%lu %lu\n", bench_alloc_count(), bench_alloc_bytes());
+        fclose(f);
+    }
+}
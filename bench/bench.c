@@ -0,0 +1,168 @@
+/**
+ * bench.c - Micro-benchmark harness implementation
+ */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_MAX_RESULTS 128
+
+typedef struct {
+    char name[96];
+    long iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+} BenchResult;
+
+static BenchResult g_results[BENCH_MAX_RESULTS];
+static int g_result_count = 0;
+static const char *g_json_path = NULL;
+static const char *g_filter = NULL;
+static long g_target_ns = 200L * 1000000L;
+static int g_repeat = 5;
+static const void *volatile g_sink;
+
+// ============================================================================
+// Harness
+// ============================================================================
+
+void bench_sink(const void *ptr) {
+    g_sink = ptr;
+}
+
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+void bench_init(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            g_json_path = argv[++i];
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            g_filter = argv[++i];
+        }
+    }
+
+    const char *time_env = getenv("BENCH_TIME_MS");
+    if (time_env && atol(time_env) > 0) {
+        g_target_ns = atol(time_env) * 1000000L;
+    }
+    const char *count_env = getenv("BENCH_COUNT");
+    if (count_env && atoi(count_env) > 0) {
+        g_repeat = atoi(count_env);
+    }
+
+    printf("%-48s %12s %14s %12s %14s\n", "benchmark", "iterations", "ns/op", "allocs/op", "bytes/op");
+}
+
+static int compare_double(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+void bench_run(const char *name, BenchFn fn, void *ctx) {
+    if (g_filter && !strstr(name, g_filter)) {
+        return;
+    }
+    if (g_result_count >= BENCH_MAX_RESULTS) {
+        fprintf(stderr, "bench: too many benchmarks, skipping %s\n", name);
+        return;
+    }
+
+    // Warm up caches and lazily-initialized state
+    fn(ctx, 1);
+
+    // Grow the iteration count until one run reaches the target time
+    long iterations = 1;
+    long elapsed = 0;
+    while (1) {
+        long start = now_ns();
+        fn(ctx, iterations);
+        elapsed = now_ns() - start;
+        if (elapsed >= g_target_ns || iterations >= 1000000000L) {
+            break;
+        }
+        long next = elapsed > 0 ? (long)((double)iterations * 1.2 * (double)g_target_ns / (double)elapsed)
+                                : iterations * 100;
+        if (next <= iterations) {
+            next = iterations + 1;
+        }
+        if (next > iterations * 100) {
+            next = iterations * 100;
+        }
+        iterations = next;
+    }
+
+    double samples[64];
+    int repeat = g_repeat < 64 ? g_repeat : 64;
+    unsigned long allocs = 0;
+    unsigned long bytes = 0;
+    for (int r = 0; r < repeat; r++) {
+        unsigned long allocs_before = bench_alloc_count();
+        unsigned long bytes_before = bench_alloc_bytes();
+        long start = now_ns();
+        fn(ctx, iterations);
+        elapsed = now_ns() - start;
+        allocs = bench_alloc_count() - allocs_before;
+        bytes = bench_alloc_bytes() - bytes_before;
+        samples[r] = (double)elapsed / (double)iterations;
+    }
+    qsort(samples, (size_t)repeat, sizeof(samples[0]), compare_double);
+
+    BenchResult *res = &g_results[g_result_count++];
+    snprintf(res->name, sizeof(res->name), "%s", name);
+    res->iterations = iterations;
+    res->ns_per_op = samples[repeat / 2];
+    res->allocs_per_op = (double)allocs / (double)iterations;
+    res->bytes_per_op = (double)bytes / (double)iterations;
+
+    printf("%-48s %12ld %14.1f %12.1f %14.1f\n",
+           res->name, res->iterations, res->ns_per_op, res->allocs_per_op, res->bytes_per_op);
+    fflush(stdout);
+}
+
+static void write_json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', f);
+        }
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+int bench_finish(void) {
+    if (!g_json_path) {
+        return 0;
+    }
+
+    FILE *f = fopen(g_json_path, "w");
+    if (!f) {
+        fprintf(stderr, "bench: cannot write %s\n", g_json_path);
+        return 1;
+    }
+
+    fprintf(f, "{\n  \"timestamp\": %ld,\n  \"repeat\": %d,\n  \"results\": [\n",
+            (long)time(NULL), g_repeat);
+    for (int i = 0; i < g_result_count; i++) {
+        const BenchResult *res = &g_results[i];
+        fprintf(f, "    {\"name\": ");
+        write_json_string(f, res->name);
+        fprintf(f, ", \"iterations\": %ld, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, \"bytes_per_op\": %.1f}%s\n",
+                res->iterations, res->ns_per_op, res->allocs_per_op, res->bytes_per_op,
+                i + 1 < g_result_count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+
+    printf("\nWrote %s\n", g_json_path);
+    return 0;
+}
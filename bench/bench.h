@@ -0,0 +1,59 @@
+/**
+ * bench.h - Minimal micro-benchmark harness
+ *
+ * Each benchmark is a function that runs its operation `iterations` times.
+ * The harness calibrates the iteration count until a run takes at least
+ * BENCH_TIME_MS (default 200 ms), repeats the measurement BENCH_COUNT times
+ * (default 5) and reports the median ns/op together with allocs/op and
+ * bytes/op counted by an interposed malloc family (glibc only).
+ *
+ * Usage:
+ *   static void bench_foo(void *ctx, long iterations) {
+ *       for (long i = 0; i < iterations; i++) { ... }
+ *   }
+ *
+ *   bench_init(argc, argv);
+ *   bench_run("foo", bench_foo, ctx);
+ *   return bench_finish();
+ *
+ * Command line:
+ *   --json PATH     Also write results as JSON (for regression tracking)
+ *   --filter TEXT   Only run benchmarks whose name contains TEXT
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stddef.h>
+
+typedef void (*BenchFn)(void *ctx, long iterations);
+
+/**
+ * Parse command line options and environment (BENCH_TIME_MS, BENCH_COUNT)
+ */
+void bench_init(int argc, char **argv);
+
+/**
+ * Calibrate, measure and print one benchmark
+ */
+void bench_run(const char *name, BenchFn fn, void *ctx);
+
+/**
+ * Write the JSON report (if requested)
+ * Returns process exit code (0 on success)
+ */
+int bench_finish(void);
+
+/**
+ * Keep a computed value alive so the optimizer cannot drop the work
+ */
+void bench_sink(const void *ptr);
+
+/**
+ * Allocation counters maintained by the malloc interposer (alloc_count.c).
+ * Always 0 on platforms where the interposer is unavailable.
+ */
+unsigned long bench_alloc_count(void);
+unsigned long bench_alloc_bytes(void);
+
+#endif // BENCH_H
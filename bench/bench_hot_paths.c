@@ -0,0 +1,418 @@
+/**
+ * bench_hot_paths.c - Micro-benchmarks for the agent's hot paths
+ *
+ * Covers request building and provider conversion, tool helpers, the TUI
+ * message queue and input history loading. Links against claude.c built
+ * with -DTEST_BUILD (same as the unit tests) so internal helpers are
+ * reachable.
+ *
+ * Build and run: make bench
+ * Usage: ./build/bench_hot_paths [--json out.json] [--filter name]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <cjson/cJSON.h>
+
+#include "bench.h"
+#include "../src/claude_internal.h"
+#include "../src/base64.h"
+#include "../src/patch_parser.h"
+#include "../src/message_queue.h"
+#include "../src/history_file.h"
+#include "../src/anthropic_provider.h"
+#include "../src/aws_bedrock.h"
+#include "../src/arena.h"
+
+// Exported from claude.c in TEST_BUILD
+extern cJSON* tool_read(cJSON *params, ConversationState *state);
+extern char* str_replace_all(const char *content, const char *old_str, const char *new_str, int *replace_count);
+extern char* regex_replace(const char *content, const char *pattern, const char *replacement,
+                           int replace_all, int *replace_count, char **error_msg);
+
+static char g_tmp_dir[] = "/tmp/claude_bench_XXXXXX";
+
+// ============================================================================
+// Fixtures
+// ============================================================================
+
+static void add_content(InternalMessage *msg, InternalContent content) {
+    InternalContent *grown = realloc(msg->contents, (size_t)(msg->content_count + 1) * sizeof(InternalContent));
+    if (!grown) {
+        return;
+    }
+    msg->contents = grown;
+    msg->contents[msg->content_count++] = content;
+}
+
+/**
+ * Build a conversation resembling a real agent session: a system prompt,
+ * then repeating user text / assistant tool call / tool result turns.
+ */
+static ConversationState *make_conversation(int message_count) {
+    ConversationState *state = calloc(1, sizeof(ConversationState));
+    if (!state || conversation_state_init(state) != 0) {
+        free(state);
+        return NULL;
+    }
+    state->model = strdup("bench-model");
+    state->working_dir = strdup(g_tmp_dir);
+
+    for (int i = 0; i < message_count && i < MAX_MESSAGES; i++) {
+        InternalMessage *msg = &state->messages[state->count++];
+        InternalContent c = {0};
+        char id[32];
+        snprintf(id, sizeof(id), "call_%d", i / 3);
+
+        if (i == 0) {
+            msg->role = MSG_SYSTEM;
+            c.type = INTERNAL_TEXT;
+            c.text = strdup("You are a coding agent. Working directory: /tmp/project\n"
+                            "Use the tools to read, edit and run code. Be concise.");
+        } else if (i % 3 == 1) {
+            msg->role = MSG_USER;
+            c.type = INTERNAL_TEXT;
+            c.text = strdup("Please look at src/main.c and fix the off-by-one error in the loop "
+                            "that walks the argument vector, then run the tests.");
+        } else if (i % 3 == 2) {
+            msg->role = MSG_ASSISTANT;
+            c.type = INTERNAL_TEXT;
+            c.text = strdup("I'll read the file first.");
+            add_content(msg, c);
+            memset(&c, 0, sizeof(c));
+            c.type = INTERNAL_TOOL_CALL;
+            c.tool_id = strdup(id);
+            c.tool_name = strdup("Read");
+            c.tool_params = cJSON_CreateObject();
+            cJSON_AddStringToObject(c.tool_params, "file_path", "src/main.c");
+            cJSON_AddNumberToObject(c.tool_params, "start_line", 1);
+            cJSON_AddNumberToObject(c.tool_params, "end_line", 80);
+        } else {
+            msg->role = MSG_USER;
+            c.type = INTERNAL_TOOL_RESPONSE;
+            c.tool_id = strdup(id);
+            c.tool_name = strdup("Read");
+            c.tool_output = cJSON_CreateObject();
+            char body[2048];
+            size_t off = 0;
+            for (int line = 1; line <= 40 && off + 64 < sizeof(body); line++) {
+                off += (size_t)snprintf(body + off, sizeof(body) - off,
+                                        "%4d  for (int i = 0; i <= argc; i++) { use(argv[i]); }\n", line);
+            }
+            cJSON_AddStringToObject(c.tool_output, "content", body);
+        }
+        add_content(msg, c);
+    }
+    return state;
+}
+
+static void free_conversation(ConversationState *state) {
+    if (!state) {
+        return;
+    }
+    conversation_free(state);
+    free(state->model);
+    free(state->working_dir);
+    conversation_state_destroy(state);
+    free(state);
+}
+
+static char *make_text(size_t size, const char *unit) {
+    size_t unit_len = strlen(unit);
+    char *text = malloc(size + 1);
+    if (!text) {
+        return NULL;
+    }
+    for (size_t off = 0; off < size; off += unit_len) {
+        size_t n = size - off < unit_len ? size - off : unit_len;
+        memcpy(text + off, unit, n);
+    }
+    text[size] = '\0';
+    return text;
+}
+
+static int write_lines(const char *path, int lines, const char *prefix, const char *suffix) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        return -1;
+    }
+    for (int i = 1; i <= lines; i++) {
+        fprintf(f, "%s%d%s\n", prefix, i, suffix);
+    }
+    fclose(f);
+    return 0;
+}
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+typedef struct {
+    unsigned char *data;
+    size_t len;
+    char *encoded;
+    size_t encoded_len;
+} Base64Ctx;
+
+static void bench_base64_encode(void *ctx, long iterations) {
+    Base64Ctx *b = ctx;
+    for (long i = 0; i < iterations; i++) {
+        size_t out_len = 0;
+        char *out = base64_encode(b->data, b->len, &out_len);
+        bench_sink(out);
+        free(out);
+    }
+}
+
+static void bench_base64_decode(void *ctx, long iterations) {
+    Base64Ctx *b = ctx;
+    for (long i = 0; i < iterations; i++) {
+        size_t out_len = 0;
+        unsigned char *out = base64_decode(b->encoded, b->encoded_len, &out_len);
+        bench_sink(out);
+        free(out);
+    }
+}
+
+static void bench_build_request(void *ctx, long iterations) {
+    ConversationState *state = ctx;
+    for (long i = 0; i < iterations; i++) {
+        char *json = build_request_json_from_state(state);
+        bench_sink(json);
+        free(json);
+    }
+}
+
+// Same work with the intermediate trees in the turn arena, as the providers do it
+static void bench_build_request_arena(void *ctx, long iterations) {
+    ConversationState *state = ctx;
+    for (long i = 0; i < iterations; i++) {
+        Arena *prev = arena_cjson_push(arena_turn());
+        char *json = build_request_json_from_state(state);
+        arena_cjson_pop(prev);
+        bench_sink(json);
+        free(json);
+        arena_turn_reset();
+    }
+}
+
+static void bench_bedrock_convert_arena(void *ctx, long iterations) {
+    const char *request = ctx;
+    for (long i = 0; i < iterations; i++) {
+        Arena *prev = arena_cjson_push(arena_turn());
+        char *out = bedrock_convert_request(request);
+        arena_cjson_pop(prev);
+        bench_sink(out);
+        free(out);
+        arena_turn_reset();
+    }
+}
+
+static void bench_openai_to_anthropic(void *ctx, long iterations) {
+    const char *request = ctx;
+    for (long i = 0; i < iterations; i++) {
+        char *out = openai_to_anthropic_request(request);
+        bench_sink(out);
+        free(out);
+    }
+}
+
+static void bench_bedrock_convert(void *ctx, long iterations) {
+    const char *request = ctx;
+    for (long i = 0; i < iterations; i++) {
+        char *out = bedrock_convert_request(request);
+        bench_sink(out);
+        free(out);
+    }
+}
+
+typedef struct {
+    ConversationState *state;
+    cJSON *params;
+} ToolCtx;
+
+static void bench_tool_read(void *ctx, long iterations) {
+    ToolCtx *t = ctx;
+    for (long i = 0; i < iterations; i++) {
+        cJSON *res = tool_read(t->params, t->state);
+        bench_sink(res);
+        cJSON_Delete(res);
+    }
+}
+
+typedef struct {
+    const char *content;
+    const char *old_str;
+    const char *new_str;
+} ReplaceCtx;
+
+static void bench_str_replace_all(void *ctx, long iterations) {
+    ReplaceCtx *r = ctx;
+    for (long i = 0; i < iterations; i++) {
+        int count = 0;
+        char *out = str_replace_all(r->content, r->old_str, r->new_str, &count);
+        bench_sink(out);
+        free(out);
+    }
+}
+
+static void bench_regex_replace(void *ctx, long iterations) {
+    ReplaceCtx *r = ctx;
+    for (long i = 0; i < iterations; i++) {
+        int count = 0;
+        char *error = NULL;
+        char *out = regex_replace(r->content, r->old_str, r->new_str, 1, &count, &error);
+        bench_sink(out);
+        free(out);
+        free(error);
+    }
+}
+
+static void bench_parse_patch(void *ctx, long iterations) {
+    const char *patch = ctx;
+    for (long i = 0; i < iterations; i++) {
+        ParsedPatch *parsed = parse_patch_format(patch);
+        bench_sink(parsed);
+        free_parsed_patch(parsed);
+    }
+}
+
+// One op = post one ADD_LINE message and poll it back
+static void bench_tui_queue(void *ctx, long iterations) {
+    TUIMessageQueue *queue = ctx;
+    TUIMessage msg = {0};
+    const long batch = 64;
+    for (long i = 0; i < iterations; i += batch) {
+        long n = iterations - i < batch ? iterations - i : batch;
+        for (long j = 0; j < n; j++) {
+            post_tui_message(queue, TUI_MSG_ADD_LINE, "[Tool] Read src/main.c (lines 1-80)");
+        }
+        for (long j = 0; j < n; j++) {
+            if (poll_tui_message(queue, &msg) == 1) {
+                tui_message_release(&msg);
+            }
+        }
+    }
+}
+
+static void bench_history_load_recent(void *ctx, long iterations) {
+    HistoryFile *hf = ctx;
+    for (long i = 0; i < iterations; i++) {
+        int count = 0;
+        char **lines = history_file_load_recent(hf, 100, &count);
+        for (int j = 0; j < count; j++) {
+            free(lines[j]);
+        }
+        free(lines);
+    }
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+int main(int argc, char **argv) {
+    arena_cjson_init();
+    if (!mkdtemp(g_tmp_dir)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    setenv("DISABLE_PROMPT_CACHING", "1", 0);
+
+    bench_init(argc, argv);
+
+    // base64
+    Base64Ctx b64 = {0};
+    b64.len = 4096;
+    b64.data = malloc(b64.len);
+    for (size_t i = 0; i < b64.len; i++) {
+        b64.data[i] = (unsigned char)(i * 31u + 7u);
+    }
+    b64.encoded = base64_encode(b64.data, b64.len, &b64.encoded_len);
+    bench_run("base64_encode/4KiB", bench_base64_encode, &b64);
+    bench_run("base64_decode/4KiB", bench_base64_decode, &b64);
+
+    // Request building and provider conversion
+    const int sizes[] = {10, 100, 1000};
+    char *request_100 = NULL;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        ConversationState *state = make_conversation(sizes[i]);
+        char name[64];
+        snprintf(name, sizeof(name), "build_request_json_from_state/%d", sizes[i]);
+        bench_run(name, bench_build_request, state);
+        snprintf(name, sizeof(name), "build_request_json_from_state/%d/arena", sizes[i]);
+        bench_run(name, bench_build_request_arena, state);
+        if (sizes[i] == 100) {
+            request_100 = build_request_json_from_state(state);
+        }
+        free_conversation(state);
+    }
+    if (request_100) {
+        bench_run("openai_to_anthropic_request/100", bench_openai_to_anthropic, request_100);
+        bench_run("bedrock_convert_request/100", bench_bedrock_convert, request_100);
+        bench_run("bedrock_convert_request/100/arena", bench_bedrock_convert_arena, request_100);
+    }
+
+    // tool_read slicing a 100-line window out of a 5000-line file
+    char read_path[512];
+    snprintf(read_path, sizeof(read_path), "%s/read_target.c", g_tmp_dir);
+    write_lines(read_path, 5000, "static int value_", " = 0; /* padding to a typical source line width */");
+    ToolCtx tool = {make_conversation(1), cJSON_CreateObject()};
+    cJSON_AddStringToObject(tool.params, "file_path", read_path);
+    cJSON_AddNumberToObject(tool.params, "start_line", 2000);
+    cJSON_AddNumberToObject(tool.params, "end_line", 2100);
+    bench_run("tool_read/slice100of5000", bench_tool_read, &tool);
+
+    // Edit helpers on a 64 KiB buffer
+    char *text = make_text(64 * 1024, "int counter = 0;\ncounter += step;\nreturn counter;\n");
+    ReplaceCtx plain = {text, "counter", "total"};
+    ReplaceCtx regex = {text, "count[a-z]+", "total"};
+    bench_run("str_replace_all/64KiB", bench_str_replace_all, &plain);
+    bench_run("regex_replace/64KiB", bench_regex_replace, &regex);
+
+    // Patch parsing: 20 file sections
+    size_t patch_cap = 64 * 1024;
+    char *patch = malloc(patch_cap);
+    size_t off = (size_t)snprintf(patch, patch_cap, "*** Begin Patch\n");
+    for (int i = 0; i < 20; i++) {
+        off += (size_t)snprintf(patch + off, patch_cap - off,
+                                "*** Update File: src/file_%d.c\n@@\n-old line %d\n-second old line\n"
+                                "+new line %d\n+second new line\n@@\n", i, i, i);
+    }
+    snprintf(patch + off, patch_cap - off, "*** End Patch\n");
+    bench_run("parse_patch_format/20files", bench_parse_patch, patch);
+
+    // TUI queue round trip
+    TUIMessageQueue queue;
+    tui_msg_queue_init(&queue, 256);
+    bench_run("tui_queue/post+poll", bench_tui_queue, &queue);
+    tui_msg_queue_free(&queue);
+
+    // History file with 10k entries, load the newest 100
+    char history_path[512];
+    snprintf(history_path, sizeof(history_path), "%s/history.txt", g_tmp_dir);
+    write_lines(history_path, 10000, "git commit -m \"change number ", "\" && make test");
+    HistoryFile *hf = history_file_open(history_path);
+    if (hf) {
+        bench_run("history_file_load_recent/100of10000", bench_history_load_recent, hf);
+        history_file_close(hf);
+    }
+
+    int rc = bench_finish();
+
+    free(b64.data);
+    free(b64.encoded);
+    free(request_100);
+    cJSON_Delete(tool.params);
+    free_conversation(tool.state);
+    free(text);
+    free(patch);
+    unlink(read_path);
+    unlink(history_path);
+    rmdir(g_tmp_dir);
+
+    return rc;
+}
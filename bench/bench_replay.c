@@ -0,0 +1,742 @@
+/**
+ * bench_replay.c - End-to-end replay benchmark against a local mock provider
+ *
+ * Replays a recorded session (a JSONL file of provider responses, or the
+ * successful rows of one session in the api_calls table) through an
+ * unmodified claude-c binary. A mock HTTP server on 127.0.0.1 answers each
+ * API request with the next recorded response, so the client runs its real
+ * provider, tool and persistence code paths headless (single command mode)
+ * without network access or token spend.
+ *
+ * Each run uses a fresh scratch directory as working directory, database
+ * and log location; tools from the recording execute for real inside it.
+ *
+ * Reported per build:
+ *   - turn latency: time from the mock sending response N to receiving
+ *     request N+1, i.e. client-side response handling, tool execution,
+ *     persistence and request building (p50/p90/p99/max)
+ *   - startup latency (process start to first request) and session time
+ *   - CPU time (user+sys) and peak RSS of the client, via wait4()
+ *   - allocations, via the alloc_preload.so LD_PRELOAD counter (glibc)
+ *
+ * Build and run: make bench-replay
+ * Usage: ./build/bench_replay [--claude PATH] [--jsonl FILE | --db FILE [--session ID]]
+ *                             [--runs N] [--prompt TEXT] [--preload PATH] [--json OUT]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <cjson/cJSON.h>
+#include <sqlite3.h>
+
+#define MAX_RECORDED_REQUESTS 4096
+#define REQUEST_BUFFER_INITIAL 65536
+
+// Served once the recording is exhausted so the client's turn loop ends
+static const char *FINAL_OPENAI_RESPONSE =
+    "{\"id\":\"chatcmpl-replay-end\",\"object\":\"chat.completion\",\"choices\":[{\"index\":0,"
+    "\"message\":{\"role\":\"assistant\",\"content\":\"Replay finished.\"},\"finish_reason\":\"stop\"}],"
+    "\"usage\":{\"prompt_tokens\":0,\"completion_tokens\":0,\"total_tokens\":0}}";
+static const char *FINAL_ANTHROPIC_RESPONSE =
+    "{\"id\":\"msg_replay_end\",\"type\":\"message\",\"role\":\"assistant\",\"content\":[{\"type\":\"text\","
+    "\"text\":\"Replay finished.\"}],\"stop_reason\":\"end_turn\",\"usage\":{\"input_tokens\":0,\"output_tokens\":0}}";
+
+typedef struct {
+    char **bodies;
+    int count;
+    int capacity;
+    int anthropic_format;   // Recorded responses are Anthropic-native (not OpenAI)
+} ReplayScript;
+
+typedef struct {
+    int listen_fd;
+    int port;
+    const ReplayScript *script;
+    pthread_t thread;
+    volatile int stop;
+
+    pthread_mutex_t mutex;
+    int served;
+    int64_t recv_ns[MAX_RECORDED_REQUESTS];
+    int64_t sent_ns[MAX_RECORDED_REQUESTS];
+} MockServer;
+
+typedef struct {
+    double *values;
+    int count;
+    int capacity;
+} Samples;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// ============================================================================
+// Replay script loading
+// ============================================================================
+
+static int script_add(ReplayScript *script, const char *body) {
+    if (script->count == script->capacity) {
+        int new_cap = script->capacity ? script->capacity * 2 : 16;
+        char **grown = realloc(script->bodies, (size_t)new_cap * sizeof(char *));
+        if (!grown) {
+            return -1;
+        }
+        script->bodies = grown;
+        script->capacity = new_cap;
+    }
+    script->bodies[script->count] = strdup(body);
+    if (!script->bodies[script->count]) {
+        return -1;
+    }
+    script->count++;
+    return 0;
+}
+
+static void script_free(ReplayScript *script) {
+    for (int i = 0; i < script->count; i++) {
+        free(script->bodies[i]);
+    }
+    free(script->bodies);
+    memset(script, 0, sizeof(*script));
+}
+
+static void script_detect_format(ReplayScript *script) {
+    if (script->count == 0) {
+        return;
+    }
+    cJSON *first = cJSON_Parse(script->bodies[0]);
+    if (first && !cJSON_GetObjectItem(first, "choices") &&
+        cJSON_IsArray(cJSON_GetObjectItem(first, "content"))) {
+        script->anthropic_format = 1;
+    }
+    cJSON_Delete(first);
+}
+
+/**
+ * Each line is either a raw provider response, or an object carrying it as
+ * "response_json" (string, as exported from api_calls) or "response".
+ */
+static int load_jsonl(ReplayScript *script, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "bench_replay: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t len;
+    int rc = 0;
+    while ((len = getline(&line, &line_cap, f)) != -1) {
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+        if (len == 0) {
+            continue;
+        }
+
+        cJSON *json = cJSON_Parse(line);
+        if (!json) {
+            fprintf(stderr, "bench_replay: skipping invalid JSON line in %s\n", path);
+            continue;
+        }
+        cJSON *wrapped_str = cJSON_GetObjectItem(json, "response_json");
+        cJSON *wrapped_obj = cJSON_GetObjectItem(json, "response");
+        if (cJSON_IsString(wrapped_str)) {
+            rc = script_add(script, wrapped_str->valuestring);
+        } else if (cJSON_IsObject(wrapped_obj)) {
+            char *body = cJSON_PrintUnformatted(wrapped_obj);
+            rc = body ? script_add(script, body) : -1;
+            free(body);
+        } else {
+            rc = script_add(script, line);
+        }
+        cJSON_Delete(json);
+        if (rc != 0) {
+            break;
+        }
+    }
+
+    free(line);
+    fclose(f);
+    return rc;
+}
+
+static int load_db(ReplayScript *script, const char *path, const char *session_id) {
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(path, &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        fprintf(stderr, "bench_replay: cannot open database %s: %s\n", path, sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return -1;
+    }
+
+    char *latest = NULL;
+    if (!session_id) {
+        sqlite3_stmt *stmt = NULL;
+        const char *sql = "SELECT session_id FROM api_calls WHERE status = 'success' "
+                          "AND session_id IS NOT NULL ORDER BY id DESC LIMIT 1;";
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK &&
+            sqlite3_step(stmt) == SQLITE_ROW) {
+            latest = strdup((const char *)sqlite3_column_text(stmt, 0));
+        }
+        sqlite3_finalize(stmt);
+        session_id = latest;
+        if (!session_id) {
+            fprintf(stderr, "bench_replay: no sessions found in %s\n", path);
+            sqlite3_close(db);
+            return -1;
+        }
+    }
+
+    sqlite3_stmt *stmt = NULL;
+    const char *sql = "SELECT response_json FROM api_calls WHERE session_id = ? "
+                      "AND status = 'success' AND response_json IS NOT NULL ORDER BY id;";
+    int rc = -1;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, session_id, -1, SQLITE_TRANSIENT);
+        rc = 0;
+        while (rc == 0 && sqlite3_step(stmt) == SQLITE_ROW) {
+            rc = script_add(script, (const char *)sqlite3_column_text(stmt, 0));
+        }
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+
+    printf("Replaying session %s (%d responses)\n", session_id, script->count);
+    free(latest);
+    return rc;
+}
+
+// ============================================================================
+// Mock provider
+// ============================================================================
+
+static int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/**
+ * Read one HTTP request (headers plus Content-Length body) from fd.
+ * Returns 0 once the full request has arrived, -1 on error or EOF.
+ */
+static int read_request(int fd) {
+    size_t cap = REQUEST_BUFFER_INITIAL;
+    size_t len = 0;
+    char *buf = malloc(cap);
+    if (!buf) {
+        return -1;
+    }
+
+    size_t header_end = 0;
+    size_t content_length = 0;
+    while (1) {
+        if (len + 1 >= cap) {
+            char *grown = realloc(buf, cap * 2);
+            if (!grown) {
+                free(buf);
+                return -1;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t n = read(fd, buf + len, cap - len - 1);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            free(buf);
+            return -1;
+        }
+        len += (size_t)n;
+        buf[len] = '\0';
+
+        if (header_end == 0) {
+            char *end = strstr(buf, "\r\n\r\n");
+            if (!end) {
+                continue;
+            }
+            header_end = (size_t)(end - buf) + 4;
+            for (char *line = buf; line && line < end; line = strstr(line, "\r\n")) {
+                if (line != buf) {
+                    line += 2;
+                }
+                if (strncasecmp(line, "Content-Length:", 15) == 0) {
+                    content_length = (size_t)strtoul(line + 15, NULL, 10);
+                }
+                if (line == buf) {
+                    line++;
+                }
+            }
+        }
+        if (len >= header_end + content_length) {
+            break;
+        }
+    }
+
+    free(buf);
+    return 0;
+}
+
+static void *mock_server_thread(void *arg) {
+    MockServer *server = arg;
+
+    while (!server->stop) {
+        struct pollfd pfd = {server->listen_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) {
+            continue;
+        }
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+
+        if (read_request(fd) == 0) {
+            int64_t received = now_ns();
+
+            pthread_mutex_lock(&server->mutex);
+            int index = server->served;
+            pthread_mutex_unlock(&server->mutex);
+
+            const ReplayScript *script = server->script;
+            const char *body;
+            if (index < script->count) {
+                body = script->bodies[index];
+            } else {
+                body = script->anthropic_format ? FINAL_ANTHROPIC_RESPONSE : FINAL_OPENAI_RESPONSE;
+            }
+
+            char header[256];
+            int header_len = snprintf(header, sizeof(header),
+                                      "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                      "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+                                      strlen(body));
+            write_all(fd, header, (size_t)header_len);
+            write_all(fd, body, strlen(body));
+            int64_t sent = now_ns();
+
+            pthread_mutex_lock(&server->mutex);
+            if (index < MAX_RECORDED_REQUESTS) {
+                server->recv_ns[index] = received;
+                server->sent_ns[index] = sent;
+            }
+            server->served++;
+            pthread_mutex_unlock(&server->mutex);
+        }
+        close(fd);
+    }
+    return NULL;
+}
+
+static int mock_server_start(MockServer *server, const ReplayScript *script) {
+    memset(server, 0, sizeof(*server));
+    server->script = script;
+    pthread_mutex_init(&server->mutex, NULL);
+
+    server->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->listen_fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t addr_len = sizeof(addr);
+    if (bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(server->listen_fd, 16) != 0 ||
+        getsockname(server->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0) {
+        close(server->listen_fd);
+        return -1;
+    }
+    server->port = ntohs(addr.sin_port);
+
+    if (pthread_create(&server->thread, NULL, mock_server_thread, server) != 0) {
+        close(server->listen_fd);
+        return -1;
+    }
+    return 0;
+}
+
+static void mock_server_reset(MockServer *server) {
+    pthread_mutex_lock(&server->mutex);
+    server->served = 0;
+    pthread_mutex_unlock(&server->mutex);
+}
+
+static void mock_server_stop(MockServer *server) {
+    server->stop = 1;
+    pthread_join(server->thread, NULL);
+    close(server->listen_fd);
+    pthread_mutex_destroy(&server->mutex);
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+static void samples_add(Samples *s, double value) {
+    if (s->count == s->capacity) {
+        int new_cap = s->capacity ? s->capacity * 2 : 64;
+        double *grown = realloc(s->values, (size_t)new_cap * sizeof(double));
+        if (!grown) {
+            return;
+        }
+        s->values = grown;
+        s->capacity = new_cap;
+    }
+    s->values[s->count++] = value;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile; samples must be sorted
+static double percentile(const Samples *s, double p) {
+    if (s->count == 0) {
+        return 0.0;
+    }
+    int rank = (int)((p / 100.0) * (double)s->count + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > s->count) {
+        rank = s->count;
+    }
+    return s->values[rank - 1];
+}
+
+static void print_samples(const char *label, Samples *s) {
+    qsort(s->values, (size_t)s->count, sizeof(double), compare_double);
+    printf("%-18s p50 %9.2f ms   p90 %9.2f ms   p99 %9.2f ms   max %9.2f ms   (n=%d)\n",
+           label, percentile(s, 50), percentile(s, 90), percentile(s, 99),
+           s->count ? s->values[s->count - 1] : 0.0, s->count);
+}
+
+static void json_samples(FILE *f, const char *key, const Samples *s, const char *trailer) {
+    fprintf(f, "  \"%s\": {\"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f, \"count\": %d}%s\n",
+            key, percentile(s, 50), percentile(s, 90), percentile(s, 99),
+            s->count ? s->values[s->count - 1] : 0.0, s->count, trailer);
+}
+
+// ============================================================================
+// Client runs
+// ============================================================================
+
+typedef struct {
+    const char *claude_path;
+    const char *preload_path;
+    const char *prompt;
+    int runs;
+} ReplayOptions;
+
+typedef struct {
+    int exit_status;
+    double cpu_ms;
+    long max_rss_kb;
+    unsigned long allocs;
+    unsigned long alloc_bytes;
+    int64_t start_ns;
+    int64_t end_ns;
+} RunResult;
+
+static void remove_tree(const char *path) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        execlp("rm", "rm", "-rf", path, (char *)NULL);
+        _exit(127);
+    }
+    if (pid > 0) {
+        waitpid(pid, NULL, 0);
+    }
+}
+
+static int run_client(const ReplayOptions *opts, const MockServer *server,
+                      const ReplayScript *script, RunResult *out) {
+    char scratch[] = "/tmp/claude_replay_XXXXXX";
+    if (!mkdtemp(scratch)) {
+        perror("mkdtemp");
+        return -1;
+    }
+
+    char url[128], db_path[512], log_path[512], alloc_path[512];
+    snprintf(url, sizeof(url), "http://127.0.0.1:%d%s", server->port,
+             script->anthropic_format ? "/v1/messages" : "/v1/chat/completions");
+    snprintf(db_path, sizeof(db_path), "%s/.claude-c/api_calls.db", scratch);
+    snprintf(log_path, sizeof(log_path), "%s/.claude-c/claude.log", scratch);
+    snprintf(alloc_path, sizeof(alloc_path), "%s/allocs.txt", scratch);
+
+    memset(out, 0, sizeof(*out));
+    fflush(NULL);
+    out->start_ns = now_ns();
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        remove_tree(scratch);
+        return -1;
+    }
+    if (pid == 0) {
+        if (chdir(scratch) != 0) {
+            _exit(127);
+        }
+        int devnull = open("/dev/null", O_RDWR);
+        if (devnull >= 0) {
+            dup2(devnull, STDIN_FILENO);
+            dup2(devnull, STDOUT_FILENO);
+            dup2(devnull, STDERR_FILENO);
+        }
+
+        unsetenv("CLAUDE_CODE_USE_BEDROCK");
+        unsetenv("CLAUDE_C_TRACE");
+        setenv("OPENAI_API_KEY", "replay-key", 1);
+        setenv("OPENAI_MODEL", "replay-model", 1);
+        setenv("OPENAI_API_BASE", url, 1);
+        if (script->anthropic_format) {
+            setenv("ANTHROPIC_API_URL", url, 1);
+        } else {
+            unsetenv("ANTHROPIC_API_URL");
+        }
+        setenv("CLAUDE_C_DB_PATH", db_path, 1);
+        setenv("CLAUDE_C_LOG_PATH", log_path, 1);
+        if (opts->preload_path) {
+            setenv("LD_PRELOAD", opts->preload_path, 1);
+            setenv("BENCH_ALLOC_REPORT", alloc_path, 1);
+        }
+
+        execl(opts->claude_path, opts->claude_path, opts->prompt, (char *)NULL);
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    while (wait4(pid, &status, 0, &usage) < 0 && errno == EINTR) {
+    }
+    out->end_ns = now_ns();
+
+    out->exit_status = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    out->cpu_ms = (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+                  (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+    out->max_rss_kb = usage.ru_maxrss;
+
+    FILE *f = fopen(alloc_path, "r");
+    if (f) {
+        if (fscanf(f, "%lu %lu", &out->allocs, &out->alloc_bytes) != 2) {
+            out->allocs = 0;
+            out->alloc_bytes = 0;
+        }
+        fclose(f);
+    }
+
+    remove_tree(scratch);
+    return 0;
+}
+
+static void usage(const char *argv0) {
+    printf("Usage: %s [options]\n\n", argv0);
+    printf("  --claude PATH    claude-c binary to drive (default: ./build/claude-c)\n");
+    printf("  --jsonl FILE     Recorded responses, one JSON per line\n");
+    printf("  --db FILE        Replay a session from an api_calls database\n");
+    printf("  --session ID     Session to replay with --db (default: most recent)\n");
+    printf("  --runs N         Number of replays (default: 5)\n");
+    printf("  --prompt TEXT    Initial user prompt (default: generic replay prompt)\n");
+    printf("  --preload PATH   LD_PRELOAD allocation counter (alloc_preload.so)\n");
+    printf("  --json OUT       Write the summary as JSON\n");
+}
+
+int main(int argc, char **argv) {
+    ReplayOptions opts = {"./build/claude-c", NULL, "Replay the recorded session.", 5};
+    const char *jsonl_path = NULL;
+    const char *db_path = NULL;
+    const char *session_id = NULL;
+    const char *json_out = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            usage(argv[0]);
+            return 0;
+        }
+        if (!val) {
+            fprintf(stderr, "bench_replay: %s requires a value\n", arg);
+            return 2;
+        }
+        if (strcmp(arg, "--claude") == 0) {
+            opts.claude_path = val;
+        } else if (strcmp(arg, "--jsonl") == 0) {
+            jsonl_path = val;
+        } else if (strcmp(arg, "--db") == 0) {
+            db_path = val;
+        } else if (strcmp(arg, "--session") == 0) {
+            session_id = val;
+        } else if (strcmp(arg, "--runs") == 0) {
+            opts.runs = atoi(val) > 0 ? atoi(val) : 1;
+        } else if (strcmp(arg, "--prompt") == 0) {
+            opts.prompt = val;
+        } else if (strcmp(arg, "--preload") == 0) {
+            opts.preload_path = val;
+        } else if (strcmp(arg, "--json") == 0) {
+            json_out = val;
+        } else {
+            fprintf(stderr, "bench_replay: unknown option %s\n", arg);
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+    }
+
+    // Runs chdir into a scratch directory, so resolve paths up front
+    char claude_abs[PATH_MAX], preload_abs[PATH_MAX];
+    if (!realpath(opts.claude_path, claude_abs)) {
+        fprintf(stderr, "bench_replay: %s: %s\n", opts.claude_path, strerror(errno));
+        return 1;
+    }
+    opts.claude_path = claude_abs;
+    if (opts.preload_path) {
+        if (!realpath(opts.preload_path, preload_abs)) {
+            fprintf(stderr, "bench_replay: %s: %s\n", opts.preload_path, strerror(errno));
+            return 1;
+        }
+        opts.preload_path = preload_abs;
+    }
+
+    ReplayScript script = {0};
+    int rc = db_path ? load_db(&script, db_path, session_id)
+                     : load_jsonl(&script, jsonl_path ? jsonl_path : "bench/replay/sample_session.jsonl");
+    if (rc != 0 || script.count == 0) {
+        fprintf(stderr, "bench_replay: nothing to replay\n");
+        script_free(&script);
+        return 1;
+    }
+    script_detect_format(&script);
+
+    MockServer server;
+    if (mock_server_start(&server, &script) != 0) {
+        fprintf(stderr, "bench_replay: failed to start mock server: %s\n", strerror(errno));
+        script_free(&script);
+        return 1;
+    }
+    printf("Mock provider on 127.0.0.1:%d (%s format, %d responses), %d run(s)\n\n",
+           server.port, script.anthropic_format ? "Anthropic" : "OpenAI", script.count, opts.runs);
+
+    Samples turns = {0}, startup = {0}, session = {0};
+    double cpu_total = 0.0;
+    long rss_peak = 0;
+    unsigned long allocs_total = 0, bytes_total = 0;
+    int failures = 0;
+    int measured = 0;  // Runs whose numbers went into the totals
+
+    for (int run = 0; run < opts.runs; run++) {
+        mock_server_reset(&server);
+        RunResult result;
+        if (run_client(&opts, &server, &script, &result) != 0) {
+            failures++;
+            continue;
+        }
+
+        pthread_mutex_lock(&server.mutex);
+        int served = server.served < MAX_RECORDED_REQUESTS ? server.served : MAX_RECORDED_REQUESTS;
+        if (served > 0) {
+            samples_add(&startup, (double)(server.recv_ns[0] - result.start_ns) / 1e6);
+        }
+        for (int k = 0; k + 1 < served; k++) {
+            samples_add(&turns, (double)(server.recv_ns[k + 1] - server.sent_ns[k]) / 1e6);
+        }
+        pthread_mutex_unlock(&server.mutex);
+
+        samples_add(&session, (double)(result.end_ns - result.start_ns) / 1e6);
+        cpu_total += result.cpu_ms;
+        if (result.max_rss_kb > rss_peak) {
+            rss_peak = result.max_rss_kb;
+        }
+        allocs_total += result.allocs;
+        bytes_total += result.alloc_bytes;
+        measured++;
+
+        if (result.exit_status != 0 || served < script.count) {
+            fprintf(stderr, "run %d: exit status %d, %d of %d responses consumed\n",
+                    run + 1, result.exit_status, served, script.count);
+            failures++;
+        }
+    }
+
+    mock_server_stop(&server);
+
+    int divisor = measured > 0 ? measured : 1;
+    print_samples("turn latency", &turns);
+    print_samples("startup", &startup);
+    print_samples("session", &session);
+    printf("%-18s %.2f ms/run\n", "cpu (user+sys)", cpu_total / divisor);
+    printf("%-18s %ld KiB\n", "peak rss", rss_peak);
+    if (opts.preload_path) {
+        printf("%-18s %lu allocs/run, %lu bytes/run\n", "allocations",
+               allocs_total / (unsigned long)divisor, bytes_total / (unsigned long)divisor);
+    }
+    if (failures > 0) {
+        printf("\n%d run(s) did not replay cleanly\n", failures);
+    }
+
+    if (json_out) {
+        FILE *f = fopen(json_out, "w");
+        if (f) {
+            fprintf(f, "{\n  \"timestamp\": %ld,\n  \"runs\": %d,\n  \"failures\": %d,\n  \"responses\": %d,\n",
+                    (long)time(NULL), opts.runs, failures, script.count);
+            json_samples(f, "turn_latency_ms", &turns, ",");
+            json_samples(f, "startup_ms", &startup, ",");
+            json_samples(f, "session_ms", &session, ",");
+            fprintf(f, "  \"cpu_ms_per_run\": %.3f,\n  \"peak_rss_kb\": %ld,\n",
+                    cpu_total / divisor, rss_peak);
+            fprintf(f, "  \"allocs_per_run\": %lu,\n  \"alloc_bytes_per_run\": %lu\n}\n",
+                    allocs_total / (unsigned long)divisor, bytes_total / (unsigned long)divisor);
+            fclose(f);
+            printf("\nWrote %s\n", json_out);
+        } else {
+            fprintf(stderr, "bench_replay: cannot write %s\n", json_out);
+        }
+    }
+
+    free(turns.values);
+    free(startup.values);
+    free(session.values);
+    script_free(&script);
+    return failures > 0 ? 1 : 0;
+}
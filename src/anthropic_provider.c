@@ -8,6 +8,8 @@
 #include "anthropic_provider.h"
 #include "openai_messages.h"  // We reuse internal message building and parse into OpenAI-like intermediate
 #include "logger.h"
+#include "trace.h"
+#include "arena.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -85,7 +87,11 @@ static char* headers_to_json(struct curl_slist *headers) {
 // ============================================================================
 
 // Convert OpenAI-style request (our internal builder outputs) to Anthropic native
+#ifdef TEST_BUILD
+char* openai_to_anthropic_request(const char *openai_req) {
+#else
 static char* openai_to_anthropic_request(const char *openai_req) {
+#endif
     cJSON *openai_json = cJSON_Parse(openai_req);
     if (!openai_json) return NULL;
 
@@ -191,7 +197,7 @@ static char* openai_to_anthropic_request(const char *openai_req) {
                     } else {
                         char *s = cJSON_PrintUnformatted(content);
                         cJSON_AddStringToObject(tr, "content", s ? s : "");
-                        free(s);
+                        cJSON_free(s);
                     }
                     cJSON_AddItemToArray(content_arr, tr);
                     cJSON_AddItemToObject(anth_m, "content", content_arr);
@@ -250,7 +256,7 @@ static char* openai_to_anthropic_request(const char *openai_req) {
         cJSON_AddStringToObject(anth, "anthropic_version", version_env);
     }
 
-    char *out = cJSON_PrintUnformatted(anth);
+    char *out = arena_cjson_print(anth);
     cJSON_Delete(openai_json);
     cJSON_Delete(anth);
     return out;
@@ -360,21 +366,26 @@ static ApiCallResult anthropic_call_api(Provider *self, ConversationState *state
         enable_caching = 0;
     }
 
+    // Intermediate trees are dead once serialized, so build them in the turn arena
+    Arena *prev_arena = arena_cjson_push(arena_turn());
     cJSON *openai_req_obj = build_openai_request(state, enable_caching);
     if (!openai_req_obj) {
+        arena_cjson_pop(prev_arena);
         result.error_message = strdup("Failed to build request JSON");
         result.is_retryable = 0;
         return result;
     }
-    char *openai_req = cJSON_PrintUnformatted(openai_req_obj);
+    char *openai_req = arena_cjson_print(openai_req_obj);
     cJSON_Delete(openai_req_obj);
     if (!openai_req) {
+        arena_cjson_pop(prev_arena);
         result.error_message = strdup("Failed to serialize request JSON");
         result.is_retryable = 0;
         return result;
     }
 
     char *anth_req = openai_to_anthropic_request(openai_req);
+    arena_cjson_pop(prev_arena);
     if (!anth_req) {
         result.error_message = strdup("Failed to convert request to Anthropic format");
         result.is_retryable = 0;
@@ -465,8 +476,10 @@ static ApiCallResult anthropic_call_api(Provider *self, ConversationState *state
 
     struct timespec start, end;
     clock_gettime(CLOCK_MONOTONIC, &start);
+    int64_t perform_start_us = trace_now_us();
     CURLcode rc = curl_easy_perform(curl);
     clock_gettime(CLOCK_MONOTONIC, &end);
+    trace_curl_phases(curl, "anthropic", perform_start_us);
 
     result.duration_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &result.http_status);
@@ -30,4 +30,9 @@ typedef struct {
  */
 Provider* anthropic_provider_create(const char *api_key, const char *base_url);
 
+#ifdef TEST_BUILD
+// Internal functions exposed for testing and benchmarks
+char* openai_to_anthropic_request(const char *openai_req);
+#endif
+
 #endif // ANTHROPIC_PROVIDER_H
@@ -0,0 +1,262 @@
+/**
+ * arena.c - Per-turn bump allocator and cJSON allocator routing
+ */
+
+#include "arena.h"
+#include "logger.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define ARENA_ALIGN ((size_t)_Alignof(max_align_t))
+#define ARENA_DEFAULT_BLOCK_SIZE ((size_t)64 * 1024)
+#define ARENA_MAX_BLOCK_SIZE ((size_t)4 * 1024 * 1024)
+// Largest single block kept across resets; bigger turns re-grow from scratch
+#define ARENA_MAX_RETAIN ((size_t)16 * 1024 * 1024)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    size_t size;                        // Usable bytes in data
+    size_t used;
+    _Alignas(max_align_t) unsigned char data[];
+} ArenaBlock;
+
+struct Arena {
+    ArenaBlock *blocks;                 // Newest (current) block first
+    size_t block_size;
+    size_t used;                        // Bytes handed out since last reset
+    size_t peak;
+};
+
+static size_t align_up(size_t n, size_t align) {
+    return (n + align - 1) & ~(align - 1);
+}
+
+static ArenaBlock* arena_block_new(size_t size) {
+    ArenaBlock *block = malloc(sizeof(ArenaBlock) + size);
+    if (!block) {
+        return NULL;
+    }
+    block->next = NULL;
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+static void arena_free_blocks(ArenaBlock *block) {
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+Arena* arena_create(size_t block_size) {
+    Arena *arena = calloc(1, sizeof(Arena));
+    if (!arena) {
+        return NULL;
+    }
+    arena->block_size = block_size ? align_up(block_size, ARENA_ALIGN) : ARENA_DEFAULT_BLOCK_SIZE;
+    return arena;
+}
+
+void arena_destroy(Arena *arena) {
+    if (!arena) {
+        return;
+    }
+    arena_free_blocks(arena->blocks);
+    free(arena);
+}
+
+void* arena_alloc(Arena *arena, size_t size) {
+    if (!arena || size > SIZE_MAX / 2) {
+        return NULL;
+    }
+    size_t needed = align_up(size ? size : 1, ARENA_ALIGN);
+
+    ArenaBlock *block = arena->blocks;
+    if (!block || block->size - block->used < needed) {
+        // Double the block size as the turn grows so the block list (walked
+        // by arena_owns) stays short even for very large requests
+        size_t new_size = block ? block->size * 2 : arena->block_size;
+        if (new_size > ARENA_MAX_BLOCK_SIZE) {
+            new_size = ARENA_MAX_BLOCK_SIZE;
+        }
+        if (new_size < needed) {
+            new_size = needed;
+        }
+        ArenaBlock *fresh = arena_block_new(new_size);
+        if (!fresh) {
+            return NULL;
+        }
+        fresh->next = arena->blocks;
+        arena->blocks = fresh;
+        block = fresh;
+    }
+
+    void *ptr = block->data + block->used;
+    block->used += needed;
+    arena->used += needed;
+    if (arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+    return ptr;
+}
+
+char* arena_strdup(Arena *arena, const char *s) {
+    if (!s) {
+        return NULL;
+    }
+    size_t len = strlen(s) + 1;
+    char *copy = arena_alloc(arena, len);
+    if (copy) {
+        memcpy(copy, s, len);
+    }
+    return copy;
+}
+
+int arena_owns(const Arena *arena, const void *ptr) {
+    if (!arena || !ptr) {
+        return 0;
+    }
+    uintptr_t p = (uintptr_t)ptr;
+    for (const ArenaBlock *block = arena->blocks; block; block = block->next) {
+        uintptr_t start = (uintptr_t)block->data;
+        if (p >= start && p < start + block->size) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void arena_reset(Arena *arena) {
+    if (!arena || !arena->blocks) {
+        return;
+    }
+
+    size_t used = arena->used;
+    arena->used = 0;
+
+    // Common case: the turn fit in one block that is not oversized for it
+    ArenaBlock *head = arena->blocks;
+    if (!head->next && (head->size <= arena->block_size || head->size / 4 <= used)) {
+        head->used = 0;
+        return;
+    }
+
+    // The turn spilled over several blocks (or shrank a lot): replace them
+    // with a single block sized for this turn
+    arena_free_blocks(arena->blocks);
+    arena->blocks = NULL;
+
+    size_t keep = align_up(used, arena->block_size);
+    if (keep < arena->block_size) {
+        keep = arena->block_size;
+    }
+    if (keep > ARENA_MAX_RETAIN) {
+        keep = arena->block_size;
+    }
+    arena->blocks = arena_block_new(keep);
+}
+
+size_t arena_bytes_used(const Arena *arena) {
+    return arena ? arena->used : 0;
+}
+
+size_t arena_peak_bytes(const Arena *arena) {
+    return arena ? arena->peak : 0;
+}
+
+// ============================================================================
+// cJSON routing
+// ============================================================================
+
+static _Thread_local Arena *t_cjson_arena = NULL;
+
+static void* arena_cjson_malloc(size_t size) {
+    Arena *arena = t_cjson_arena;
+    if (arena) {
+        void *ptr = arena_alloc(arena, size);
+        if (ptr) {
+            return ptr;
+        }
+        // Fall back to the heap; the free hook tells the two apart
+    }
+    return malloc(size);
+}
+
+static void arena_cjson_free(void *ptr) {
+    if (arena_owns(t_cjson_arena, ptr)) {
+        return;  // Reclaimed wholesale by arena_reset()
+    }
+    free(ptr);
+}
+
+void arena_cjson_init(void) {
+    cJSON_Hooks hooks = {arena_cjson_malloc, arena_cjson_free};
+    cJSON_InitHooks(&hooks);
+}
+
+Arena* arena_cjson_push(Arena *arena) {
+    Arena *previous = t_cjson_arena;
+    t_cjson_arena = arena;
+    return previous;
+}
+
+void arena_cjson_pop(Arena *previous) {
+    t_cjson_arena = previous;
+}
+
+char* arena_cjson_print(const cJSON *item) {
+    Arena *previous = arena_cjson_push(NULL);
+    char *out = cJSON_PrintUnformatted(item);
+    arena_cjson_pop(previous);
+    return out;
+}
+
+// ============================================================================
+// Per-thread turn arena
+// ============================================================================
+
+static pthread_key_t g_turn_key;
+static pthread_once_t g_turn_key_once = PTHREAD_ONCE_INIT;
+static int g_turn_key_ok = 0;
+
+static void turn_arena_destructor(void *arena) {
+    arena_destroy(arena);
+}
+
+static void create_turn_key(void) {
+    g_turn_key_ok = pthread_key_create(&g_turn_key, turn_arena_destructor) == 0;
+}
+
+Arena* arena_turn(void) {
+    pthread_once(&g_turn_key_once, create_turn_key);
+    if (!g_turn_key_ok) {
+        return NULL;
+    }
+    Arena *arena = pthread_getspecific(g_turn_key);
+    if (!arena) {
+        arena = arena_create(0);
+        if (!arena || pthread_setspecific(g_turn_key, arena) != 0) {
+            LOG_WARN("Failed to create turn arena, using the heap");
+            arena_destroy(arena);
+            return NULL;
+        }
+    }
+    return arena;
+}
+
+void arena_turn_reset(void) {
+    pthread_once(&g_turn_key_once, create_turn_key);
+    if (!g_turn_key_ok) {
+        return;
+    }
+    Arena *arena = pthread_getspecific(g_turn_key);
+    if (arena) {
+        LOG_DEBUG("Turn arena reset (used: %zu bytes, peak: %zu bytes)",
+                  arena->used, arena->peak);
+        arena_reset(arena);
+    }
+}
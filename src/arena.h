@@ -0,0 +1,110 @@
+/**
+ * arena.h - Per-turn bump allocator for transient JSON trees
+ *
+ * Every API turn rebuilds the whole conversation as a cJSON tree, converts
+ * it to the provider's format and serializes it, then throws all of it
+ * away. An arena turns those thousands of small malloc/free pairs into
+ * pointer bumps in a few large blocks that are recycled at the end of the
+ * turn, which keeps the request path off the shared heap and avoids
+ * fragmenting it over long sessions.
+ *
+ * cJSON allocations are routed into an arena through cJSON_InitHooks,
+ * installed once by arena_cjson_init(). The routing is per thread and only
+ * active between arena_cjson_push() and arena_cjson_pop(); everywhere else
+ * cJSON uses malloc/free as before.
+ *
+ * Usage:
+ *   Arena *prev = arena_cjson_push(arena_turn());
+ *   cJSON *tree = build_tree(...);          // nodes come from the arena
+ *   char *json = arena_cjson_print(tree);   // heap string, caller frees
+ *   cJSON_Delete(tree);                     // no-op for arena nodes
+ *   arena_cjson_pop(prev);
+ *   ...
+ *   arena_turn_reset();                     // at the end of the turn
+ *
+ * Rules inside a push/pop scope:
+ *   - Trees built in the scope must not outlive it or be stored anywhere
+ *     that frees them later (conversation history, ApiResponse).
+ *   - Strings from cJSON_Print* must be released with cJSON_free(), or
+ *     produced with arena_cjson_print() when the caller wants heap memory.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <cjson/cJSON.h>
+
+typedef struct Arena Arena;
+
+/**
+ * Create an arena whose blocks start at block_size bytes (0 = default)
+ * Returns NULL on allocation failure
+ */
+Arena* arena_create(size_t block_size);
+
+/**
+ * Free the arena and all memory handed out from it
+ */
+void arena_destroy(Arena *arena);
+
+/**
+ * Allocate size bytes aligned for any type
+ * Returns NULL on allocation failure
+ */
+void* arena_alloc(Arena *arena, size_t size);
+
+/**
+ * Copy a NUL-terminated string into the arena
+ */
+char* arena_strdup(Arena *arena, const char *s);
+
+/**
+ * Returns 1 if ptr points into memory handed out by this arena
+ */
+int arena_owns(const Arena *arena, const void *ptr);
+
+/**
+ * Release everything allocated since the last reset. Keeps one block
+ * sized to this turn's usage so the next turn usually needs no malloc.
+ */
+void arena_reset(Arena *arena);
+
+/**
+ * Bytes handed out since the last reset / largest such value seen
+ */
+size_t arena_bytes_used(const Arena *arena);
+size_t arena_peak_bytes(const Arena *arena);
+
+/**
+ * Install the cJSON hooks. Call once from main() before any thread that
+ * uses cJSON is started; until then pushed arenas go unused and cJSON
+ * allocates from the heap.
+ */
+void arena_cjson_init(void);
+
+/**
+ * Route the calling thread's cJSON allocations into arena (NULL routes
+ * them back to the heap). Returns the previous arena for arena_cjson_pop().
+ */
+Arena* arena_cjson_push(Arena *arena);
+void arena_cjson_pop(Arena *previous);
+
+/**
+ * cJSON_PrintUnformatted into heap memory regardless of the active arena
+ * Returns: Newly allocated string (caller must free), or NULL on error
+ */
+char* arena_cjson_print(const cJSON *item);
+
+/**
+ * The calling thread's turn arena, created on first use and destroyed
+ * when the thread exits. Returns NULL if it cannot be allocated.
+ */
+Arena* arena_turn(void);
+
+/**
+ * Reset the calling thread's turn arena (no-op if it was never used)
+ */
+void arena_turn_reset(void);
+
+#endif // ARENA_H
@@ -7,6 +7,7 @@
 
 #include "aws_bedrock.h"
 #include "logger.h"
+#include "arena.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -18,6 +19,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <pwd.h>
+#include <pthread.h>
 
 // ============================================================================
 // Helper Functions
@@ -107,6 +109,102 @@ static char* sha256_hash(const char *data) {
     return hex_encode(hash, SHA256_DIGEST_LENGTH);
 }
 
+void bedrock_payload_hash(const char *payload, size_t len, char out[65]) {
+    static const char digits[] = "0123456789abcdef";
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256((const unsigned char*)payload, len, hash);
+    for (size_t i = 0; i < SHA256_DIGEST_LENGTH; i++) {
+        out[i * 2] = digits[hash[i] >> 4];
+        out[i * 2 + 1] = digits[hash[i] & 0x0f];
+    }
+    out[SHA256_DIGEST_LENGTH * 2] = '\0';
+}
+
+// ============================================================================
+// SigV4 Signing Key Cache
+// ============================================================================
+
+// A signing key depends only on the secret, the date, the region and the
+// service, so it is derived once a day instead of four HMACs per request.
+// A few slots cover a rotation in flight or a second region.
+#define SIGNING_KEY_CACHE_SLOTS 4
+
+typedef struct {
+    int used;
+    unsigned char creds_id[SHA256_DIGEST_LENGTH];  // HMAC of the access key under the secret
+    char datestamp[9];
+    char region[32];
+    char service[32];
+    unsigned char key[SHA256_DIGEST_LENGTH];
+} SigningKeyCacheEntry;
+
+static SigningKeyCacheEntry signing_key_cache[SIGNING_KEY_CACHE_SLOTS];
+static int signing_key_cache_next = 0;
+static pthread_mutex_t signing_key_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+int bedrock_derive_signing_key(const AWSCredentials *creds, const char *datestamp,
+                               const char *region, const char *service,
+                               unsigned char key[32]) {
+    if (!creds || !creds->secret_access_key || !datestamp || !region || !service) {
+        return -1;
+    }
+
+    // Identify the credentials without keeping a copy of the secret
+    const char *access_key = creds->access_key_id ? creds->access_key_id : "";
+    unsigned char creds_id[SHA256_DIGEST_LENGTH];
+    hmac_sha256((const unsigned char*)creds->secret_access_key, strlen(creds->secret_access_key),
+                (const unsigned char*)access_key, strlen(access_key), creds_id);
+
+    int cacheable = strlen(datestamp) < sizeof(signing_key_cache[0].datestamp) &&
+                    strlen(region) < sizeof(signing_key_cache[0].region) &&
+                    strlen(service) < sizeof(signing_key_cache[0].service);
+
+    if (cacheable) {
+        pthread_mutex_lock(&signing_key_cache_lock);
+        for (int i = 0; i < SIGNING_KEY_CACHE_SLOTS; i++) {
+            SigningKeyCacheEntry *entry = &signing_key_cache[i];
+            if (entry->used && memcmp(entry->creds_id, creds_id, sizeof(creds_id)) == 0 &&
+                strcmp(entry->datestamp, datestamp) == 0 &&
+                strcmp(entry->region, region) == 0 &&
+                strcmp(entry->service, service) == 0) {
+                memcpy(key, entry->key, SHA256_DIGEST_LENGTH);
+                pthread_mutex_unlock(&signing_key_cache_lock);
+                return 0;
+            }
+        }
+        pthread_mutex_unlock(&signing_key_cache_lock);
+    }
+
+    char key_buffer[256];
+    snprintf(key_buffer, sizeof(key_buffer), "AWS4%s", creds->secret_access_key);
+
+    unsigned char k_date[32];
+    hmac_sha256((const unsigned char*)key_buffer, strlen(key_buffer),
+                (const unsigned char*)datestamp, strlen(datestamp), k_date);
+
+    unsigned char k_region[32];
+    hmac_sha256(k_date, 32, (const unsigned char*)region, strlen(region), k_region);
+
+    unsigned char k_service[32];
+    hmac_sha256(k_region, 32, (const unsigned char*)service, strlen(service), k_service);
+
+    hmac_sha256(k_service, 32, (const unsigned char*)"aws4_request", 12, key);
+
+    if (cacheable) {
+        pthread_mutex_lock(&signing_key_cache_lock);
+        SigningKeyCacheEntry *entry = &signing_key_cache[signing_key_cache_next];
+        signing_key_cache_next = (signing_key_cache_next + 1) % SIGNING_KEY_CACHE_SLOTS;
+        entry->used = 1;
+        memcpy(entry->creds_id, creds_id, sizeof(creds_id));
+        snprintf(entry->datestamp, sizeof(entry->datestamp), "%s", datestamp);
+        snprintf(entry->region, sizeof(entry->region), "%s", region);
+        snprintf(entry->service, sizeof(entry->service), "%s", service);
+        memcpy(entry->key, key, SHA256_DIGEST_LENGTH);
+        pthread_mutex_unlock(&signing_key_cache_lock);
+    }
+    return 0;
+}
+
 /**
  * Execute a command and return its output
  */
@@ -1166,7 +1264,7 @@ char* bedrock_convert_request(const char *openai_request) {
                         char *content_str = cJSON_PrintUnformatted(content);
                         if (content_str) {
                             cJSON_AddStringToObject(tool_result_block, "content", content_str);
-                            free(content_str);
+                            cJSON_free(content_str);
                         } else {
                             cJSON_AddStringToObject(tool_result_block, "content", "");
                         }
@@ -1233,7 +1331,7 @@ char* bedrock_convert_request(const char *openai_request) {
     // Add anthropic_version
     cJSON_AddStringToObject(anthropic_json, "anthropic_version", "bedrock-2023-05-31");
 
-    char *result = cJSON_PrintUnformatted(anthropic_json);
+    char *result = arena_cjson_print(anthropic_json);
 
     LOG_DEBUG("Anthropic request created, length: %zu bytes", result ? strlen(result) : 0);
     LOG_DEBUG("Messages in request: %d", cJSON_GetArraySize(anthropic_messages));
@@ -1443,7 +1541,26 @@ struct curl_slist* bedrock_sign_request(
     const char *region,
     const char *service
 ) {
-    if (!method || !url || !payload || !creds || !region || !service) {
+    if (!payload) {
+        LOG_ERROR("Invalid parameters for bedrock_sign_request");
+        return NULL;
+    }
+
+    char payload_hash[65];
+    bedrock_payload_hash(payload, strlen(payload), payload_hash);
+    return bedrock_sign_request_hashed(headers, method, url, payload_hash, creds, region, service);
+}
+
+struct curl_slist* bedrock_sign_request_hashed(
+    struct curl_slist *headers,
+    const char *method,
+    const char *url,
+    const char *payload_hash,
+    const AWSCredentials *creds,
+    const char *region,
+    const char *service
+) {
+    if (!method || !url || !payload_hash || !creds || !region || !service) {
         LOG_ERROR("Invalid parameters for bedrock_sign_request");
         return NULL;
     }
@@ -1496,9 +1613,6 @@ struct curl_slist* bedrock_sign_request(
         return NULL;
     }
 
-    // Create canonical request
-    char *payload_hash = sha256_hash(payload);
-
     // URL-encode the path for canonical request (per AWS SigV4 spec)
     char *encoded_path = url_encode(path, 0);  // 0 = don't encode slashes
     if (!encoded_path) {
@@ -1506,7 +1620,6 @@ struct curl_slist* bedrock_sign_request(
         free(datestamp);
         free(host);
         free(path);
-        free(payload_hash);
         return NULL;
     }
 
@@ -1532,22 +1645,18 @@ struct curl_slist* bedrock_sign_request(
              "AWS4-HMAC-SHA256\n%s\n%s/%s/%s/aws4_request\n%s",
              timestamp, datestamp, region, service, canonical_request_hash);
 
-    // Calculate signing key
-    char key_buffer[256];
-    snprintf(key_buffer, sizeof(key_buffer), "AWS4%s", creds->secret_access_key);
-
-    unsigned char k_date[32];
-    hmac_sha256((const unsigned char*)key_buffer, strlen(key_buffer),
-                (const unsigned char*)datestamp, strlen(datestamp), k_date);
-
-    unsigned char k_region[32];
-    hmac_sha256(k_date, 32, (const unsigned char*)region, strlen(region), k_region);
-
-    unsigned char k_service[32];
-    hmac_sha256(k_region, 32, (const unsigned char*)service, strlen(service), k_service);
-
+    // Signing key (derived once per day, region and service)
     unsigned char signing_key[32];
-    hmac_sha256(k_service, 32, (const unsigned char*)"aws4_request", 12, signing_key);
+    if (bedrock_derive_signing_key(creds, datestamp, region, service, signing_key) != 0) {
+        LOG_ERROR("Missing AWS secret access key for request signing");
+        free(timestamp);
+        free(datestamp);
+        free(host);
+        free(path);
+        free(encoded_path);
+        free(canonical_request_hash);
+        return NULL;
+    }
 
     // Calculate signature
     unsigned char signature_bytes[32];
@@ -1587,7 +1696,6 @@ struct curl_slist* bedrock_sign_request(
     free(host);
     free(path);
     free(encoded_path);
-    free(payload_hash);
     free(canonical_request_hash);
     free(signature);
 
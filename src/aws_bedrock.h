@@ -165,4 +165,35 @@ struct curl_slist* bedrock_sign_request(
     const char *service
 );
 
+/**
+ * Same as bedrock_sign_request(), with the payload already hashed by
+ * bedrock_payload_hash(). A request body that is signed more than once
+ * (retries after a credential refresh) is then hashed only once.
+ */
+struct curl_slist* bedrock_sign_request_hashed(
+    struct curl_slist *headers,
+    const char *method,
+    const char *url,
+    const char *payload_hash,
+    const AWSCredentials *creds,
+    const char *region,
+    const char *service
+);
+
+/**
+ * Hex SHA-256 of a request body, as SigV4 signs it
+ * out receives 64 hex digits and a NUL
+ */
+void bedrock_payload_hash(const char *payload, size_t len, char out[65]);
+
+/**
+ * Derive the SigV4 signing key for creds on datestamp (YYYYMMDD) in
+ * region for service. Keys are cached per credentials, date, region and
+ * service, so rotated credentials or a new day derive a new one.
+ * Returns: 0 on success, -1 if the secret access key is missing
+ */
+int bedrock_derive_signing_key(const AWSCredentials *creds, const char *datestamp,
+                               const char *region, const char *service,
+                               unsigned char key[32]);
+
 #endif // AWS_BEDROCK_H
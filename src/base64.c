@@ -72,25 +72,13 @@ char *base64_encode(const unsigned char *data, size_t input_length, size_t *outp
     return encoded_data;
 }
 
-unsigned char *base64_decode(const char *data, size_t input_length, size_t *output_length) {
-    if (!data || !output_length) {
-        return NULL;
-    }
-
-    // Skip padding characters at the end
-    while (input_length > 0 && data[input_length - 1] == '=') {
-        input_length--;
-    }
-
+// Decode input_length characters (padding already stripped) into out,
+// which may be data itself: each group of four is read before its three
+// bytes are written, and the writes never pass the reads
+static size_t decode_into(const char *data, size_t input_length, unsigned char *out) {
     // Calculate output length: floor(input_length * 3 / 4)
     size_t decoded_length = (input_length * 3) / 4;
 
-    // Allocate output buffer
-    unsigned char *decoded_data = malloc(decoded_length + 1);
-    if (!decoded_data) {
-        return NULL;
-    }
-
     size_t i = 0;
     size_t j = 0;
 
@@ -112,14 +100,50 @@ unsigned char *base64_decode(const char *data, size_t input_length, size_t *outp
         unsigned int triple = ((unsigned int)sextet_a << 18) + ((unsigned int)sextet_b << 12) + ((unsigned int)sextet_c << 6) + sextet_d;
 
         // Extract 3 bytes
-        if (j < decoded_length) decoded_data[j++] = (unsigned char)((triple >> 16) & 0xFF);
-        if (j < decoded_length) decoded_data[j++] = (unsigned char)((triple >> 8) & 0xFF);
-        if (j < decoded_length) decoded_data[j++] = (unsigned char)(triple & 0xFF);
+        if (j < decoded_length) out[j++] = (unsigned char)((triple >> 16) & 0xFF);
+        if (j < decoded_length) out[j++] = (unsigned char)((triple >> 8) & 0xFF);
+        if (j < decoded_length) out[j++] = (unsigned char)(triple & 0xFF);
+    }
+
+    return decoded_length;
+}
+
+unsigned char *base64_decode(const char *data, size_t input_length, size_t *output_length) {
+    if (!data || !output_length) {
+        return NULL;
+    }
+
+    // Skip padding characters at the end
+    while (input_length > 0 && data[input_length - 1] == '=') {
+        input_length--;
+    }
+
+    // Allocate output buffer
+    unsigned char *decoded_data = malloc((input_length * 3) / 4 + 1);
+    if (!decoded_data) {
+        return NULL;
     }
 
+    size_t decoded_length = decode_into(data, input_length, decoded_data);
+
     // Null terminate for safety (though this is binary data)
     decoded_data[decoded_length] = '\0';
     *output_length = decoded_length;
 
     return decoded_data;
 }
+
+size_t base64_decode_in_place(char *data, size_t input_length) {
+    if (!data) {
+        return 0;
+    }
+
+    // Skip padding characters at the end
+    while (input_length > 0 && data[input_length - 1] == '=') {
+        input_length--;
+    }
+
+    size_t decoded_length = decode_into(data, input_length, (unsigned char *)data);
+    data[decoded_length] = '\0';
+    return decoded_length;
+}
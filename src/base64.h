@@ -25,4 +25,11 @@ char *base64_encode(const unsigned char *data, size_t input_length, size_t *outp
 // Caller must free the returned buffer
 unsigned char *base64_decode(const char *data, size_t input_length, size_t *output_length);
 
+// Base64 decode a string over itself, for payloads too large to copy
+// Parameters:
+//   data - base64 encoded string, replaced by the decoded bytes
+//   input_length - length of input string
+// Returns: decoded data length (a NUL follows the decoded bytes)
+size_t base64_decode_in_place(char *data, size_t input_length);
+
 #endif // BASE64_H
@@ -7,6 +7,8 @@
 #include "claude_internal.h"  // Must be first to get ApiResponse definition
 #include "bedrock_provider.h"
 #include "logger.h"
+#include "trace.h"
+#include "arena.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -117,14 +119,17 @@ static char* headers_to_json(struct curl_slist *headers) {
 
 /**
  * Helper: Execute a single HTTP request with current credentials
+ * The body is hashed once by the caller (payload_hash), since a request
+ * retried with refreshed credentials is signed again over the same body.
  * Returns: ApiCallResult (caller must free fields)
  */
-static ApiCallResult bedrock_execute_request(BedrockConfig *config, const char *bedrock_json) {
+static ApiCallResult bedrock_execute_request(BedrockConfig *config, const char *bedrock_json,
+                                             size_t bedrock_json_len, const char *payload_hash) {
     ApiCallResult result = {0};
 
     // Sign request with SigV4 using current credentials
-    struct curl_slist *headers = bedrock_sign_request(
-        NULL, "POST", config->endpoint, bedrock_json,
+    struct curl_slist *headers = bedrock_sign_request_hashed(
+        NULL, "POST", config->endpoint, payload_hash,
         config->creds, config->region, AWS_BEDROCK_SERVICE
     );
 
@@ -150,6 +155,7 @@ static ApiCallResult bedrock_execute_request(BedrockConfig *config, const char *
     curl_easy_setopt(curl, CURLOPT_URL, config->endpoint);
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
     curl_easy_setopt(curl, CURLOPT_POSTFIELDS, bedrock_json);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)bedrock_json_len);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
 
@@ -164,8 +170,10 @@ static ApiCallResult bedrock_execute_request(BedrockConfig *config, const char *
 
     struct timespec start, end;
     clock_gettime(CLOCK_MONOTONIC, &start);
+    int64_t perform_start_us = trace_now_us();
     CURLcode res = curl_easy_perform(curl);
     clock_gettime(CLOCK_MONOTONIC, &end);
+    trace_curl_phases(curl, "bedrock", perform_start_us);
 
     result.duration_ms = (end.tv_sec - start.tv_sec) * 1000 +
                          (end.tv_nsec - start.tv_nsec) / 1000000;
@@ -431,8 +439,11 @@ static ApiCallResult bedrock_call_api(Provider *self, ConversationState *state)
     }
 
     // === Build request (do this once, reuse for retries) ===
+    // Intermediate trees are dead once serialized, so build them in the turn arena
+    Arena *prev_arena = arena_cjson_push(arena_turn());
     char *openai_json = build_request_json_from_state(state);
     if (!openai_json) {
+        arena_cjson_pop(prev_arena);
         result.error_message = strdup("Failed to build request JSON");
         result.is_retryable = 0;
         free(saved_access_key);
@@ -440,6 +451,7 @@ static ApiCallResult bedrock_call_api(Provider *self, ConversationState *state)
     }
 
     char *bedrock_json = bedrock_convert_request(openai_json);
+    arena_cjson_pop(prev_arena);
     free(openai_json);
 
     if (!bedrock_json) {
@@ -449,6 +461,10 @@ static ApiCallResult bedrock_call_api(Provider *self, ConversationState *state)
         return result;
     }
 
+    size_t bedrock_json_len = strlen(bedrock_json);
+    char payload_hash[65];
+    bedrock_payload_hash(bedrock_json, bedrock_json_len, payload_hash);
+
     // Update profile from config if available
     if (config->creds && config->creds->profile) {
         profile = config->creds->profile;
@@ -456,7 +472,7 @@ static ApiCallResult bedrock_call_api(Provider *self, ConversationState *state)
 
     // === STEP 2: First API call attempt ===
     LOG_DEBUG("Executing first API call attempt...");
-    result = bedrock_execute_request(config, bedrock_json);
+    result = bedrock_execute_request(config, bedrock_json, bedrock_json_len, payload_hash);
 
     // Success on first try
     if (result.response) {
@@ -504,7 +520,7 @@ static ApiCallResult bedrock_call_api(Provider *self, ConversationState *state)
 
                 // === STEP 5: Retry with externally rotated credentials ===
                 LOG_DEBUG("Retrying API call with externally rotated credentials...");
-                result = bedrock_execute_request(config, bedrock_json);
+                result = bedrock_execute_request(config, bedrock_json, bedrock_json_len, payload_hash);
 
                 if (result.response) {
                     LOG_INFO("API call succeeded after using externally rotated credentials");
@@ -569,7 +585,7 @@ static ApiCallResult bedrock_call_api(Provider *self, ConversationState *state)
 
                         // === STEP 5: Retry with rotated credentials ===
                         LOG_DEBUG("Retrying API call with rotated credentials...");
-                        result = bedrock_execute_request(config, bedrock_json);
+                        result = bedrock_execute_request(config, bedrock_json, bedrock_json_len, payload_hash);
 
                         if (result.response) {
                             LOG_INFO("API call succeeded after credential rotation");
@@ -643,7 +659,7 @@ static ApiCallResult bedrock_call_api(Provider *self, ConversationState *state)
 
                     // === STEP 7: Final retry ===
                     LOG_DEBUG("Final API call attempt with re-rotated credentials...");
-                    result = bedrock_execute_request(config, bedrock_json);
+                    result = bedrock_execute_request(config, bedrock_json, bedrock_json_len, payload_hash);
 
                     if (result.response) {
                         LOG_INFO("API call succeeded on final retry");
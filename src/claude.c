@@ -107,6 +107,10 @@ static int bedrock_handle_auth_error(BedrockConfig *config, long http_status, co
 // Visual indicators for interactive mode
 #include "indicators.h"
 
+// Opt-in Chrome trace-event export (CLAUDE_C_TRACE)
+#include "trace.h"
+#include "arena.h"
+
 // Internal API for module access
 #include "claude_internal.h"
 #include "provider.h"  // For ApiCallResult and Provider definitions
@@ -120,6 +124,9 @@ static int bedrock_handle_auth_error(BedrockConfig *config, long http_status, co
 #include "message_queue.h"
 #include "ai_worker.h"
 
+// In-process diff for Write/Edit
+#include "line_diff.h"
+
 // AWS Bedrock support
 #ifndef TEST_BUILD
 #include "aws_bedrock.h"
@@ -129,6 +136,7 @@ static int bedrock_handle_auth_error(BedrockConfig *config, long http_status, co
 #ifndef TEST_BUILD
 #include "mcp.h"
 #endif
+#include "tool_registry.h"
 
 // Base64 encoding/decoding for binary content
 #include "base64.h"
@@ -607,6 +615,9 @@ cJSON* tool_todo_write(cJSON *params, ConversationState *state);
 cJSON* tool_bash(cJSON *params, ConversationState *state);
 static cJSON* tool_sleep(cJSON *params, ConversationState *state);
 static cJSON* tool_upload_image(cJSON *params, ConversationState *state);
+char* str_replace_all(const char *content, const char *old_str, const char *new_str, int *replace_count);
+char* regex_replace(const char *content, const char *pattern, const char *replacement,
+                    int replace_all, int *replace_count, char **error_msg);
 #else
 #define STATIC static
 // Forward declarations
@@ -1003,83 +1014,207 @@ static const char* format_file_size(size_t size) {
 // Diff Functionality
 // ============================================================================
 
-// Show unified diff between original content and current file
-// Returns 0 on success, -1 on error
-static int show_diff(const char *file_path, const char *original_content) {
-    // Create temporary file for original content
-    char temp_path[PATH_MAX];
-    snprintf(temp_path, sizeof(temp_path), "%s.claude_diff.XXXXXX", file_path);
-
-    int fd = mkstemp(temp_path);
-    if (fd == -1) {
-        LOG_ERROR("Failed to create temporary file for diff");
-        return -1;
-    }
-
-    // Write original content to temp file
-    size_t content_len = strlen(original_content);
-    ssize_t written = write(fd, original_content, content_len);
-    close(fd);
+#define DIFF_INLINE_MAX_LINES 120    // Diff lines shown per edit before collapsing
 
-    if (written < 0 || (size_t)written != content_len) {
-        LOG_ERROR("Failed to write original content to temp file");
-        unlink(temp_path);
-        return -1;
-    }
-
-    // Run diff command to show changes
-    char diff_cmd[PATH_MAX * 2];
-    snprintf(diff_cmd, sizeof(diff_cmd), "diff -u \"%s\" \"%s\"", temp_path, file_path);
+// Diff of the last Write/Edit, kept so /diff can expand collapsed hunks.
+// Tools may run on several threads, the command on the main thread.
+static pthread_mutex_t g_last_diff_mutex = PTHREAD_MUTEX_INITIALIZER;
+static LineDiff g_last_diff;
+static char g_last_diff_path[PATH_MAX];
 
-    FILE *pipe = popen(diff_cmd, "r");
-    if (!pipe) {
-        LOG_ERROR("Failed to run diff command");
-        unlink(temp_path);
-        return -1;
-    }
+// Where diff lines go: the terminal in the tool's colors, or (for /diff on
+// the main thread) straight into the TUI conversation
+typedef struct {
+    const char *add_color;
+    const char *remove_color;
+    TUIState *tui;               // NULL = terminal; never set on tool threads
+} DiffColors;
 
-    // Get color codes for added and removed lines
-    char add_color[32], remove_color[32];
-    const char *add_color_str, *remove_color_str;
+static void get_diff_colors(DiffColors *colors, char *add_buf, char *remove_buf, size_t size) {
+    colors->tui = NULL;
 
     // Try to get colors from colorscheme, fall back to ANSI colors
-    if (get_colorscheme_color(COLORSCHEME_DIFF_ADD, add_color, sizeof(add_color)) == 0) {
-        add_color_str = add_color;
+    if (get_colorscheme_color(COLORSCHEME_DIFF_ADD, add_buf, size) == 0) {
+        colors->add_color = add_buf;
     } else {
         LOG_WARN("Using fallback ANSI color for DIFF_ADD");
-        add_color_str = ANSI_FALLBACK_DIFF_ADD;
+        colors->add_color = ANSI_FALLBACK_DIFF_ADD;
     }
 
-    if (get_colorscheme_color(COLORSCHEME_DIFF_REMOVE, remove_color, sizeof(remove_color)) == 0) {
-        remove_color_str = remove_color;
+    if (get_colorscheme_color(COLORSCHEME_DIFF_REMOVE, remove_buf, size) == 0) {
+        colors->remove_color = remove_buf;
     } else {
         LOG_WARN("Using fallback ANSI color for DIFF_REMOVE");
-        remove_color_str = ANSI_FALLBACK_DIFF_REMOVE;
+        colors->remove_color = ANSI_FALLBACK_DIFF_REMOVE;
     }
+}
 
-    // Read and display diff output with simple indentation
-    char line[1024];
-    int has_diff = 0;
+// Add a diff line to the TUI conversation (test builds have no TUI)
+static void add_diff_tui_line(TUIState *tui, const char *line, TUIColorPair color) {
+#ifndef TEST_BUILD
+    tui_add_conversation_line(tui, "", line, color);
+#else
+    (void)tui; (void)line; (void)color;
+#endif
+}
 
-    while (fgets(line, sizeof(line), pipe)) {
-        has_diff = 1;
-        emit_diff_line(line, add_color_str, remove_color_str);
+static void emit_rendered_diff_line(void *ctx, const char *line) {
+    const DiffColors *colors = ctx;
+    if (colors->tui) {
+        // Same colors the TUI infers for queued diff lines
+        TUIColorPair color = COLOR_PAIR_DEFAULT;
+        if (line[0] == '+') {
+            color = COLOR_PAIR_USER;
+        } else if (line[0] == '-') {
+            color = COLOR_PAIR_ERROR;
+        } else if (line[0] == '@' && line[1] == '@') {
+            color = COLOR_PAIR_STATUS;
+        }
+        add_diff_tui_line(colors->tui, line, color);
+        return;
     }
+    emit_diff_line(line, colors->add_color, colors->remove_color);
+}
 
-    int result = pclose(pipe);
-    unlink(temp_path);
+static void emit_diff_note(const DiffColors *colors, const char *text) {
+    if (colors->tui) {
+        add_diff_tui_line(colors->tui, text, COLOR_PAIR_STATUS);
+    } else {
+        tool_emit_line(" ", text);
+    }
+}
+
+// Render hunks [first, last) with at most max_lines body lines in total
+// (< 0 = no limit); whatever does not fit is summarized with a /diff hint
+static void render_diff_hunks(const LineDiff *diff, int first, int last, int max_lines,
+                              DiffColors *colors) {
+    char note[160];
+    int budget = max_lines;
+    int h = first;
+    for (; h < last && budget != 0; h++) {
+        int hidden = line_diff_render_hunk(diff, h, budget, emit_rendered_diff_line, colors);
+        if (hidden < 0) {
+            return;
+        }
+        if (budget > 0) {
+            budget -= diff->hunks[h].op_count - hidden;
+        }
+        if (hidden > 0) {
+            snprintf(note, sizeof(note), "... %d more line(s) in hunk %d (/diff %d to expand)",
+                     hidden, h + 1, h + 1);
+            emit_diff_note(colors, note);
+            h++;
+            break;
+        }
+    }
+
+    if (h < last) {
+        int added = 0;
+        int removed = 0;
+        for (int k = h; k < last; k++) {
+            added += diff->hunks[k].added;
+            removed += diff->hunks[k].removed;
+        }
+        snprintf(note, sizeof(note), "... %d more hunk(s) collapsed, +%d -%d (/diff to expand)",
+                 last - h, added, removed);
+        emit_diff_note(colors, note);
+    }
+}
+
+// Show unified diff between original and new content of a file, computed in
+// process. Large diffs are shown up to DIFF_INLINE_MAX_LINES lines and the
+// rest is kept for /diff.
+// Returns 0 on success, -1 on error
+static int show_diff(const char *file_path, const char *original_content, const char *new_content) {
+    LineDiff diff;
+    if (line_diff_compute(&diff, original_content, new_content, LINE_DIFF_CONTEXT) != 0) {
+        LOG_ERROR("Failed to compute diff for %s", file_path);
+        return -1;
+    }
 
-    if (!has_diff) {
+    if (diff.hunk_count == 0) {
         tool_emit_line(" ", "(No changes - files are identical)");
-    } else if (result == 0) {
-        // diff exit code 0 means no differences found
-        tool_emit_line(" ", "(No differences found)");
+        line_diff_free(&diff);
+        return 0;
     }
 
+    char add_color[32], remove_color[32];
+    DiffColors colors;
+    get_diff_colors(&colors, add_color, remove_color, sizeof(add_color));
+
+    char header[PATH_MAX + 16];
+    snprintf(header, sizeof(header), "--- %s (before)", file_path);
+    emit_diff_line(header, colors.add_color, colors.remove_color);
+    snprintf(header, sizeof(header), "+++ %s", file_path);
+    emit_diff_line(header, colors.add_color, colors.remove_color);
+    render_diff_hunks(&diff, 0, diff.hunk_count, DIFF_INLINE_MAX_LINES, &colors);
+
+    pthread_mutex_lock(&g_last_diff_mutex);
+    line_diff_free(&g_last_diff);
+    g_last_diff = diff;  // Ownership moves to the /diff store
+    snprintf(g_last_diff_path, sizeof(g_last_diff_path), "%s", file_path);
+    pthread_mutex_unlock(&g_last_diff_mutex);
 
     return 0;
 }
 
+// /diff: print the last diff to the terminal, or add it to tui when set
+static int show_last_diff_to(TUIState *tui, const char *args) {
+    char add_color[32], remove_color[32];
+    DiffColors colors;
+    get_diff_colors(&colors, add_color, remove_color, sizeof(add_color));
+    colors.tui = tui;
+
+    while (args && (*args == ' ' || *args == '\t')) {
+        args++;
+    }
+    int hunk = 0;
+    if (args && *args) {
+        char *end = NULL;
+        long value = strtol(args, &end, 10);
+        if (value <= 0 || value > INT_MAX || (end && *end && *end != ' ')) {
+            emit_diff_note(&colors, "Usage: /diff [hunk-number]");
+            return 0;
+        }
+        hunk = (int)value;
+    }
+
+    pthread_mutex_lock(&g_last_diff_mutex);
+    if (g_last_diff.hunk_count == 0) {
+        emit_diff_note(&colors, "(No file changes to show yet)");
+    } else if (hunk > g_last_diff.hunk_count) {
+        char note[96];
+        snprintf(note, sizeof(note), "(No hunk %d; the last diff has %d)",
+                 hunk, g_last_diff.hunk_count);
+        emit_diff_note(&colors, note);
+    } else {
+        char header[PATH_MAX + 16];
+        snprintf(header, sizeof(header), "--- %s (before)", g_last_diff_path);
+        emit_rendered_diff_line(&colors, header);
+        snprintf(header, sizeof(header), "+++ %s", g_last_diff_path);
+        emit_rendered_diff_line(&colors, header);
+#ifndef TEST_BUILD
+        if (tui) {
+            tui_begin_conversation_batch(tui);
+        }
+#endif
+        int first = hunk > 0 ? hunk - 1 : 0;
+        int last = hunk > 0 ? hunk : g_last_diff.hunk_count;
+        render_diff_hunks(&g_last_diff, first, last, -1, &colors);
+#ifndef TEST_BUILD
+        if (tui) {
+            tui_end_conversation_batch(tui);
+        }
+#endif
+    }
+    pthread_mutex_unlock(&g_last_diff_mutex);
+    return 0;
+}
+
+int show_last_diff(const char *args) {
+    return show_last_diff_to(NULL, args);
+}
+
 // ============================================================================
 // Tool Implementations
 // ============================================================================
@@ -1604,7 +1739,7 @@ STATIC cJSON* tool_write(cJSON *params, ConversationState *state) {
     // Show diff if write was successful
     if (ret == 0) {
         if (original_content) {
-            show_diff(resolved_path, original_content);
+            show_diff(resolved_path, original_content, content_json->valuestring);
         } else {
             // New file creation - show content as diff with all lines added
             char header[PATH_MAX + 64];
@@ -1856,7 +1991,10 @@ static void *tool_thread_func(void *arg) {
     // Execute the tool
     TUIMessageQueue *previous_queue = g_active_tool_queue;
     g_active_tool_queue = t->queue;
+    TraceSpan span;
+    trace_span_begin(&span, t->tool_name, "tool");
     cJSON *res = execute_tool(t->tool_name, t->input, t->state);
+    trace_span_end(&span, "\"error\":%s", cJSON_HasObjectItem(res, "error") ? "true" : "false");
     g_active_tool_queue = previous_queue;
     // Free input JSON
     cJSON_Delete(t->input);
@@ -1892,7 +2030,7 @@ static void *tool_thread_func(void *arg) {
 }
 
 // Helper function for simple string multi-replace
-static char* str_replace_all(const char *content, const char *old_str, const char *new_str, int *replace_count) {
+STATIC char* str_replace_all(const char *content, const char *old_str, const char *new_str, int *replace_count) {
     *replace_count = 0;
 
     // Count occurrences
@@ -1931,7 +2069,7 @@ static char* str_replace_all(const char *content, const char *old_str, const cha
 }
 
 // Helper function for regex replacement
-static char* regex_replace(const char *content, const char *pattern, const char *replacement,
+STATIC char* regex_replace(const char *content, const char *pattern, const char *replacement,
                           int replace_all, int *replace_count, char **error_msg) {
     *replace_count = 0;
 
@@ -2304,7 +2442,7 @@ STATIC cJSON* tool_edit(cJSON *params, ConversationState *state) {
 
     // Show diff if edit was successful
     if (ret == 0) {
-        show_diff(resolved_path, original_content);
+        show_diff(resolved_path, original_content, new_content);
     }
 
     free(content);
@@ -2942,28 +3080,128 @@ static cJSON* tool_call_mcp_tool(cJSON *params, ConversationState *state) {
 
 typedef struct {
     const char *name;
-    cJSON* (*handler)(cJSON *params, ConversationState *state);
+    ToolHandler handler;
+    int needs_mcp;      // Offered only when MCP servers are configured
 } Tool;
 
+// Built-in tools, in the order their definitions are offered
 static Tool tools[] = {
-    {"Sleep", tool_sleep},
-    {"Bash", tool_bash},
-    {"Read", tool_read},
-    {"Write", tool_write},
-    {"Edit", tool_edit},
-    {"Glob", tool_glob},
-    {"Grep", tool_grep},
-    {"TodoWrite", tool_todo_write},
-    {"UploadImage", tool_upload_image},
+    {"Sleep", tool_sleep, 0},
+    {"Bash", tool_bash, 0},
+    {"Read", tool_read, 0},
+    {"Write", tool_write, 0},
+    {"Edit", tool_edit, 0},
+    {"Glob", tool_glob, 0},
+    {"Grep", tool_grep, 0},
+    {"UploadImage", tool_upload_image, 0},
+    {"TodoWrite", tool_todo_write, 0},
 #ifndef TEST_BUILD
-    {"ListMcpResources", tool_list_mcp_resources},
-    {"ReadMcpResource", tool_read_mcp_resource},
-    {"CallMcpTool", tool_call_mcp_tool},
+    {"ListMcpResources", tool_list_mcp_resources, 1},
+    {"ReadMcpResource", tool_read_mcp_resource, 1},
+    {"CallMcpTool", tool_call_mcp_tool, 1},
 #endif
 };
 
 static const int num_tools = sizeof(tools) / sizeof(Tool);
 
+// Every tool by the name the model calls it: the built-in tools above, then
+// the tools of the MCP config last synced in. Readers resolve names under the
+// read lock; a sync swaps the MCP entries under the write lock.
+static ToolRegistry tool_registry;
+static pthread_rwlock_t tool_registry_lock = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_once_t tool_registry_once = PTHREAD_ONCE_INIT;
+#ifndef TEST_BUILD
+static MCPConfig *tool_registry_mcp = NULL;             // Config the MCP entries came from
+static unsigned long tool_registry_mcp_generation = 0;  // mcp_tools_generation() at that time
+#endif
+
+static cJSON* build_builtin_tool_definitions(void);
+
+static const char* tool_definition_name(const cJSON *definition) {
+    const cJSON *func = cJSON_GetObjectItem(definition, "function");
+    const cJSON *name = cJSON_GetObjectItem(func, "name");
+    return cJSON_IsString(name) ? name->valuestring : NULL;
+}
+
+static void tool_registry_setup(void) {
+    tool_registry_init(&tool_registry);
+
+    cJSON *definitions = build_builtin_tool_definitions();
+    for (int i = 0; i < num_tools; i++) {
+        cJSON *definition = NULL;
+        cJSON *def = NULL;
+        cJSON_ArrayForEach(def, definitions) {
+            const char *name = tool_definition_name(def);
+            if (name && strcmp(name, tools[i].name) == 0) {
+                definition = cJSON_DetachItemViaPointer(definitions, def);
+                break;
+            }
+        }
+        if (tool_registry_add_builtin(&tool_registry, tools[i].name, tools[i].handler,
+                                      tools[i].needs_mcp, definition) != 0) {
+            LOG_ERROR("Failed to register built-in tool '%s'", tools[i].name);
+        }
+    }
+    cJSON_Delete(definitions);
+    LOG_DEBUG("Tool registry: %d built-in tools", tool_registry.builtin_count);
+}
+
+#ifndef TEST_BUILD
+static void tool_registry_add_mcp_tool(void *ctx, MCPServer *server, const char *prefixed_name,
+                                       const char *tool_name, cJSON *definition) {
+    ToolRegistry *registry = (ToolRegistry *)ctx;
+    if (tool_registry_add_mcp(registry, prefixed_name, server, tool_name, definition) != 0) {
+        LOG_WARN("Tool registry: skipping MCP tool '%s' (name already taken)", prefixed_name);
+    }
+}
+#endif
+
+// Bring the MCP entries in line with the servers of the current config.
+// Callers may be building a request in the turn arena, but the definitions
+// live as long as the process, so they are built on the heap.
+static void tool_registry_sync(ConversationState *state) {
+    Arena *prev_arena = arena_cjson_push(NULL);
+    pthread_once(&tool_registry_once, tool_registry_setup);
+#ifndef TEST_BUILD
+    MCPConfig *config = state ? state->mcp_config : NULL;
+    unsigned long generation = mcp_tools_generation();
+
+    pthread_rwlock_rdlock(&tool_registry_lock);
+    int current = tool_registry_mcp == config && tool_registry_mcp_generation == generation;
+    pthread_rwlock_unlock(&tool_registry_lock);
+    if (current) {
+        arena_cjson_pop(prev_arena);
+        return;
+    }
+
+    pthread_rwlock_wrlock(&tool_registry_lock);
+    if (tool_registry_mcp != config || tool_registry_mcp_generation != generation) {
+        tool_registry_clear_mcp(&tool_registry);
+        if (config) {
+            mcp_visit_tools(config, tool_registry_add_mcp_tool, &tool_registry);
+        }
+        tool_registry_mcp = config;
+        tool_registry_mcp_generation = generation;
+        LOG_DEBUG("Tool registry: %d MCP tools",
+                  tool_registry.count - tool_registry.builtin_count);
+    }
+    pthread_rwlock_unlock(&tool_registry_lock);
+#else
+    (void)state;
+#endif
+    arena_cjson_pop(prev_arena);
+}
+
+#ifndef TEST_BUILD
+// Drop the MCP entries before their config is freed
+static void tool_registry_release_mcp(void) {
+    pthread_rwlock_wrlock(&tool_registry_lock);
+    tool_registry_clear_mcp(&tool_registry);
+    tool_registry_mcp = NULL;
+    pthread_rwlock_unlock(&tool_registry_lock);
+}
+#endif
+
 static cJSON* execute_tool(const char *tool_name, cJSON *input, ConversationState *state) {
     // Time the tool execution
     struct timespec start, end;
@@ -2977,141 +3215,151 @@ static cJSON* execute_tool(const char *tool_name, cJSON *input, ConversationStat
               tool_name, input_str ? input_str : "null");
     if (input_str) free(input_str);
 
-    // Try built-in tools first
-    for (int i = 0; i < num_tools; i++) {
-        if (strcmp(tools[i].name, tool_name) == 0) {
-            LOG_DEBUG("execute_tool: Found built-in tool '%s' at index %d", tool_name, i);
-            result = tools[i].handler(input, state);
-            break;
+    // One registry lookup resolves built-in and MCP tools alike; copy out
+    // what the call needs so the lock is not held while the tool runs
+    ToolHandler handler = NULL;
+#ifndef TEST_BUILD
+    MCPServer *server = NULL;
+    char actual_tool_name[256] = "";
+#endif
+    tool_registry_sync(state);
+    pthread_rwlock_rdlock(&tool_registry_lock);
+    const ToolEntry *entry = tool_registry_find(&tool_registry, tool_name);
+    if (entry) {
+        switch (entry->kind) {
+            case TOOL_KIND_BUILTIN:
+                handler = entry->handler;
+                break;
+            case TOOL_KIND_MCP:
+#ifndef TEST_BUILD
+                server = entry->server;
+                snprintf(actual_tool_name, sizeof(actual_tool_name), "%s", entry->mcp_name);
+#endif
+                break;
+            default:
+                break;
         }
     }
+    pthread_rwlock_unlock(&tool_registry_lock);
+
+    if (handler) {
+        LOG_DEBUG("execute_tool: Found built-in tool '%s'", tool_name);
+        result = handler(input, state);
+    }
 
 #ifndef TEST_BUILD
-    // If not found in built-in tools, try MCP tools
-    if (!result && state && state->mcp_config && strncmp(tool_name, "mcp_", 4) == 0) {
-        LOG_DEBUG("execute_tool: Tool '%s' matches MCP pattern, attempting MCP lookup", tool_name);
-        MCPServer *server = mcp_find_tool_server(state->mcp_config, tool_name);
-        if (server) {
-            LOG_DEBUG("execute_tool: Found MCP server '%s' for tool '%s'", server->name, tool_name);
-            // Extract the actual tool name (remove mcp_<server>_ prefix)
-            const char *actual_tool_name = strchr(tool_name + 4, '_');
-            if (actual_tool_name) {
-                actual_tool_name++;  // Skip the underscore
-
-                LOG_INFO("Calling MCP tool '%s' on server '%s' (original tool name: '%s')",
-                         actual_tool_name, server->name, tool_name);
-
-                MCPToolResult *mcp_result = mcp_call_tool(server, actual_tool_name, input);
-                if (mcp_result) {
-                    LOG_DEBUG("execute_tool: MCP tool call succeeded, is_error=%d", mcp_result->is_error);
-                    result = cJSON_CreateObject();
-
-                    if (mcp_result->is_error) {
-                        LOG_WARN("execute_tool: MCP tool returned error: %s",
-                                mcp_result->result ? mcp_result->result : "MCP tool error");
-                        cJSON_AddStringToObject(result, "error", mcp_result->result ? mcp_result->result : "MCP tool error");
+    if (!result && !server && strncmp(tool_name, "mcp_", 4) == 0) {
+        LOG_WARN("execute_tool: No MCP server found for tool '%s'", tool_name);
+    }
+
+    if (!result && server) {
+        LOG_DEBUG("execute_tool: Found MCP server '%s' for tool '%s'", server->name, tool_name);
+        LOG_INFO("Calling MCP tool '%s' on server '%s' (original tool name: '%s')",
+                 actual_tool_name, server->name, tool_name);
+
+        MCPToolResult *mcp_result = mcp_call_tool(server, actual_tool_name, input);
+        if (mcp_result) {
+            LOG_DEBUG("execute_tool: MCP tool call succeeded, is_error=%d", mcp_result->is_error);
+            result = cJSON_CreateObject();
+
+            if (mcp_result->is_error) {
+                LOG_WARN("execute_tool: MCP tool returned error: %s",
+                        mcp_result->result ? mcp_result->result : "MCP tool error");
+                cJSON_AddStringToObject(result, "error", mcp_result->result ? mcp_result->result : "MCP tool error");
+            } else {
+                LOG_DEBUG("execute_tool: MCP tool returned success, result length: %zu, blob size: %zu, mime_type: %s",
+                         mcp_result->result ? strlen(mcp_result->result) : 0,
+                         mcp_result->blob_size,
+                         mcp_result->mime_type ? mcp_result->mime_type : "none");
+
+                // Handle different content types
+                if (mcp_result->blob && mcp_result->blob_size > 0) {
+                    // Binary content (e.g., images) - auto-save to file
+                    const char *mime_type = mcp_result->mime_type ? mcp_result->mime_type : "application/octet-stream";
+
+                    // Generate appropriate filename based on tool and MIME type
+                    char filename[256];
+                    if (strncmp(actual_tool_name, "screenshot", 10) == 0 ||
+                        strncmp(actual_tool_name, "take_screenshot", 15) == 0) {
+                        generate_timestamped_filename(filename, sizeof(filename), "screenshot", mime_type);
+                    } else if (strncmp(mime_type, "image/", 6) == 0) {
+                        generate_timestamped_filename(filename, sizeof(filename), "image", mime_type);
                     } else {
-                        LOG_DEBUG("execute_tool: MCP tool returned success, result length: %zu, blob size: %zu, mime_type: %s",
-                                 mcp_result->result ? strlen(mcp_result->result) : 0,
-                                 mcp_result->blob_size,
-                                 mcp_result->mime_type ? mcp_result->mime_type : "none");
-
-                        // Handle different content types
-                        if (mcp_result->blob && mcp_result->blob_size > 0) {
-                            // Binary content (e.g., images) - auto-save to file
-                            const char *mime_type = mcp_result->mime_type ? mcp_result->mime_type : "application/octet-stream";
-
-                            // Generate appropriate filename based on tool and MIME type
-                            char filename[256];
-                            if (strncmp(actual_tool_name, "screenshot", 10) == 0 ||
-                                strncmp(actual_tool_name, "take_screenshot", 15) == 0) {
-                                generate_timestamped_filename(filename, sizeof(filename), "screenshot", mime_type);
-                            } else if (strncmp(mime_type, "image/", 6) == 0) {
-                                generate_timestamped_filename(filename, sizeof(filename), "image", mime_type);
-                            } else {
-                                generate_timestamped_filename(filename, sizeof(filename), "file", mime_type);
-                            }
+                        generate_timestamped_filename(filename, sizeof(filename), "file", mime_type);
+                    }
 
-                            // Save binary data to file
-                            int save_result = save_binary_file(filename, mcp_result->blob, mcp_result->blob_size);
-
-                            if (save_result == 0) {
-                                // Success - encode base64 for image content (if it's an image)
-                                int is_image = (strncmp(mime_type, "image/", 6) == 0);
-
-                                if (is_image) {
-                                    // For images, encode to base64 and mark as image content
-                                    // This allows the TUI to display it properly like UploadImage
-                                    size_t encoded_size = 0;
-                                    char *encoded_data = base64_encode(mcp_result->blob, mcp_result->blob_size, &encoded_size);
-                                    if (encoded_data) {
-                                        cJSON_AddStringToObject(result, "content_type", "image");
-                                        cJSON_AddStringToObject(result, "file_path", filename);
-                                        cJSON_AddStringToObject(result, "mime_type", mime_type);
-                                        cJSON_AddStringToObject(result, "base64_data", encoded_data);
-                                        cJSON_AddNumberToObject(result, "file_size_bytes", (double)mcp_result->blob_size);
-                                        free(encoded_data);
-                                        LOG_INFO("execute_tool: Saved image to '%s' (%zu bytes)", filename, mcp_result->blob_size);
-                                    } else {
-                                        // Encoding failed, fall back to file info only
-                                        LOG_WARN("execute_tool: Failed to encode image to base64, returning file info only");
-                                        cJSON_AddStringToObject(result, "status", "success");
-                                        cJSON_AddStringToObject(result, "message", "Image saved to file");
-                                        cJSON_AddStringToObject(result, "file_path", filename);
-                                        cJSON_AddStringToObject(result, "file_type", mime_type);
-                                        cJSON_AddNumberToObject(result, "file_size_bytes", (double)mcp_result->blob_size);
-                                        cJSON_AddStringToObject(result, "file_size_human", format_file_size(mcp_result->blob_size));
-                                    }
-                                } else {
-                                    // For non-image binary content, return file info only
-                                    cJSON_AddStringToObject(result, "status", "success");
-                                    cJSON_AddStringToObject(result, "message", "Binary content saved to file");
-                                    cJSON_AddStringToObject(result, "file_path", filename);
-                                    cJSON_AddStringToObject(result, "file_type", mime_type);
-                                    cJSON_AddNumberToObject(result, "file_size_bytes", (double)mcp_result->blob_size);
-                                    cJSON_AddStringToObject(result, "file_size_human", format_file_size(mcp_result->blob_size));
-                                    LOG_INFO("execute_tool: Saved binary content to '%s' (%zu bytes)", filename, mcp_result->blob_size);
-                                }
-                            } else {
-                                // Failed to save - fall back to base64 (but this shouldn't happen)
-                                LOG_WARN("execute_tool: Failed to save binary content to file, falling back to base64");
-                                cJSON_AddStringToObject(result, "content_type", "binary");
+                    // Save binary data to file
+                    int save_result = save_binary_file(filename, mcp_result->blob, mcp_result->blob_size);
+
+                    if (save_result == 0) {
+                        // Success - encode base64 for image content (if it's an image)
+                        int is_image = (strncmp(mime_type, "image/", 6) == 0);
+
+                        if (is_image) {
+                            // For images, encode to base64 and mark as image content
+                            // This allows the TUI to display it properly like UploadImage
+                            size_t encoded_size = 0;
+                            char *encoded_data = base64_encode(mcp_result->blob, mcp_result->blob_size, &encoded_size);
+                            if (encoded_data) {
+                                cJSON_AddStringToObject(result, "content_type", "image");
+                                cJSON_AddStringToObject(result, "file_path", filename);
                                 cJSON_AddStringToObject(result, "mime_type", mime_type);
-
-                                size_t encoded_size = 0;
-                                char *encoded_data = base64_encode(mcp_result->blob, mcp_result->blob_size, &encoded_size);
-                                if (encoded_data) {
-                                    cJSON_AddStringToObject(result, "content", encoded_data);
-                                    free(encoded_data);
-                                } else {
-                                    cJSON_AddStringToObject(result, "content", "[binary data received - saving and encoding failed]");
-                                }
+                                cJSON_AddStringToObject(result, "base64_data", encoded_data);
+                                cJSON_AddNumberToObject(result, "file_size_bytes", (double)mcp_result->blob_size);
+                                free(encoded_data);
+                                LOG_INFO("execute_tool: Saved image to '%s' (%zu bytes)", filename, mcp_result->blob_size);
+                            } else {
+                                // Encoding failed, fall back to file info only
+                                LOG_WARN("execute_tool: Failed to encode image to base64, returning file info only");
+                                cJSON_AddStringToObject(result, "status", "success");
+                                cJSON_AddStringToObject(result, "message", "Image saved to file");
+                                cJSON_AddStringToObject(result, "file_path", filename);
+                                cJSON_AddStringToObject(result, "file_type", mime_type);
+                                cJSON_AddNumberToObject(result, "file_size_bytes", (double)mcp_result->blob_size);
+                                cJSON_AddStringToObject(result, "file_size_human", format_file_size(mcp_result->blob_size));
                             }
                         } else {
-                            // Text content
-                            cJSON_AddStringToObject(result, "content_type", "text");
-                            if (mcp_result->mime_type) {
-                                cJSON_AddStringToObject(result, "mime_type", mcp_result->mime_type);
-                            }
-                            cJSON_AddStringToObject(result, "content", mcp_result->result ? mcp_result->result : "");
+                            // For non-image binary content, return file info only
+                            cJSON_AddStringToObject(result, "status", "success");
+                            cJSON_AddStringToObject(result, "message", "Binary content saved to file");
+                            cJSON_AddStringToObject(result, "file_path", filename);
+                            cJSON_AddStringToObject(result, "file_type", mime_type);
+                            cJSON_AddNumberToObject(result, "file_size_bytes", (double)mcp_result->blob_size);
+                            cJSON_AddStringToObject(result, "file_size_human", format_file_size(mcp_result->blob_size));
+                            LOG_INFO("execute_tool: Saved binary content to '%s' (%zu bytes)", filename, mcp_result->blob_size);
                         }
-                    }
+                    } else {
+                        // Failed to save - fall back to base64 (but this shouldn't happen)
+                        LOG_WARN("execute_tool: Failed to save binary content to file, falling back to base64");
+                        cJSON_AddStringToObject(result, "content_type", "binary");
+                        cJSON_AddStringToObject(result, "mime_type", mime_type);
 
-                    mcp_free_tool_result(mcp_result);
+                        size_t encoded_size = 0;
+                        char *encoded_data = base64_encode(mcp_result->blob, mcp_result->blob_size, &encoded_size);
+                        if (encoded_data) {
+                            cJSON_AddStringToObject(result, "content", encoded_data);
+                            free(encoded_data);
+                        } else {
+                            cJSON_AddStringToObject(result, "content", "[binary data received - saving and encoding failed]");
+                        }
+                    }
                 } else {
-                    LOG_ERROR("execute_tool: MCP tool call failed for tool '%s' on server '%s'",
-                              actual_tool_name, server->name);
-                    result = cJSON_CreateObject();
-                    cJSON_AddStringToObject(result, "error", "MCP tool call failed");
+                    // Text content
+                    cJSON_AddStringToObject(result, "content_type", "text");
+                    if (mcp_result->mime_type) {
+                        cJSON_AddStringToObject(result, "mime_type", mcp_result->mime_type);
+                    }
+                    cJSON_AddStringToObject(result, "content", mcp_result->result ? mcp_result->result : "");
                 }
-            } else {
-                LOG_ERROR("execute_tool: Failed to extract actual tool name from '%s'", tool_name);
             }
+
+            mcp_free_tool_result(mcp_result);
         } else {
-            LOG_WARN("execute_tool: No MCP server found for tool '%s'", tool_name);
+            LOG_ERROR("execute_tool: MCP tool call failed for tool '%s' on server '%s'",
+                      actual_tool_name, server->name);
+            result = cJSON_CreateObject();
+            cJSON_AddStringToObject(result, "error", "MCP tool call failed");
         }
-    } else if (!result && state && state->mcp_config) {
-        LOG_DEBUG("execute_tool: Tool '%s' not found in built-in tools and doesn't match MCP pattern", tool_name);
     }
 #endif
 
@@ -3140,10 +3388,8 @@ static cJSON* execute_tool(const char *tool_name, cJSON *input, ConversationStat
 // Tool Definitions for API
 // ============================================================================
 
-// Forward declaration for cache_control helper
-
-
-cJSON* get_tool_definitions(ConversationState *state, int enable_caching) {
+// Definitions of the built-in tools, registered once at startup
+static cJSON* build_builtin_tool_definitions(void) {
     cJSON *tool_array = cJSON_CreateArray();
     // Sleep tool
     cJSON *sleep_tool = cJSON_CreateObject();
@@ -3164,9 +3410,6 @@ cJSON* get_tool_definitions(ConversationState *state, int enable_caching) {
     cJSON_AddItemToObject(sleep_params, "required", sleep_req);
     cJSON_AddItemToObject(sleep_func, "parameters", sleep_params);
     cJSON_AddItemToObject(sleep_tool, "function", sleep_func);
-    if (enable_caching) {
-        add_cache_control(sleep_tool);
-    }
     cJSON_AddItemToArray(tool_array, sleep_tool);
 
     // Bash tool
@@ -3437,128 +3680,144 @@ cJSON* get_tool_definitions(ConversationState *state, int enable_caching) {
     cJSON_AddItemToObject(todo_params, "required", todo_req);
     cJSON_AddItemToObject(todo_func, "parameters", todo_params);
     cJSON_AddItemToObject(todo_tool, "function", todo_func);
+    cJSON_AddItemToArray(tool_array, todo_tool);
 
-    // Add cache_control to the last tool (TodoWrite) if caching is enabled
-    // This is the second cache breakpoint (tool definitions)
-    if (enable_caching) {
-        add_cache_control(todo_tool);
-    }
+#ifndef TEST_BUILD
+    // Built-in helper tools for MCP resources and generic invocation
+    // ListMcpResources tool
+    cJSON *list_res_tool = cJSON_CreateObject();
+    cJSON_AddStringToObject(list_res_tool, "type", "function");
+    cJSON *list_res_func = cJSON_CreateObject();
+    cJSON_AddStringToObject(list_res_func, "name", "ListMcpResources");
+    cJSON_AddStringToObject(list_res_func, "description",
+        "Lists available resources from configured MCP servers. "
+        "Each resource object includes a 'server' field indicating which server it's from.");
+    cJSON *list_res_params = cJSON_CreateObject();
+    cJSON_AddStringToObject(list_res_params, "type", "object");
+    cJSON *list_res_props = cJSON_CreateObject();
+    cJSON *server_prop = cJSON_CreateObject();
+    cJSON_AddStringToObject(server_prop, "type", "string");
+    cJSON_AddStringToObject(server_prop, "description",
+        "Optional server name to filter resources by. If not provided, resources from all servers will be returned.");
+    cJSON_AddItemToObject(list_res_props, "server", server_prop);
+    cJSON_AddItemToObject(list_res_params, "properties", list_res_props);
+    cJSON_AddItemToObject(list_res_func, "parameters", list_res_params);
+    cJSON_AddItemToObject(list_res_tool, "function", list_res_func);
+    cJSON_AddItemToArray(tool_array, list_res_tool);
+
+    // ReadMcpResource tool
+    cJSON *read_res_tool = cJSON_CreateObject();
+    cJSON_AddStringToObject(read_res_tool, "type", "function");
+    cJSON *read_res_func = cJSON_CreateObject();
+    cJSON_AddStringToObject(read_res_func, "name", "ReadMcpResource");
+    cJSON_AddStringToObject(read_res_func, "description",
+        "Reads a specific resource from an MCP server, identified by server name and resource URI.");
+    cJSON *read_res_params = cJSON_CreateObject();
+    cJSON_AddStringToObject(read_res_params, "type", "object");
+    cJSON *read_res_props = cJSON_CreateObject();
+    cJSON *read_server_prop = cJSON_CreateObject();
+    cJSON_AddStringToObject(read_server_prop, "type", "string");
+    cJSON_AddStringToObject(read_server_prop, "description", "The name of the MCP server to read from");
+    cJSON_AddItemToObject(read_res_props, "server", read_server_prop);
+    cJSON *uri_prop = cJSON_CreateObject();
+    cJSON_AddStringToObject(uri_prop, "type", "string");
+    cJSON_AddStringToObject(uri_prop, "description", "The URI of the resource to read");
+    cJSON_AddItemToObject(read_res_props, "uri", uri_prop);
+    cJSON_AddItemToObject(read_res_params, "properties", read_res_props);
+    cJSON *read_res_req = cJSON_CreateArray();
+    cJSON_AddItemToArray(read_res_req, cJSON_CreateString("server"));
+    cJSON_AddItemToArray(read_res_req, cJSON_CreateString("uri"));
+    cJSON_AddItemToObject(read_res_params, "required", read_res_req);
+    cJSON_AddItemToObject(read_res_func, "parameters", read_res_params);
+    cJSON_AddItemToObject(read_res_tool, "function", read_res_func);
+    cJSON_AddItemToArray(tool_array, read_res_tool);
+
+    // CallMcpTool tool (generic MCP tool invoker)
+    cJSON *call_tool = cJSON_CreateObject();
+    cJSON_AddStringToObject(call_tool, "type", "function");
+    cJSON *call_func = cJSON_CreateObject();
+    cJSON_AddStringToObject(call_func, "name", "CallMcpTool");
+    cJSON_AddStringToObject(call_func, "description",
+        "Calls a specific MCP tool by server and tool name with JSON arguments.");
+    cJSON *call_params = cJSON_CreateObject();
+    cJSON_AddStringToObject(call_params, "type", "object");
+    cJSON *call_props = cJSON_CreateObject();
+    cJSON *call_server_prop = cJSON_CreateObject();
+    cJSON_AddStringToObject(call_server_prop, "type", "string");
+    cJSON_AddStringToObject(call_server_prop, "description", "The MCP server name (as in config)");
+    cJSON_AddItemToObject(call_props, "server", call_server_prop);
+    cJSON *call_tool_prop = cJSON_CreateObject();
+    cJSON_AddStringToObject(call_tool_prop, "type", "string");
+    cJSON_AddStringToObject(call_tool_prop, "description", "The tool name exposed by the server");
+    cJSON_AddItemToObject(call_props, "tool", call_tool_prop);
+    cJSON *call_args_prop = cJSON_CreateObject();
+    cJSON_AddStringToObject(call_args_prop, "type", "object");
+    cJSON_AddStringToObject(call_args_prop, "description", "Arguments object per the tool's JSON schema");
+    cJSON_AddItemToObject(call_props, "arguments", call_args_prop);
+    cJSON_AddItemToObject(call_params, "properties", call_props);
+    cJSON *call_req = cJSON_CreateArray();
+    cJSON_AddItemToArray(call_req, cJSON_CreateString("server"));
+    cJSON_AddItemToArray(call_req, cJSON_CreateString("tool"));
+    cJSON_AddItemToObject(call_params, "required", call_req);
+    cJSON_AddItemToObject(call_func, "parameters", call_params);
+    cJSON_AddItemToObject(call_tool, "function", call_func);
+    cJSON_AddItemToArray(tool_array, call_tool);
+#endif
 
-    cJSON_AddItemToArray(tool_array, todo_tool);
+    return tool_array;
+}
 
+cJSON* get_tool_definitions(ConversationState *state, int enable_caching) {
+    cJSON *tool_array = cJSON_CreateArray();
+    int with_mcp = 0;
 #ifndef TEST_BUILD
-    // Add MCP tools if MCP is enabled and configured
-    if (state && state->mcp_config && mcp_is_enabled()) {
-        LOG_DEBUG("get_tool_definitions: Adding MCP tools to tool definitions");
-
-        // 1) Dynamic MCP tools discovered from servers
-        cJSON *mcp_tools = mcp_get_all_tools(state->mcp_config);
-        if (mcp_tools && cJSON_IsArray(mcp_tools)) {
-            int mcp_tool_count = cJSON_GetArraySize(mcp_tools);
-            LOG_DEBUG("get_tool_definitions: Found %d dynamic MCP tools", mcp_tool_count);
-            cJSON *t = NULL;
-            int idx = 0;
-            cJSON_ArrayForEach(t, mcp_tools) {
-                // Each t is already a full Claude tool definition object
-                cJSON *name_obj = cJSON_GetObjectItem(t, "name");
-                const char *tool_name = name_obj && cJSON_IsString(name_obj) ? name_obj->valuestring : "unknown";
-                LOG_DEBUG("get_tool_definitions: Adding dynamic MCP tool %d: '%s'", idx, tool_name);
-                cJSON_AddItemToArray(tool_array, cJSON_Duplicate(t, 1));
-                idx++;
+    with_mcp = state && state->mcp_config && mcp_is_enabled();
+#endif
+
+    tool_registry_sync(state);
+    pthread_rwlock_rdlock(&tool_registry_lock);
+
+    // Core built-in tools first, so their definitions form a stable prefix.
+    // The first and last carry the tool-definition cache breakpoints.
+    cJSON *first = NULL;
+    cJSON *last = NULL;
+    for (int i = 0; i < tool_registry.builtin_count; i++) {
+        const ToolEntry *entry = &tool_registry.entries[i];
+        if (entry->needs_mcp || !entry->definition) {
+            continue;
+        }
+        last = cJSON_Duplicate(entry->definition, 1);
+        cJSON_AddItemToArray(tool_array, last);
+        if (!first) {
+            first = last;
+        }
+    }
+    if (enable_caching && first) {
+        add_cache_control(first);
+        if (last != first) {
+            add_cache_control(last);
+        }
+    }
+
+    if (with_mcp) {
+        // Tools discovered from MCP servers, then the MCP helper tools
+        LOG_DEBUG("get_tool_definitions: Adding %d dynamic MCP tools",
+                  tool_registry.count - tool_registry.builtin_count);
+        for (int i = tool_registry.builtin_count; i < tool_registry.count; i++) {
+            if (tool_registry.entries[i].definition) {
+                cJSON_AddItemToArray(tool_array, cJSON_Duplicate(tool_registry.entries[i].definition, 1));
             }
-            cJSON_Delete(mcp_tools);
-        } else {
-            LOG_DEBUG("get_tool_definitions: No dynamic MCP tools found");
-        }
-
-        // 2) Built-in helper tools for MCP resources and generic invocation
-        LOG_DEBUG("get_tool_definitions: Adding built-in MCP resource tools");
-
-        // ListMcpResources tool
-        cJSON *list_res_tool = cJSON_CreateObject();
-        cJSON_AddStringToObject(list_res_tool, "type", "function");
-        cJSON *list_res_func = cJSON_CreateObject();
-        cJSON_AddStringToObject(list_res_func, "name", "ListMcpResources");
-        cJSON_AddStringToObject(list_res_func, "description",
-            "Lists available resources from configured MCP servers. "
-            "Each resource object includes a 'server' field indicating which server it's from.");
-        cJSON *list_res_params = cJSON_CreateObject();
-        cJSON_AddStringToObject(list_res_params, "type", "object");
-        cJSON *list_res_props = cJSON_CreateObject();
-        cJSON *server_prop = cJSON_CreateObject();
-        cJSON_AddStringToObject(server_prop, "type", "string");
-        cJSON_AddStringToObject(server_prop, "description",
-            "Optional server name to filter resources by. If not provided, resources from all servers will be returned.");
-        cJSON_AddItemToObject(list_res_props, "server", server_prop);
-        cJSON_AddItemToObject(list_res_params, "properties", list_res_props);
-        cJSON_AddItemToObject(list_res_func, "parameters", list_res_params);
-        cJSON_AddItemToObject(list_res_tool, "function", list_res_func);
-        cJSON_AddItemToArray(tool_array, list_res_tool);
-
-        // ReadMcpResource tool
-        cJSON *read_res_tool = cJSON_CreateObject();
-        cJSON_AddStringToObject(read_res_tool, "type", "function");
-        cJSON *read_res_func = cJSON_CreateObject();
-        cJSON_AddStringToObject(read_res_func, "name", "ReadMcpResource");
-        cJSON_AddStringToObject(read_res_func, "description",
-            "Reads a specific resource from an MCP server, identified by server name and resource URI.");
-        cJSON *read_res_params = cJSON_CreateObject();
-        cJSON_AddStringToObject(read_res_params, "type", "object");
-        cJSON *read_res_props = cJSON_CreateObject();
-        cJSON *read_server_prop = cJSON_CreateObject();
-        cJSON_AddStringToObject(read_server_prop, "type", "string");
-        cJSON_AddStringToObject(read_server_prop, "description", "The name of the MCP server to read from");
-        cJSON_AddItemToObject(read_res_props, "server", read_server_prop);
-        cJSON *uri_prop = cJSON_CreateObject();
-        cJSON_AddStringToObject(uri_prop, "type", "string");
-        cJSON_AddStringToObject(uri_prop, "description", "The URI of the resource to read");
-        cJSON_AddItemToObject(read_res_props, "uri", uri_prop);
-        cJSON_AddItemToObject(read_res_params, "properties", read_res_props);
-        cJSON *read_res_req = cJSON_CreateArray();
-        cJSON_AddItemToArray(read_res_req, cJSON_CreateString("server"));
-        cJSON_AddItemToArray(read_res_req, cJSON_CreateString("uri"));
-        cJSON_AddItemToObject(read_res_params, "required", read_res_req);
-        cJSON_AddItemToObject(read_res_func, "parameters", read_res_params);
-        cJSON_AddItemToObject(read_res_tool, "function", read_res_func);
-        cJSON_AddItemToArray(tool_array, read_res_tool);
-
-        // CallMcpTool tool (generic MCP tool invoker)
-        cJSON *call_tool = cJSON_CreateObject();
-        cJSON_AddStringToObject(call_tool, "type", "function");
-        cJSON *call_func = cJSON_CreateObject();
-        cJSON_AddStringToObject(call_func, "name", "CallMcpTool");
-        cJSON_AddStringToObject(call_func, "description",
-            "Calls a specific MCP tool by server and tool name with JSON arguments.");
-        cJSON *call_params = cJSON_CreateObject();
-        cJSON_AddStringToObject(call_params, "type", "object");
-        cJSON *call_props = cJSON_CreateObject();
-        cJSON *call_server_prop = cJSON_CreateObject();
-        cJSON_AddStringToObject(call_server_prop, "type", "string");
-        cJSON_AddStringToObject(call_server_prop, "description", "The MCP server name (as in config)");
-        cJSON_AddItemToObject(call_props, "server", call_server_prop);
-        cJSON *call_tool_prop = cJSON_CreateObject();
-        cJSON_AddStringToObject(call_tool_prop, "type", "string");
-        cJSON_AddStringToObject(call_tool_prop, "description", "The tool name exposed by the server");
-        cJSON_AddItemToObject(call_props, "tool", call_tool_prop);
-        cJSON *call_args_prop = cJSON_CreateObject();
-        cJSON_AddStringToObject(call_args_prop, "type", "object");
-        cJSON_AddStringToObject(call_args_prop, "description", "Arguments object per the tool's JSON schema");
-        cJSON_AddItemToObject(call_props, "arguments", call_args_prop);
-        cJSON_AddItemToObject(call_params, "properties", call_props);
-        cJSON *call_req = cJSON_CreateArray();
-        cJSON_AddItemToArray(call_req, cJSON_CreateString("server"));
-        cJSON_AddItemToArray(call_req, cJSON_CreateString("tool"));
-        cJSON_AddItemToObject(call_params, "required", call_req);
-        cJSON_AddItemToObject(call_func, "parameters", call_params);
-        cJSON_AddItemToObject(call_tool, "function", call_func);
-        cJSON_AddItemToArray(tool_array, call_tool);
-
-        LOG_INFO("Added MCP resource tools (ListMcpResources, ReadMcpResource)");
+        }
+        for (int i = 0; i < tool_registry.builtin_count; i++) {
+            const ToolEntry *entry = &tool_registry.entries[i];
+            if (entry->needs_mcp && entry->definition) {
+                cJSON_AddItemToArray(tool_array, cJSON_Duplicate(entry->definition, 1));
+            }
+        }
+        LOG_DEBUG("get_tool_definitions: Added MCP resource tools (ListMcpResources, ReadMcpResource, CallMcpTool)");
     }
-#else
-    (void)state;  // Suppress unused parameter warning in test builds
-#endif
 
+    pthread_rwlock_unlock(&tool_registry_lock);
     return tool_array;
 }
 
@@ -3595,10 +3854,14 @@ char* build_request_json_from_state(ConversationState *state) {
         return NULL;
     }
 
+    TraceSpan span;
+    trace_span_begin(&span, "build_request_json_from_state", "api");
+
     if (conversation_state_lock(state) != 0) {
         return NULL;
     }
 
+    int message_count = state->count;
     char *json_str = NULL;
 
     // Check if prompt caching is enabled
@@ -3686,7 +3949,7 @@ char* build_request_json_from_state(ConversationState *state) {
                         // Convert result to string
                         char *result_str = cJSON_PrintUnformatted(cb->tool_output);
                         cJSON_AddStringToObject(tool_msg, "content", result_str);
-                        free(result_str);
+                        cJSON_free(result_str);
                         cJSON_AddItemToArray(messages_array, tool_msg);
                     }
                 }
@@ -3766,7 +4029,7 @@ char* build_request_json_from_state(ConversationState *state) {
                     cJSON_AddStringToObject(function, "name", cb->tool_name);
                     char *args_str = cJSON_PrintUnformatted(cb->tool_params);
                     cJSON_AddStringToObject(function, "arguments", args_str);
-                    free(args_str);
+                    cJSON_free(args_str);
                     cJSON_AddItemToObject(tool_call, "function", function);
                     cJSON_AddItemToArray(tool_calls, tool_call);
                 }
@@ -3796,10 +4059,12 @@ char* build_request_json_from_state(ConversationState *state) {
     conversation_state_unlock(state);
     state = NULL;
 
-    json_str = cJSON_PrintUnformatted(request);
+    json_str = arena_cjson_print(request);
     cJSON_Delete(request);
 
-    LOG_DEBUG("Request built successfully (size: %zu bytes)", json_str ? strlen(json_str) : 0);
+    size_t json_len = json_str ? strlen(json_str) : 0;
+    LOG_DEBUG("Request built successfully (size: %zu bytes)", json_len);
+    trace_span_end(&span, "\"messages\":%d,\"bytes\":%zu", message_count, json_len);
     return json_str;
 
 unlock:
@@ -3807,6 +4072,7 @@ unlock:
     if (request) {
         cJSON_Delete(request);
     }
+    trace_span_end(&span, "\"messages\":%d,\"error\":true", message_count);
     return NULL;
 }
 
@@ -4022,7 +4288,15 @@ static ApiResponse* call_api_with_retries(ConversationState *state) {
 
         // Call provider's single-attempt API call
         LOG_DEBUG("API call attempt %d (elapsed: %ld ms)", attempt_num, elapsed_ms);
+        TraceSpan call_span;
+        trace_span_begin(&call_span, "call_api", "api");
         ApiCallResult result = state->provider->call_api(state->provider, state);
+        trace_span_end(&call_span, "\"provider\":\"%s\",\"attempt\":%d,\"http_status\":%ld",
+                       state->provider->name, attempt_num, result.http_status);
+
+        // End of the turn for request building: everything the provider put
+        // in the turn arena was serialized or discarded by now
+        arena_turn_reset();
 
         // Success case
         if (result.response) {
@@ -4044,6 +4318,8 @@ static ApiResponse* call_api_with_retries(ConversationState *state) {
                 // Tool count is already available in the ApiResponse
                 int tool_count = result.response->tool_count;
 
+                TraceSpan db_span;
+                trace_span_begin(&db_span, "persistence_log_api_call", "persistence");
                 persistence_log_api_call(
                     state->persistence_db,
                     state->session_id,
@@ -4058,6 +4334,7 @@ static ApiResponse* call_api_with_retries(ConversationState *state) {
                     result.duration_ms,
                     tool_count
                 );
+                trace_span_end(&db_span, "\"status\":\"success\"");
             }
 
             // Cleanup and return
@@ -4076,6 +4353,8 @@ static ApiResponse* call_api_with_retries(ConversationState *state) {
 
         // Log error to persistence
         if (state->persistence_db) {
+            TraceSpan db_span;
+            trace_span_begin(&db_span, "persistence_log_api_call", "persistence");
             persistence_log_api_call(
                 state->persistence_db,
                 state->session_id,
@@ -4090,6 +4369,7 @@ static ApiResponse* call_api_with_retries(ConversationState *state) {
                 result.duration_ms,
                 0
             );
+            trace_span_end(&db_span, "\"status\":\"error\"");
         }
 
         // Save last error details for potential timeout message
@@ -4185,10 +4465,13 @@ static ApiResponse* call_api_with_retries(ConversationState *state) {
 }
 
 /**
- * Main API call entry point
+ * Main API call entry point. Each call ends a turn, so the trace is
+ * flushed here: a crash loses at most the turn in progress.
  */
 static ApiResponse* call_api(ConversationState *state) {
-    return call_api_with_retries(state);
+    ApiResponse *response = call_api_with_retries(state);
+    trace_flush();
+    return response;
 }
 
 
@@ -5379,8 +5662,13 @@ static int submit_input_callback(const char *input, void *user_data) {
             close(devnull);
         }
 
-        // Use the command system from commands.c
-        int cmd_result = commands_execute(state, input_copy);
+        // Use the command system from commands.c; /diff writes to the TUI directly
+        int cmd_result;
+        if (strncmp(input_copy, "/diff", 5) == 0 && (input_copy[5] == '\0' || input_copy[5] == ' ')) {
+            cmd_result = show_last_diff_to(tui, input_copy + 5);
+        } else {
+            cmd_result = commands_execute(state, input_copy);
+        }
 
         // Restore stdout/stderr
         if (saved_stdout != -1) {
@@ -5534,6 +5822,13 @@ static int single_command_mode(ConversationState *state, const char *prompt) {
     // Enable oneshot/subagent mode for structured tool output
     g_oneshot_mode = 1;
 
+#ifndef TEST_BUILD
+    // There is no later turn to pick up slow MCP servers, so wait for them
+    if (state->mcp_config) {
+        mcp_wait_for_servers(state->mcp_config);
+    }
+#endif
+
     // Add user message to conversation
     add_user_message(state, prompt);
 
@@ -6082,6 +6377,10 @@ static char* generate_session_id(void) {
 // ============================================================================
 
 int main(int argc, char *argv[]) {
+    // cJSON_InitHooks is not thread safe: install the arena hooks before
+    // any thread (MCP startup, AI worker) uses cJSON
+    arena_cjson_init();
+
     // Handle version flag first (no API key needed)
     if (argc == 2 && strcmp(argv[1], "--version") == 0) {
         printf("Claude C version %s\n", CLAUDE_C_VERSION_FULL);
@@ -6119,7 +6418,9 @@ int main(int argc, char *argv[]) {
         printf("    CLAUDE_C_DB_PATH     Optional: Path to SQLite database for API history\n");
         printf("                         Default: ~/.local/share/claude-c/api_calls.db\n");
         printf("    CLAUDE_C_MAX_RETRY_DURATION_MS  Optional: Maximum retry duration in milliseconds\n");
-        printf("                                     Default: 600000 (10 minutes)\n\n");
+        printf("                                     Default: 600000 (10 minutes)\n");
+        printf("    CLAUDE_C_TRACE       Optional: Write Chrome trace events (chrome://tracing,\n");
+        printf("                         ui.perfetto.dev) for API calls and tools to this path\n\n");
         printf("  UI Customization:\n");
         printf("    CLAUDE_C_THEME       Optional: Path to Kitty theme file\n\n");
 
@@ -6240,6 +6541,13 @@ int main(int argc, char *argv[]) {
     LOG_INFO("API URL: %s", api_base);
     LOG_INFO("Model: %s", model);
 
+    // Optional trace-event export for profiling (CLAUDE_C_TRACE=path)
+    if (trace_init_from_env() != 0) {
+        LOG_WARN("Failed to open trace file '%s', tracing disabled", getenv("CLAUDE_C_TRACE"));
+    } else if (trace_enabled()) {
+        LOG_INFO("Writing trace events to %s", getenv("CLAUDE_C_TRACE"));
+    }
+
     // Initialize colorscheme EARLY (before any colored output/spinners)
     const char *theme = getenv("CLAUDE_C_THEME");
     if (theme && strlen(theme) > 0) {
@@ -6340,31 +6648,9 @@ int main(int argc, char *argv[]) {
         if (state.mcp_config) {
             LOG_INFO("MCP: Loaded %d server(s) from config", state.mcp_config->server_count);
 
-            // Connect to all configured servers
-            for (int i = 0; i < state.mcp_config->server_count; i++) {
-                MCPServer *server = state.mcp_config->servers[i];
-                LOG_DEBUG("MCP: Attempting to connect to server '%s'", server->name);
-                if (mcp_connect_server(server) == 0) {
-                    LOG_DEBUG("MCP: Connected to server '%s', discovering tools", server->name);
-                    // Discover tools from connected server
-                    int tool_count = mcp_discover_tools(server);
-                    if (tool_count > 0) {
-                        LOG_INFO("MCP: Server '%s' provides %d tool(s)", server->name, tool_count);
-                        // Log individual tool names
-                        for (int j = 0; j < tool_count; j++) {
-                            if (server->tools[j]) {
-                                LOG_DEBUG("MCP: Server '%s' tool %d: '%s'", server->name, j, server->tools[j]);
-                            }
-                        }
-                    } else if (tool_count == 0) {
-                        LOG_DEBUG("MCP: Server '%s' provides no tools", server->name);
-                    } else {
-                        LOG_WARN("MCP: Failed to discover tools from server '%s'", server->name);
-                    }
-                } else {
-                    LOG_WARN("MCP: Failed to connect to server '%s'", server->name);
-                }
-            }
+            // Connect and discover tools in the background; each server's
+            // tools join the tool definitions once it is ready
+            mcp_start_servers(state.mcp_config);
 
             // Log status
             char *status = mcp_get_status(state.mcp_config);
@@ -6462,6 +6748,7 @@ int main(int argc, char *argv[]) {
 
     // Cleanup MCP configuration
     if (state.mcp_config) {
+        tool_registry_release_mcp();
         mcp_free_config(state.mcp_config);
         state.mcp_config = NULL;
         LOG_DEBUG("MCP configuration cleaned up");
@@ -6494,6 +6781,8 @@ int main(int argc, char *argv[]) {
 
     curl_global_cleanup();
 
+    trace_shutdown();
+
     LOG_INFO("Application terminated");
     log_shutdown();
 
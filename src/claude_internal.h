@@ -210,6 +210,13 @@ typedef struct ConversationState {
  */
 int add_directory(ConversationState *state, const char *path);
 
+/**
+ * Show the diff of the last Write/Edit in full (args: optional 1-based hunk
+ * number). Used by the /diff command to expand collapsed hunks.
+ * Returns: 0
+ */
+int show_last_diff(const char *args);
+
 /**
  * Add a user message to the conversation
  */
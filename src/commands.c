@@ -185,6 +185,11 @@ static int cmd_voice(ConversationState *state, const char *args) {
     }
 }
 
+static int cmd_diff(ConversationState *state, const char *args) {
+    (void)state;
+    return show_last_diff(args);
+}
+
 static int cmd_help(ConversationState *state, const char *args) {
     (void)state; (void)args;
     // Suppress non-TUI help text output
@@ -235,6 +240,14 @@ static Command help_cmd = {
     .completer = commands_tab_completer
 };
 
+static Command diff_cmd = {
+    .name = "diff",
+    .usage = "/diff [hunk]",
+    .description = "Show the last file change in full (expand collapsed hunks)",
+    .handler = cmd_diff,
+    .completer = commands_tab_completer
+};
+
 static Command voice_cmd = {
     .name = "voice",
     .usage = "/voice",
@@ -254,6 +267,7 @@ void commands_init(void) {
     commands_register(&clear_cmd);
     commands_register(&add_dir_cmd);
     commands_register(&help_cmd);
+    commands_register(&diff_cmd);
     commands_register(&voice_cmd);
 }
 
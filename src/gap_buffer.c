@@ -0,0 +1,360 @@
+/**
+ * gap_buffer.c - Gap buffer text storage with a visual-row index for the input box
+ */
+
+#include "gap_buffer.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int line_rows(int len, int width) {
+    return len / width + 1;
+}
+
+static int gap_size(const GapBuffer *gb) {
+    return gb->gap_end - gb->gap_start;
+}
+
+static int reserve_ints(int **arr, int *capacity, int needed) {
+    if (needed <= *capacity) {
+        return 0;
+    }
+    int new_capacity = *capacity > 0 ? *capacity : 16;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    int *grown = realloc(*arr, (size_t)new_capacity * sizeof(int));
+    if (!grown) {
+        return -1;
+    }
+    *arr = grown;
+    *capacity = new_capacity;
+    return 0;
+}
+
+// Make room for `needed` more lines in both line stacks, so that moving the
+// cursor or inserting text never fails halfway through
+static int reserve_lines(GapBuffer *gb, int needed) {
+    int total = gb->above_count + gb->below_count + needed;
+    if (reserve_ints(&gb->above, &gb->above_capacity, total) != 0 ||
+        reserve_ints(&gb->below, &gb->below_capacity, total) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int reserve_gap(GapBuffer *gb, int needed) {
+    if (gap_size(gb) >= needed) {
+        return 0;
+    }
+    int length = gap_buffer_length(gb);
+    int new_capacity = gb->capacity > 0 ? gb->capacity : 64;
+    while (new_capacity - length < needed) {
+        new_capacity *= 2;
+    }
+    char *grown = realloc(gb->data, (size_t)new_capacity);
+    if (!grown) {
+        return -1;
+    }
+    // Text after the gap moves to the end of the larger allocation
+    int tail = gb->capacity - gb->gap_end;
+    memmove(grown + new_capacity - tail, grown + gb->gap_end, (size_t)tail);
+    gb->data = grown;
+    gb->gap_end = new_capacity - tail;
+    gb->capacity = new_capacity;
+    return 0;
+}
+
+static void push_above(GapBuffer *gb, int len) {
+    gb->above[gb->above_count++] = len;
+    if (gb->width > 0) {
+        gb->rows_above += line_rows(len, gb->width);
+    }
+}
+
+static int pop_above(GapBuffer *gb) {
+    int len = gb->above[--gb->above_count];
+    if (gb->width > 0) {
+        gb->rows_above -= line_rows(len, gb->width);
+    }
+    return len;
+}
+
+static void push_below(GapBuffer *gb, int len) {
+    gb->below[gb->below_count++] = len;
+    if (gb->width > 0) {
+        gb->rows_below += line_rows(len, gb->width);
+    }
+}
+
+static int pop_below(GapBuffer *gb) {
+    int len = gb->below[--gb->below_count];
+    if (gb->width > 0) {
+        gb->rows_below -= line_rows(len, gb->width);
+    }
+    return len;
+}
+
+static void set_width(GapBuffer *gb, int width) {
+    if (width < 1) {
+        width = 1;
+    }
+    if (gb->width == width) {
+        return;
+    }
+    gb->width = width;
+    gb->rows_above = 0;
+    gb->rows_below = 0;
+    for (int i = 0; i < gb->above_count; i++) {
+        gb->rows_above += line_rows(gb->above[i], width);
+    }
+    for (int i = 0; i < gb->below_count; i++) {
+        gb->rows_below += line_rows(gb->below[i], width);
+    }
+}
+
+int gap_buffer_init(GapBuffer *gb, int capacity) {
+    if (!gb) {
+        return -1;
+    }
+    memset(gb, 0, sizeof(*gb));
+    if (capacity < 16) {
+        capacity = 16;
+    }
+    gb->data = malloc((size_t)capacity);
+    if (!gb->data || reserve_lines(gb, 1) != 0) {
+        gap_buffer_free(gb);
+        return -1;
+    }
+    gb->capacity = capacity;
+    gb->gap_end = capacity;
+    return 0;
+}
+
+void gap_buffer_free(GapBuffer *gb) {
+    if (!gb) {
+        return;
+    }
+    free(gb->data);
+    free(gb->above);
+    free(gb->below);
+    free(gb->flat);
+    memset(gb, 0, sizeof(*gb));
+}
+
+int gap_buffer_length(const GapBuffer *gb) {
+    return gb->capacity - gap_size(gb);
+}
+
+int gap_buffer_cursor(const GapBuffer *gb) {
+    return gb->gap_start;
+}
+
+char gap_buffer_at(const GapBuffer *gb, int pos) {
+    return pos < gb->gap_start ? gb->data[pos] : gb->data[pos + gap_size(gb)];
+}
+
+void gap_buffer_copy(const GapBuffer *gb, int pos, int len, char *dest) {
+    if (pos < gb->gap_start) {
+        int head = gb->gap_start - pos < len ? gb->gap_start - pos : len;
+        memcpy(dest, gb->data + pos, (size_t)head);
+        dest += head;
+        pos += head;
+        len -= head;
+    }
+    if (len > 0) {
+        memcpy(dest, gb->data + pos + gap_size(gb), (size_t)len);
+    }
+}
+
+void gap_buffer_set_cursor(GapBuffer *gb, int pos) {
+    int length = gap_buffer_length(gb);
+    if (pos < 0) pos = 0;
+    if (pos > length) pos = length;
+
+    // Bytes crossing the gap only touch the line index at newlines
+    while (gb->gap_start > pos) {
+        char c = gb->data[--gb->gap_start];
+        gb->data[--gb->gap_end] = c;
+        if (c == '\n') {
+            push_below(gb, gb->line_len);
+            gb->line_len = pop_above(gb);
+            gb->line_start = gb->gap_start - gb->line_len;
+        }
+    }
+    while (gb->gap_start < pos) {
+        char c = gb->data[gb->gap_end++];
+        gb->data[gb->gap_start++] = c;
+        if (c == '\n') {
+            push_above(gb, gb->line_len);
+            gb->line_len = pop_below(gb);
+            gb->line_start = gb->gap_start;
+        }
+    }
+}
+
+int gap_buffer_insert(GapBuffer *gb, const char *text, int len) {
+    if (len <= 0) {
+        return 0;
+    }
+    int newlines = 0;
+    for (int i = 0; i < len; i++) {
+        if (text[i] == '\n') newlines++;
+    }
+    if (reserve_gap(gb, len) != 0 || reserve_lines(gb, newlines) != 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < len; i++) {
+        gb->data[gb->gap_start] = text[i];
+        if (text[i] == '\n') {
+            // The cursor line splits: its head becomes the line above
+            int head = gb->gap_start - gb->line_start;
+            push_above(gb, head);
+            gb->line_len -= head;
+            gb->line_start = gb->gap_start + 1;
+        } else {
+            gb->line_len++;
+        }
+        gb->gap_start++;
+    }
+    gb->flat_valid = 0;
+    return 0;
+}
+
+int gap_buffer_delete_backward(GapBuffer *gb, int n) {
+    int deleted = 0;
+    while (deleted < n && gb->gap_start > 0) {
+        if (gb->data[--gb->gap_start] == '\n') {
+            int prev = pop_above(gb);
+            gb->line_start -= prev + 1;
+            gb->line_len += prev;
+        } else {
+            gb->line_len--;
+        }
+        deleted++;
+    }
+    if (deleted > 0) {
+        gb->flat_valid = 0;
+    }
+    return deleted;
+}
+
+int gap_buffer_delete_forward(GapBuffer *gb, int n) {
+    int deleted = 0;
+    while (deleted < n && gb->gap_end < gb->capacity) {
+        if (gb->data[gb->gap_end++] == '\n') {
+            gb->line_len += pop_below(gb);
+        } else {
+            gb->line_len--;
+        }
+        deleted++;
+    }
+    if (deleted > 0) {
+        gb->flat_valid = 0;
+    }
+    return deleted;
+}
+
+void gap_buffer_clear(GapBuffer *gb) {
+    gb->gap_start = 0;
+    gb->gap_end = gb->capacity;
+    gb->above_count = 0;
+    gb->below_count = 0;
+    gb->line_start = 0;
+    gb->line_len = 0;
+    gb->rows_above = 0;
+    gb->rows_below = 0;
+    gb->flat_valid = 0;
+}
+
+int gap_buffer_set_text(GapBuffer *gb, const char *text, int len) {
+    gap_buffer_clear(gb);
+    return gap_buffer_insert(gb, text, len);
+}
+
+const char *gap_buffer_text(GapBuffer *gb) {
+    if (gb->flat_valid) {
+        return gb->flat;
+    }
+    int length = gap_buffer_length(gb);
+    if (length + 1 > gb->flat_capacity) {
+        int new_capacity = length + 1 > 64 ? length + 1 : 64;
+        char *grown = realloc(gb->flat, (size_t)new_capacity);
+        if (!grown) {
+            return NULL;
+        }
+        gb->flat = grown;
+        gb->flat_capacity = new_capacity;
+    }
+    gap_buffer_copy(gb, 0, length, gb->flat);
+    gb->flat[length] = '\0';
+    gb->flat_valid = 1;
+    return gb->flat;
+}
+
+int gap_buffer_rows(GapBuffer *gb, int width) {
+    set_width(gb, width);
+    return gb->rows_above + line_rows(gb->line_len, gb->width) + gb->rows_below;
+}
+
+void gap_buffer_cursor_row(GapBuffer *gb, int width, int *row, int *col) {
+    set_width(gb, width);
+    int offset = gb->gap_start - gb->line_start;
+    *row = gb->rows_above + offset / gb->width;
+    *col = offset % gb->width;
+}
+
+// Length of line d relative to the cursor line (d < 0 above, d > 0 below)
+static int line_len_at(const GapBuffer *gb, int d) {
+    if (d < 0) {
+        return gb->above[gb->above_count + d];
+    }
+    if (d > 0) {
+        return gb->below[gb->below_count - d];
+    }
+    return gb->line_len;
+}
+
+int gap_buffer_layout_rows(GapBuffer *gb, int width, int first_row,
+                           GapBufferRow *rows, int max_rows) {
+    set_width(gb, width);
+    int w = gb->width;
+
+    // Walk line by line from the cursor line to the one holding first_row
+    int d = 0;
+    int start = gb->line_start;
+    int row = gb->rows_above;       // First visual row of line d
+    while (row > first_row && d > -gb->above_count) {
+        d--;
+        start -= line_len_at(gb, d) + 1;
+        row -= line_rows(line_len_at(gb, d), w);
+    }
+    while (row + line_rows(line_len_at(gb, d), w) <= first_row) {
+        if (d == gb->below_count) {
+            return 0;               // Past the last row
+        }
+        start += line_len_at(gb, d) + 1;
+        row += line_rows(line_len_at(gb, d), w);
+        d++;
+    }
+
+    int filled = 0;
+    int r = first_row > row ? first_row - row : 0;
+    while (filled < max_rows) {
+        int len = line_len_at(gb, d);
+        int nrows = line_rows(len, w);
+        for (; r < nrows && filled < max_rows; r++) {
+            GapBufferRow *out = &rows[filled++];
+            out->start = start + r * w;
+            out->len = r == nrows - 1 ? len - r * w : w;
+            out->newline = r == nrows - 1 && d < gb->below_count;
+        }
+        if (d == gb->below_count) {
+            break;
+        }
+        start += len + 1;
+        d++;
+        r = 0;
+    }
+    return filled;
+}
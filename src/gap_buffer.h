@@ -0,0 +1,133 @@
+/**
+ * gap_buffer.h - Gap buffer text storage with a visual-row index for the input box
+ *
+ * The text is kept in one allocation with a gap at the cursor, so typing,
+ * backspace and delete at the cursor are O(1) amortized no matter how much
+ * text is in the buffer. Moving the cursor by d bytes moves the gap by d.
+ *
+ * Next to the text the buffer keeps the length of every hard ('\n'
+ * separated) line, split at the cursor line the same way the text is split
+ * at the gap, plus the total number of visual rows above and below the
+ * cursor line at the last width asked about. A line of L bytes wraps into
+ * L / width + 1 rows, so the total row count and the cursor's row and
+ * column are answered in O(1) and the rows around the cursor can be listed
+ * without scanning the text. Changing the width recomputes the row sums
+ * from the line lengths.
+ *
+ * Columns are counted in bytes, matching how the input box draws text.
+ */
+
+#ifndef GAP_BUFFER_H
+#define GAP_BUFFER_H
+
+#include <stddef.h>
+
+typedef struct {
+    char *data;
+    int capacity;
+    int gap_start;                  // Text position of the gap == cursor
+    int gap_end;                    // Index in data of the first byte after the gap
+
+    // Hard lines around the cursor line (lengths exclude the '\n')
+    int *above;                     // Lines above the cursor line, first line first
+    int above_count;
+    int above_capacity;
+    int *below;                     // Lines below the cursor line, last line first
+    int below_count;
+    int below_capacity;
+    int line_start;                 // Text position where the cursor line starts
+    int line_len;
+
+    // Visual rows above/below the cursor line at `width` (0 = not computed)
+    int width;
+    int rows_above;
+    int rows_below;
+
+    char *flat;                     // Contiguous copy returned by gap_buffer_text()
+    int flat_capacity;
+    int flat_valid;
+} GapBuffer;
+
+/**
+ * One visual row of the text at a given width
+ */
+typedef struct {
+    int start;                      // Text position of the first byte
+    int len;                        // Bytes on the row (excluding the newline)
+    int newline;                    // 1 if the row ends its line with a '\n'
+} GapBufferRow;
+
+/**
+ * Initialize an empty buffer with room for `capacity` bytes
+ * Returns 0 on success, -1 on allocation failure
+ */
+int gap_buffer_init(GapBuffer *gb, int capacity);
+
+/**
+ * Free memory held by the buffer (the struct itself is not freed)
+ */
+void gap_buffer_free(GapBuffer *gb);
+
+int gap_buffer_length(const GapBuffer *gb);
+int gap_buffer_cursor(const GapBuffer *gb);
+
+/**
+ * Byte at text position pos (0 <= pos < length)
+ */
+char gap_buffer_at(const GapBuffer *gb, int pos);
+
+/**
+ * Copy len bytes starting at text position pos into dest (not terminated)
+ */
+void gap_buffer_copy(const GapBuffer *gb, int pos, int len, char *dest);
+
+/**
+ * Move the cursor (and the gap) to pos, clamped to [0, length]
+ */
+void gap_buffer_set_cursor(GapBuffer *gb, int pos);
+
+/**
+ * Insert len bytes at the cursor and move the cursor past them
+ * Returns 0 on success, -1 on allocation failure
+ */
+int gap_buffer_insert(GapBuffer *gb, const char *text, int len);
+
+/**
+ * Delete up to n bytes before / after the cursor; returns the number deleted
+ */
+int gap_buffer_delete_backward(GapBuffer *gb, int n);
+int gap_buffer_delete_forward(GapBuffer *gb, int n);
+
+/**
+ * Replace the whole text and put the cursor at the end
+ * Returns 0 on success, -1 on allocation failure (the buffer is then empty)
+ */
+int gap_buffer_set_text(GapBuffer *gb, const char *text, int len);
+
+void gap_buffer_clear(GapBuffer *gb);
+
+/**
+ * The text as one NUL-terminated string. The pointer stays valid until the
+ * buffer is next modified.
+ */
+const char *gap_buffer_text(GapBuffer *gb);
+
+/**
+ * Number of visual rows the text wraps into at width (>= 1)
+ */
+int gap_buffer_rows(GapBuffer *gb, int width);
+
+/**
+ * Visual row and column of the cursor at width (>= 1)
+ */
+void gap_buffer_cursor_row(GapBuffer *gb, int width, int *row, int *col);
+
+/**
+ * Fill rows[] with visual rows [first_row, first_row + max_rows) at width.
+ * Walks only the lines between the cursor line and the requested rows.
+ * Returns the number of rows filled.
+ */
+int gap_buffer_layout_rows(GapBuffer *gb, int width, int first_row,
+                           GapBufferRow *rows, int max_rows);
+
+#endif // GAP_BUFFER_H
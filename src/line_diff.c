@@ -0,0 +1,482 @@
+/**
+ * line_diff.c - In-process line diff (Myers) with a compact hunk structure
+ */
+
+#include "line_diff.h"
+#include "logger.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t hash;
+    const LineDiffLine *line;       // NULL = empty bucket
+    int id;
+} InternEntry;
+
+typedef struct {
+    const int *a;                   // Interned ids of the old lines
+    const int *b;                   // Interned ids of the new lines
+    unsigned char *a_changed;
+    unsigned char *b_changed;
+    int *v1;                        // Forward / reverse furthest-x arrays,
+    int *v2;                        // sized for the largest subproblem
+} DiffSearch;
+
+typedef struct {
+    LineDiffOpKind kind;
+    int old_line;                   // Position in each text when the op is reached
+    int new_line;
+} FullOp;
+
+static char *copy_text(const char *text) {
+    const char *src = text ? text : "";
+    size_t len = strlen(src);
+    char *copy = malloc(len + 1);
+    if (copy) {
+        memcpy(copy, src, len + 1);
+    }
+    return copy;
+}
+
+// Split text into lines (without their newlines). A final line without a
+// newline still counts; an empty text has no lines.
+static LineDiffLine *split_lines(const char *text, int *count_out) {
+    int count = 0;
+    const char *p = text;
+    for (; *p; p++) {
+        if (*p == '\n') {
+            count++;
+        }
+    }
+    if (p > text && p[-1] != '\n') {
+        count++;
+    }
+
+    *count_out = count;
+    LineDiffLine *lines = malloc(sizeof(LineDiffLine) * (size_t)(count > 0 ? count : 1));
+    if (!lines) {
+        return NULL;
+    }
+
+    int n = 0;
+    const char *start = text;
+    for (p = text; *p; p++) {
+        if (*p == '\n') {
+            lines[n].start = start;
+            lines[n].len = (size_t)(p - start);
+            n++;
+            start = p + 1;
+        }
+    }
+    if (n < count) {
+        lines[n].start = start;
+        lines[n].len = (size_t)(p - start);
+    }
+    return lines;
+}
+
+static uint64_t hash_line(const LineDiffLine *line) {
+    uint64_t h = 1469598103934665603ULL;        // FNV-1a
+    for (size_t i = 0; i < line->len; i++) {
+        h ^= (unsigned char)line->start[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Map every line of both texts to a small integer, equal lines to equal ids
+static int intern_lines(const LineDiff *diff, int *a, int *b) {
+    size_t total = (size_t)diff->old_count + (size_t)diff->new_count;
+    size_t size = 16;
+    while (size < total * 2) {
+        size <<= 1;
+    }
+    InternEntry *table = calloc(size, sizeof(InternEntry));
+    if (!table) {
+        return -1;
+    }
+
+    int next_id = 0;
+    for (int side = 0; side < 2; side++) {
+        const LineDiffLine *lines = side == 0 ? diff->old_lines : diff->new_lines;
+        int count = side == 0 ? diff->old_count : diff->new_count;
+        int *ids = side == 0 ? a : b;
+
+        for (int i = 0; i < count; i++) {
+            uint64_t h = hash_line(&lines[i]);
+            size_t slot = (size_t)h & (size - 1);
+            for (;;) {
+                InternEntry *e = &table[slot];
+                if (!e->line) {
+                    e->hash = h;
+                    e->line = &lines[i];
+                    e->id = next_id++;
+                    ids[i] = e->id;
+                    break;
+                }
+                if (e->hash == h && e->line->len == lines[i].len &&
+                    memcmp(e->line->start, lines[i].start, lines[i].len) == 0) {
+                    ids[i] = e->id;
+                    break;
+                }
+                slot = (slot + 1) & (size - 1);
+            }
+        }
+    }
+
+    free(table);
+    return 0;
+}
+
+// Find the middle snake of a[a_lo, a_hi) vs b[b_lo, b_hi) (both non-empty,
+// first and last lines differing). On success the split point, relative to
+// the range, is stored and 1 returned; 0 if the search exceeded its budget.
+static int bisect(DiffSearch *s, int a_lo, int a_hi, int b_lo, int b_hi,
+                  int *split_x, int *split_y) {
+    const int *a = s->a + a_lo;
+    const int *b = s->b + b_lo;
+    int n = a_hi - a_lo;
+    int m = b_hi - b_lo;
+    int max_d = (n + m + 1) / 2;
+    int v_offset = max_d;
+    int v_length = 2 * max_d + 2;
+    int *v1 = s->v1;
+    int *v2 = s->v2;
+
+    for (int i = 0; i < v_length; i++) {
+        v1[i] = -1;
+        v2[i] = -1;
+    }
+    v1[v_offset + 1] = 0;
+    v2[v_offset + 1] = 0;
+
+    int delta = n - m;
+    int front = (delta % 2) != 0;   // Odd delta: overlap is found going forward
+    int k1start = 0, k1end = 0, k2start = 0, k2end = 0;
+    int limit = max_d < LINE_DIFF_MAX_COST ? max_d : LINE_DIFF_MAX_COST;
+
+    for (int d = 0; d < limit; d++) {
+        for (int k1 = -d + k1start; k1 <= d - k1end; k1 += 2) {
+            int k1_offset = v_offset + k1;
+            int x1;
+            if (k1 == -d || (k1 != d && v1[k1_offset - 1] < v1[k1_offset + 1])) {
+                x1 = v1[k1_offset + 1];
+            } else {
+                x1 = v1[k1_offset - 1] + 1;
+            }
+            int y1 = x1 - k1;
+            while (x1 < n && y1 < m && a[x1] == b[y1]) {
+                x1++;
+                y1++;
+            }
+            v1[k1_offset] = x1;
+            if (x1 > n) {
+                k1end += 2;         // Ran off the right
+            } else if (y1 > m) {
+                k1start += 2;       // Ran off the bottom
+            } else if (front) {
+                int k2_offset = v_offset + delta - k1;
+                if (k2_offset >= 0 && k2_offset < v_length && v2[k2_offset] != -1) {
+                    int x2 = n - v2[k2_offset];
+                    if (x1 >= x2) {
+                        *split_x = x1;
+                        *split_y = y1;
+                        return 1;
+                    }
+                }
+            }
+        }
+
+        for (int k2 = -d + k2start; k2 <= d - k2end; k2 += 2) {
+            int k2_offset = v_offset + k2;
+            int x2;
+            if (k2 == -d || (k2 != d && v2[k2_offset - 1] < v2[k2_offset + 1])) {
+                x2 = v2[k2_offset + 1];
+            } else {
+                x2 = v2[k2_offset - 1] + 1;
+            }
+            int y2 = x2 - k2;
+            while (x2 < n && y2 < m && a[n - x2 - 1] == b[m - y2 - 1]) {
+                x2++;
+                y2++;
+            }
+            v2[k2_offset] = x2;
+            if (x2 > n) {
+                k2end += 2;
+            } else if (y2 > m) {
+                k2start += 2;
+            } else if (!front) {
+                int k1_offset = v_offset + delta - k2;
+                if (k1_offset >= 0 && k1_offset < v_length && v1[k1_offset] != -1) {
+                    int x1 = v1[k1_offset];
+                    int y1 = v_offset + x1 - k1_offset;
+                    if (x1 >= n - x2) {
+                        *split_x = x1;
+                        *split_y = y1;
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static void compare(DiffSearch *s, int a_lo, int a_hi, int b_lo, int b_hi) {
+    // Identical prefix and suffix never need searching
+    while (a_lo < a_hi && b_lo < b_hi && s->a[a_lo] == s->b[b_lo]) {
+        a_lo++;
+        b_lo++;
+    }
+    while (a_lo < a_hi && b_lo < b_hi && s->a[a_hi - 1] == s->b[b_hi - 1]) {
+        a_hi--;
+        b_hi--;
+    }
+
+    if (a_lo == a_hi || b_lo == b_hi) {
+        memset(s->a_changed + a_lo, 1, (size_t)(a_hi - a_lo));
+        memset(s->b_changed + b_lo, 1, (size_t)(b_hi - b_lo));
+        return;
+    }
+
+    int x = 0, y = 0;
+    if (!bisect(s, a_lo, a_hi, b_lo, b_hi, &x, &y)) {
+        // Too expensive to search: report the range as replaced
+        memset(s->a_changed + a_lo, 1, (size_t)(a_hi - a_lo));
+        memset(s->b_changed + b_lo, 1, (size_t)(b_hi - b_lo));
+        return;
+    }
+    compare(s, a_lo, a_lo + x, b_lo, b_lo + y);
+    compare(s, a_lo + x, a_hi, b_lo + y, b_hi);
+}
+
+static int add_hunk(LineDiff *diff, const FullOp *full, int start, int end) {
+    LineDiffHunk *hunk = &diff->hunks[diff->hunk_count++];
+    memset(hunk, 0, sizeof(*hunk));
+    hunk->old_start = full[start].old_line;
+    hunk->new_start = full[start].new_line;
+    hunk->first_op = diff->op_count;
+
+    for (int p = start; p < end; p++) {
+        LineDiffOp *op = &diff->ops[diff->op_count++];
+        op->kind = full[p].kind;
+        switch (full[p].kind) {
+            case LINE_DIFF_CONTEXT_LINE:
+                op->line = full[p].old_line;
+                hunk->old_count++;
+                hunk->new_count++;
+                break;
+            case LINE_DIFF_DELETE:
+                op->line = full[p].old_line;
+                hunk->old_count++;
+                hunk->removed++;
+                break;
+            case LINE_DIFF_INSERT:
+                op->line = full[p].new_line;
+                hunk->new_count++;
+                hunk->added++;
+                break;
+            default:
+                return -1;
+        }
+    }
+    hunk->op_count = diff->op_count - hunk->first_op;
+    diff->added += hunk->added;
+    diff->removed += hunk->removed;
+    return 0;
+}
+
+// Walk the change flags into ops and keep only those near a change
+static int build_hunks(LineDiff *diff, const unsigned char *a_changed,
+                       const unsigned char *b_changed, int context) {
+    size_t max_ops = (size_t)diff->old_count + (size_t)diff->new_count;
+    FullOp *full = malloc(sizeof(FullOp) * (max_ops > 0 ? max_ops : 1));
+    if (!full) {
+        return -1;
+    }
+
+    int nops = 0;
+    int changes = 0;
+    int i = 0, j = 0;
+    while (i < diff->old_count || j < diff->new_count) {
+        FullOp *op = &full[nops++];
+        op->old_line = i;
+        op->new_line = j;
+        if (i < diff->old_count && a_changed[i]) {
+            op->kind = LINE_DIFF_DELETE;
+            i++;
+            changes++;
+        } else if (j < diff->new_count && b_changed[j]) {
+            op->kind = LINE_DIFF_INSERT;
+            j++;
+            changes++;
+        } else {
+            op->kind = LINE_DIFF_CONTEXT_LINE;
+            i++;
+            j++;
+        }
+    }
+
+    // Upper bounds: every change could open a hunk with 2 * context lines
+    size_t op_cap = (size_t)changes * (size_t)(2 * context + 1);
+    if (op_cap > (size_t)nops) {
+        op_cap = (size_t)nops;
+    }
+    diff->ops = malloc(sizeof(LineDiffOp) * (op_cap > 0 ? op_cap : 1));
+    diff->hunks = malloc(sizeof(LineDiffHunk) * (size_t)(changes > 0 ? changes : 1));
+    if (!diff->ops || !diff->hunks) {
+        free(full);
+        return -1;
+    }
+
+    int hunk_start = -1;
+    int last_end = 0;               // One past the last change op seen
+    int rc = 0;
+    for (int p = 0; p < nops && rc == 0; p++) {
+        if (full[p].kind == LINE_DIFF_CONTEXT_LINE) {
+            continue;
+        }
+        if (hunk_start < 0 || p - last_end > 2 * context) {
+            if (hunk_start >= 0) {
+                int end = last_end + context < nops ? last_end + context : nops;
+                rc = add_hunk(diff, full, hunk_start, end);
+            }
+            hunk_start = p - context > 0 ? p - context : 0;
+        }
+        last_end = p + 1;
+    }
+    if (rc == 0 && hunk_start >= 0) {
+        int end = last_end + context < nops ? last_end + context : nops;
+        rc = add_hunk(diff, full, hunk_start, end);
+    }
+
+    free(full);
+    return rc;
+}
+
+int line_diff_compute(LineDiff *diff, const char *old_text, const char *new_text, int context) {
+    if (!diff) {
+        return -1;
+    }
+    memset(diff, 0, sizeof(*diff));
+    if (context < 0) {
+        context = 0;
+    }
+
+    diff->old_text = copy_text(old_text);
+    diff->new_text = copy_text(new_text);
+    if (!diff->old_text || !diff->new_text) {
+        line_diff_free(diff);
+        return -1;
+    }
+    diff->old_lines = split_lines(diff->old_text, &diff->old_count);
+    diff->new_lines = split_lines(diff->new_text, &diff->new_count);
+    if (!diff->old_lines || !diff->new_lines) {
+        line_diff_free(diff);
+        return -1;
+    }
+
+    size_t n = (size_t)diff->old_count;
+    size_t m = (size_t)diff->new_count;
+    size_t v_length = 2 * ((n + m + 1) / 2) + 2;
+    int *a = malloc(sizeof(int) * (n + 1));
+    int *b = malloc(sizeof(int) * (m + 1));
+    unsigned char *a_changed = calloc(n + 1, 1);
+    unsigned char *b_changed = calloc(m + 1, 1);
+    int *v = malloc(sizeof(int) * v_length * 2);
+
+    int rc = -1;
+    if (a && b && a_changed && b_changed && v && intern_lines(diff, a, b) == 0) {
+        DiffSearch search = {a, b, a_changed, b_changed, v, v + v_length};
+        compare(&search, 0, diff->old_count, 0, diff->new_count);
+        rc = build_hunks(diff, a_changed, b_changed, context);
+    }
+
+    free(a);
+    free(b);
+    free(a_changed);
+    free(b_changed);
+    free(v);
+
+    if (rc != 0) {
+        LOG_ERROR("[Diff] Out of memory diffing %d vs %d lines", diff->old_count, diff->new_count);
+        line_diff_free(diff);
+        return -1;
+    }
+    LOG_DEBUG("[Diff] %d vs %d lines: %d hunk(s), +%d -%d",
+              diff->old_count, diff->new_count, diff->hunk_count, diff->added, diff->removed);
+    return 0;
+}
+
+void line_diff_hunk_header(const LineDiffHunk *hunk, char *buf, size_t size) {
+    if (!buf || size == 0) {
+        return;
+    }
+    if (!hunk) {
+        buf[0] = '\0';
+        return;
+    }
+    // Unified format numbers lines from 1; an empty side names the line before it
+    snprintf(buf, size, "@@ -%d,%d +%d,%d @@",
+             hunk->old_count ? hunk->old_start + 1 : hunk->old_start, hunk->old_count,
+             hunk->new_count ? hunk->new_start + 1 : hunk->new_start, hunk->new_count);
+}
+
+int line_diff_render_hunk(const LineDiff *diff, int index, int max_lines,
+                          LineDiffEmitFn emit, void *ctx) {
+    if (!diff || !emit || index < 0 || index >= diff->hunk_count) {
+        return -1;
+    }
+
+    const LineDiffHunk *hunk = &diff->hunks[index];
+    char header[96];
+    line_diff_hunk_header(hunk, header, sizeof(header));
+    emit(ctx, header);
+
+    int shown = hunk->op_count;
+    if (max_lines >= 0 && max_lines < shown) {
+        shown = max_lines;
+    }
+
+    char *buf = NULL;
+    size_t buf_size = 0;
+    for (int k = 0; k < shown; k++) {
+        const LineDiffOp *op = &diff->ops[hunk->first_op + k];
+        const LineDiffLine *line = op->kind == LINE_DIFF_INSERT
+            ? &diff->new_lines[op->line]
+            : &diff->old_lines[op->line];
+
+        if (line->len + 2 > buf_size) {
+            size_t new_size = line->len + 2 > 256 ? line->len + 2 : 256;
+            char *grown = realloc(buf, new_size);
+            if (!grown) {
+                free(buf);
+                return -1;
+            }
+            buf = grown;
+            buf_size = new_size;
+        }
+        buf[0] = op->kind == LINE_DIFF_INSERT ? '+' : op->kind == LINE_DIFF_DELETE ? '-' : ' ';
+        memcpy(buf + 1, line->start, line->len);
+        buf[line->len + 1] = '\0';
+        emit(ctx, buf);
+    }
+
+    free(buf);
+    return hunk->op_count - shown;
+}
+
+void line_diff_free(LineDiff *diff) {
+    if (!diff) {
+        return;
+    }
+    free(diff->old_text);
+    free(diff->new_text);
+    free(diff->old_lines);
+    free(diff->new_lines);
+    free(diff->ops);
+    free(diff->hunks);
+    memset(diff, 0, sizeof(*diff));
+}
@@ -0,0 +1,99 @@
+/**
+ * line_diff.h - In-process line diff (Myers) with a compact hunk structure
+ *
+ * Compares two texts line by line without temp files or an external `diff`.
+ * Lines are interned to integer ids through a hash table, so the diff
+ * itself only compares integers. The common prefix and suffix are skipped
+ * before the search, so a small edit in a large file costs little more than
+ * one pass over it. The search is Myers' O(ND) algorithm in its linear-space
+ * (middle snake) form; very expensive subproblems stop searching after
+ * LINE_DIFF_MAX_COST steps and are reported as a plain replacement.
+ *
+ * The result keeps only the lines inside hunks (changes plus context), as
+ * indexes into the diff's own copy of both texts. Lines are formatted only
+ * when a hunk is rendered, so callers can show some hunks and keep the rest
+ * collapsed until asked.
+ */
+
+#ifndef LINE_DIFF_H
+#define LINE_DIFF_H
+
+#include <stddef.h>
+
+#define LINE_DIFF_CONTEXT 3         // Default context lines around a change
+#define LINE_DIFF_MAX_COST 4096     // Edit distance searched per subproblem
+
+typedef enum {
+    LINE_DIFF_CONTEXT_LINE = 0,     // ' ' line present in both texts
+    LINE_DIFF_DELETE = 1,           // '-' line only in the old text
+    LINE_DIFF_INSERT = 2            // '+' line only in the new text
+} LineDiffOpKind;
+
+typedef struct {
+    LineDiffOpKind kind;
+    int line;                       // Old line for context/delete, new line for insert
+} LineDiffOp;
+
+typedef struct {
+    int old_start;                  // 0-based first old line covered
+    int old_count;
+    int new_start;                  // 0-based first new line covered
+    int new_count;
+    int first_op;                   // Index into LineDiff.ops
+    int op_count;
+    int added;
+    int removed;
+} LineDiffHunk;
+
+typedef struct {
+    const char *start;
+    size_t len;                     // Excluding the newline
+} LineDiffLine;
+
+typedef struct {
+    char *old_text;                 // Owned copies the lines point into
+    char *new_text;
+    LineDiffLine *old_lines;
+    LineDiffLine *new_lines;
+    int old_count;
+    int new_count;
+
+    LineDiffOp *ops;                // Ops of all hunks, in order
+    int op_count;
+    LineDiffHunk *hunks;
+    int hunk_count;
+    int added;                      // Totals over all hunks
+    int removed;
+} LineDiff;
+
+/**
+ * Called for each rendered line (NUL-terminated, no trailing newline)
+ */
+typedef void (*LineDiffEmitFn)(void *ctx, const char *line);
+
+/**
+ * Diff old_text against new_text (either may be NULL for empty) with
+ * `context` lines around each change. The texts are copied.
+ * Returns 0 on success, -1 on allocation failure.
+ */
+int line_diff_compute(LineDiff *diff, const char *old_text, const char *new_text, int context);
+
+/**
+ * Write the unified header of a hunk ("@@ -a,b +c,d @@") into buf
+ */
+void line_diff_hunk_header(const LineDiffHunk *hunk, char *buf, size_t size);
+
+/**
+ * Render hunk `index` through emit: its header, then up to max_lines body
+ * lines prefixed with ' ', '-' or '+' (max_lines < 0 renders all).
+ * Returns the number of body lines left unrendered, or -1 on error.
+ */
+int line_diff_render_hunk(const LineDiff *diff, int index, int max_lines,
+                          LineDiffEmitFn emit, void *ctx);
+
+/**
+ * Free memory held by the diff (the struct itself is not freed)
+ */
+void line_diff_free(LineDiff *diff);
+
+#endif // LINE_DIFF_H
@@ -2,7 +2,8 @@
  * mcp.c - Model Context Protocol (MCP) client implementation
  *
  * This implements a JSON-RPC 2.0 client for communicating with MCP servers.
- * Supports stdio transport (process spawning) and basic server management.
+ * Supports the stdio transport (process spawning), the streamable HTTP
+ * transport (mcp_http.c) and basic server management.
  */
 
 #ifdef __APPLE__
@@ -11,35 +12,57 @@
     #define _GNU_SOURCE
 #endif
 
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
 #include <unistd.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/stat.h>
 #include <signal.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <stdatomic.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #include <cjson/cJSON.h>
 #include "mcp.h"
+#include "mcp_http.h"
+#include "mcp_resource_cache.h"
+#include "mcp_stderr.h"
 #include "base64.h"
 
 #ifndef TEST_BUILD
 #include "logger.h"
 #else
-// Stub logger for test builds
-#define LOG_INFO(...)
-#define LOG_DEBUG(...)
-#define LOG_WARN(...)
-#define LOG_ERROR(...)
+// Stub logger for test builds; the arguments are still type-checked
+#define LOG_STUB(...) do { if (0) fprintf(stderr, __VA_ARGS__); } while (0)
+#define LOG_INFO(...) LOG_STUB(__VA_ARGS__)
+#define LOG_DEBUG(...) LOG_STUB(__VA_ARGS__)
+#define LOG_WARN(...) LOG_STUB(__VA_ARGS__)
+#define LOG_ERROR(...) LOG_STUB(__VA_ARGS__)
 #endif
 
 // Global MCP state
 static int mcp_initialized = 0;
 static int mcp_enabled = 0;
 
+// Bumped whenever the tools some server offers may have changed
+static atomic_ulong mcp_tool_generation;
+
+// Wakes the supervisor threads: a server went down or a config is freed.
+// Taken after a server's lock, never before it.
+static pthread_mutex_t mcp_supervisor_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mcp_supervisor_cond = PTHREAD_COND_INITIALIZER;
+static unsigned long mcp_supervisor_events = 0;
+
 /*
  * Create directory recursively (like mkdir -p)
  */
@@ -121,6 +144,68 @@ int mcp_is_enabled(void) {
     return mcp_enabled;
 }
 
+/*
+ * Server index: open-addressed table of server positions (+ 1, 0 = empty)
+ * by name, so a prefixed tool name finds its server without a scan
+ */
+static uint32_t mcp_name_hash(const char *name, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)name[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static MCPServer* mcp_index_lookup(const MCPConfig *config, const char *name, size_t len) {
+    if (config->server_index_size == 0) {
+        return NULL;
+    }
+    size_t mask = config->server_index_size - 1;
+    for (size_t i = mcp_name_hash(name, len) & mask; config->server_index[i] != 0; i = (i + 1) & mask) {
+        MCPServer *server = config->servers[config->server_index[i] - 1];
+        if (strncmp(server->name, name, len) == 0 && server->name[len] == '\0') {
+            return server;
+        }
+    }
+    return NULL;
+}
+
+static void mcp_build_server_index(MCPConfig *config) {
+    size_t size = 16;
+    while (size < (size_t)config->server_count * 2 + 1) {
+        size *= 2;
+    }
+    config->server_index = calloc(size, sizeof(int));
+    if (!config->server_index) {
+        return;  // Lookups find nothing rather than the wrong server
+    }
+    config->server_index_size = size;
+    for (int i = 0; i < config->server_count; i++) {
+        const char *name = config->servers[i] ? config->servers[i]->name : NULL;
+        if (!name || mcp_index_lookup(config, name, strlen(name))) {
+            continue;  // First of two servers with one name wins
+        }
+        size_t slot = mcp_name_hash(name, strlen(name)) & (size - 1);
+        while (config->server_index[slot] != 0) {
+            slot = (slot + 1) & (size - 1);
+        }
+        config->server_index[slot] = i + 1;
+    }
+}
+
+static long long mcp_resource_cache_ttl_ms(void) {
+    const char *env = getenv("CLAUDE_MCP_RESOURCE_CACHE_TTL_MS");
+    if (env && *env) {
+        char *end = NULL;
+        long long ms = strtoll(env, &end, 10);
+        if (end && *end == '\0' && ms >= 0) {
+            return ms;
+        }
+    }
+    return MCP_RESOURCE_CACHE_TTL_MS;
+}
+
 /*
  * Load MCP server configuration from JSON file
  */
@@ -261,8 +346,17 @@ MCPConfig* mcp_load_config(const char *config_path) {
         server->transport = MCP_TRANSPORT_STDIO;  // Default to stdio
         server->stdin_fd = -1;
         server->stdout_fd = -1;
+        server->stderr_fd = -1;
+        server->pidfd = -1;
+        server->exit_status = -1;
+        server->wake_pipe[0] = -1;
+        server->wake_pipe[1] = -1;
         server->connected = 0;
         server->message_id = 1;
+        server->max_in_flight = MCP_DEFAULT_MAX_IN_FLIGHT;
+        pthread_mutex_init(&server->write_lock, NULL);
+        pthread_mutex_init(&server->lock, NULL);
+        pthread_cond_init(&server->cond, NULL);
 
         // Parse command
         cJSON *command = cJSON_GetObjectItem(server_item, "command");
@@ -270,6 +364,38 @@ MCPConfig* mcp_load_config(const char *config_path) {
             server->command = strdup(command->valuestring);
         }
 
+        // Parse url (HTTP servers have no command)
+        cJSON *url = cJSON_GetObjectItem(server_item, "url");
+        if (url && cJSON_IsString(url) && !server->command) {
+            server->url = strdup(url->valuestring);
+            server->transport = MCP_TRANSPORT_SSE;
+        }
+
+        // Parse HTTP headers
+        cJSON *headers = cJSON_GetObjectItem(server_item, "headers");
+        if (headers && cJSON_IsObject(headers) && cJSON_GetArraySize(headers) > 0) {
+            server->headers = calloc((size_t)cJSON_GetArraySize(headers), sizeof(char*));
+            if (server->headers) {
+                cJSON *header = NULL;
+                cJSON_ArrayForEach(header, headers) {
+                    if (header->string && cJSON_IsString(header)) {
+                        char header_str[1024];
+                        snprintf(header_str, sizeof(header_str), "%s: %s", header->string, header->valuestring);
+                        server->headers[server->header_count] = strdup(header_str);
+                        if (server->headers[server->header_count]) {
+                            server->header_count++;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Parse request concurrency limit
+        cJSON *max_in_flight = cJSON_GetObjectItem(server_item, "maxInFlight");
+        if (max_in_flight && cJSON_IsNumber(max_in_flight) && max_in_flight->valueint > 0) {
+            server->max_in_flight = max_in_flight->valueint;
+        }
+
         // Parse args
         cJSON *args = cJSON_GetObjectItem(server_item, "args");
         if (args && cJSON_IsArray(args)) {
@@ -313,12 +439,20 @@ MCPConfig* mcp_load_config(const char *config_path) {
         }
 
         config->servers[idx++] = server;
-        LOG_INFO("MCP: Configured server '%s' (command: %s)", server->name, server->command ? server->command : "none");
+        LOG_INFO("MCP: Configured server '%s' (%s: %s)", server->name,
+                 server->url ? "url" : "command",
+                 server->url ? server->url : server->command ? server->command : "none");
     }
 
     config->server_count = idx;
     cJSON_Delete(root);
     root = NULL;
+    mcp_build_server_index(config);
+
+    config->resource_cache = mcp_resource_cache_new(MCP_RESOURCE_CACHE_BYTES, mcp_resource_cache_ttl_ms());
+    for (int i = 0; i < config->server_count; i++) {
+        config->servers[i]->resource_cache = config->resource_cache;
+    }
 
     LOG_INFO("MCP: Loaded %d server(s) from config", config->server_count);
     // Debug summary of configured servers for local troubleshooting
@@ -365,25 +499,156 @@ cleanup:
     return config;
 }
 
+static long long mcp_now_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static long long mcp_now_ms(void) {
+    return mcp_now_us() / 1000;
+}
+
+static void mcp_wake_supervisor(void) {
+    pthread_mutex_lock(&mcp_supervisor_lock);
+    mcp_supervisor_events++;
+    pthread_cond_broadcast(&mcp_supervisor_cond);
+    pthread_mutex_unlock(&mcp_supervisor_lock);
+}
+
+/*
+ * Mark a server down (server->lock held): requests waiting on it fail now,
+ * and the supervisor restarts it after a delay that doubles for each exit
+ * soon after it came up
+ */
+static void mcp_mark_down(MCPServer *server) {
+    if (server->health == MCP_HEALTH_DOWN) {
+        return;
+    }
+    long long now = mcp_now_ms();
+    if (server->health == MCP_HEALTH_UP && now - server->up_since_ms >= MCP_RESTART_RESET_MS) {
+        server->quick_exits = 0;
+    }
+    long long delay = MCP_RESTART_DELAY_MS;
+    for (int i = 0; i < server->quick_exits && delay < MCP_RESTART_MAX_DELAY_MS; i++) {
+        delay *= 2;
+    }
+    if (delay > MCP_RESTART_MAX_DELAY_MS) {
+        delay = MCP_RESTART_MAX_DELAY_MS;
+    }
+    server->quick_exits++;
+    server->health = MCP_HEALTH_DOWN;
+    server->restart_at_ms = now + delay;
+    pthread_cond_broadcast(&server->cond);
+    LOG_WARN("MCP: Server '%s' is down, restarting it in %lld ms", server->name, delay);
+    mcp_wake_supervisor();
+}
+
+/*
+ * Mark a server up once it has answered initialize (server->lock held)
+ */
+static void mcp_mark_up(MCPServer *server) {
+    server->health = MCP_HEALTH_UP;
+    server->up_since_ms = mcp_now_ms();
+}
+
+/*
+ * Drop what is known about a server's resources: subscriptions, which end
+ * with the connection, and the listing (server->lock held)
+ */
+static void mcp_forget_resources(MCPServer *server) {
+    for (int i = 0; i < server->resource_subscription_count; i++) {
+        free(server->resource_subscriptions[i]);
+    }
+    free(server->resource_subscriptions);
+    server->resource_subscriptions = NULL;
+    server->resource_subscription_count = 0;
+    server->resource_subscription_capacity = 0;
+    cJSON_Delete(server->resource_listing);
+    server->resource_listing = NULL;
+    server->resource_generation++;
+}
+
+/*
+ * Whether a server is connected, up and not still being started in the
+ * background (its startup thread owns it until then)
+ */
+static int mcp_server_available(MCPServer *server) {
+    pthread_mutex_lock(&server->lock);
+    int available = !server->starting && server->connected && server->health != MCP_HEALTH_DOWN;
+    pthread_mutex_unlock(&server->lock);
+    return available;
+}
+
+/*
+ * Make a background startup give up and wait for its thread. Requests it
+ * is waiting on fail at once instead of running into their timeout.
+ */
+static void mcp_stop_startup(MCPServer *server) {
+    if (!server->startup_running) {
+        return;
+    }
+    pthread_mutex_lock(&server->lock);
+    server->stopping = 1;
+    pthread_cond_broadcast(&server->cond);
+    pthread_mutex_unlock(&server->lock);
+
+    pthread_join(server->startup_thread, NULL);
+    server->startup_running = 0;
+}
+
 /*
  * Free MCP configuration
  */
 void mcp_free_config(MCPConfig *config) {
     if (!config) return;
 
+    if (config->supervisor_running) {
+        // Make a restart in progress give up, then stop the supervisor
+        for (int i = 0; i < config->server_count; i++) {
+            MCPServer *server = config->servers[i];
+            if (server) {
+                pthread_mutex_lock(&server->lock);
+                server->stopping = 1;
+                pthread_cond_broadcast(&server->cond);
+                pthread_mutex_unlock(&server->lock);
+            }
+        }
+        pthread_mutex_lock(&mcp_supervisor_lock);
+        config->supervisor_stop = 1;
+        pthread_cond_broadcast(&mcp_supervisor_cond);
+        pthread_mutex_unlock(&mcp_supervisor_lock);
+        pthread_join(config->supervisor, NULL);
+        config->supervisor_running = 0;
+    }
+
     for (int i = 0; i < config->server_count; i++) {
         MCPServer *server = config->servers[i];
         if (!server) continue;
 
+        mcp_stop_startup(server);
+        if (server->refresh_running) {
+            pthread_join(server->refresh_thread, NULL);  // Fails fast once stopping
+            server->refresh_running = 0;
+        }
+
         // Disconnect if connected
         if (server->connected) {
             mcp_disconnect_server(server);
         }
+        mcp_stderr_close(server->stderr_capture);
 
         free(server->name);
         free(server->command);
         free(server->url);
 
+        if (server->headers) {
+            for (int j = 0; j < server->header_count; j++) {
+                free(server->headers[j]);
+            }
+            free(server->headers);
+        }
+
         if (server->args) {
             for (int j = 0; j < server->args_count; j++) {
                 free(server->args[j]);
@@ -408,280 +673,1007 @@ void mcp_free_config(MCPConfig *config) {
         if (server->tool_schemas) {
             cJSON_Delete(server->tool_schemas);
         }
+        mcp_forget_resources(server);
 
+        pthread_mutex_destroy(&server->write_lock);
+        pthread_mutex_destroy(&server->lock);
+        pthread_cond_destroy(&server->cond);
         free(server);
     }
 
     free(config->servers);
+    free(config->server_index);
+    mcp_resource_cache_free(config->resource_cache);
     free(config);
 }
 
 /*
  * Forward declaration for stderr reading function
  */
-static void mcp_read_stderr(MCPServer *server);
+static int mcp_read_stderr(MCPServer *server);
+static void mcp_open_stderr_capture(MCPServer *server);
+static cJSON* mcp_send_request(MCPServer *server, const char *method, cJSON *params);
+
+// Reader thread framing buffer: starts at one read's worth and grows for
+// long messages, up to a sanity limit
+#define MCP_READ_CHUNK 65536
+#define MCP_MAX_MESSAGE_SIZE (256u * 1024u * 1024u)
+
+// Longest prefix of a received message copied into the debug log
+#define MCP_LOG_PREVIEW 1024
+
+// Answers to server requests waiting to be written; more are dropped
+#define MCP_MAX_QUEUED_ANSWERS 64
+
+/*
+ * A request waiting for its reply. Lives on the caller's stack and is
+ * linked into server->pending (at most max_in_flight long) while the
+ * caller waits.
+ */
+typedef struct MCPPendingRequest {
+    int id;
+    cJSON *response;             // Set by the reader thread
+    const char *failure;         // Why no reply will come (static string)
+    struct MCPPendingRequest *next;
+} MCPPendingRequest;
+
+typedef struct MCPQueuedAnswer {
+    char *message;
+    struct MCPQueuedAnswer *next;
+} MCPQueuedAnswer;
 
 /*
- * Connect to an MCP server (stdio transport)
+ * Create a pipe whose ends are not inherited by other servers, including
+ * ones forked by another thread while this one is still setting up
  */
-int mcp_connect_server(MCPServer *server) {
-    if (!server || !server->command) {
-        LOG_ERROR("MCP: Invalid server or missing command");
+static int mcp_pipe_cloexec(int fds[2]) {
+#ifdef __linux__
+    return pipe2(fds, O_CLOEXEC);
+#else
+    if (pipe(fds) < 0) {
         return -1;
     }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+#endif
+}
 
-    if (server->connected) {
-        LOG_WARN("MCP: Server '%s' already connected", server->name);
-        return 0;
+/*
+ * Request timeout in milliseconds (CLAUDE_MCP_TIMEOUT_MS or the default)
+ */
+static long mcp_timeout_ms(void) {
+    const char *env = getenv("CLAUDE_MCP_TIMEOUT_MS");
+    if (env && *env) {
+        char *end = NULL;
+        long ms = strtol(env, &end, 10);
+        if (end && *end == '\0' && ms > 0) {
+            return ms;
+        }
     }
+    return MCP_DEFAULT_TIMEOUT_MS;
+}
 
-    LOG_INFO("MCP: Connecting to server '%s'...", server->name);
-
-    // Create pipes for stdin/stdout/stderr
-    int stdin_pipe[2] = {-1, -1};
-    int stdout_pipe[2] = {-1, -1};
-    int stderr_pipe[2] = {-1, -1};
+static void mcp_free_answers(MCPQueuedAnswer *answers) {
+    while (answers) {
+        MCPQueuedAnswer *next = answers->next;
+        free(answers->message);
+        free(answers);
+        answers = next;
+    }
+}
 
-    if (pipe(stdin_pipe) < 0) {
-        LOG_ERROR("MCP: Failed to create stdin pipe: %s", strerror(errno));
-        return -1;
+/*
+ * Write all of text to the server's stdin (write_lock held). With
+ * wake_fd >= 0, waits for room in the pipe before each write and gives
+ * up (ECANCELED) once wake_fd is readable.
+ */
+static int mcp_write_all(MCPServer *server, const char *text, int wake_fd) {
+    size_t left = strlen(text);
+    while (left > 0) {
+        if (wake_fd >= 0) {
+            struct pollfd fds[2];
+            fds[0].fd = server->stdin_fd;
+            fds[0].events = POLLOUT;
+            fds[1].fd = wake_fd;
+            fds[1].events = POLLIN;
+            fds[0].revents = fds[1].revents = 0;
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+            if (fds[1].revents) {
+                errno = ECANCELED;
+                return -1;
+            }
+        }
+        ssize_t n = write(server->stdin_fd, text, left);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        text += n;
+        left -= (size_t)n;
     }
+    return 0;
+}
 
-    if (pipe(stdout_pipe) < 0) {
-        LOG_ERROR("MCP: Failed to create stdout pipe: %s", strerror(errno));
-        close(stdin_pipe[0]);
-        close(stdin_pipe[1]);
+/*
+ * Write one newline-terminated message to the server's stdin, after the
+ * answers the reader thread queued so far (message NULL writes only
+ * those). A server that has exited makes the write fail with EPIPE
+ * instead of raising SIGPIPE in this process. wake_fd as for
+ * mcp_write_all(). Answers that could not be written are dropped.
+ */
+static int mcp_write_message_until(MCPServer *server, const char *message, int wake_fd) {
+    pthread_mutex_lock(&server->write_lock);
+    pthread_mutex_lock(&server->lock);
+    MCPQueuedAnswer *answers = server->answers;
+    server->answers = NULL;
+    server->answer_count = 0;
+    pthread_mutex_unlock(&server->lock);
+
+    if (server->stdin_fd < 0) {
+        pthread_mutex_unlock(&server->write_lock);
+        mcp_free_answers(answers);
         return -1;
     }
 
-    if (pipe(stderr_pipe) < 0) {
-        LOG_ERROR("MCP: Failed to create stderr pipe: %s", strerror(errno));
-        close(stdin_pipe[0]);
-        close(stdin_pipe[1]);
-        close(stdout_pipe[0]);
-        close(stdout_pipe[1]);
-        return -1;
+#ifndef __APPLE__
+    sigset_t pipe_set;
+    sigset_t old_set;
+    sigemptyset(&pipe_set);
+    sigaddset(&pipe_set, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_set, &old_set);
+#endif
+
+    int rc = 0;
+    for (MCPQueuedAnswer *answer = answers; answer && rc == 0; answer = answer->next) {
+        rc = mcp_write_all(server, answer->message, wake_fd);
+        if (rc == 0) {
+            rc = mcp_write_all(server, "\n", wake_fd);
+        }
+    }
+    mcp_free_answers(answers);
+    if (rc == 0 && message) {
+        rc = mcp_write_all(server, message, wake_fd);
+        if (rc == 0) {
+            rc = mcp_write_all(server, "\n", wake_fd);
+        }
     }
 
-    // Fork process
-    pid_t pid = fork();
-    if (pid < 0) {
-        LOG_ERROR("MCP: Failed to fork: %s", strerror(errno));
-        close(stdin_pipe[0]);
-        close(stdin_pipe[1]);
-        close(stdout_pipe[0]);
-        close(stdout_pipe[1]);
-        close(stderr_pipe[0]);
-        close(stderr_pipe[1]);
-        return -1;
+#ifndef __APPLE__
+    if (rc != 0 && errno == EPIPE) {
+        int saved_errno = errno;
+        struct timespec zero = {0, 0};
+        sigtimedwait(&pipe_set, NULL, &zero);  // Discard the SIGPIPE we caused
+        errno = saved_errno;
     }
+    pthread_sigmask(SIG_SETMASK, &old_set, NULL);
+#endif
 
-    if (pid == 0) {
-        // Child process
+    pthread_mutex_unlock(&server->write_lock);
+    return rc;
+}
 
-        // Redirect stdin/stdout/stderr
-        dup2(stdin_pipe[0], STDIN_FILENO);
-        dup2(stdout_pipe[1], STDOUT_FILENO);
-        dup2(stderr_pipe[1], STDERR_FILENO);
+static int mcp_write_message(MCPServer *server, const char *message) {
+    return mcp_write_message_until(server, message, -1);
+}
 
-        // Close unused pipe ends
-        close(stdin_pipe[0]);
-        close(stdin_pipe[1]);
-        close(stdout_pipe[0]);
-        close(stdout_pipe[1]);
-        close(stderr_pipe[0]);
-        close(stderr_pipe[1]);
+/*
+ * Send one message over the server's transport. request_id is the id of a
+ * request whose failure the transport should report (-1 for none).
+ */
+static int mcp_post_message(MCPServer *server, const char *message, int request_id, int initialize) {
+    if (server->transport == MCP_TRANSPORT_SSE) {
+        return mcp_http_send(server->http, message, request_id, initialize);
+    }
+    return mcp_write_message(server, message);
+}
 
-        // Build argv
-        char **argv = calloc((size_t)(server->args_count + 2), sizeof(char*));
-        if (!argv) {
-            exit(1);
-        }
+/*
+ * Answer a request sent by the server (only ping is supported). Runs on
+ * the thread that reads the server's messages: over stdio the answer is
+ * queued for the reply thread, since a server blocked on a full stdout
+ * pipe would never read a write to stdin made from here.
+ */
+static void mcp_answer_server_request(MCPServer *server, cJSON *id, const char *method) {
+    cJSON *reply = cJSON_CreateObject();
+    cJSON_AddStringToObject(reply, "jsonrpc", "2.0");
+    cJSON_AddItemToObject(reply, "id", cJSON_Duplicate(id, 1));
+    if (strcmp(method, "ping") == 0) {
+        cJSON_AddItemToObject(reply, "result", cJSON_CreateObject());
+    } else {
+        LOG_DEBUG("MCP: Server '%s' sent unsupported request '%s'", server->name, method);
+        cJSON *error = cJSON_CreateObject();
+        cJSON_AddNumberToObject(error, "code", -32601);
+        cJSON_AddStringToObject(error, "message", "Method not found");
+        cJSON_AddItemToObject(reply, "error", error);
+    }
+
+    char *reply_str = cJSON_PrintUnformatted(reply);
+    cJSON_Delete(reply);
+    if (!reply_str) {
+        return;
+    }
 
-        argv[0] = server->command;
-        for (int i = 0; i < server->args_count; i++) {
-            argv[i + 1] = server->args[i];
+    if (server->transport == MCP_TRANSPORT_SSE) {
+        if (mcp_post_message(server, reply_str, -1, 0) != 0) {
+            LOG_WARN("MCP: Failed to answer '%s' from server '%s': %s",
+                     method, server->name, strerror(errno));
         }
-        argv[server->args_count + 1] = NULL;
+        free(reply_str);
+        return;
+    }
 
-        // Set environment if provided
-        if (server->env_count > 0) {
-            for (int i = 0; i < server->env_count; i++) {
-                putenv(server->env[i]);
-            }
+    MCPQueuedAnswer *answer = malloc(sizeof(MCPQueuedAnswer));
+    pthread_mutex_lock(&server->lock);
+    if (!answer || !server->reply_running || server->answer_count >= MCP_MAX_QUEUED_ANSWERS) {
+        pthread_mutex_unlock(&server->lock);
+        LOG_WARN("MCP: Dropping the answer to '%s' from server '%s'", method, server->name);
+        free(answer);
+        free(reply_str);
+        return;
+    }
+    answer->message = reply_str;
+    answer->next = NULL;
+    MCPQueuedAnswer **tail = &server->answers;
+    while (*tail) {
+        tail = &(*tail)->next;
+    }
+    *tail = answer;
+    server->answer_count++;
+    pthread_cond_broadcast(&server->cond);
+    pthread_mutex_unlock(&server->lock);
+}
+
+/*
+ * Write the answers the reader thread queued when no request is being
+ * sent to carry them
+ */
+static void* mcp_reply_thread(void *arg) {
+    MCPServer *server = arg;
+
+    pthread_mutex_lock(&server->lock);
+    for (;;) {
+        while (!server->answers && !server->answers_stop) {
+            pthread_cond_wait(&server->cond, &server->lock);
         }
+        if (server->answers_stop) {
+            break;
+        }
+        pthread_mutex_unlock(&server->lock);
 
-        // Execute command
-        execvp(server->command, argv);
+        if (mcp_write_message_until(server, NULL, server->wake_pipe[0]) != 0) {
+            LOG_WARN("MCP: Failed to answer requests from server '%s': %s",
+                     server->name, strerror(errno));
+        }
 
-        // If we get here, exec failed
-        fprintf(stderr, "MCP: Failed to exec %s: %s\n", server->command, strerror(errno));
-        exit(1);
+        pthread_mutex_lock(&server->lock);
     }
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
 
-    // Parent process
-    close(stdin_pipe[0]);   // Close read end of stdin pipe
-    close(stdout_pipe[1]);  // Close write end of stdout pipe
-    close(stderr_pipe[1]);  // Close write end of stderr pipe
-
-    server->pid = pid;
-    server->stdin_fd = stdin_pipe[1];
-    server->stdout_fd = stdout_pipe[0];
-    server->stderr_fd = stderr_pipe[0];
-    server->connected = 1;
+/*
+ * Handle a notification from the server
+ */
+static void mcp_handle_notification(MCPServer *server, cJSON *message, const char *method) {
+    cJSON *params = cJSON_GetObjectItem(message, "params");
 
-    // Set non-blocking mode for stdout and stderr
-    int flags = fcntl(server->stdout_fd, F_GETFL, 0);
-    if (flags >= 0) {
-        fcntl(server->stdout_fd, F_SETFL, flags | O_NONBLOCK);
+    if (strcmp(method, "notifications/message") == 0) {
+        cJSON *data = cJSON_GetObjectItem(params, "data");
+        if (data && cJSON_IsString(data)) {
+            LOG_DEBUG("MCP[%s log]: %s", server->name, data->valuestring);
+        }
+    } else if (strcmp(method, "notifications/tools/list_changed") == 0) {
+        LOG_INFO("MCP: Server '%s' reports that its tool list changed", server->name);
+        // Fetched again by the supervisor; this thread must not wait on a reply
+        pthread_mutex_lock(&server->lock);
+        server->tools_stale = 1;
+        pthread_mutex_unlock(&server->lock);
+        mcp_wake_supervisor();
+    } else if (strcmp(method, "notifications/resources/list_changed") == 0) {
+        LOG_DEBUG("MCP: Server '%s' reports that its resource list changed", server->name);
+        pthread_mutex_lock(&server->lock);
+        cJSON_Delete(server->resource_listing);
+        server->resource_listing = NULL;
+        server->resource_generation++;
+        pthread_mutex_unlock(&server->lock);
+    } else if (strcmp(method, "notifications/resources/updated") == 0) {
+        cJSON *uri = cJSON_GetObjectItem(params, "uri");
+        if (cJSON_IsString(uri)) {
+            LOG_DEBUG("MCP: Resource '%s' of server '%s' changed", uri->valuestring, server->name);
+            mcp_resource_cache_invalidate(server->resource_cache, server->name, uri->valuestring);
+        }
+    } else {
+        LOG_DEBUG("MCP: Notification '%s' from server '%s'", method, server->name);
     }
+}
 
-    flags = fcntl(server->stderr_fd, F_GETFL, 0);
-    if (flags >= 0) {
-        fcntl(server->stderr_fd, F_SETFL, flags | O_NONBLOCK);
+/*
+ * Route one message received from the server
+ * Returns: Id of the waiting request it answered, -1 if none
+ */
+static int mcp_dispatch_message(MCPServer *server, const char *line, size_t len) {
+    LOG_DEBUG("MCP: Received %zu bytes from '%s': %.*s%s", len, server->name,
+              (int)(len < MCP_LOG_PREVIEW ? len : MCP_LOG_PREVIEW), line,
+              len > MCP_LOG_PREVIEW ? "..." : "");
+
+    cJSON *message = cJSON_ParseWithLength(line, len);
+    if (!message) {
+        LOG_ERROR("MCP: Failed to parse JSON message from '%s'. First 200 chars: %.200s%s",
+                 server->name, line, len > 200 ? "..." : "");
+        return -1;
     }
 
-    // Open log file for stderr output
-    // Use ./.claude-c/mcp/<server-name>.log
-    char log_path[512];
-    snprintf(log_path, sizeof(log_path), ".claude-c/mcp/%s.log", server->name);
+    cJSON *id = cJSON_GetObjectItem(message, "id");
+    cJSON *method = cJSON_GetObjectItem(message, "method");
 
-    // Create directory if it doesn't exist
-#ifdef TEST_BUILD
-    if (mcp_mkdir_p(".claude-c/mcp") != 0) {
-#else
-    if (mkdir_p(".claude-c/mcp") != 0) {
-#endif
-        LOG_WARN("MCP: Failed to create directory .claude-c/mcp: %s", strerror(errno));
+    if (method && cJSON_IsString(method)) {
+        if (id) {
+            mcp_answer_server_request(server, id, method->valuestring);
+        } else {
+            mcp_handle_notification(server, message, method->valuestring);
+        }
+        cJSON_Delete(message);
+        return -1;
     }
 
-    server->stderr_log = fopen(log_path, "w");
-    if (server->stderr_log) {
-        LOG_DEBUG("MCP: Logging stderr for '%s' to %s", server->name, log_path);
-    } else {
-        LOG_WARN("MCP: Failed to open stderr log file %s: %s", log_path, strerror(errno));
+    int answered = -1;
+    if (id && cJSON_IsNumber(id)) {
+        pthread_mutex_lock(&server->lock);
+        for (MCPPendingRequest *req = server->pending; req; req = req->next) {
+            if (req->id == id->valueint && !req->response) {
+                req->response = message;
+                message = NULL;
+                answered = req->id;
+                pthread_cond_broadcast(&server->cond);
+                break;
+            }
+        }
+        pthread_mutex_unlock(&server->lock);
     }
 
-    LOG_INFO("MCP: Connected to server '%s' (pid: %d)", server->name, server->pid);
+    if (message) {
+        // Usually the reply to a request that already timed out
+        LOG_WARN("MCP: Dropping unexpected message from '%s' (id: %d)",
+                 server->name, id && cJSON_IsNumber(id) ? id->valueint : -1);
+        cJSON_Delete(message);
+    }
+    return answered;
+}
 
-    // Send initialize request
-    cJSON *request = cJSON_CreateObject();
-    cJSON_AddStringToObject(request, "jsonrpc", "2.0");
-    cJSON_AddNumberToObject(request, "id", server->message_id++);
-    cJSON_AddStringToObject(request, "method", "initialize");
+/*
+ * HTTP transport callbacks (run on the transport thread)
+ */
+static int mcp_http_on_message(void *ctx, const char *message, size_t len) {
+    return mcp_dispatch_message((MCPServer *)ctx, message, len);
+}
 
-    cJSON *params = cJSON_CreateObject();
-    cJSON_AddStringToObject(params, "protocolVersion", "2024-11-05");
+static void mcp_http_on_fail(void *ctx, int request_id, const char *reason) {
+    MCPServer *server = (MCPServer *)ctx;
+    pthread_mutex_lock(&server->lock);
+    for (MCPPendingRequest *req = server->pending; req; req = req->next) {
+        if (req->id == request_id && !req->response) {
+            req->failure = reason;
+            pthread_cond_broadcast(&server->cond);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+}
 
-    // clientInfo should be an object with name and version
-    cJSON *clientInfo = cJSON_CreateObject();
-    cJSON_AddStringToObject(clientInfo, "name", "claude-c");
-    cJSON_AddStringToObject(clientInfo, "version", "1.0");
-    cJSON_AddItemToObject(params, "clientInfo", clientInfo);
+/*
+ * A reply was too large to read. When only one request is waiting it must
+ * have been that one's, so fail it now rather than at its timeout.
+ */
+static void mcp_fail_pending(MCPServer *server) {
+    pthread_mutex_lock(&server->lock);
+    MCPPendingRequest *req = server->pending;
+    if (req && !req->next && !req->response) {
+        req->failure = "response too large";
+        pthread_cond_broadcast(&server->cond);
+    }
+    pthread_mutex_unlock(&server->lock);
+}
 
-    // capabilities is required (can be empty for basic client)
-    cJSON *capabilities = cJSON_CreateObject();
-    cJSON_AddItemToObject(params, "capabilities", capabilities);
+/*
+ * Reader thread: waits on the server's stdout and stderr, frames
+ * newline-delimited JSON-RPC messages and dispatches each one as soon as
+ * it is complete. Exits when the wake pipe is written, or when the server
+ * exits (its pidfd fires) or closes stdout; then the server is down.
+ */
+static void* mcp_reader_thread(void *arg) {
+    MCPServer *server = arg;
+    size_t capacity = MCP_READ_CHUNK;
+    char *buffer = malloc(capacity);
+    size_t start = 0;     // Where the message being framed begins
+    size_t scanned = 0;   // Bytes before this hold no newline of that message
+    size_t used = 0;      // Bytes read into buffer
+    int discarding = 0;   // Skipping the rest of an oversized message
+    int stderr_open = server->stderr_fd >= 0;
+    int exited = 0;       // The process is gone; read what it left, then stop
+    int stopped = 0;      // Woken by mcp_stop_reader
+
+    while (buffer) {
+        struct pollfd fds[4];
+        fds[0].fd = server->stdout_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = stderr_open ? server->stderr_fd : -1;
+        fds[1].events = POLLIN;
+        fds[2].fd = server->wake_pipe[0];
+        fds[2].events = POLLIN;
+        fds[3].fd = exited ? -1 : server->pidfd;
+        fds[3].events = POLLIN;
+        fds[0].revents = fds[1].revents = fds[2].revents = fds[3].revents = 0;
+
+        if (poll(fds, 4, exited ? 0 : -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("MCP: poll failed for server '%s': %s", server->name, strerror(errno));
+            break;
+        }
 
-    cJSON_AddItemToObject(request, "params", params);
+        if (fds[2].revents) {
+            stopped = 1;
+            break;
+        }
 
-    char *request_str = cJSON_PrintUnformatted(request);
-    cJSON_Delete(request);
+        if (fds[3].revents) {
+            // Noticed even when a child of the server still holds stdout open
+            LOG_DEBUG("MCP: Server '%s' exited", server->name);
+            exited = 1;
+        }
 
-    if (request_str) {
-        // Write request with newline (JSON-RPC over stdio uses line-delimited JSON)
-        dprintf(server->stdin_fd, "%s\n", request_str);
-        free(request_str);
+        if (fds[1].revents && mcp_read_stderr(server) != 0) {
+            stderr_open = 0;
+        }
 
-        // Read initialize response
-        char buffer[65536] = {0};
-        size_t total_read = 0;
+        if (!fds[0].revents) {
+            if (exited) {
+                break;  // Everything it wrote before exiting has been read
+            }
+            continue;
+        }
 
-        // Wait for response (with timeout)
-        for (int i = 0; i < 50; i++) {  // 5 second timeout
-            // Read any stderr output during initialization
-            mcp_read_stderr(server);
+        // Make room for the read: move a partial message to the front
+        // first, and grow only when it fills the whole buffer
+        if (used == capacity && start > 0) {
+            memmove(buffer, buffer + start, used - start);
+            used -= start;
+            scanned -= start;
+            start = 0;
+        }
+        if (used == capacity) {
+            if (capacity >= MCP_MAX_MESSAGE_SIZE) {
+                LOG_ERROR("MCP: Message from '%s' exceeds %u bytes, dropping it",
+                          server->name, MCP_MAX_MESSAGE_SIZE);
+                mcp_fail_pending(server);
+                discarding = 1;
+                start = scanned = used = 0;
+            } else {
+                char *grown = realloc(buffer, capacity * 2);
+                if (!grown) {
+                    LOG_ERROR("MCP: Out of memory reading from server '%s'", server->name);
+                    break;
+                }
+                buffer = grown;
+                capacity *= 2;
+            }
+        }
 
-            ssize_t n = read(server->stdout_fd, buffer + total_read, sizeof(buffer) - total_read - 1);
-            if (n > 0) {
-                total_read += (size_t)n;
+        ssize_t n = read(server->stdout_fd, buffer + used, capacity - used);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            continue;
+        }
+        if (n <= 0) {
+            LOG_DEBUG("MCP: Server '%s' closed stdout", server->name);
+            break;
+        }
+        used += (size_t)n;
+
+        // Dispatch every complete line, scanning only the bytes just read
+        char *newline;
+        while ((newline = memchr(buffer + scanned, '\n', used - scanned)) != NULL) {
+            size_t end = (size_t)(newline - buffer);
+            if (discarding) {
+                discarding = 0;
+            } else {
+                size_t len = end - start;
+                if (len > 0 && buffer[end - 1] == '\r') {
+                    len--;
+                }
+                buffer[start + len] = '\0';
+                if (len > 0) {
+                    mcp_dispatch_message(server, buffer + start, len);
+                }
+            }
+            start = end + 1;
+            scanned = start;
+        }
+        scanned = used;
+        if (discarding) {
+            start = used;  // Still inside the oversized message
+        }
 
-                // Check if we have a complete line
-                if (strchr(buffer, '\n')) {
-                    break;
+        // Nothing left over: start again at the front, and give back the
+        // memory a long message needed
+        if (start == used) {
+            start = scanned = used = 0;
+            if (capacity > MCP_READ_CHUNK) {
+                char *shrunk = realloc(buffer, MCP_READ_CHUNK);
+                if (shrunk) {
+                    buffer = shrunk;
+                    capacity = MCP_READ_CHUNK;
                 }
             }
-            usleep(100000);  // 100ms
         }
+    }
+
+    free(buffer);
+
+    // stdout closes just before the process is gone; give its exit status
+    // a moment to become available
+    if (!stopped && !exited && server->pidfd >= 0) {
+        struct pollfd exit_fd = {server->pidfd, POLLIN, 0};
+        poll(&exit_fd, 1, 100);
+    }
 
-        // Read any remaining stderr after initialization
+    // Drain whatever the server wrote to stderr before exiting
+    if (stderr_open) {
         mcp_read_stderr(server);
+    }
 
-        if (total_read > 0) {
-            buffer[total_read] = '\0';
-            LOG_DEBUG("MCP: Initialize response: %s", buffer);
+    pthread_mutex_lock(&server->lock);
+    server->reader_done = 1;
+    if (!stopped && !server->stopping) {
+        int status = 0;
+        if (server->pid > 0 && waitpid(server->pid, &status, WNOHANG) == server->pid) {
+            server->exit_status = status;
+            server->pid = 0;
+        }
+        mcp_mark_down(server);
+    }
+    pthread_cond_broadcast(&server->cond);
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
 
-            // Send "initialized" notification to complete handshake
-            cJSON *notification = cJSON_CreateObject();
-            cJSON_AddStringToObject(notification, "jsonrpc", "2.0");
-            cJSON_AddStringToObject(notification, "method", "notifications/initialized");
-            cJSON_AddItemToObject(notification, "params", cJSON_CreateObject());
+/*
+ * Stop the reader and reply threads and wait for them. Answers not
+ * written yet are dropped.
+ */
+static void mcp_stop_reader(MCPServer *server) {
+    if (server->wake_pipe[1] >= 0) {
+        ssize_t n;
+        do {
+            n = write(server->wake_pipe[1], "x", 1);
+        } while (n < 0 && errno == EINTR);
+    }
+    if (server->reader_running) {
+        pthread_join(server->reader_thread, NULL);
+        server->reader_running = 0;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    int reply_running = server->reply_running;
+    server->answers_stop = 1;
+    pthread_cond_broadcast(&server->cond);
+    pthread_mutex_unlock(&server->lock);
+    if (reply_running) {
+        pthread_join(server->reply_thread, NULL);
+    }
+    pthread_mutex_lock(&server->lock);
+    server->reply_running = 0;
+    mcp_free_answers(server->answers);
+    server->answers = NULL;
+    server->answer_count = 0;
+    pthread_mutex_unlock(&server->lock);
+    for (int i = 0; i < 2; i++) {
+        if (server->wake_pipe[i] >= 0) {
+            close(server->wake_pipe[i]);
+            server->wake_pipe[i] = -1;
+        }
+    }
 
-            char *notif_str = cJSON_PrintUnformatted(notification);
-            cJSON_Delete(notification);
+    // Waiting callers see reader_done, unlink themselves and free any reply
+    pthread_mutex_lock(&server->lock);
+    server->reader_done = 1;
+    pthread_cond_broadcast(&server->cond);
+    pthread_mutex_unlock(&server->lock);
+}
 
-            if (notif_str) {
-                dprintf(server->stdin_fd, "%s\n", notif_str);
-                free(notif_str);
+/*
+ * Create the wake pipe and start the reply and reader threads
+ */
+static int mcp_start_reader(MCPServer *server) {
+    if (mcp_pipe_cloexec(server->wake_pipe) < 0) {
+        LOG_ERROR("MCP: Failed to create wake pipe: %s", strerror(errno));
+        server->wake_pipe[0] = server->wake_pipe[1] = -1;
+        return -1;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->reader_done = 0;
+    server->pending = NULL;
+    server->in_flight = 0;
+    server->answers_stop = 0;
+    pthread_mutex_unlock(&server->lock);
+
+    int rc = pthread_create(&server->reply_thread, NULL, mcp_reply_thread, server);
+    if (rc != 0) {
+        LOG_ERROR("MCP: Failed to start reply thread for '%s': %s", server->name, strerror(rc));
+        mcp_stop_reader(server);
+        return -1;
+    }
+    pthread_mutex_lock(&server->lock);
+    server->reply_running = 1;
+    pthread_mutex_unlock(&server->lock);
+
+    rc = pthread_create(&server->reader_thread, NULL, mcp_reader_thread, server);
+    if (rc != 0) {
+        LOG_ERROR("MCP: Failed to start reader thread for '%s': %s", server->name, strerror(rc));
+        mcp_stop_reader(server);
+        return -1;
+    }
+    server->reader_running = 1;
+    return 0;
+}
+
+/*
+ * Environment for a server process: ours, with the server's "env" entries
+ * added or replacing variables of the same name. The array is allocated,
+ * its strings are borrowed.
+ */
+static char** mcp_build_env(const MCPServer *server) {
+    size_t count = 0;
+    while (environ && environ[count]) {
+        count++;
+    }
+
+    char **envp = calloc(count + (size_t)server->env_count + 1, sizeof(char*));
+    if (!envp) {
+        return NULL;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++) {
+        const char *eq = strchr(environ[i], '=');
+        size_t key_len = eq ? (size_t)(eq - environ[i]) : strlen(environ[i]);
+        int overridden = 0;
+        for (int j = 0; j < server->env_count && !overridden; j++) {
+            const char *entry = server->env[j];
+            overridden = entry && strncmp(entry, environ[i], key_len) == 0 && entry[key_len] == '=';
+        }
+        if (!overridden) {
+            envp[n++] = environ[i];
+        }
+    }
+    for (int j = 0; j < server->env_count; j++) {
+        if (server->env[j]) {
+            envp[n++] = server->env[j];
+        }
+    }
+    envp[n] = NULL;
+    return envp;
+}
+
+/*
+ * Initialize handshake: the initialize request, then the initialized
+ * notification once the server has answered. The server is up once it has.
+ */
+static void mcp_initialize_session(MCPServer *server) {
+    cJSON *params = cJSON_CreateObject();
+    cJSON_AddStringToObject(params, "protocolVersion", "2024-11-05");
+
+    // clientInfo should be an object with name and version
+    cJSON *clientInfo = cJSON_CreateObject();
+    cJSON_AddStringToObject(clientInfo, "name", "claude-c");
+    cJSON_AddStringToObject(clientInfo, "version", "1.0");
+    cJSON_AddItemToObject(params, "clientInfo", clientInfo);
+
+    // capabilities is required (can be empty for basic client)
+    cJSON *capabilities = cJSON_CreateObject();
+    cJSON_AddItemToObject(params, "capabilities", capabilities);
+
+    cJSON *response = mcp_send_request(server, "initialize", params);
+    cJSON_Delete(params);
+
+    if (response) {
+        cJSON *server_caps = cJSON_GetObjectItem(cJSON_GetObjectItem(response, "result"), "capabilities");
+        cJSON *resources = cJSON_GetObjectItem(server_caps, "resources");
+        pthread_mutex_lock(&server->lock);
+        server->resources_subscribe = cJSON_IsTrue(cJSON_GetObjectItem(resources, "subscribe"));
+        mcp_forget_resources(server);
+        pthread_mutex_unlock(&server->lock);
+        cJSON_Delete(response);
+
+        // Send "initialized" notification to complete handshake
+        cJSON *notification = cJSON_CreateObject();
+        cJSON_AddStringToObject(notification, "jsonrpc", "2.0");
+        cJSON_AddStringToObject(notification, "method", "notifications/initialized");
+        cJSON_AddItemToObject(notification, "params", cJSON_CreateObject());
+
+        char *notif_str = cJSON_PrintUnformatted(notification);
+        cJSON_Delete(notification);
+
+        if (notif_str) {
+            if (mcp_post_message(server, notif_str, -1, 0) == 0) {
                 LOG_DEBUG("MCP: Sent initialized notification");
             }
-        } else {
-            LOG_WARN("MCP: No initialize response received from server '%s'", server->name);
+            free(notif_str);
+        }
+        pthread_mutex_lock(&server->lock);
+        if (!server->reader_done) {
+            mcp_mark_up(server);
         }
+        pthread_mutex_unlock(&server->lock);
+    } else {
+        LOG_WARN("MCP: No initialize response received from server '%s'", server->name);
     }
+}
 
+/*
+ * A descriptor that becomes readable when the process exits, or -1 where
+ * pidfds are not available (stdout closing is noticed instead)
+ */
+static int mcp_pidfd_open(pid_t pid) {
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    int fd = (int)syscall(SYS_pidfd_open, pid, 0);
+    if (fd >= 0) {
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+#else
+    (void)pid;
+    return -1;
+#endif
+}
+
+/*
+ * Connect to an MCP server over streamable HTTP
+ */
+static int mcp_connect_http(MCPServer *server) {
+    server->http = mcp_http_open(server->url, server->headers, server->header_count,
+                                 mcp_timeout_ms(), mcp_http_on_message, mcp_http_on_fail, server);
+    if (!server->http) {
+        LOG_ERROR("MCP: Failed to open HTTP session for server '%s'", server->name);
+        return -1;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->reader_done = 0;
+    server->pending = NULL;
+    server->in_flight = 0;
+    server->connected = 1;
+    pthread_mutex_unlock(&server->lock);
+
+    LOG_INFO("MCP: Connected to server '%s' (url: %s)", server->name, server->url);
+
+    mcp_initialize_session(server);
+    mcp_http_listen(server->http);
     return 0;
 }
 
 /*
- * Read and log stderr output from MCP server (non-blocking)
- * This helps capture debug logs and errors from the server.
- * Logs are written both to the main log and to a server-specific file.
+ * Connect to an MCP server (stdio or HTTP transport)
  */
-static void mcp_read_stderr(MCPServer *server) {
-    if (!server || server->stderr_fd < 0) {
+int mcp_connect_server(MCPServer *server) {
+    if (!server || (!server->command && !server->url)) {
+        LOG_ERROR("MCP: Invalid server or missing command");
+        return -1;
+    }
+
+    if (server->connected) {
+        LOG_WARN("MCP: Server '%s' already connected", server->name);
+        return 0;
+    }
+
+    LOG_INFO("MCP: Connecting to server '%s'...", server->name);
+
+    if (server->transport == MCP_TRANSPORT_SSE) {
+        return mcp_connect_http(server);
+    }
+
+    // Build argv and the environment before forking: servers start from
+    // several threads at once, and the child of a threaded process must not
+    // allocate before exec
+    char **argv = calloc((size_t)(server->args_count + 2), sizeof(char*));
+    char **envp = mcp_build_env(server);
+    if (!argv || !envp) {
+        LOG_ERROR("MCP: Failed to allocate arguments for server '%s'", server->name);
+        free(argv);
+        free(envp);
+        return -1;
+    }
+    argv[0] = server->command;
+    for (int i = 0; i < server->args_count; i++) {
+        argv[i + 1] = server->args[i];
+    }
+    argv[server->args_count + 1] = NULL;
+
+    // Create pipes for stdin/stdout/stderr
+    int stdin_pipe[2] = {-1, -1};
+    int stdout_pipe[2] = {-1, -1};
+    int stderr_pipe[2] = {-1, -1};
+
+    if (mcp_pipe_cloexec(stdin_pipe) < 0) {
+        LOG_ERROR("MCP: Failed to create stdin pipe: %s", strerror(errno));
+        free(argv);
+        free(envp);
+        return -1;
+    }
+
+    if (mcp_pipe_cloexec(stdout_pipe) < 0) {
+        LOG_ERROR("MCP: Failed to create stdout pipe: %s", strerror(errno));
+        close(stdin_pipe[0]);
+        close(stdin_pipe[1]);
+        free(argv);
+        free(envp);
+        return -1;
+    }
+
+    if (mcp_pipe_cloexec(stderr_pipe) < 0) {
+        LOG_ERROR("MCP: Failed to create stderr pipe: %s", strerror(errno));
+        close(stdin_pipe[0]);
+        close(stdin_pipe[1]);
+        close(stdout_pipe[0]);
+        close(stdout_pipe[1]);
+        free(argv);
+        free(envp);
+        return -1;
+    }
+
+    // Fork process
+    pid_t pid = fork();
+    if (pid < 0) {
+        LOG_ERROR("MCP: Failed to fork: %s", strerror(errno));
+        close(stdin_pipe[0]);
+        close(stdin_pipe[1]);
+        close(stdout_pipe[0]);
+        close(stdout_pipe[1]);
+        close(stderr_pipe[0]);
+        close(stderr_pipe[1]);
+        free(argv);
+        free(envp);
+        return -1;
+    }
+
+    if (pid == 0) {
+        // Child process
+
+        // Redirect stdin/stdout/stderr (dup2 clears close-on-exec on the
+        // copies; the originals close at exec)
+        dup2(stdin_pipe[0], STDIN_FILENO);
+        dup2(stdout_pipe[1], STDOUT_FILENO);
+        dup2(stderr_pipe[1], STDERR_FILENO);
+
+        // Execute command with the server's environment
+        environ = envp;
+        execvp(server->command, argv);
+
+        // If we get here, exec failed
+        static const char msg[] = "MCP: Failed to exec server command\n";
+        ssize_t written = write(STDERR_FILENO, msg, sizeof(msg) - 1);
+        (void)written;
+        _exit(1);
+    }
+
+    // Parent process
+    free(argv);
+    free(envp);
+    close(stdin_pipe[0]);   // Close read end of stdin pipe
+    close(stdout_pipe[1]);  // Close write end of stdout pipe
+    close(stderr_pipe[1]);  // Close write end of stderr pipe
+
+    pthread_mutex_lock(&server->lock);
+    server->pid = pid;
+    server->connected = 1;
+    pthread_mutex_unlock(&server->lock);
+    server->stdin_fd = stdin_pipe[1];
+    server->stdout_fd = stdout_pipe[0];
+    server->stderr_fd = stderr_pipe[0];
+    server->pidfd = mcp_pidfd_open(pid);
+
+    // Set non-blocking mode for stdout and stderr
+    int flags = fcntl(server->stdout_fd, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(server->stdout_fd, F_SETFL, flags | O_NONBLOCK);
+    }
+
+    flags = fcntl(server->stderr_fd, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(server->stderr_fd, F_SETFL, flags | O_NONBLOCK);
+    }
+
+#ifdef __APPLE__
+    fcntl(server->stdin_fd, F_SETNOSIGPIPE, 1);
+#endif
+
+    mcp_open_stderr_capture(server);
+
+    if (mcp_start_reader(server) != 0) {
+        mcp_disconnect_server(server);
+        return -1;
+    }
+
+    LOG_INFO("MCP: Connected to server '%s' (pid: %d)", server->name, server->pid);
+
+    mcp_initialize_session(server);
+    return 0;
+}
+
+/*
+ * Log one line of a server's stderr (on its flush thread)
+ */
+static void mcp_log_stderr_line(void *ctx, const char *line) {
+    MCPServer *server = ctx;
+    LOG_DEBUG("MCP[%s stderr]: %s", server->name, line);
+}
+
+/*
+ * Start capturing a server's stderr to ./.claude-c/mcp/<server-name>.log
+ * and the debug log. Done on the first connect only: the capture is kept
+ * across restarts, so the file keeps what a crashed server wrote.
+ */
+static void mcp_open_stderr_capture(MCPServer *server) {
+    pthread_mutex_lock(&server->lock);
+    int capturing = server->stderr_capture != NULL;
+    pthread_mutex_unlock(&server->lock);
+    if (capturing) {
         return;
     }
 
-    char buffer[4096];
-    ssize_t n;
+    char log_path[512];
+    snprintf(log_path, sizeof(log_path), ".claude-c/mcp/%s.log", server->name);
 
-    while ((n = read(server->stderr_fd, buffer, sizeof(buffer) - 1)) > 0) {
-        buffer[n] = '\0';
+    // Create directory if it doesn't exist
+#ifdef TEST_BUILD
+    if (mcp_mkdir_p(".claude-c/mcp") != 0) {
+#else
+    if (mkdir_p(".claude-c/mcp") != 0) {
+#endif
+        LOG_WARN("MCP: Failed to create directory .claude-c/mcp: %s", strerror(errno));
+    }
 
-        // Write raw output to server's log file if open
-        if (server->stderr_log) {
-            fwrite(buffer, 1, (size_t)n, server->stderr_log);
-            fflush(server->stderr_log);
-        }
+    MCPStderrLog *capture = mcp_stderr_open(log_path, MCP_STDERR_RING_SIZE,
+                                            mcp_log_stderr_line, server);
+    if (!capture) {
+        LOG_WARN("MCP: Failed to start stderr capture for '%s'", server->name);
+        return;
+    }
+    LOG_DEBUG("MCP: Logging stderr for '%s' to %s", server->name, log_path);
 
-        // Also log each line to main debug log for convenience
-        char *line = buffer;
-        char *next_line;
+    pthread_mutex_lock(&server->lock);
+    server->stderr_capture = capture;
+    pthread_mutex_unlock(&server->lock);
+}
 
-        while ((next_line = strchr(line, '\n')) != NULL) {
-            *next_line = '\0';
-            if (strlen(line) > 0) {
-                LOG_DEBUG("MCP[%s stderr]: %s", server->name, line);
-            }
-            line = next_line + 1;
-        }
+/*
+ * Read stderr output from MCP server (non-blocking)
+ * Runs on the reader thread, so it only queues what it read; the capture's
+ * own thread writes it to the server's log file and the debug log.
+ */
+static int mcp_read_stderr(MCPServer *server) {
+    if (!server || server->stderr_fd < 0) {
+        return -1;
+    }
 
-        // Log any remaining partial line
-        if (strlen(line) > 0) {
-            LOG_DEBUG("MCP[%s stderr]: %s", server->name, line);
-        }
+    char buffer[4096];
+    ssize_t n;
+
+    while ((n = read(server->stderr_fd, buffer, sizeof(buffer))) > 0) {
+        mcp_stderr_append(server->stderr_capture, buffer, (size_t)n, mcp_now_ms());
     }
+
+    // 0 = drained for now, -1 = closed
+    return (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) ? 0 : -1;
 }
 
 /*
@@ -694,11 +1686,22 @@ void mcp_disconnect_server(MCPServer *server) {
 
     LOG_INFO("MCP: Disconnecting from server '%s'", server->name);
 
+    // Changes made while it is gone would go unreported
+    mcp_resource_cache_invalidate(server->resource_cache, server->name, NULL);
+
+    if (server->http) {
+        mcp_http_close(server->http);
+        server->http = NULL;
+    }
+    mcp_stop_reader(server);
+
     // Close pipes
+    pthread_mutex_lock(&server->write_lock);
     if (server->stdin_fd >= 0) {
         close(server->stdin_fd);
         server->stdin_fd = -1;
     }
+    pthread_mutex_unlock(&server->write_lock);
 
     if (server->stdout_fd >= 0) {
         close(server->stdout_fd);
@@ -710,10 +1713,9 @@ void mcp_disconnect_server(MCPServer *server) {
         server->stderr_fd = -1;
     }
 
-    // Close stderr log file
-    if (server->stderr_log) {
-        fclose(server->stderr_log);
-        server->stderr_log = NULL;
+    if (server->pidfd >= 0) {
+        close(server->pidfd);
+        server->pidfd = -1;
     }
 
     // Kill process if still running
@@ -733,26 +1735,54 @@ void mcp_disconnect_server(MCPServer *server) {
         kill(server->pid, SIGKILL);
         waitpid(server->pid, &status, 0);
 
+        pthread_mutex_lock(&server->lock);
         server->pid = 0;
+        pthread_mutex_unlock(&server->lock);
     }
 
+    pthread_mutex_lock(&server->lock);
     server->connected = 0;
+    mcp_forget_resources(server);
+    pthread_mutex_unlock(&server->lock);
     LOG_INFO("MCP: Disconnected from server '%s'", server->name);
 }
 
 /*
- * Send JSON-RPC request and read response
+ * Send JSON-RPC request and wait for the reader thread to hand over the
+ * response with the same id. Any number of threads may call this for the
+ * same server at once; up to max_in_flight requests are outstanding and
+ * the rest wait for a slot.
  */
 static cJSON* mcp_send_request(MCPServer *server, const char *method, cJSON *params) {
-    if (!server || !server->connected) {
+    if (!server) {
         LOG_ERROR("MCP: Server not connected");
         return NULL;
     }
 
+    long timeout_ms = mcp_timeout_ms();
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    MCPPendingRequest req = {0, NULL, NULL, NULL};
+    pthread_mutex_lock(&server->lock);
+    int connected = server->connected;
+    req.id = server->message_id++;
+    pthread_mutex_unlock(&server->lock);
+    if (!connected) {
+        LOG_ERROR("MCP: Server '%s' not connected", server->name);
+        return NULL;
+    }
+
     // Build request
     cJSON *request = cJSON_CreateObject();
     cJSON_AddStringToObject(request, "jsonrpc", "2.0");
-    cJSON_AddNumberToObject(request, "id", server->message_id++);
+    cJSON_AddNumberToObject(request, "id", req.id);
     cJSON_AddStringToObject(request, "method", method);
 
     // Always include params field (even if empty) per JSON-RPC 2.0 spec
@@ -770,148 +1800,703 @@ static cJSON* mcp_send_request(MCPServer *server, const char *method, cJSON *par
         return NULL;
     }
 
+    // Take an in-flight slot and register for the reply before sending, so
+    // a fast reply cannot arrive ahead of its waiter
+    int max_in_flight = server->max_in_flight > 0 ? server->max_in_flight : MCP_DEFAULT_MAX_IN_FLIGHT;
+    pthread_mutex_lock(&server->lock);
+    while (server->in_flight >= max_in_flight && !server->reader_done && !server->stopping &&
+           server->health != MCP_HEALTH_DOWN) {
+        if (pthread_cond_timedwait(&server->cond, &server->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    if (server->reader_done || server->stopping || server->health == MCP_HEALTH_DOWN ||
+        server->in_flight >= max_in_flight) {
+        const char *why = server->stopping ? "shutting down" :
+                          server->health == MCP_HEALTH_DOWN ? "server is down" :
+                          server->reader_done ? "server closed the connection" :
+                          "timed out waiting for a request slot";
+        server->failures++;
+        pthread_mutex_unlock(&server->lock);
+        LOG_ERROR("MCP: Cannot send '%s' to server '%s' (%s)", method, server->name, why);
+        free(request_str);
+        return NULL;
+    }
+    server->in_flight++;
+    req.next = server->pending;
+    server->pending = &req;
+    pthread_mutex_unlock(&server->lock);
+
     // Send request
     LOG_DEBUG("MCP: Sending request to '%s': %s", server->name, request_str);
-    dprintf(server->stdin_fd, "%s\n", request_str);
+    long long sent_us = mcp_now_us();
+    int write_rc = mcp_post_message(server, request_str, req.id, strcmp(method, "initialize") == 0);
     free(request_str);
 
-    // Read response (line-delimited JSON)
-    char buffer[65536] = {0};
-    size_t total_read = 0;
+    // Wait for the reader thread to deliver the response
+    const char *reason = "timed out";
+    pthread_mutex_lock(&server->lock);
+    if (write_rc != 0) {
+        reason = "write failed";
+    } else {
+        while (!req.response && !req.failure && !server->reader_done && !server->stopping &&
+               server->health != MCP_HEALTH_DOWN) {
+            if (pthread_cond_timedwait(&server->cond, &server->lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+        if (req.failure && !req.response) {
+            reason = req.failure;
+        } else if (!req.response && server->health == MCP_HEALTH_DOWN) {
+            reason = "server is down";
+        } else if (!req.response && server->reader_done) {
+            reason = "server closed the connection";
+        } else if (!req.response && server->stopping) {
+            reason = "shutting down";
+        }
+    }
+    for (MCPPendingRequest **link = &server->pending; *link; link = &(*link)->next) {
+        if (*link == &req) {
+            *link = req.next;
+            break;
+        }
+    }
+    server->in_flight--;
+    pthread_cond_broadcast(&server->cond);  // A slot is free
+    cJSON *response = req.response;
+    if (response) {
+        long long latency_us = mcp_now_us() - sent_us;
+        server->requests++;
+        server->latency_total_us += latency_us;
+        if (latency_us > server->latency_max_us) {
+            server->latency_max_us = latency_us;
+        }
+    } else {
+        server->failures++;
+    }
+    pthread_mutex_unlock(&server->lock);
 
-    // Wait for response (with timeout)
-    for (int i = 0; i < 50; i++) {  // 5 second timeout
-        // Read any stderr output (for logging/debugging)
-        mcp_read_stderr(server);
+    if (!response) {
+        LOG_ERROR("MCP: No response from server '%s' to '%s' (%s)", server->name, method, reason);
+        return NULL;
+    }
 
-            // Read any stderr output during initialization
-            mcp_read_stderr(server);
+    // Check for JSON-RPC error
+    cJSON *error = cJSON_GetObjectItem(response, "error");
+    if (error) {
+        cJSON *message = cJSON_GetObjectItem(error, "message");
+        const char *error_msg = (message && cJSON_IsString(message)) ? message->valuestring : "unknown";
+        LOG_ERROR("MCP: Server returned error: %s", error_msg);
+        (void)error_msg;  // Suppress unused warning when LOG_ERROR is stubbed out
+        cJSON_Delete(response);
+        return NULL;
+    }
 
-        ssize_t n = read(server->stdout_fd, buffer + total_read, sizeof(buffer) - total_read - 1);
-        if (n > 0) {
-            total_read += (size_t)n;
+    return response;
+}
 
-            // Check if we have a complete line
-            if (strchr(buffer, '\n')) {
-                break;
+/*
+ * Directory of the tool schema cache, or -1 when it is turned off
+ */
+static int mcp_tool_cache_dir(char *dir, size_t size) {
+    int n;
+    const char *env = getenv("CLAUDE_MCP_CACHE_DIR");
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+
+    if (env) {
+        if (env[0] == '\0') {
+            return -1;
+        }
+        n = snprintf(dir, size, "%s", env);
+    } else if (xdg && xdg[0] != '\0') {
+        n = snprintf(dir, size, "%s/claude-c/mcp", xdg);
+    } else if (home && home[0] != '\0') {
+        n = snprintf(dir, size, "%s/.cache/claude-c/mcp", home);
+    } else {
+        return -1;
+    }
+    return (n < 0 || (size_t)n >= size) ? -1 : 0;
+}
+
+// FNV-1a over s including its NUL, so ("ab", "c") and ("a", "bc") differ
+static uint64_t mcp_hash_string(uint64_t hash, const char *s) {
+    do {
+        hash ^= (unsigned char)*s;
+        hash *= 1099511628211ULL;
+    } while (*s++);
+    return hash;
+}
+
+/*
+ * Cache file for a server: the same command line gets the same file
+ */
+static int mcp_tool_cache_path(const MCPServer *server, char *path, size_t size) {
+    if (!server->command && !server->url) {
+        return -1;
+    }
+    char dir[384];
+    if (mcp_tool_cache_dir(dir, sizeof(dir)) != 0) {
+        return -1;
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    hash = mcp_hash_string(hash, server->command ? server->command : server->url);
+    for (int i = 0; i < server->header_count; i++) {
+        hash = mcp_hash_string(hash, server->headers[i] ? server->headers[i] : "");
+    }
+    for (int i = 0; i < server->args_count; i++) {
+        hash = mcp_hash_string(hash, server->args[i] ? server->args[i] : "");
+    }
+    hash = mcp_hash_string(hash, "");  // Keeps args apart from env
+    for (int i = 0; i < server->env_count; i++) {
+        hash = mcp_hash_string(hash, server->env[i] ? server->env[i] : "");
+    }
+
+    int n = snprintf(path, size, "%s/%016" PRIx64 ".json", dir, hash);
+    return (n < 0 || (size_t)n >= size) ? -1 : 0;
+}
+
+/*
+ * Tool schemas cached for a server's command line, NULL if there are none
+ */
+static cJSON* mcp_load_cached_tools(const MCPServer *server) {
+    char path[512];
+    if (mcp_tool_cache_path(server, path, sizeof(path)) != 0) {
+        return NULL;
+    }
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    char *data = size > 0 ? malloc((size_t)size + 1) : NULL;
+    size_t read_len = data ? fread(data, 1, (size_t)size, fp) : 0;
+    fclose(fp);
+    if (!data) {
+        return NULL;
+    }
+    data[read_len] = '\0';
+
+    cJSON *tools = cJSON_Parse(data);
+    free(data);
+    if (!tools || !cJSON_IsArray(tools)) {
+        LOG_WARN("MCP: Ignoring unreadable tool cache %s", path);
+        cJSON_Delete(tools);
+        return NULL;
+    }
+    return tools;
+}
+
+/*
+ * Write a server's tool schemas to the cache. The file is replaced by a
+ * rename, so a concurrent reader never sees half of it.
+ */
+static void mcp_save_cached_tools(const MCPServer *server, const char *json) {
+    char path[512];
+    if (!json || mcp_tool_cache_path(server, path, sizeof(path)) != 0) {
+        return;
+    }
+
+    char dir[512];
+    snprintf(dir, sizeof(dir), "%s", path);
+    char *slash = strrchr(dir, '/');
+    if (slash) {
+        *slash = '\0';
+#ifdef TEST_BUILD
+        if (mcp_mkdir_p(dir) != 0) {
+#else
+        if (mkdir_p(dir) != 0) {
+#endif
+            LOG_WARN("MCP: Failed to create tool cache directory %s: %s", dir, strerror(errno));
+            return;
+        }
+    }
+
+    char tmp_path[528];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.XXXXXX", path);
+    int fd = mkstemp(tmp_path);
+    if (fd < 0) {
+        LOG_WARN("MCP: Failed to write tool cache %s: %s", path, strerror(errno));
+        return;
+    }
+
+    size_t len = strlen(json);
+    const char *p = json;
+    while (len > 0) {
+        ssize_t written = write(fd, p, len);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0) {
+            break;
+        }
+        p += written;
+        len -= (size_t)written;
+    }
+    close(fd);
+
+    if (len > 0 || rename(tmp_path, path) != 0) {
+        LOG_WARN("MCP: Failed to write tool cache %s: %s", path, strerror(errno));
+        unlink(tmp_path);
+        return;
+    }
+    LOG_DEBUG("MCP: Cached tool schemas of '%s' in %s", server->name, path);
+}
+
+/*
+ * Replace a server's tools with the given tools/list array, which it takes
+ * over. Readers of tools and tool_schemas hold the lock, so the old ones
+ * can be freed once swapped out.
+ * Returns: Number of tools
+ */
+static int mcp_install_tools(MCPServer *server, cJSON *schemas, int cached) {
+    int count = schemas ? cJSON_GetArraySize(schemas) : 0;
+    char **names = count > 0 ? calloc((size_t)count, sizeof(char*)) : NULL;
+    if (count > 0 && !names) {
+        LOG_ERROR("MCP: Failed to allocate tool array");
+        cJSON_Delete(schemas);
+        return -1;
+    }
+
+    int idx = 0;
+    cJSON *tool = NULL;
+    cJSON_ArrayForEach(tool, schemas) {
+        cJSON *name = cJSON_GetObjectItem(tool, "name");
+        if (name && cJSON_IsString(name)) {
+            names[idx] = strdup(name->valuestring);
+            if (!names[idx]) {
+                LOG_WARN("MCP: Failed to allocate tool name, skipping");
+                continue;
+            }
+            LOG_DEBUG("MCP: Tool '%s' from server '%s'%s", name->valuestring, server->name,
+                      cached ? " (cached)" : "");
+            idx++;
+        }
+    }
+
+    pthread_mutex_lock(&server->lock);
+    char **old_names = server->tools;
+    int old_count = server->tool_count;
+    cJSON *old_schemas = server->tool_schemas;
+    server->tools = names;
+    server->tool_count = idx;
+    server->tool_schemas = schemas;
+    server->tools_cached = cached;
+    server->tools_ready = 1;
+    pthread_mutex_unlock(&server->lock);
+    atomic_fetch_add(&mcp_tool_generation, 1);
+
+    for (int i = 0; i < old_count; i++) {
+        free(old_names[i]);
+    }
+    free(old_names);
+    cJSON_Delete(old_schemas);
+    return idx;
+}
+
+/*
+ * Discover tools from a connected MCP server
+ */
+int mcp_discover_tools(MCPServer *server) {
+    if (!server || !server->connected) {
+        LOG_ERROR("MCP: Server not connected");
+        return -1;
+    }
+
+    LOG_INFO("MCP: Discovering tools from server '%s'...", server->name);
+
+    // A list_changed arriving from here on means this reply may be outdated
+    pthread_mutex_lock(&server->lock);
+    server->tools_stale = 0;
+    pthread_mutex_unlock(&server->lock);
+
+    cJSON *response = mcp_send_request(server, "tools/list", NULL);
+    if (!response) {
+        return -1;
+    }
+
+    // Extract tools from response
+    cJSON *result = cJSON_GetObjectItem(response, "result");
+    if (!result) {
+        char *resp_str = cJSON_Print(response);
+        LOG_ERROR("MCP: No result in tools/list response. Full response: %s", resp_str ? resp_str : "null");
+        free(resp_str);
+        cJSON_Delete(response);
+        return -1;
+    }
+
+    cJSON *tools = cJSON_GetObjectItem(result, "tools");
+    if (!tools || !cJSON_IsArray(tools)) {
+        char *result_str = cJSON_Print(result);
+        LOG_ERROR("MCP: Invalid tools array in response. Result: %s", result_str ? result_str : "null");
+        free(result_str);
+        cJSON_Delete(response);
+        return -1;
+    }
+    cJSON_DetachItemViaPointer(result, tools);
+    cJSON_Delete(response);
+
+    // Usually the cached list is still current and nothing needs replacing
+    char *json = cJSON_PrintUnformatted(tools);
+    pthread_mutex_lock(&server->lock);
+    char *current = server->tool_schemas ? cJSON_PrintUnformatted(server->tool_schemas) : NULL;
+    int unchanged = json && current && strcmp(json, current) == 0;
+    int count = server->tool_count;
+    if (unchanged) {
+        server->tools_cached = 0;
+        server->tools_ready = 1;
+    }
+    pthread_mutex_unlock(&server->lock);
+    free(current);
+
+    if (unchanged) {
+        free(json);
+        cJSON_Delete(tools);
+        LOG_DEBUG("MCP: Tool list of server '%s' is unchanged", server->name);
+        return count;
+    }
+
+    count = mcp_install_tools(server, tools, 0);
+    if (count >= 0) {
+        mcp_save_cached_tools(server, json);
+    }
+    free(json);
+
+    if (count == 0) {
+        LOG_INFO("MCP: Server '%s' provides no tools", server->name);
+    } else if (count > 0) {
+        LOG_INFO("MCP: Discovered %d tool(s) from server '%s'", count, server->name);
+    }
+    return count;
+}
+
+/*
+ * Decode a base64 string item into result->blob. The decoded bytes
+ * overwrite the string cJSON allocated for it, which the result then
+ * takes over, so a large image is neither copied nor held twice. The
+ * response was parsed on the reader thread, which never routes cJSON into
+ * an arena, so the string is ordinary heap memory.
+ */
+static void mcp_take_base64_blob(MCPToolResult *result, cJSON *item) {
+    size_t encoded_len = strlen(item->valuestring);
+    size_t decoded_len = base64_decode_in_place(item->valuestring, encoded_len);
+
+    // Shrinking a large block gives back the tail without moving it
+    char *blob = realloc(item->valuestring, decoded_len + 1);
+    if (!blob) {
+        blob = item->valuestring;
+    }
+    item->valuestring = NULL;  // cJSON_Delete() skips it now
+
+    free(result->blob);
+    result->blob = blob;
+    result->blob_size = decoded_len;
+    LOG_DEBUG("MCP: Binary content decoded (encoded size: %zu, decoded size: %zu)", encoded_len, decoded_len);
+}
+
+/*
+ * Background startup of one server
+ */
+static void* mcp_startup_thread(void *arg) {
+    MCPServer *server = arg;
+
+    if (mcp_connect_server(server) == 0) {
+        int tool_count = mcp_discover_tools(server);
+        if (tool_count > 0) {
+            LOG_INFO("MCP: Server '%s' ready with %d tool(s)", server->name, tool_count);
+        } else if (tool_count == 0) {
+            LOG_DEBUG("MCP: Server '%s' provides no tools", server->name);
+        } else {
+            LOG_WARN("MCP: Failed to discover tools from server '%s'", server->name);
+        }
+    } else {
+        LOG_WARN("MCP: Failed to connect to server '%s'", server->name);
+        // Do not keep offering cached tools nothing can run
+        mcp_install_tools(server, NULL, 0);
+    }
+
+    pthread_mutex_lock(&server->lock);
+    if (server->health != MCP_HEALTH_UP && !server->stopping) {
+        mcp_mark_down(server);  // Never came up; the supervisor retries
+    }
+    server->starting = 0;
+    pthread_cond_broadcast(&server->cond);
+    pthread_mutex_unlock(&server->lock);
+    mcp_wake_supervisor();
+    return NULL;
+}
+
+/*
+ * Start a server again after it went down. Runs on the supervisor, which
+ * has already claimed the server by setting starting.
+ */
+static void mcp_restart_server(MCPServer *server) {
+    // Calls still on the old process fail fast while it is down; let them
+    // leave before the connection they use is torn down
+    pthread_mutex_lock(&server->lock);
+    while (server->in_flight > 0 && !server->stopping) {
+        pthread_cond_wait(&server->cond, &server->lock);
+    }
+    int stopping = server->stopping;
+    if (!stopping) {
+        server->health = MCP_HEALTH_RESTARTING;
+    }
+    pthread_mutex_unlock(&server->lock);
+
+    int ok = 0;
+    if (!stopping) {
+        LOG_INFO("MCP: Restarting server '%s'", server->name);
+        mcp_disconnect_server(server);
+        if (mcp_connect_server(server) == 0) {
+            pthread_mutex_lock(&server->lock);
+            int up = server->health == MCP_HEALTH_UP;
+            pthread_mutex_unlock(&server->lock);
+            ok = up && mcp_discover_tools(server) >= 0;
+        }
+    }
+
+    pthread_mutex_lock(&server->lock);
+    if (ok && server->health == MCP_HEALTH_UP) {
+        server->restarts++;
+        LOG_INFO("MCP: Server '%s' is back up (restart %d)", server->name, server->restarts);
+    } else if (!server->stopping) {
+        // mcp_mark_down keeps the backoff of a server that is already down
+        if (server->health != MCP_HEALTH_DOWN) {
+            mcp_mark_down(server);
+        }
+    }
+    server->starting = 0;
+    pthread_cond_broadcast(&server->cond);
+    pthread_mutex_unlock(&server->lock);
+}
+
+/*
+ * Fetch a server's tools again after it said they changed
+ */
+static void* mcp_refresh_thread(void *arg) {
+    MCPServer *server = arg;
+
+    if (mcp_discover_tools(server) < 0) {
+        LOG_WARN("MCP: Failed to refresh tools of server '%s'", server->name);
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->refresh_done = 1;
+    pthread_mutex_unlock(&server->lock);
+    mcp_wake_supervisor();
+    return NULL;
+}
+
+/*
+ * Join a finished refresh of a server's tools, then start another if the
+ * server said they changed, unless it is starting, stopping or down. Runs
+ * on the supervisor thread only.
+ */
+static void mcp_refresh_if_stale(MCPServer *server) {
+    pthread_mutex_lock(&server->lock);
+    int done = server->refresh_done;
+    int refresh = server->tools_stale && server->connected && !server->starting &&
+                  !server->stopping && server->health != MCP_HEALTH_DOWN;
+    server->refresh_done = 0;
+    pthread_mutex_unlock(&server->lock);
+
+    if (server->refresh_running) {
+        if (!done) {
+            return;
+        }
+        pthread_join(server->refresh_thread, NULL);
+        server->refresh_running = 0;
+    }
+    if (!refresh) {
+        return;
+    }
+
+    int rc = pthread_create(&server->refresh_thread, NULL, mcp_refresh_thread, server);
+    if (rc != 0) {
+        LOG_WARN("MCP: Failed to refresh tools of server '%s': %s", server->name, strerror(rc));
+        return;
+    }
+    server->refresh_running = 1;
+}
+
+/*
+ * Restart servers that went down once their backoff has passed, and fetch
+ * the tools of servers that reported a change on a thread of their own. Sleeps until the next
+ * restart is due or a server's health or tools change.
+ */
+static void* mcp_supervisor_thread(void *arg) {
+    MCPConfig *config = arg;
+
+    pthread_mutex_lock(&mcp_supervisor_lock);
+    for (;;) {
+        if (config->supervisor_stop) {
+            break;
+        }
+        unsigned long events = mcp_supervisor_events;
+        pthread_mutex_unlock(&mcp_supervisor_lock);
+
+        long long now = mcp_now_ms();
+        long long next = -1;
+        int restarted = 0;
+        for (int i = 0; i < config->server_count; i++) {
+            MCPServer *server = config->servers[i];
+            if (!server) {
+                continue;
+            }
+            pthread_mutex_lock(&server->lock);
+            // A refresh still running fails fast and wakes the supervisor
+            int down = server->health == MCP_HEALTH_DOWN && !server->starting &&
+                       !server->stopping && !server->refresh_running;
+            int due = down && server->restart_at_ms <= now;
+            if (due) {
+                server->starting = 1;
+            } else if (down && (next < 0 || server->restart_at_ms < next)) {
+                next = server->restart_at_ms;
+            }
+            pthread_mutex_unlock(&server->lock);
+            if (due) {
+                mcp_restart_server(server);
+                restarted = 1;
+            } else {
+                mcp_refresh_if_stale(server);
             }
         }
-        usleep(100000);  // 100ms
-    }
-
-    // Read any remaining stderr output
-    mcp_read_stderr(server);
-
-    if (total_read == 0) {
-        LOG_ERROR("MCP: No response from server '%s'", server->name);
-        return NULL;
-    }
-
-    buffer[total_read] = '\0';
-    LOG_DEBUG("MCP: Received response from '%s': %s", server->name, buffer);
-
-    // Parse response
-    cJSON *response = cJSON_Parse(buffer);
-    if (!response) {
-        // Show first 200 chars of response for debugging
-        char preview[201];
-        snprintf(preview, sizeof(preview), "%.200s", buffer);
-        LOG_ERROR("MCP: Failed to parse JSON response from '%s'. First 200 chars: %s%s",
-                 server->name, preview, total_read > 200 ? "..." : "");
-        return NULL;
-    }
 
-    // Check for JSON-RPC error
-    cJSON *error = cJSON_GetObjectItem(response, "error");
-    if (error) {
-        cJSON *message = cJSON_GetObjectItem(error, "message");
-        const char *error_msg = (message && cJSON_IsString(message)) ? message->valuestring : "unknown";
-        LOG_ERROR("MCP: Server returned error: %s", error_msg);
-        (void)error_msg;  // Suppress unused warning when LOG_ERROR is stubbed out
-        cJSON_Delete(response);
-        return NULL;
+        pthread_mutex_lock(&mcp_supervisor_lock);
+        if (restarted) {
+            continue;  // Restarts take time; look again before sleeping
+        }
+        if (next < 0) {
+            while (mcp_supervisor_events == events && !config->supervisor_stop) {
+                pthread_cond_wait(&mcp_supervisor_cond, &mcp_supervisor_lock);
+            }
+        } else {
+            long long wait_ms = next - mcp_now_ms();
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            if (wait_ms > 0) {
+                deadline.tv_sec += (time_t)(wait_ms / 1000);
+                deadline.tv_nsec += (long)(wait_ms % 1000) * 1000000L;
+                if (deadline.tv_nsec >= 1000000000L) {
+                    deadline.tv_sec++;
+                    deadline.tv_nsec -= 1000000000L;
+                }
+                while (mcp_supervisor_events == events && !config->supervisor_stop) {
+                    if (pthread_cond_timedwait(&mcp_supervisor_cond, &mcp_supervisor_lock,
+                                               &deadline) == ETIMEDOUT) {
+                        break;
+                    }
+                }
+            }
+        }
     }
-
-    return response;
+    pthread_mutex_unlock(&mcp_supervisor_lock);
+    return NULL;
 }
 
 /*
- * Discover tools from a connected MCP server
+ * Start every configured server in the background
  */
-int mcp_discover_tools(MCPServer *server) {
-    if (!server || !server->connected) {
-        LOG_ERROR("MCP: Server not connected");
-        return -1;
+int mcp_start_servers(MCPConfig *config) {
+    if (!config) {
+        return 0;
     }
 
-    LOG_INFO("MCP: Discovering tools from server '%s'...", server->name);
+    int started = 0;
+    for (int i = 0; i < config->server_count; i++) {
+        MCPServer *server = config->servers[i];
+        if (!server || server->startup_running || server->connected) {
+            continue;
+        }
 
-    cJSON *response = mcp_send_request(server, "tools/list", NULL);
-    if (!response) {
-        return -1;
-    }
+        cJSON *cached = mcp_load_cached_tools(server);
+        if (cached) {
+            int count = mcp_install_tools(server, cached, 1);
+            LOG_DEBUG("MCP: Offering %d cached tool(s) of server '%s' while it starts", count, server->name);
+        }
 
-    // Extract tools from response
-    cJSON *result = cJSON_GetObjectItem(response, "result");
-    if (!result) {
-        char *resp_str = cJSON_Print(response);
-        LOG_ERROR("MCP: No result in tools/list response. Full response: %s", resp_str ? resp_str : "null");
-        free(resp_str);
-        cJSON_Delete(response);
-        return -1;
-    }
+        pthread_mutex_lock(&server->lock);
+        server->starting = 1;
+        pthread_mutex_unlock(&server->lock);
 
-    cJSON *tools = cJSON_GetObjectItem(result, "tools");
-    if (!tools || !cJSON_IsArray(tools)) {
-        char *result_str = cJSON_Print(result);
-        LOG_ERROR("MCP: Invalid tools array in response. Result: %s", result_str ? result_str : "null");
-        free(result_str);
-        cJSON_Delete(response);
-        return -1;
+        int rc = pthread_create(&server->startup_thread, NULL, mcp_startup_thread, server);
+        if (rc != 0) {
+            LOG_ERROR("MCP: Failed to start server '%s' in the background: %s", server->name, strerror(rc));
+            pthread_mutex_lock(&server->lock);
+            server->starting = 0;
+            pthread_mutex_unlock(&server->lock);
+            continue;
+        }
+        server->startup_running = 1;
+        started++;
     }
 
-    int tool_count = cJSON_GetArraySize(tools);
-    if (tool_count <= 0) {
-        LOG_INFO("MCP: Server '%s' provides no tools", server->name);
-        cJSON_Delete(response);
-        return 0;
+    if (!config->supervisor_running && config->server_count > 0) {
+        int rc = pthread_create(&config->supervisor, NULL, mcp_supervisor_thread, config);
+        if (rc == 0) {
+            config->supervisor_running = 1;
+        } else {
+            LOG_WARN("MCP: Failed to start the server supervisor: %s", strerror(rc));
+        }
     }
 
-    // Store tool names
-    server->tool_count = tool_count;
-    server->tools = calloc((size_t)tool_count, sizeof(char*));
-    server->tool_schemas = cJSON_Duplicate(tools, 1);
+    LOG_DEBUG("MCP: Starting %d server(s) in the background", started);
+    return started;
+}
 
-    if (!server->tools) {
-        LOG_ERROR("MCP: Failed to allocate tool array");
-        cJSON_Delete(response);
-        return -1;
+/*
+ * Wait for background startups to finish
+ */
+void mcp_wait_for_servers(MCPConfig *config) {
+    if (!config) {
+        return;
     }
 
-    int idx = 0;
-    cJSON *tool = NULL;
-    cJSON_ArrayForEach(tool, tools) {
-        cJSON *name = cJSON_GetObjectItem(tool, "name");
-        if (name && cJSON_IsString(name)) {
-            server->tools[idx] = strdup(name->valuestring);
-            if (!server->tools[idx]) {
-                LOG_WARN("MCP: Failed to allocate tool name, skipping");
-                continue;
-            }
-            LOG_INFO("MCP: Discovered tool '%s' from server '%s'", name->valuestring, server->name);
-            idx++;
+    for (int i = 0; i < config->server_count; i++) {
+        MCPServer *server = config->servers[i];
+        if (server && server->startup_running) {
+            pthread_join(server->startup_thread, NULL);
+            server->startup_running = 0;
         }
     }
+}
 
-    cJSON_Delete(response);
-    LOG_INFO("MCP: Discovered %d tool(s) from server '%s'", idx, server->name);
-    return idx;
+/*
+ * Wait until a background startup or restart of the server has finished.
+ * Returns 0 when the server can take calls, -1 while it is down.
+ */
+static int mcp_wait_started(MCPServer *server) {
+    pthread_mutex_lock(&server->lock);
+    while (server->starting && !server->stopping && server->health != MCP_HEALTH_DOWN) {
+        pthread_cond_wait(&server->cond, &server->lock);
+    }
+    int down = server->health == MCP_HEALTH_DOWN;
+    pthread_mutex_unlock(&server->lock);
+    return down ? -1 : 0;
 }
 
 /*
  * Call an MCP tool
  */
 MCPToolResult* mcp_call_tool(MCPServer *server, const char *tool_name, cJSON *arguments) {
+    // The tool may have been offered from the cache before the server was up
+    if (server && tool_name && mcp_wait_started(server) != 0) {
+        LOG_WARN("MCP: Server '%s' is down, not calling tool '%s'", server->name, tool_name);
+        MCPToolResult *error_result = calloc(1, sizeof(MCPToolResult));
+        if (error_result) {
+            char message[256];
+            snprintf(message, sizeof(message), "MCP: Server '%s' is down (restarting)", server->name);
+            error_result->tool_name = strdup(tool_name);
+            error_result->is_error = 1;
+            error_result->result = strdup(message);
+        }
+        return error_result;
+    }
     if (!server || !server->connected || !tool_name) {
         LOG_ERROR("MCP: Invalid parameters for tool call");
         MCPToolResult *error_result = calloc(1, sizeof(MCPToolResult));
@@ -1011,54 +2596,14 @@ MCPToolResult* mcp_call_tool(MCPServer *server, const char *tool_name, cJSON *ar
                 strcmp(content_type->valuestring, "image") == 0) {
                 cJSON *image_data = cJSON_GetObjectItem(item, "data");
                 if (image_data && cJSON_IsString(image_data)) {
-                    // Handle image content (base64 encoded)
-                    const char *image_str = image_data->valuestring;
-                    size_t image_len = strlen(image_str);
-
-                    // Decode base64
-                    size_t decoded_size = 0;
-                    unsigned char *decoded_data = base64_decode(image_str, image_len, &decoded_size);
-                    if (decoded_data) {
-                        result->blob = decoded_data;
-                        result->blob_size = decoded_size;
-                        LOG_DEBUG("MCP: Image content received and decoded (encoded size: %zu, decoded size: %zu)", image_len, decoded_size);
-                    } else {
-                        LOG_WARN("MCP: Failed to decode base64 image content");
-                        // Fallback: store as-is
-                        result->blob = malloc(image_len);
-                        if (result->blob) {
-                            memcpy(result->blob, image_str, image_len);
-                            result->blob_size = image_len;
-                            LOG_DEBUG("MCP: Image content stored as-is (size: %zu)", image_len);
-                        }
-                    }
+                    mcp_take_base64_blob(result, image_data);
                 }
             }
 
             // Handle blob (binary) content (legacy format)
             cJSON *blob = cJSON_GetObjectItem(item, "blob");
             if (blob && cJSON_IsString(blob) && !result->blob) {
-                // Handle binary content (base64 encoded)
-                const char *blob_str = blob->valuestring;
-                size_t blob_len = strlen(blob_str);
-
-                // Decode base64
-                size_t decoded_size = 0;
-                unsigned char *decoded_data = base64_decode(blob_str, blob_len, &decoded_size);
-                if (decoded_data) {
-                    result->blob = decoded_data;
-                    result->blob_size = decoded_size;
-                    LOG_DEBUG("MCP: Binary blob content received and decoded (encoded size: %zu, decoded size: %zu)", blob_len, decoded_size);
-                } else {
-                    LOG_WARN("MCP: Failed to decode base64 blob content");
-                    // Fallback: store as-is
-                    result->blob = malloc(blob_len);
-                    if (result->blob) {
-                        memcpy(result->blob, blob_str, blob_len);
-                        result->blob_size = blob_len;
-                        LOG_DEBUG("MCP: Binary blob content stored as-is (size: %zu)", blob_len);
-                    }
-                }
+                mcp_take_base64_blob(result, blob);
             }
 
             // Check for MIME type
@@ -1100,85 +2645,129 @@ void mcp_free_tool_result(MCPToolResult *result) {
  * Get JSON schema for a tool from an MCP server
  */
 cJSON* mcp_get_tool_schema(MCPServer *server, const char *tool_name) {
-    if (!server || !tool_name || !server->tool_schemas) {
+    if (!server || !tool_name) {
         return NULL;
     }
 
-    cJSON *tool = NULL;
-    cJSON_ArrayForEach(tool, server->tool_schemas) {
-        cJSON *name = cJSON_GetObjectItem(tool, "name");
-        if (name && cJSON_IsString(name) && strcmp(name->valuestring, tool_name) == 0) {
-            return cJSON_Duplicate(tool, 1);
+    cJSON *schema = NULL;
+    pthread_mutex_lock(&server->lock);
+    if (server->tools_ready) {
+        cJSON *tool = NULL;
+        cJSON_ArrayForEach(tool, server->tool_schemas) {
+            cJSON *name = cJSON_GetObjectItem(tool, "name");
+            if (name && cJSON_IsString(name) && strcmp(name->valuestring, tool_name) == 0) {
+                schema = cJSON_Duplicate(tool, 1);
+                break;
+            }
         }
     }
+    pthread_mutex_unlock(&server->lock);
 
-    return NULL;
+    return schema;
 }
 
 /*
- * Get all tools from all connected servers as Claude API tool definitions
+ * Claude API tool definition for one MCP tool schema:
+ * { type: "function", function: { name, description, parameters } }
  */
-cJSON* mcp_get_all_tools(MCPConfig *config) {
-    if (!config) {
-        return NULL;
+static cJSON* mcp_tool_definition(const char *prefixed_name, const cJSON *tool) {
+    cJSON *tool_def = cJSON_CreateObject();
+    if (!tool_def) return NULL;
+    cJSON_AddStringToObject(tool_def, "type", "function");
+
+    cJSON *func = cJSON_CreateObject();
+    if (!func) { cJSON_Delete(tool_def); return NULL; }
+    cJSON_AddStringToObject(func, "name", prefixed_name);
+
+    // Description if present
+    const cJSON *desc = cJSON_GetObjectItem(tool, "description");
+    if (desc && cJSON_IsString(desc)) {
+        cJSON_AddStringToObject(func, "description", desc->valuestring);
+    }
+
+    // Parameters: map from MCP tool's input schema to Claude parameters
+    // Try common keys from MCP servers: inputSchema, input_schema, parameters
+    const cJSON *input_schema = cJSON_GetObjectItem(tool, "inputSchema");
+    if (!input_schema) input_schema = cJSON_GetObjectItem(tool, "input_schema");
+    if (!input_schema) input_schema = cJSON_GetObjectItem(tool, "parameters");
+
+    if (input_schema && (cJSON_IsObject(input_schema) || cJSON_IsArray(input_schema))) {
+        // Duplicate schema as-is under "parameters"
+        cJSON_AddItemToObject(func, "parameters", cJSON_Duplicate(input_schema, 1));
+    } else {
+        // Fallback to an empty object schema
+        cJSON *empty_params = cJSON_CreateObject();
+        cJSON_AddStringToObject(empty_params, "type", "object");
+        cJSON_AddItemToObject(func, "parameters", empty_params);
     }
 
-    // Return an array of Claude API tool definitions: { type: "function", function: { name, description, parameters } }
-    cJSON *tools_array = cJSON_CreateArray();
-    if (!tools_array) {
-        return NULL;
+    cJSON_AddItemToObject(tool_def, "function", func);
+    return tool_def;
+}
+
+/*
+ * Visit every tool of every server whose tools are known
+ */
+void mcp_visit_tools(MCPConfig *config, MCPToolVisitor visit, void *ctx) {
+    if (!config || !visit) {
+        return;
     }
 
     for (int i = 0; i < config->server_count; i++) {
         MCPServer *server = config->servers[i];
-        if (!server || !server->connected || !server->tool_schemas) {
+        if (!server) {
+            continue;
+        }
+        // Held while visiting so a refresh cannot free the schemas underneath
+        pthread_mutex_lock(&server->lock);
+        if (!server->tools_ready) {
+            pthread_mutex_unlock(&server->lock);
             continue;
         }
 
         cJSON *tool = NULL;
         cJSON_ArrayForEach(tool, server->tool_schemas) {
-            // Prepare Claude tool definition wrapper
-            cJSON *tool_def = cJSON_CreateObject();
-            if (!tool_def) continue;
-            cJSON_AddStringToObject(tool_def, "type", "function");
-
-            cJSON *func = cJSON_CreateObject();
-            if (!func) { cJSON_Delete(tool_def); continue; }
-
             // Name with mcp_<server>_<tool> prefix
             const cJSON *name = cJSON_GetObjectItem(tool, "name");
-            if (!name || !cJSON_IsString(name)) { cJSON_Delete(tool_def); cJSON_Delete(func); continue; }
+            if (!name || !cJSON_IsString(name)) continue;
             char prefixed_name[256];
             snprintf(prefixed_name, sizeof(prefixed_name), "mcp_%s_%s", server->name, name->valuestring);
-            cJSON_AddStringToObject(func, "name", prefixed_name);
 
-            // Description if present
-            const cJSON *desc = cJSON_GetObjectItem(tool, "description");
-            if (desc && cJSON_IsString(desc)) {
-                cJSON_AddStringToObject(func, "description", desc->valuestring);
+            cJSON *tool_def = mcp_tool_definition(prefixed_name, tool);
+            if (tool_def) {
+                visit(ctx, server, prefixed_name, name->valuestring, tool_def);
             }
+        }
+        pthread_mutex_unlock(&server->lock);
+    }
+}
 
-            // Parameters: map from MCP tool's input schema to Claude parameters
-            // Try common keys from MCP servers: inputSchema, input_schema, parameters
-            const cJSON *input_schema = cJSON_GetObjectItem(tool, "inputSchema");
-            if (!input_schema) input_schema = cJSON_GetObjectItem(tool, "input_schema");
-            if (!input_schema) input_schema = cJSON_GetObjectItem(tool, "parameters");
+unsigned long mcp_tools_generation(void) {
+    return atomic_load(&mcp_tool_generation);
+}
 
-            if (input_schema && (cJSON_IsObject(input_schema) || cJSON_IsArray(input_schema))) {
-                // Duplicate schema as-is under "parameters"
-                cJSON_AddItemToObject(func, "parameters", cJSON_Duplicate(input_schema, 1));
-            } else {
-                // Fallback to an empty object schema
-                cJSON *empty_params = cJSON_CreateObject();
-                cJSON_AddStringToObject(empty_params, "type", "object");
-                cJSON_AddItemToObject(func, "parameters", empty_params);
-            }
+static void mcp_collect_tool(void *ctx, MCPServer *server, const char *prefixed_name,
+                             const char *tool_name, cJSON *definition) {
+    (void)server;
+    (void)prefixed_name;
+    (void)tool_name;
+    cJSON_AddItemToArray((cJSON *)ctx, definition);
+}
 
-            cJSON_AddItemToObject(tool_def, "function", func);
-            cJSON_AddItemToArray(tools_array, tool_def);
-        }
+/*
+ * Get all tools from all connected servers as Claude API tool definitions
+ */
+cJSON* mcp_get_all_tools(MCPConfig *config) {
+    if (!config) {
+        return NULL;
     }
 
+    // Return an array of Claude API tool definitions: { type: "function", function: { name, description, parameters } }
+    cJSON *tools_array = cJSON_CreateArray();
+    if (!tools_array) {
+        return NULL;
+    }
+    mcp_visit_tools(config, mcp_collect_tool, tools_array);
     return tools_array;
 }
 
@@ -1195,30 +2784,59 @@ MCPServer* mcp_find_tool_server(MCPConfig *config, const char *tool_name) {
         return NULL;
     }
 
-    // Extract server name (format: mcp_<server>_<tool>)
-    char server_name[128] = {0};
-    const char *underscore = strchr(tool_name + 4, '_');
-    if (!underscore) {
-        return NULL;
+    // Server names may contain underscores themselves (format:
+    // mcp_<server>_<tool>), so try each split, shortest server name first
+    const char *server_name = tool_name + 4;
+    for (const char *underscore = strchr(server_name, '_'); underscore;
+         underscore = strchr(underscore + 1, '_')) {
+        MCPServer *server = mcp_index_lookup(config, server_name, (size_t)(underscore - server_name));
+        if (server) {
+            return server;
+        }
     }
 
-    size_t len = (size_t)(underscore - (tool_name + 4));
-    if (len >= sizeof(server_name)) {
-        return NULL;
-    }
+    return NULL;
+}
 
-    strncpy(server_name, tool_name + 4, len);
-    server_name[len] = '\0';
+/*
+ * Append formatted text to a growable status string. On failure the string
+ * is freed and set to NULL, and later appends do nothing.
+ */
+static void status_append(char **status, size_t *used, size_t *cap, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
 
-    // Find server
-    for (int i = 0; i < config->server_count; i++) {
-        MCPServer *server = config->servers[i];
-        if (server && server->name && strcmp(server->name, server_name) == 0) {
-            return server;
-        }
+static void status_append(char **status, size_t *used, size_t *cap, const char *fmt, ...) {
+    if (!*status) {
+        return;
     }
 
-    return NULL;
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(*status + *used, *cap - *used, fmt, args);
+    va_end(args);
+    if (len < 0) {
+        free(*status);
+        *status = NULL;
+        return;
+    }
+    if ((size_t)len >= *cap - *used) {
+        size_t new_cap = *cap * 2;
+        while (new_cap < *used + (size_t)len + 1) {
+            new_cap *= 2;
+        }
+        char *grown = realloc(*status, new_cap);
+        if (!grown) {
+            free(*status);
+            *status = NULL;
+            return;
+        }
+        *status = grown;
+        *cap = new_cap;
+        va_start(args, fmt);
+        vsnprintf(*status + *used, *cap - *used, fmt, args);
+        va_end(args);
+    }
+    *used += (size_t)len;
 }
 
 /*
@@ -1233,29 +2851,155 @@ char* mcp_get_status(MCPConfig *config) {
         return msg;
     }
 
-    char *status = calloc(4096, 1);
+    size_t used = 0;
+    size_t cap = 1024;
+    char *status = calloc(cap, 1);
     if (!status) {
         return NULL;
     }
 
-    snprintf(status, 4096, "MCP Status: %d server(s)\n", config->server_count);
+    status_append(&status, &used, &cap, "MCP Status: %d server(s)\n", config->server_count);
 
     for (int i = 0; i < config->server_count; i++) {
         MCPServer *server = config->servers[i];
         if (!server) continue;
 
-        char server_status[512];
-        snprintf(server_status, sizeof(server_status),
-                "  - %s: %s (%d tools)\n",
+        pthread_mutex_lock(&server->lock);
+        MCPHealth health = server->health;
+        int starting = server->starting;
+        const char *state = (starting && health == MCP_HEALTH_RESTARTING) ? "restarting" :
+                            starting ? "starting" :
+                            health == MCP_HEALTH_DOWN ? "down" :
+                            server->connected ? "connected" : "disconnected";
+        int tool_count = server->tool_count;
+        int cached = server->tools_cached;
+        int exit_status = server->exit_status;
+        long long restart_in_ms = server->restart_at_ms - mcp_now_ms();
+        int restarts = server->restarts;
+        unsigned long requests = server->requests;
+        unsigned long failures = server->failures;
+        long long latency_total_us = server->latency_total_us;
+        long long latency_max_us = server->latency_max_us;
+        MCPStderrLog *stderr_capture = server->stderr_capture;
+        pthread_mutex_unlock(&server->lock);
+
+        // How it went down and when it comes back
+        char down_info[96] = "";
+        if (health == MCP_HEALTH_DOWN && !starting) {
+            char exit_info[48] = "";
+            if (exit_status >= 0 && WIFEXITED(exit_status)) {
+                snprintf(exit_info, sizeof(exit_info), ", exited with status %d", WEXITSTATUS(exit_status));
+            } else if (exit_status >= 0 && WIFSIGNALED(exit_status)) {
+                snprintf(exit_info, sizeof(exit_info), ", killed by signal %d", WTERMSIG(exit_status));
+            }
+            snprintf(down_info, sizeof(down_info), "%s, restart in %.1fs", exit_info,
+                     restart_in_ms > 0 ? (double)restart_in_ms / 1000.0 : 0.0);
+        }
+        char request_info[128] = "";
+        if (requests > 0) {
+            snprintf(request_info, sizeof(request_info),
+                     ", %lu requests, %lu failed, latency avg %.1fms max %.1fms",
+                     requests, failures,
+                     (double)latency_total_us / (double)requests / 1000.0,
+                     (double)latency_max_us / 1000.0);
+        } else if (failures > 0) {
+            snprintf(request_info, sizeof(request_info), ", %lu failed", failures);
+        }
+        char restart_info[48] = "";
+        if (restarts > 0) {
+            snprintf(restart_info, sizeof(restart_info), ", restarted %d time%s",
+                     restarts, restarts == 1 ? "" : "s");
+        }
+
+        char stderr_info[96] = "";
+        MCPStderrStats stderr_stats;
+        mcp_stderr_stats(stderr_capture, mcp_now_ms(), &stderr_stats);
+        if (stderr_stats.bytes > 0) {
+            int len = snprintf(stderr_info, sizeof(stderr_info), ", stderr %llu KB (%.1f KB/s)",
+                               (stderr_stats.bytes + 1023) / 1024,
+                               stderr_stats.bytes_per_sec / 1024.0);
+            if (stderr_stats.dropped > 0 && len > 0 && (size_t)len < sizeof(stderr_info)) {
+                snprintf(stderr_info + len, sizeof(stderr_info) - (size_t)len,
+                         ", %llu KB dropped", (stderr_stats.dropped + 1023) / 1024);
+            }
+        }
+
+        status_append(&status, &used, &cap,
+                "  - %s: %s (%d tools%s)%s%s%s%s\n",
                 server->name,
-                server->connected ? "connected" : "disconnected",
-                server->tool_count);
-        strncat(status, server_status, 4096 - strlen(status) - 1);
+                state,
+                tool_count,
+                cached ? ", cached" : "",
+                down_info,
+                request_info,
+                restart_info,
+                stderr_info);
+    }
+
+    if (config->resource_cache) {
+        MCPResourceCacheStats stats;
+        mcp_resource_cache_stats(config->resource_cache, &stats);
+        status_append(&status, &used, &cap,
+                      "Resource cache: %d entries, %zu KB, %lu hits, %lu misses\n",
+                      stats.entries, (stats.bytes + 1023) / 1024, stats.hits, stats.misses);
     }
 
     return status;
 }
 
+/*
+ * A server's resources (the "resources" array of resources/list), from the
+ * copy kept since the last listing if the server has not reported a change
+ * Returns: Array to free with cJSON_Delete, NULL on failure
+ */
+static cJSON* mcp_resource_listing(MCPServer *server) {
+    pthread_mutex_lock(&server->lock);
+    cJSON *resources = server->resource_listing ? cJSON_Duplicate(server->resource_listing, 1) : NULL;
+    unsigned long generation = server->resource_generation;
+    pthread_mutex_unlock(&server->lock);
+    if (resources) {
+        LOG_DEBUG("MCP: Resource list of server '%s' served from memory", server->name);
+        return resources;
+    }
+
+    LOG_INFO("MCP: Listing resources from server '%s'", server->name);
+
+    // Send resources/list request
+    cJSON *response = mcp_send_request(server, "resources/list", NULL);
+    if (!response) {
+        LOG_WARN("MCP: Failed to list resources from server '%s'", server->name);
+        return NULL;
+    }
+
+    // Extract resources from response
+    cJSON *result_obj = cJSON_GetObjectItem(response, "result");
+    if (!result_obj) {
+        LOG_WARN("MCP: No result in resources/list response from '%s'", server->name);
+        cJSON_Delete(response);
+        return NULL;
+    }
+
+    resources = cJSON_DetachItemFromObject(result_obj, "resources");
+    cJSON_Delete(response);
+    if (!resources || !cJSON_IsArray(resources)) {
+        LOG_WARN("MCP: Invalid resources array from '%s'", server->name);
+        cJSON_Delete(resources);
+        return NULL;
+    }
+
+    // Kept unless a change was reported while the reply was on its way
+    cJSON *copy = cJSON_Duplicate(resources, 1);
+    pthread_mutex_lock(&server->lock);
+    if (copy && server->resource_generation == generation) {
+        cJSON_Delete(server->resource_listing);
+        server->resource_listing = copy;
+        copy = NULL;
+    }
+    pthread_mutex_unlock(&server->lock);
+    cJSON_Delete(copy);
+    return resources;
+}
+
 /*
  * List resources from MCP servers
  */
@@ -1291,7 +3035,7 @@ MCPResourceList* mcp_list_resources(MCPConfig *config, const char *server_name)
     // Iterate through servers
     for (int i = 0; i < config->server_count; i++) {
         MCPServer *server = config->servers[i];
-        if (!server || !server->connected) {
+        if (!server || !mcp_server_available(server)) {
             continue;
         }
 
@@ -1300,27 +3044,8 @@ MCPResourceList* mcp_list_resources(MCPConfig *config, const char *server_name)
             continue;
         }
 
-        LOG_INFO("MCP: Listing resources from server '%s'", server->name);
-
-        // Send resources/list request
-        cJSON *response = mcp_send_request(server, "resources/list", NULL);
-        if (!response) {
-            LOG_WARN("MCP: Failed to list resources from server '%s'", server->name);
-            continue;
-        }
-
-        // Extract resources from response
-        cJSON *result_obj = cJSON_GetObjectItem(response, "result");
-        if (!result_obj) {
-            LOG_WARN("MCP: No result in resources/list response from '%s'", server->name);
-            cJSON_Delete(response);
-            continue;
-        }
-
-        cJSON *resources = cJSON_GetObjectItem(result_obj, "resources");
-        if (!resources || !cJSON_IsArray(resources)) {
-            LOG_WARN("MCP: Invalid resources array from '%s'", server->name);
-            cJSON_Delete(response);
+        cJSON *resources = mcp_resource_listing(server);
+        if (!resources) {
             continue;
         }
 
@@ -1385,7 +3110,7 @@ MCPResourceList* mcp_list_resources(MCPConfig *config, const char *server_name)
             result->resources[total_count++] = resource;
         }
 
-        cJSON_Delete(response);
+        cJSON_Delete(resources);
     }
 
     result->count = total_count;
@@ -1398,6 +3123,64 @@ MCPResourceList* mcp_list_resources(MCPConfig *config, const char *server_name)
     return result;
 }
 
+/*
+ * Whether uri was subscribed to on the server's connection (server->lock held)
+ */
+static int mcp_resource_subscribed(const MCPServer *server, const char *uri) {
+    for (int i = 0; i < server->resource_subscription_count; i++) {
+        if (strcmp(server->resource_subscriptions[i], uri) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Ask a server to report changes to a resource about to be cached, if it
+ * can and has not been asked on this connection. Sent before the read, so
+ * no change after the read goes unreported.
+ */
+static void mcp_subscribe_resource(MCPServer *server, const char *uri) {
+    pthread_mutex_lock(&server->lock);
+    int subscribe = server->resources_subscribe && !mcp_resource_subscribed(server, uri);
+    unsigned long generation = server->resource_generation;
+    pthread_mutex_unlock(&server->lock);
+    if (!subscribe || !server->resource_cache) {
+        return;
+    }
+
+    cJSON *params = cJSON_CreateObject();
+    cJSON_AddStringToObject(params, "uri", uri);
+    cJSON *response = mcp_send_request(server, "resources/subscribe", params);
+    cJSON_Delete(params);
+    int ok = response && cJSON_GetObjectItem(response, "result");
+    cJSON_Delete(response);
+    if (!ok) {
+        LOG_WARN("MCP: Failed to subscribe to resource '%s' of server '%s'", uri, server->name);
+        return;
+    }
+
+    // Remembered unless the connection it was made on is gone
+    pthread_mutex_lock(&server->lock);
+    if (server->resource_generation == generation && !mcp_resource_subscribed(server, uri)) {
+        if (server->resource_subscription_count == server->resource_subscription_capacity) {
+            int capacity = server->resource_subscription_capacity > 0
+                ? server->resource_subscription_capacity * 2 : 8;
+            char **grown = realloc(server->resource_subscriptions, (size_t)capacity * sizeof(char *));
+            if (grown) {
+                server->resource_subscriptions = grown;
+                server->resource_subscription_capacity = capacity;
+            }
+        }
+        char *copy = server->resource_subscription_count < server->resource_subscription_capacity
+            ? strdup(uri) : NULL;
+        if (copy) {
+            server->resource_subscriptions[server->resource_subscription_count++] = copy;
+        }
+    }
+    pthread_mutex_unlock(&server->lock);
+}
+
 /*
  * Read a resource from an MCP server
  */
@@ -1413,15 +3196,7 @@ MCPResourceContent* mcp_read_resource(MCPConfig *config, const char *server_name
     }
 
     // Find the server
-    MCPServer *server = NULL;
-    for (int i = 0; i < config->server_count; i++) {
-        if (config->servers[i] &&
-            config->servers[i]->name &&
-            strcmp(config->servers[i]->name, server_name) == 0) {
-            server = config->servers[i];
-            break;
-        }
-    }
+    MCPServer *server = mcp_index_lookup(config, server_name, strlen(server_name));
 
     if (!server) {
         LOG_ERROR("MCP: Server '%s' not found", server_name);
@@ -1435,7 +3210,7 @@ MCPResourceContent* mcp_read_resource(MCPConfig *config, const char *server_name
         return result;
     }
 
-    if (!server->connected) {
+    if (!mcp_server_available(server)) {
         LOG_ERROR("MCP: Server '%s' not connected", server_name);
         MCPResourceContent *result = calloc(1, sizeof(MCPResourceContent));
         if (result) {
@@ -1451,6 +3226,30 @@ MCPResourceContent* mcp_read_resource(MCPConfig *config, const char *server_name
         return result;
     }
 
+    // Read before and unchanged since: answer from memory
+    MCPResourceCacheValue cached;
+    if (mcp_resource_cache_get(server->resource_cache, server->name, uri, mcp_now_ms(), &cached)) {
+        MCPResourceContent *result = calloc(1, sizeof(MCPResourceContent));
+        char *result_uri = strdup(uri);
+        if (!result || !result_uri) {
+            free(result);
+            free(result_uri);
+            mcp_resource_cache_value_clear(&cached);
+            return NULL;
+        }
+        result->uri = result_uri;
+        result->mime_type = cached.mime_type;
+        result->text = cached.text;
+        result->blob = cached.blob;
+        result->blob_size = cached.blob_size;
+        LOG_DEBUG("MCP: Resource '%s' of server '%s' served from the cache", uri, server_name);
+        return result;
+    }
+
+    // Changes reported from here on keep this read out of the cache
+    unsigned long cache_epoch = mcp_resource_cache_epoch(server->resource_cache);
+    mcp_subscribe_resource(server, uri);
+
     LOG_INFO("MCP: Reading resource '%s' from server '%s'", uri, server_name);
 
     // Build params
@@ -1583,6 +3382,9 @@ MCPResourceContent* mcp_read_resource(MCPConfig *config, const char *server_name
 
     cJSON_Delete(response);
 
+    MCPResourceCacheValue value = {result->mime_type, result->text, result->blob, result->blob_size};
+    mcp_resource_cache_put(server->resource_cache, server->name, uri, &value, mcp_now_ms(), cache_epoch);
+
     LOG_INFO("MCP: Successfully read resource '%s' from server '%s'", uri, server_name);
 
     return result;
@@ -7,7 +7,7 @@
  * MCP Specification: https://spec.modelcontextprotocol.io/
  *
  * Features:
- * - Multiple MCP server connections via stdio/SSE transports
+ * - Multiple MCP server connections via stdio and streamable HTTP transports
  * - Dynamic tool discovery from connected servers
  * - Seamless integration with existing claude-c tool system
  * - Configuration via JSON config file
@@ -18,25 +18,93 @@
  *     "filesystem": {
  *       "command": "npx",
  *       "args": ["-y", "@modelcontextprotocol/server-filesystem", "/path/to/allowed/files"],
- *       "env": {}
+ *       "env": {},
+ *       "maxInFlight": 8
+ *     },
+ *     "shared": {
+ *       "url": "https://mcp.example.com/mcp",
+ *       "headers": {"Authorization": "Bearer ..."}
  *     }
  *   }
  * }
+ *
+ * An entry with "url" instead of "command" uses the streamable HTTP
+ * transport (see mcp_http.h).
  */
 
 #ifndef MCP_H
 #define MCP_H
 
+#include <pthread.h>
+#include <sys/types.h>
 #include <cjson/cJSON.h>
 
+/*
+ * How long a request waits for its response, in milliseconds.
+ * Override with the CLAUDE_MCP_TIMEOUT_MS environment variable.
+ */
+#define MCP_DEFAULT_TIMEOUT_MS 30000
+
+/*
+ * Requests a server may have outstanding at once, unless its config entry
+ * sets "maxInFlight". Further callers wait for a slot.
+ */
+#define MCP_DEFAULT_MAX_IN_FLIGHT 8
+
+/*
+ * Once mcp_start_servers() has run, a server whose process exits (or that
+ * fails to start) is marked down at once, and restarted after
+ * MCP_RESTART_DELAY_MS. The delay doubles for every further exit within
+ * MCP_RESTART_RESET_MS of coming up, to at most MCP_RESTART_MAX_DELAY_MS.
+ * Calls to a server that is down fail right away.
+ */
+#define MCP_RESTART_DELAY_MS 500
+#define MCP_RESTART_MAX_DELAY_MS 60000
+#define MCP_RESTART_RESET_MS 60000
+
+/*
+ * Tool schemas from each server's last tools/list are cached on disk, one
+ * file per command line (a hash of command, args and env), in
+ * $CLAUDE_MCP_CACHE_DIR, else $XDG_CACHE_HOME/claude-c/mcp, else
+ * ~/.cache/claude-c/mcp. Setting CLAUDE_MCP_CACHE_DIR to an empty string
+ * turns the cache off.
+ */
+
+/*
+ * Resource contents read with mcp_read_resource() are kept in memory, up to
+ * MCP_RESOURCE_CACHE_BYTES across all servers, for MCP_RESOURCE_CACHE_TTL_MS
+ * or until the server reports that the resource changed (servers that
+ * support it are subscribed to every resource that is cached). Override
+ * the TTL with the CLAUDE_MCP_RESOURCE_CACHE_TTL_MS environment variable;
+ * 0 turns the cache off. Each resource is subscribed to once per
+ * connection. A server's resource listing is kept until it reports
+ * resources/list_changed or reconnects.
+ */
+#define MCP_RESOURCE_CACHE_BYTES (32u * 1024u * 1024u)
+#define MCP_RESOURCE_CACHE_TTL_MS 300000
+
+struct MCPPendingRequest;
+struct MCPHttpSession;
+struct MCPResourceCache;
+
 /*
  * Transport types for MCP servers
  */
 typedef enum {
     MCP_TRANSPORT_STDIO,   // Standard input/output (local process)
-    MCP_TRANSPORT_SSE      // Server-Sent Events (HTTP)
+    MCP_TRANSPORT_SSE      // Streamable HTTP: POST requests, Server-Sent Events replies
 } MCPTransportType;
 
+/*
+ * Server health, as supervised after mcp_start_servers()
+ */
+typedef enum {
+    MCP_HEALTH_UNKNOWN,    // Not connected yet
+    MCP_HEALTH_UP,         // Answered initialize and has not exited since
+    MCP_HEALTH_DOWN,       // Exited or failed to start; restart pending
+    MCP_HEALTH_RESTARTING  // Being restarted
+} MCPHealth;
+
 /*
  * MCP server connection
  */
@@ -54,19 +122,78 @@ typedef struct MCPServer {
     int stdin_fd;                // Write to server's stdin
     int stdout_fd;               // Read from server's stdout
     int stderr_fd;               // Read from server's stderr (for logging)
+    int pidfd;                   // Readable once the process exits (Linux), else -1
 
     // For SSE transport
     char *url;                   // Server URL
+    char **headers;              // Extra HTTP headers ("Name: value")
+    int header_count;            // Number of headers
+    struct MCPHttpSession *http; // Open session (while connected)
 
     // Server capabilities
     char **tools;                // List of tool names
     int tool_count;              // Number of tools
     cJSON *tool_schemas;         // Tool JSON schemas from server
+    int resources_subscribe;     // Accepts resources/subscribe (guarded by lock)
+    char **resource_subscriptions;  // URIs subscribed to on this connection (guarded by lock)
+    int resource_subscription_count;
+    int resource_subscription_capacity;
+    cJSON *resource_listing;     // "resources" of the last resources/list, NULL if outdated (guarded by lock)
+    unsigned long resource_generation;  // Bumped on reconnect and resources/list_changed (guarded by lock)
+    struct MCPResourceCache *resource_cache;  // The config's, shared by all its servers
 
     // State
     int connected;               // Connection status
-    int message_id;              // Message ID counter for JSON-RPC
-    FILE *stderr_log;            // File handle for logging stderr output
+    int message_id;              // Message ID counter for JSON-RPC (guarded by lock)
+    struct MCPStderrLog *stderr_capture;  // Queues stderr for the log file (kept across restarts)
+
+    // Reader thread: frames stdout into JSON-RPC messages, hands responses
+    // to the waiting requests by id and handles notifications as they arrive
+    pthread_t reader_thread;
+    int reader_running;          // 1 while reader_thread must be joined
+    int wake_pipe[2];            // Written to stop the reader and reply threads
+    pthread_mutex_t write_lock;  // Keeps messages on stdin whole
+    pthread_mutex_t lock;        // Guards the fields below
+    pthread_cond_t cond;         // Signalled on a reply, a free slot, a queued answer or the reader stopping
+    struct MCPPendingRequest *pending;  // Requests waiting for a reply
+    int in_flight;               // Requests sent and not yet answered or abandoned
+    int max_in_flight;           // Limit on in_flight
+    int reader_done;             // stdout closed, no more replies will come
+
+    // Answers to the server's own requests (ping): queued by the reader
+    // thread, which must keep reading stdout, and written by reply_thread
+    pthread_t reply_thread;
+    int reply_running;           // 1 while reply_thread must be joined (guarded by lock)
+    struct MCPQueuedAnswer *answers;  // Oldest first (guarded by lock)
+    int answer_count;            // Length of answers (guarded by lock)
+    int answers_stop;            // Makes reply_thread exit (guarded by lock)
+
+    // Background startup (mcp_start_servers)
+    pthread_t startup_thread;
+    int startup_running;         // 1 while startup_thread must be joined
+    int starting;                // Connect and discovery still running (guarded by lock)
+    int stopping;                // Give up on requests, the server is being freed (guarded by lock)
+    int tools_ready;             // tools and tool_schemas are filled in (guarded by lock)
+    int tools_cached;            // They came from the on-disk cache and are not revalidated yet (guarded by lock)
+    int tools_stale;             // Server sent tools/list_changed since the last tools/list (guarded by lock)
+
+    // Fetches the tools again after tools/list_changed; started and joined
+    // by the supervisor, so a slow reply holds up no other server
+    pthread_t refresh_thread;
+    int refresh_running;         // 1 while refresh_thread must be joined (supervisor only)
+    int refresh_done;            // refresh_thread has finished (guarded by lock)
+
+    // Health and request statistics (guarded by lock)
+    MCPHealth health;
+    int exit_status;             // Wait status of the last exit, -1 if not known
+    int restarts;                // Successful restarts
+    int quick_exits;             // Exits soon after coming up, in a row (sets the restart delay)
+    long long up_since_ms;       // When the server last came up (CLOCK_MONOTONIC)
+    long long restart_at_ms;     // When a server that is down is restarted (CLOCK_MONOTONIC)
+    unsigned long requests;      // Requests answered
+    unsigned long failures;      // Requests that got no answer
+    long long latency_total_us;  // Summed over answered requests
+    long long latency_max_us;
 } MCPServer;
 
 /*
@@ -75,6 +202,14 @@ typedef struct MCPServer {
 typedef struct MCPConfig {
     MCPServer **servers;         // Array of server configurations
     int server_count;            // Number of servers
+    int *server_index;           // Servers by name hash (position + 1, 0 = empty)
+    size_t server_index_size;    // Power of two
+    struct MCPResourceCache *resource_cache;  // Resource contents read from any server
+
+    // Restarts servers that go down (started by mcp_start_servers)
+    pthread_t supervisor;
+    int supervisor_running;      // 1 while supervisor must be joined
+    int supervisor_stop;         // Tells supervisor to exit (guarded by the supervisor lock)
 } MCPConfig;
 
 /*
@@ -163,13 +298,33 @@ void mcp_disconnect_server(MCPServer *server);
 
 /*
  * Discover tools from a connected MCP server
- * Calls the tools/list method and populates server->tools
+ * Calls the tools/list method and populates server->tools. When the list
+ * differs from the one held (possibly loaded from the cache), it replaces
+ * it and is written to the cache.
  * Returns: Number of tools discovered, -1 on error
  */
 int mcp_discover_tools(MCPServer *server);
 
 /*
- * Call an MCP tool
+ * Connect to every configured server and discover its tools in the
+ * background, one thread per server, so slow servers do not hold up the
+ * first prompt. A server with cached tool schemas offers them in
+ * mcp_get_all_tools() right away, and discovery then revalidates them;
+ * any other server's tools appear as soon as its discovery finishes.
+ * From then on the servers are supervised and restarted when they exit.
+ * Returns: Number of servers being started
+ */
+int mcp_start_servers(MCPConfig *config);
+
+/*
+ * Wait until every server started by mcp_start_servers() is connected and
+ * has its tools, or has failed
+ */
+void mcp_wait_for_servers(MCPConfig *config);
+
+/*
+ * Call an MCP tool. If the server is still starting in the background
+ * (its tools came from the cache), waits for the startup first.
  *
  * Parameters:
  *   server: Connected MCP server
@@ -192,13 +347,37 @@ void mcp_free_tool_result(MCPToolResult *result);
 cJSON* mcp_get_tool_schema(MCPServer *server, const char *tool_name);
 
 /*
- * Get all tools from all connected servers as Claude API tool definitions
+ * Get all tools from all ready servers as Claude API tool definitions.
+ * Never waits for servers that are still starting. Servers that reported
+ * tools/list_changed get their list fetched again in the background; the
+ * new tools show up in a later call.
  * Returns: cJSON array of tool definitions (must be freed by caller)
  */
 cJSON* mcp_get_all_tools(MCPConfig *config);
 
 /*
- * Find which server provides a given tool
+ * Called for each tool by mcp_visit_tools() with the name it is offered
+ * under (mcp_<server>_<tool>), the server's own name for it and its tool
+ * definition as in mcp_get_all_tools(), which the visitor takes over.
+ * Runs with the server's lock held.
+ */
+typedef void (*MCPToolVisitor)(void *ctx, MCPServer *server, const char *prefixed_name,
+                               const char *tool_name, cJSON *definition);
+
+/*
+ * Visit the tools mcp_get_all_tools() would return
+ */
+void mcp_visit_tools(MCPConfig *config, MCPToolVisitor visit, void *ctx);
+
+/*
+ * Changes whenever the tools some server offers may have changed, so a
+ * caller that indexed them knows when to visit them again
+ */
+unsigned long mcp_tools_generation(void);
+
+/*
+ * Find which server provides a given tool, from the server part of its
+ * mcp_<server>_<tool> name (a hash lookup per underscore, no scan)
  * Returns: MCPServer* or NULL if not found
  */
 MCPServer* mcp_find_tool_server(MCPConfig *config, const char *tool_name);
@@ -210,7 +389,8 @@ MCPServer* mcp_find_tool_server(MCPConfig *config, const char *tool_name);
 int mcp_is_enabled(void);
 
 /*
- * Get MCP server status (for debugging/logging)
+ * Get MCP server status (for debugging/logging): per server its state,
+ * tool count, health, restarts and request latency
  * Returns: Human-readable status string (must be freed by caller)
  */
 char* mcp_get_status(MCPConfig *config);
@@ -227,7 +407,8 @@ char* mcp_get_status(MCPConfig *config);
 MCPResourceList* mcp_list_resources(MCPConfig *config, const char *server_name);
 
 /*
- * Read a resource from an MCP server
+ * Read a resource from an MCP server. Served from the resource cache when
+ * it holds the resource; otherwise read from the server and cached.
  *
  * Parameters:
  *   config: MCP configuration with connected servers
@@ -0,0 +1,913 @@
+/*
+ * mcp_http.c - Streamable HTTP transport for MCP servers
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <curl/curl.h>
+#include "mcp_http.h"
+
+#ifndef TEST_BUILD
+#include "logger.h"
+#else
+// Stub logger for test builds
+#define LOG_INFO(...)
+#define LOG_DEBUG(...)
+#define LOG_WARN(...)
+#define LOG_ERROR(...)
+#endif
+
+// Largest JSON body or SSE event accepted
+#define MCP_HTTP_MAX_MESSAGE (256u * 1024u * 1024u)
+
+// How long closing a session waits for the server to acknowledge the DELETE
+#define MCP_HTTP_CLOSE_TIMEOUT_MS 2000L
+
+#define MCP_HTTP_CONNECT_TIMEOUT_MS 10000L
+
+static const char initialized_notification[] =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\",\"params\":{}}";
+
+typedef enum {
+    MCP_HTTP_POST,               // A client message
+    MCP_HTTP_REINIT,             // initialize sent again after the session expired
+    MCP_HTTP_LISTEN,             // GET stream of server-pushed messages
+    MCP_HTTP_RESUME,             // GET continuing a reply stream that broke off
+    MCP_HTTP_DELETE              // End of the session
+} MCPHttpKind;
+
+typedef struct MCPHttpTransfer {
+    MCPHttpSession *session;
+    MCPHttpKind kind;
+    CURL *easy;
+    struct curl_slist *headers;
+    char *body;                  // POST body
+    char *resume_from;           // Last-Event-ID of a resumed stream
+    int request_id;              // Request to fail if no reply comes (-1 = none)
+    int initialize;              // body is the initialize request
+    int sent_session_id;         // Request carried Mcp-Session-Id
+    unsigned sent_generation;    // Session generation it was sent in
+    int answered;                // The reply to request_id was delivered
+    int is_sse;                  // Response is text/event-stream
+    int too_large;               // Body or an SSE event was too large to keep
+    int line_too_large;          // The SSE line being read overflowed
+    int event_too_large;         // The SSE event being read overflowed
+
+    char *buf;                   // JSON body, or the SSE line being read
+    size_t used;
+    size_t cap;
+    char *data;                  // Data of the SSE event being read
+    size_t data_used;
+    size_t data_cap;
+    char *event_id;              // id of the SSE event being read
+    char *last_event_id;         // id of the last complete event, to resume from
+
+    char errbuf[CURL_ERROR_SIZE];
+    struct MCPHttpTransfer *next;
+} MCPHttpTransfer;
+
+struct MCPHttpSession {
+    char *url;
+    char **headers;
+    int header_count;
+    long timeout_ms;
+    MCPHttpMessageFn on_message;
+    MCPHttpFailFn on_fail;
+    void *ctx;
+
+    // Transport thread only
+    char *session_id;            // Mcp-Session-Id assigned by the server
+    char *listen_event_id;       // id of the last event on the listening stream
+    char *init_body;             // initialize request, for re-initializing
+    unsigned generation;         // Bumped each time the session is initialized again
+    long retry_ms;               // Delay before reopening the listening stream
+    int listening;               // 1 = stream wanted, -1 = server does not offer one
+    int listen_open;             // A listening transfer is running
+    int listen_due;              // Reopen the stream at listen_at
+    struct timespec listen_at;
+    int reinit;                  // Re-initialization in flight
+    MCPHttpTransfer *held;       // POSTs waiting for it
+    int active;                  // Transfers in the multi handle
+    int cancelled;               // Closing: transfers cancelled, DELETE sent
+
+    // Guarded by g_lock
+    int listen_requested;
+    int closing;
+    int closed;                  // No transfer of the session remains
+    struct MCPHttpSession *next;
+};
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static pthread_once_t g_curl_once = PTHREAD_ONCE_INIT;
+static CURLM *g_multi = NULL;
+static pthread_t g_thread;
+static int g_running = 0;        // Transport thread started
+static int g_stop = 0;           // Transport thread must exit
+static MCPHttpTransfer *g_queue = NULL;       // Submitted, not started yet
+static MCPHttpSession *g_sessions = NULL;
+static MCPHttpTransfer *g_active = NULL;      // In the multi handle (transport thread only)
+
+static void mcp_http_curl_init(void) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+}
+
+static long ms_until(const struct timespec *when) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long ms = (when->tv_sec - now.tv_sec) * 1000 + (when->tv_nsec - now.tv_nsec) / 1000000;
+    return ms > 0 ? ms : 0;
+}
+
+static void schedule_listen(MCPHttpSession *s, long delay_ms) {
+    clock_gettime(CLOCK_MONOTONIC, &s->listen_at);
+    s->listen_at.tv_sec += delay_ms / 1000;
+    s->listen_at.tv_nsec += (delay_ms % 1000) * 1000000L;
+    if (s->listen_at.tv_nsec >= 1000000000L) {
+        s->listen_at.tv_sec++;
+        s->listen_at.tv_nsec -= 1000000000L;
+    }
+    s->listen_due = 1;
+}
+
+static MCPHttpTransfer* transfer_new(MCPHttpSession *s, MCPHttpKind kind, const char *body, int request_id) {
+    MCPHttpTransfer *t = calloc(1, sizeof(MCPHttpTransfer));
+    if (!t) {
+        return NULL;
+    }
+    t->session = s;
+    t->kind = kind;
+    t->request_id = request_id;
+    if (body) {
+        t->body = strdup(body);
+        if (!t->body) {
+            free(t);
+            return NULL;
+        }
+    }
+    return t;
+}
+
+// Forget everything received, so the transfer can be sent again
+static void transfer_reset(MCPHttpTransfer *t) {
+    if (t->easy) {
+        curl_easy_cleanup(t->easy);
+        t->easy = NULL;
+    }
+    curl_slist_free_all(t->headers);
+    t->headers = NULL;
+    free(t->buf);
+    free(t->data);
+    free(t->event_id);
+    free(t->last_event_id);
+    t->buf = NULL;
+    t->data = NULL;
+    t->event_id = NULL;
+    t->last_event_id = NULL;
+    t->used = t->cap = t->data_used = t->data_cap = 0;
+    t->answered = t->is_sse = t->too_large = 0;
+    t->line_too_large = t->event_too_large = 0;
+    t->sent_session_id = 0;
+    t->errbuf[0] = '\0';
+}
+
+static void transfer_free(MCPHttpTransfer *t) {
+    transfer_reset(t);
+    free(t->body);
+    free(t->resume_from);
+    free(t);
+}
+
+// Append to a growable, NUL-terminated buffer
+static int buffer_append(char **buf, size_t *used, size_t *cap, const char *p, size_t n) {
+    if (*used + n + 1 > MCP_HTTP_MAX_MESSAGE) {
+        return -1;
+    }
+    if (*used + n + 1 > *cap) {
+        size_t new_cap = *cap > 0 ? *cap : 4096;
+        while (new_cap < *used + n + 1) {
+            new_cap *= 2;
+        }
+        char *grown = realloc(*buf, new_cap);
+        if (!grown) {
+            return -1;
+        }
+        *buf = grown;
+        *cap = new_cap;
+    }
+    memcpy(*buf + *used, p, n);
+    *used += n;
+    (*buf)[*used] = '\0';
+    return 0;
+}
+
+static void deliver(MCPHttpTransfer *t, const char *message, size_t len) {
+    MCPHttpSession *s = t->session;
+    if (t->kind == MCP_HTTP_REINIT) {
+        return;  // Nobody waits for the repeated initialize
+    }
+    int id = s->on_message(s->ctx, message, len);
+    if (id >= 0 && id == t->request_id) {
+        t->answered = 1;
+    }
+}
+
+/*
+ * One line of an SSE stream: "field: value", a comment (":...") or the
+ * blank line that ends an event
+ */
+static void sse_line(MCPHttpTransfer *t, char *line, size_t len) {
+    MCPHttpSession *s = t->session;
+    if (len > 0 && line[len - 1] == '\r') {
+        line[--len] = '\0';
+    }
+
+    if (len == 0) {
+        if (t->event_too_large) {
+            t->too_large = 1;  // Dropped; the request fails unless answered otherwise
+        } else if (t->data_used > 0) {
+            deliver(t, t->data, t->data_used);
+        }
+        t->data_used = 0;
+        t->event_too_large = 0;
+        if (t->event_id) {
+            free(t->last_event_id);
+            t->last_event_id = t->event_id;
+            t->event_id = NULL;
+        }
+        return;
+    }
+    if (line[0] == ':') {
+        return;
+    }
+
+    char *value = strchr(line, ':');
+    if (value) {
+        *value++ = '\0';
+        if (*value == ' ') {
+            value++;
+        }
+    } else {
+        value = line + len;
+    }
+
+    if (strcmp(line, "data") == 0) {
+        if ((t->data_used > 0 && buffer_append(&t->data, &t->data_used, &t->data_cap, "\n", 1) != 0) ||
+            buffer_append(&t->data, &t->data_used, &t->data_cap, value, strlen(value)) != 0) {
+            t->event_too_large = 1;
+        }
+    } else if (strcmp(line, "id") == 0) {
+        free(t->event_id);
+        t->event_id = strdup(value);
+    } else if (strcmp(line, "retry") == 0) {
+        long ms = strtol(value, NULL, 10);
+        if (ms > 0) {
+            s->retry_ms = ms;
+        }
+    }
+}
+
+static size_t write_callback(char *ptr, size_t size, size_t nmemb, void *userdata) {
+    MCPHttpTransfer *t = userdata;
+    size_t n = size * nmemb;
+
+    if (t->kind == MCP_HTTP_DELETE) {
+        return n;
+    }
+    if (!t->is_sse) {
+        if (!t->too_large && buffer_append(&t->buf, &t->used, &t->cap, ptr, n) != 0) {
+            t->too_large = 1;
+        }
+        return n;
+    }
+
+    // Split the stream into lines; a partial line waits in buf
+    size_t start = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (ptr[i] != '\n') {
+            continue;
+        }
+        if (buffer_append(&t->buf, &t->used, &t->cap, ptr + start, i - start) != 0) {
+            t->line_too_large = 1;
+        }
+        if (t->line_too_large) {
+            t->event_too_large = 1;  // The line was part of the event being read
+        } else {
+            sse_line(t, t->buf, t->used);
+        }
+        t->used = 0;
+        t->line_too_large = 0;
+        start = i + 1;
+    }
+    if (start < n && buffer_append(&t->buf, &t->used, &t->cap, ptr + start, n - start) != 0) {
+        t->line_too_large = 1;
+    }
+    return n;
+}
+
+static size_t header_callback(char *buffer, size_t size, size_t nitems, void *userdata) {
+    MCPHttpTransfer *t = userdata;
+    size_t n = size * nitems;
+
+    if (n >= 5 && strncmp(buffer, "HTTP/", 5) == 0) {
+        t->is_sse = 0;  // A new response (after a redirect or 100 Continue)
+        return n;
+    }
+
+    const char *colon = memchr(buffer, ':', n);
+    if (!colon) {
+        return n;
+    }
+    size_t name_len = (size_t)(colon - buffer);
+    const char *value = colon + 1;
+    const char *end = buffer + n;
+    while (value < end && (*value == ' ' || *value == '\t')) {
+        value++;
+    }
+    while (end > value && (end[-1] == '\r' || end[-1] == '\n' || end[-1] == ' ')) {
+        end--;
+    }
+    size_t value_len = (size_t)(end - value);
+
+    if (name_len == 14 && strncasecmp(buffer, "mcp-session-id", 14) == 0 && value_len > 0) {
+        char *id = strndup(value, value_len);
+        if (id) {
+            free(t->session->session_id);
+            t->session->session_id = id;
+        }
+    } else if (name_len == 12 && strncasecmp(buffer, "content-type", 12) == 0) {
+        t->is_sse = value_len >= 17 && strncasecmp(value, "text/event-stream", 17) == 0;
+    }
+    return n;
+}
+
+static struct curl_slist* add_header(struct curl_slist *list, const char *name, const char *value) {
+    char line[1024];
+    snprintf(line, sizeof(line), "%s: %s", name, value);
+    return curl_slist_append(list, line);
+}
+
+/*
+ * Hand a transfer to the multi handle. Runs on the transport thread.
+ */
+static int start_transfer(MCPHttpTransfer *t) {
+    MCPHttpSession *s = t->session;
+
+    // Requests wait while the session is being initialized again
+    if (s->reinit && t->kind == MCP_HTTP_POST) {
+        t->next = s->held;
+        s->held = t;
+        return 0;
+    }
+    if (t->initialize && t->body && !s->init_body) {
+        s->init_body = strdup(t->body);
+    }
+
+    t->easy = curl_easy_init();
+    if (!t->easy) {
+        return -1;
+    }
+
+    struct curl_slist *h = NULL;
+    for (int i = 0; i < s->header_count; i++) {
+        h = curl_slist_append(h, s->headers[i]);
+    }
+    if (t->kind == MCP_HTTP_LISTEN || t->kind == MCP_HTTP_RESUME) {
+        const char *from = t->kind == MCP_HTTP_RESUME ? t->resume_from : s->listen_event_id;
+        h = add_header(h, "Accept", "text/event-stream");
+        if (from) {
+            h = add_header(h, "Last-Event-ID", from);
+        }
+    } else {
+        h = add_header(h, "Accept", "application/json, text/event-stream");
+    }
+    if (t->body) {
+        h = add_header(h, "Content-Type", "application/json");
+    }
+    if (s->session_id) {
+        h = add_header(h, "Mcp-Session-Id", s->session_id);
+        t->sent_session_id = 1;
+    }
+    t->sent_generation = s->generation;
+    t->headers = h;
+
+    curl_easy_setopt(t->easy, CURLOPT_URL, s->url);
+    curl_easy_setopt(t->easy, CURLOPT_HTTPHEADER, t->headers);
+    curl_easy_setopt(t->easy, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(t->easy, CURLOPT_WRITEDATA, t);
+    curl_easy_setopt(t->easy, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(t->easy, CURLOPT_HEADERDATA, t);
+    curl_easy_setopt(t->easy, CURLOPT_PRIVATE, t);
+    curl_easy_setopt(t->easy, CURLOPT_ERRORBUFFER, t->errbuf);
+    curl_easy_setopt(t->easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(t->easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(t->easy, CURLOPT_PIPEWAIT, 1L);  // Prefer multiplexing over a new connection
+    curl_easy_setopt(t->easy, CURLOPT_CONNECTTIMEOUT_MS, MCP_HTTP_CONNECT_TIMEOUT_MS);
+
+    switch (t->kind) {
+        case MCP_HTTP_POST:
+        case MCP_HTTP_REINIT:
+            curl_easy_setopt(t->easy, CURLOPT_POSTFIELDS, t->body);
+            curl_easy_setopt(t->easy, CURLOPT_POSTFIELDSIZE, (long)strlen(t->body));
+            curl_easy_setopt(t->easy, CURLOPT_TIMEOUT_MS, s->timeout_ms);
+            break;
+        case MCP_HTTP_LISTEN:
+            break;  // Stays open as long as the server keeps it
+        case MCP_HTTP_RESUME:
+            curl_easy_setopt(t->easy, CURLOPT_TIMEOUT_MS, s->timeout_ms);
+            break;
+        case MCP_HTTP_DELETE:
+            curl_easy_setopt(t->easy, CURLOPT_CUSTOMREQUEST, "DELETE");
+            curl_easy_setopt(t->easy, CURLOPT_TIMEOUT_MS, MCP_HTTP_CLOSE_TIMEOUT_MS);
+            break;
+        default:
+            break;
+    }
+
+    if (curl_multi_add_handle(g_multi, t->easy) != CURLM_OK) {
+        return -1;
+    }
+    t->next = g_active;
+    g_active = t;
+    s->active++;
+    return 0;
+}
+
+static void start_or_fail(MCPHttpTransfer *t) {
+    if (start_transfer(t) != 0) {
+        LOG_ERROR("MCP HTTP: Failed to start request to %s", t->session->url);
+        if (t->request_id >= 0) {
+            t->session->on_fail(t->session->ctx, t->request_id, "HTTP request failed");
+        }
+        transfer_free(t);
+    }
+}
+
+// Take a finished transfer out of the multi handle
+static void detach_transfer(MCPHttpTransfer *t) {
+    for (MCPHttpTransfer **link = &g_active; *link; link = &(*link)->next) {
+        if (*link == t) {
+            *link = t->next;
+            break;
+        }
+    }
+    t->next = NULL;
+    curl_multi_remove_handle(g_multi, t->easy);
+    t->session->active--;
+}
+
+static void start_listen(MCPHttpSession *s) {
+    s->listen_due = 0;
+    MCPHttpTransfer *t = transfer_new(s, MCP_HTTP_LISTEN, NULL, -1);
+    if (!t || start_transfer(t) != 0) {
+        if (t) {
+            transfer_free(t);
+        }
+        schedule_listen(s, s->retry_ms);
+        return;
+    }
+    s->listen_open = 1;
+    LOG_DEBUG("MCP HTTP: Listening on %s%s%s", s->url,
+              s->listen_event_id ? " from event " : "", s->listen_event_id ? s->listen_event_id : "");
+}
+
+/*
+ * The server no longer knows the session: send the initialize request
+ * again and hold requests until it is answered
+ */
+static void start_reinit(MCPHttpSession *s) {
+    if (s->reinit) {
+        return;
+    }
+    free(s->session_id);
+    s->session_id = NULL;
+    s->generation++;
+    if (!s->init_body) {
+        return;
+    }
+    LOG_WARN("MCP HTTP: Session with %s expired, initializing again", s->url);
+
+    MCPHttpTransfer *t = transfer_new(s, MCP_HTTP_REINIT, s->init_body, -1);
+    if (!t) {
+        return;
+    }
+    s->reinit = 1;
+    if (start_transfer(t) != 0) {
+        s->reinit = 0;
+        transfer_free(t);
+    }
+}
+
+static void finish_reinit(MCPHttpSession *s, int ok) {
+    s->reinit = 0;
+    MCPHttpTransfer *held = s->held;
+    s->held = NULL;
+
+    if (ok) {
+        MCPHttpTransfer *note = transfer_new(s, MCP_HTTP_POST, initialized_notification, -1);
+        if (note) {
+            start_or_fail(note);
+        }
+    }
+
+    // Held requests went in newest first; resend them in order
+    MCPHttpTransfer *ordered = NULL;
+    while (held) {
+        MCPHttpTransfer *next = held->next;
+        held->next = ordered;
+        ordered = held;
+        held = next;
+    }
+    while (ordered) {
+        MCPHttpTransfer *next = ordered->next;
+        ordered->next = NULL;
+        if (ok) {
+            start_or_fail(ordered);
+        } else {
+            if (ordered->request_id >= 0) {
+                s->on_fail(s->ctx, ordered->request_id, "session expired");
+            }
+            transfer_free(ordered);
+        }
+        ordered = next;
+    }
+
+    if (ok && s->listening == 1 && !s->listen_open) {
+        schedule_listen(s, 0);
+    }
+}
+
+static void finish_transfer(MCPHttpTransfer *t, CURLcode result) {
+    MCPHttpSession *s = t->session;
+    long status = 0;
+    curl_easy_getinfo(t->easy, CURLINFO_RESPONSE_CODE, &status);
+    detach_transfer(t);
+
+    int ok = result == CURLE_OK && status >= 200 && status < 300;
+    // An event stream that broke off, short of a timeout, can be picked up again
+    int resumable = status >= 200 && status < 300 && t->is_sse && t->last_event_id &&
+                    result != CURLE_OPERATION_TIMEDOUT;
+    int unknown_session = result == CURLE_OK && status == 404 && t->sent_session_id;
+    // A 404 for an id that was already replaced says nothing about the new one
+    int expired = unknown_session && t->sent_generation == s->generation;
+
+    switch (t->kind) {
+        case MCP_HTTP_POST:
+        case MCP_HTTP_RESUME:
+            if (unknown_session && s->init_body && t->kind == MCP_HTTP_POST) {
+                if (expired) {
+                    start_reinit(s);
+                }
+                transfer_reset(t);
+                start_or_fail(t);  // Held until the session is back, or resent in it
+                return;
+            }
+            if (expired) {
+                start_reinit(s);  // The stream being resumed went with the session
+            }
+            if (ok && !t->is_sse && t->used > 0 && !t->too_large) {
+                deliver(t, t->buf, t->used);
+            }
+            if (t->request_id >= 0 && !t->answered) {
+                // Resuming would skip the dropped event, not shrink it
+                MCPHttpTransfer *resume = resumable && !t->too_large ? transfer_new(s, MCP_HTTP_RESUME, NULL, t->request_id) : NULL;
+                if (resume) {
+                    // The server replays what followed the last event it sent
+                    LOG_DEBUG("MCP HTTP: Reply to %d cut off, resuming from event %s",
+                              t->request_id, t->last_event_id);
+                    resume->resume_from = t->last_event_id;
+                    t->last_event_id = NULL;
+                    start_or_fail(resume);
+                } else {
+                    if (result != CURLE_OK) {
+                        LOG_WARN("MCP HTTP: Request to %s failed: %s", s->url,
+                                 t->errbuf[0] ? t->errbuf : curl_easy_strerror(result));
+                    } else if (!ok) {
+                        LOG_WARN("MCP HTTP: Request to %s failed with HTTP %ld", s->url, status);
+                    }
+                    s->on_fail(s->ctx, t->request_id,
+                               t->too_large ? "response too large" :
+                               ok ? "response ended without a reply" : "HTTP request failed");
+                }
+            }
+            break;
+
+        case MCP_HTTP_REINIT:
+            finish_reinit(s, ok && s->session_id != NULL);
+            break;
+
+        case MCP_HTTP_LISTEN:
+            s->listen_open = 0;
+            if (t->last_event_id) {
+                free(s->listen_event_id);
+                s->listen_event_id = t->last_event_id;
+                t->last_event_id = NULL;
+            }
+            if (s->cancelled) {
+                break;
+            }
+            if (result == CURLE_OK && status == 405) {
+                LOG_DEBUG("MCP HTTP: %s offers no stream for server messages", s->url);
+                s->listening = -1;
+            } else if (expired) {
+                start_reinit(s);
+            } else if (!s->listen_due) {
+                LOG_DEBUG("MCP HTTP: Stream from %s ended, reopening in %ld ms", s->url, s->retry_ms);
+                schedule_listen(s, s->retry_ms);
+            }
+            break;
+
+        case MCP_HTTP_DELETE:
+            break;
+
+        default:
+            break;
+    }
+    (void)status;  // Only used for logging in some branches
+    transfer_free(t);
+}
+
+/*
+ * Drop every transfer of a closing session and tell the server it is done.
+ * Runs on the transport thread with g_lock held.
+ */
+static void cancel_session(MCPHttpSession *s) {
+    s->cancelled = 1;
+
+    for (MCPHttpTransfer **link = &g_active; *link;) {
+        MCPHttpTransfer *t = *link;
+        if (t->session == s && t->kind != MCP_HTTP_DELETE) {
+            *link = t->next;
+            curl_multi_remove_handle(g_multi, t->easy);
+            s->active--;
+            transfer_free(t);
+        } else {
+            link = &t->next;
+        }
+    }
+    while (s->held) {
+        MCPHttpTransfer *next = s->held->next;
+        transfer_free(s->held);
+        s->held = next;
+    }
+    s->listen_open = 0;
+    s->listen_due = 0;
+
+    if (s->session_id) {
+        MCPHttpTransfer *t = transfer_new(s, MCP_HTTP_DELETE, NULL, -1);
+        if (t && start_transfer(t) != 0) {
+            transfer_free(t);
+        }
+    }
+}
+
+static void* mcp_http_thread(void *arg) {
+    (void)arg;
+
+    for (;;) {
+        int timeout_ms = 1000;
+
+        pthread_mutex_lock(&g_lock);
+        if (g_stop) {
+            pthread_mutex_unlock(&g_lock);
+            break;
+        }
+
+        // Messages queued by other threads, in the order they were sent
+        MCPHttpTransfer *queued = g_queue;
+        g_queue = NULL;
+        MCPHttpTransfer *ordered = NULL;
+        while (queued) {
+            MCPHttpTransfer *next = queued->next;
+            if (queued->session->closing) {
+                transfer_free(queued);
+            } else {
+                queued->next = ordered;
+                ordered = queued;
+            }
+            queued = next;
+        }
+
+        for (MCPHttpSession *s = g_sessions; s; s = s->next) {
+            if (s->closing) {
+                if (!s->cancelled) {
+                    cancel_session(s);
+                }
+                if (s->active == 0 && !s->closed) {
+                    s->closed = 1;
+                    pthread_cond_broadcast(&g_cond);
+                }
+                continue;
+            }
+            if (s->listen_requested) {
+                s->listen_requested = 0;
+                if (s->listening == 0) {
+                    s->listening = 1;
+                    schedule_listen(s, 0);
+                }
+            }
+            if (s->listen_due && !s->reinit) {
+                long ms = ms_until(&s->listen_at);
+                if (ms == 0) {
+                    start_listen(s);
+                } else if (ms < timeout_ms) {
+                    timeout_ms = (int)ms;
+                }
+            }
+        }
+        pthread_mutex_unlock(&g_lock);
+
+        // A session closes only on this thread, so these stay valid unlocked
+        while (ordered) {
+            MCPHttpTransfer *next = ordered->next;
+            ordered->next = NULL;
+            start_or_fail(ordered);
+            ordered = next;
+        }
+
+        // Callbacks run here and may queue more messages, so no lock is held
+        int running = 0;
+        curl_multi_perform(g_multi, &running);
+
+        CURLMsg *msg;
+        int left = 0;
+        int finished = 0;
+        while ((msg = curl_multi_info_read(g_multi, &left)) != NULL) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            char *priv = NULL;
+            curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &priv);
+            if (priv) {
+                finish_transfer((MCPHttpTransfer *)(void *)priv, msg->data.result);
+                finished = 1;
+            }
+        }
+
+        // A finished transfer may have closed a session or started others
+        curl_multi_poll(g_multi, NULL, 0, finished ? 0 : timeout_ms, NULL);
+    }
+
+    // Only reached once every session is closed
+    while (g_active) {
+        MCPHttpTransfer *next = g_active->next;
+        curl_multi_remove_handle(g_multi, g_active->easy);
+        transfer_free(g_active);
+        g_active = next;
+    }
+    return NULL;
+}
+
+static char* copy_header(const char *line) {
+    return line ? strdup(line) : NULL;
+}
+
+static void session_free(MCPHttpSession *s) {
+    for (int i = 0; i < s->header_count; i++) {
+        free(s->headers[i]);
+    }
+    free(s->headers);
+    free(s->url);
+    free(s->session_id);
+    free(s->listen_event_id);
+    free(s->init_body);
+    free(s);
+}
+
+MCPHttpSession* mcp_http_open(const char *url, char *const *headers, int header_count,
+                              long timeout_ms, MCPHttpMessageFn on_message,
+                              MCPHttpFailFn on_fail, void *ctx) {
+    if (!url || !on_message || !on_fail) {
+        return NULL;
+    }
+    pthread_once(&g_curl_once, mcp_http_curl_init);
+
+    MCPHttpSession *s = calloc(1, sizeof(MCPHttpSession));
+    if (!s) {
+        return NULL;
+    }
+    s->url = strdup(url);
+    s->headers = header_count > 0 ? calloc((size_t)header_count, sizeof(char*)) : NULL;
+    if (!s->url || (header_count > 0 && !s->headers)) {
+        session_free(s);
+        return NULL;
+    }
+    for (int i = 0; i < header_count; i++) {
+        s->headers[s->header_count] = copy_header(headers[i]);
+        if (s->headers[s->header_count]) {
+            s->header_count++;
+        }
+    }
+    s->timeout_ms = timeout_ms;
+    s->retry_ms = MCP_HTTP_RETRY_MS;
+    s->on_message = on_message;
+    s->on_fail = on_fail;
+    s->ctx = ctx;
+
+    pthread_mutex_lock(&g_lock);
+    while (g_stop) {
+        pthread_cond_wait(&g_cond, &g_lock);  // The last session is shutting the thread down
+    }
+    if (!g_running) {
+        g_multi = curl_multi_init();
+        if (!g_multi) {
+            pthread_mutex_unlock(&g_lock);
+            session_free(s);
+            return NULL;
+        }
+        curl_multi_setopt(g_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        int rc = pthread_create(&g_thread, NULL, mcp_http_thread, NULL);
+        if (rc != 0) {
+            LOG_ERROR("MCP HTTP: Failed to start transport thread: %s", strerror(rc));
+            curl_multi_cleanup(g_multi);
+            g_multi = NULL;
+            pthread_mutex_unlock(&g_lock);
+            session_free(s);
+            return NULL;
+        }
+        g_running = 1;
+    }
+    s->next = g_sessions;
+    g_sessions = s;
+    pthread_mutex_unlock(&g_lock);
+
+    return s;
+}
+
+int mcp_http_send(MCPHttpSession *session, const char *message, int request_id, int initialize) {
+    if (!session || !message) {
+        return -1;
+    }
+    MCPHttpTransfer *t = transfer_new(session, MCP_HTTP_POST, message, request_id);
+    if (!t) {
+        return -1;
+    }
+    t->initialize = initialize;
+
+    pthread_mutex_lock(&g_lock);
+    if (session->closing) {
+        pthread_mutex_unlock(&g_lock);
+        transfer_free(t);
+        return -1;
+    }
+    t->next = g_queue;
+    g_queue = t;
+    curl_multi_wakeup(g_multi);
+    pthread_mutex_unlock(&g_lock);
+    return 0;
+}
+
+void mcp_http_listen(MCPHttpSession *session) {
+    if (!session) {
+        return;
+    }
+    pthread_mutex_lock(&g_lock);
+    session->listen_requested = 1;
+    curl_multi_wakeup(g_multi);
+    pthread_mutex_unlock(&g_lock);
+}
+
+void mcp_http_close(MCPHttpSession *session) {
+    if (!session) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    session->closing = 1;
+    curl_multi_wakeup(g_multi);
+    while (!session->closed) {
+        pthread_cond_wait(&g_cond, &g_lock);
+    }
+    for (MCPHttpSession **link = &g_sessions; *link; link = &(*link)->next) {
+        if (*link == session) {
+            *link = session->next;
+            break;
+        }
+    }
+    int last = g_sessions == NULL;
+    if (last) {
+        g_stop = 1;
+        curl_multi_wakeup(g_multi);
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    session_free(session);
+    if (!last) {
+        return;
+    }
+
+    // Nothing uses the transport any more; stop its thread
+    pthread_join(g_thread, NULL);
+    pthread_mutex_lock(&g_lock);
+    curl_multi_cleanup(g_multi);
+    g_multi = NULL;
+    g_running = 0;
+    g_stop = 0;
+    pthread_cond_broadcast(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+}
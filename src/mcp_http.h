@@ -0,0 +1,77 @@
+/*
+ * mcp_http.h - Streamable HTTP transport for MCP servers
+ *
+ * Servers configured with a "url" are reached over MCP's streamable HTTP
+ * transport. Every client message is POSTed to the URL, and the server
+ * answers with either a JSON body or an SSE stream (text/event-stream)
+ * carrying the reply along with any requests and notifications it sends
+ * first. Once the session is initialized, a GET on the same URL opens a
+ * long-lived SSE stream for messages the server pushes on its own.
+ *
+ * All sessions share one libcurl multi handle, driven by one thread.
+ * Requests to the same host reuse kept-alive connections (multiplexed over
+ * one connection when the server speaks HTTP/2), and any number of them
+ * can be outstanding at once.
+ *
+ * Sessions survive reconnects. The Mcp-Session-Id the server assigns is
+ * sent with every request. A reply stream that breaks off after an event
+ * with an id is picked up with a GET carrying Last-Event-ID, so the server
+ * can replay what was missed, and the listening stream is reopened the same
+ * way. When the server has expired the session (404), it is initialized
+ * again and the request that found out is resent.
+ */
+
+#ifndef MCP_HTTP_H
+#define MCP_HTTP_H
+
+#include <stddef.h>
+
+// Delay before reopening a dropped listening stream, unless the server sends "retry:"
+#define MCP_HTTP_RETRY_MS 1000
+
+typedef struct MCPHttpSession MCPHttpSession;
+
+/*
+ * Called on the transport thread for each JSON-RPC message received
+ * (NUL-terminated). Returns the id of the request the message answers, or
+ * -1 when it answers none.
+ */
+typedef int (*MCPHttpMessageFn)(void *ctx, const char *message, size_t len);
+
+/*
+ * Called on the transport thread when no reply will come for request_id.
+ * reason is a static string.
+ */
+typedef void (*MCPHttpFailFn)(void *ctx, int request_id, const char *reason);
+
+/*
+ * Start a session with the server at url. headers are extra "Name: value"
+ * lines sent with every request; timeout_ms bounds each POST.
+ * Returns: Session, or NULL on error
+ */
+MCPHttpSession* mcp_http_open(const char *url, char *const *headers, int header_count,
+                              long timeout_ms, MCPHttpMessageFn on_message,
+                              MCPHttpFailFn on_fail, void *ctx);
+
+/*
+ * Queue one message for sending. request_id is the id of a request whose
+ * failure on_fail should report (-1 for notifications and replies).
+ * initialize marks the initialize request, which is kept to initialize the
+ * session again if the server expires it.
+ * Returns: 0 when queued, -1 if the session is closing or out of memory
+ */
+int mcp_http_send(MCPHttpSession *session, const char *message, int request_id, int initialize);
+
+/*
+ * Open the stream for messages the server sends on its own. Called once
+ * the session is initialized; the stream is reopened whenever it drops.
+ */
+void mcp_http_listen(MCPHttpSession *session);
+
+/*
+ * End the session: cancel its transfers, tell the server (DELETE) and free
+ * it. No callback for the session runs once this returns.
+ */
+void mcp_http_close(MCPHttpSession *session);
+
+#endif // MCP_HTTP_H
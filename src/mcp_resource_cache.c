@@ -0,0 +1,327 @@
+/*
+ * mcp_resource_cache.c - In-memory cache of MCP resource contents
+ */
+
+#include "mcp_resource_cache.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MCP_RESOURCE_CACHE_MIN_BUCKETS 64
+
+typedef struct MCPResourceCacheEntry {
+    struct MCPResourceCacheEntry *next;     // Same bucket
+    struct MCPResourceCacheEntry *newer;    // Toward the most recently used
+    struct MCPResourceCacheEntry *older;    // Toward the least recently used
+    uint32_t hash;
+    char *server;
+    char *uri;
+    MCPResourceCacheValue value;
+    size_t bytes;                           // Counted against max_bytes
+    long long expires_ms;
+} MCPResourceCacheEntry;
+
+struct MCPResourceCache {
+    pthread_mutex_t lock;
+    MCPResourceCacheEntry **buckets;        // Chains by hash of (server, uri)
+    size_t bucket_count;                    // Power of two
+    MCPResourceCacheEntry *newest;
+    MCPResourceCacheEntry *oldest;
+    int count;
+    size_t bytes;
+    size_t max_bytes;
+    long long ttl_ms;
+    unsigned long epoch;                    // Bumped by every invalidation
+    unsigned long hits;
+    unsigned long misses;
+};
+
+// FNV-1a over server, a separator and uri
+static uint32_t key_hash(const char *server, const char *uri) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)server; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    h *= 16777619u;  // The separator (a zero byte)
+    for (const unsigned char *p = (const unsigned char *)uri; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static size_t value_bytes(const MCPResourceCacheValue *value) {
+    return (value->mime_type ? strlen(value->mime_type) + 1 : 0) +
+           (value->text ? strlen(value->text) + 1 : 0) +
+           (value->blob ? value->blob_size : 0);
+}
+
+void mcp_resource_cache_value_clear(MCPResourceCacheValue *value) {
+    if (!value) {
+        return;
+    }
+    free(value->mime_type);
+    free(value->text);
+    free(value->blob);
+    memset(value, 0, sizeof(*value));
+}
+
+static int value_copy(MCPResourceCacheValue *dst, const MCPResourceCacheValue *src) {
+    memset(dst, 0, sizeof(*dst));
+    if (src->mime_type && !(dst->mime_type = strdup(src->mime_type))) {
+        return -1;
+    }
+    if (src->text && !(dst->text = strdup(src->text))) {
+        mcp_resource_cache_value_clear(dst);
+        return -1;
+    }
+    if (src->blob) {
+        dst->blob = malloc(src->blob_size > 0 ? src->blob_size : 1);
+        if (!dst->blob) {
+            mcp_resource_cache_value_clear(dst);
+            return -1;
+        }
+        memcpy(dst->blob, src->blob, src->blob_size);
+        dst->blob_size = src->blob_size;
+    }
+    return 0;
+}
+
+static void entry_free(MCPResourceCacheEntry *entry) {
+    free(entry->server);
+    free(entry->uri);
+    mcp_resource_cache_value_clear(&entry->value);
+    free(entry);
+}
+
+MCPResourceCache* mcp_resource_cache_new(size_t max_bytes, long long ttl_ms) {
+    if (ttl_ms <= 0) {
+        return NULL;
+    }
+    MCPResourceCache *cache = calloc(1, sizeof(MCPResourceCache));
+    if (!cache) {
+        return NULL;
+    }
+    cache->buckets = calloc(MCP_RESOURCE_CACHE_MIN_BUCKETS, sizeof(MCPResourceCacheEntry *));
+    if (!cache->buckets) {
+        free(cache);
+        return NULL;
+    }
+    cache->bucket_count = MCP_RESOURCE_CACHE_MIN_BUCKETS;
+    cache->max_bytes = max_bytes;
+    cache->ttl_ms = ttl_ms;
+    pthread_mutex_init(&cache->lock, NULL);
+    return cache;
+}
+
+void mcp_resource_cache_free(MCPResourceCache *cache) {
+    if (!cache) {
+        return;
+    }
+    MCPResourceCacheEntry *entry = cache->newest;
+    while (entry) {
+        MCPResourceCacheEntry *older = entry->older;
+        entry_free(entry);
+        entry = older;
+    }
+    free(cache->buckets);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+static MCPResourceCacheEntry* find_entry(MCPResourceCache *cache, uint32_t hash,
+                                         const char *server, const char *uri) {
+    MCPResourceCacheEntry *entry = cache->buckets[hash & (cache->bucket_count - 1)];
+    while (entry && (entry->hash != hash || strcmp(entry->server, server) != 0 ||
+                     strcmp(entry->uri, uri) != 0)) {
+        entry = entry->next;
+    }
+    return entry;
+}
+
+static void lru_unlink(MCPResourceCache *cache, MCPResourceCacheEntry *entry) {
+    if (entry->newer) {
+        entry->newer->older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+    if (entry->older) {
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+    entry->newer = entry->older = NULL;
+}
+
+static void lru_push_newest(MCPResourceCache *cache, MCPResourceCacheEntry *entry) {
+    entry->newer = NULL;
+    entry->older = cache->newest;
+    if (cache->newest) {
+        cache->newest->newer = entry;
+    } else {
+        cache->oldest = entry;
+    }
+    cache->newest = entry;
+}
+
+static void remove_entry(MCPResourceCache *cache, MCPResourceCacheEntry *entry) {
+    MCPResourceCacheEntry **link = &cache->buckets[entry->hash & (cache->bucket_count - 1)];
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    lru_unlink(cache, entry);
+    cache->bytes -= entry->bytes;
+    cache->count--;
+    entry_free(entry);
+}
+
+// Double the buckets; keeps the old table if memory runs out
+static void grow_buckets(MCPResourceCache *cache) {
+    size_t bucket_count = cache->bucket_count * 2;
+    MCPResourceCacheEntry **buckets = calloc(bucket_count, sizeof(MCPResourceCacheEntry *));
+    if (!buckets) {
+        return;
+    }
+    for (MCPResourceCacheEntry *entry = cache->newest; entry; entry = entry->older) {
+        size_t i = entry->hash & (bucket_count - 1);
+        entry->next = buckets[i];
+        buckets[i] = entry;
+    }
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_count = bucket_count;
+}
+
+int mcp_resource_cache_get(MCPResourceCache *cache, const char *server, const char *uri,
+                           long long now_ms, MCPResourceCacheValue *value) {
+    if (value) {
+        memset(value, 0, sizeof(*value));
+    }
+    if (!cache || !server || !uri || !value) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    MCPResourceCacheEntry *entry = find_entry(cache, key_hash(server, uri), server, uri);
+    if (entry && entry->expires_ms <= now_ms) {
+        remove_entry(cache, entry);
+        entry = NULL;
+    }
+    int hit = entry && value_copy(value, &entry->value) == 0;
+    if (hit) {
+        lru_unlink(cache, entry);
+        lru_push_newest(cache, entry);
+        cache->hits++;
+    } else {
+        cache->misses++;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return hit;
+}
+
+unsigned long mcp_resource_cache_epoch(MCPResourceCache *cache) {
+    if (!cache) {
+        return 0;
+    }
+    pthread_mutex_lock(&cache->lock);
+    unsigned long epoch = cache->epoch;
+    pthread_mutex_unlock(&cache->lock);
+    return epoch;
+}
+
+int mcp_resource_cache_put(MCPResourceCache *cache, const char *server, const char *uri,
+                           const MCPResourceCacheValue *value, long long now_ms,
+                           unsigned long epoch) {
+    if (!cache || !server || !uri || !value) {
+        return -1;
+    }
+    size_t bytes = sizeof(MCPResourceCacheEntry) + strlen(server) + 1 + strlen(uri) + 1 +
+                   value_bytes(value);
+    if (bytes > cache->max_bytes) {
+        return -1;
+    }
+
+    // Copy outside the lock; large blobs take a while
+    MCPResourceCacheEntry *entry = calloc(1, sizeof(MCPResourceCacheEntry));
+    if (!entry) {
+        return -1;
+    }
+    entry->server = strdup(server);
+    entry->uri = strdup(uri);
+    if (!entry->server || !entry->uri || value_copy(&entry->value, value) != 0) {
+        entry_free(entry);
+        return -1;
+    }
+    entry->hash = key_hash(server, uri);
+    entry->bytes = bytes;
+    entry->expires_ms = now_ms + cache->ttl_ms;
+
+    pthread_mutex_lock(&cache->lock);
+    if (cache->epoch != epoch) {
+        pthread_mutex_unlock(&cache->lock);
+        entry_free(entry);
+        return -1;
+    }
+    MCPResourceCacheEntry *old = find_entry(cache, entry->hash, server, uri);
+    if (old) {
+        remove_entry(cache, old);
+    }
+    while (cache->oldest && cache->bytes + bytes > cache->max_bytes) {
+        remove_entry(cache, cache->oldest);
+    }
+    if ((size_t)cache->count >= cache->bucket_count) {
+        grow_buckets(cache);
+    }
+    size_t i = entry->hash & (cache->bucket_count - 1);
+    entry->next = cache->buckets[i];
+    cache->buckets[i] = entry;
+    lru_push_newest(cache, entry);
+    cache->bytes += bytes;
+    cache->count++;
+    pthread_mutex_unlock(&cache->lock);
+    return 0;
+}
+
+void mcp_resource_cache_invalidate(MCPResourceCache *cache, const char *server, const char *uri) {
+    if (!cache || !server) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->lock);
+    cache->epoch++;
+    if (uri) {
+        MCPResourceCacheEntry *entry = find_entry(cache, key_hash(server, uri), server, uri);
+        if (entry) {
+            remove_entry(cache, entry);
+        }
+    } else {
+        MCPResourceCacheEntry *entry = cache->newest;
+        while (entry) {
+            MCPResourceCacheEntry *older = entry->older;
+            if (strcmp(entry->server, server) == 0) {
+                remove_entry(cache, entry);
+            }
+            entry = older;
+        }
+    }
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void mcp_resource_cache_stats(MCPResourceCache *cache, MCPResourceCacheStats *stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (!cache) {
+        return;
+    }
+    pthread_mutex_lock(&cache->lock);
+    stats->entries = cache->count;
+    stats->bytes = cache->bytes;
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    pthread_mutex_unlock(&cache->lock);
+}
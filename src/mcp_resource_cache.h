@@ -0,0 +1,92 @@
+/*
+ * mcp_resource_cache.h - In-memory cache of MCP resource contents
+ *
+ * Contents read with resources/read are kept per (server, uri), so a
+ * resource read again is answered from memory instead of another round
+ * trip and another parse of the (often large, base64-encoded) reply.
+ *
+ * The cache is bounded by the bytes its entries hold and evicts the least
+ * recently used entry first. An entry also expires ttl_ms after it was
+ * stored, and is dropped as soon as the server says the resource changed.
+ * Values are copied in and out, so callers own what they pass and get.
+ *
+ * All functions are safe to call from several threads at once.
+ */
+
+#ifndef MCP_RESOURCE_CACHE_H
+#define MCP_RESOURCE_CACHE_H
+
+#include <stddef.h>
+
+typedef struct MCPResourceCache MCPResourceCache;
+
+/*
+ * Contents of one resource. Any field may be NULL.
+ */
+typedef struct {
+    char *mime_type;
+    char *text;
+    void *blob;
+    size_t blob_size;
+} MCPResourceCacheValue;
+
+/*
+ * Counters for mcp_get_status()
+ */
+typedef struct {
+    int entries;
+    size_t bytes;
+    unsigned long hits;
+    unsigned long misses;
+} MCPResourceCacheStats;
+
+/*
+ * Create a cache holding at most max_bytes, whose entries expire ttl_ms
+ * after they were stored
+ * Returns: Cache, or NULL when ttl_ms is 0 or memory runs out. Every
+ * function takes a NULL cache and then caches nothing.
+ */
+MCPResourceCache* mcp_resource_cache_new(size_t max_bytes, long long ttl_ms);
+
+void mcp_resource_cache_free(MCPResourceCache *cache);
+
+/*
+ * Copy the cached contents of uri on server into *value, which the caller
+ * frees with mcp_resource_cache_value_clear(). now_ms is CLOCK_MONOTONIC.
+ * Returns: 1 on a hit, 0 on a miss (value left zeroed)
+ */
+int mcp_resource_cache_get(MCPResourceCache *cache, const char *server, const char *uri,
+                           long long now_ms, MCPResourceCacheValue *value);
+
+/*
+ * The invalidation count, taken before reading a resource from its server
+ * and passed to mcp_resource_cache_put(). A change notification that
+ * arrives while the read is in flight then keeps the reply out.
+ */
+unsigned long mcp_resource_cache_epoch(MCPResourceCache *cache);
+
+/*
+ * Store a copy of value for uri on server, replacing any older entry and
+ * evicting the least recently used ones to make room. Nothing is stored
+ * if anything was invalidated since epoch was taken, or if the value alone
+ * is larger than the cache.
+ * Returns: 0 when stored, -1 otherwise
+ */
+int mcp_resource_cache_put(MCPResourceCache *cache, const char *server, const char *uri,
+                           const MCPResourceCacheValue *value, long long now_ms,
+                           unsigned long epoch);
+
+/*
+ * Drop the entry for uri on server, or every entry of server when uri is
+ * NULL
+ */
+void mcp_resource_cache_invalidate(MCPResourceCache *cache, const char *server, const char *uri);
+
+void mcp_resource_cache_stats(MCPResourceCache *cache, MCPResourceCacheStats *stats);
+
+/*
+ * Free the fields of a value filled in by mcp_resource_cache_get()
+ */
+void mcp_resource_cache_value_clear(MCPResourceCacheValue *value);
+
+#endif // MCP_RESOURCE_CACHE_H
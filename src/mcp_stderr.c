@@ -0,0 +1,241 @@
+/*
+ * mcp_stderr.c - Background capture of an MCP server's stderr
+ */
+
+#include "mcp_stderr.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Length of the window the rate is measured over
+#define MCP_STDERR_RATE_WINDOW_MS 1000
+
+struct MCPStderrLog {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;                 // Signalled when output arrives or on close
+    pthread_t thread;
+    char *ring;
+    size_t capacity;
+    size_t head;                         // Oldest byte not yet flushed
+    size_t used;
+    int closing;
+
+    // Counters (guarded by lock)
+    unsigned long long bytes;
+    unsigned long lines;
+    unsigned long long dropped;
+    unsigned long long dropped_unreported;  // Not yet noted in the file
+    long long window_start_ms;           // 0 = nothing read yet
+    unsigned long long window_bytes;
+    double rate;                         // Of the last full window
+
+    // Flush thread only
+    FILE *file;
+    char *chunk;                         // What one flush takes out of the ring
+    MCPStderrLineFn on_line;
+    void *ctx;
+    char line[MCP_STDERR_MAX_LINE + 1];  // Line still being assembled
+    size_t line_len;
+};
+
+static void emit_line(MCPStderrLog *log) {
+    while (log->line_len > 0 && log->line[log->line_len - 1] == '\r') {
+        log->line_len--;
+    }
+    if (log->line_len > 0 && log->on_line) {
+        log->line[log->line_len] = '\0';
+        log->on_line(log->ctx, log->line);
+    }
+    log->line_len = 0;
+}
+
+// Write one chunk to the file and hand out its lines
+static void write_chunk(MCPStderrLog *log, const char *data, size_t len, unsigned long long dropped) {
+    if (dropped > 0) {
+        emit_line(log);  // What came before the gap
+        if (log->file) {
+            fprintf(log->file, "\n[%llu bytes of stderr dropped]\n", dropped);
+        }
+    }
+    if (log->file) {
+        fwrite(data, 1, len, log->file);
+        fflush(log->file);
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == '\n') {
+            emit_line(log);
+            continue;
+        }
+        if (log->line_len == MCP_STDERR_MAX_LINE) {
+            emit_line(log);
+        }
+        log->line[log->line_len++] = data[i];
+    }
+}
+
+static void* flush_thread(void *arg) {
+    MCPStderrLog *log = arg;
+
+    pthread_mutex_lock(&log->lock);
+    for (;;) {
+        while (log->used == 0 && !log->closing) {
+            pthread_cond_wait(&log->cond, &log->lock);
+        }
+        if (log->used == 0) {
+            break;  // Closing, and everything is out
+        }
+
+        // Take everything queued; the reader can refill the ring meanwhile
+        size_t len = log->used;
+        size_t first = log->capacity - log->head < len ? log->capacity - log->head : len;
+        memcpy(log->chunk, log->ring + log->head, first);
+        memcpy(log->chunk + first, log->ring, len - first);
+        log->head = (log->head + len) % log->capacity;
+        log->used = 0;
+        unsigned long long dropped = log->dropped_unreported;
+        log->dropped_unreported = 0;
+        pthread_mutex_unlock(&log->lock);
+
+        write_chunk(log, log->chunk, len, dropped);
+
+        pthread_mutex_lock(&log->lock);
+    }
+    pthread_mutex_unlock(&log->lock);
+
+    emit_line(log);  // A last line without a newline
+    return NULL;
+}
+
+MCPStderrLog* mcp_stderr_open(const char *path, size_t capacity, MCPStderrLineFn on_line, void *ctx) {
+    if (capacity == 0) {
+        return NULL;
+    }
+    MCPStderrLog *log = calloc(1, sizeof(MCPStderrLog));
+    if (!log) {
+        return NULL;
+    }
+    log->ring = malloc(capacity);
+    log->chunk = malloc(capacity);
+    if (!log->ring || !log->chunk) {
+        free(log->ring);
+        free(log->chunk);
+        free(log);
+        return NULL;
+    }
+    log->capacity = capacity;
+    log->on_line = on_line;
+    log->ctx = ctx;
+    log->file = path ? fopen(path, "w") : NULL;
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->cond, NULL);
+
+    if (pthread_create(&log->thread, NULL, flush_thread, log) != 0) {
+        if (log->file) {
+            fclose(log->file);
+        }
+        pthread_mutex_destroy(&log->lock);
+        pthread_cond_destroy(&log->cond);
+        free(log->ring);
+        free(log->chunk);
+        free(log);
+        return NULL;
+    }
+    return log;
+}
+
+void mcp_stderr_append(MCPStderrLog *log, const char *data, size_t len, long long now_ms) {
+    if (!log || !data || len == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&log->lock);
+    log->bytes += len;
+    for (const char *p = data; (p = memchr(p, '\n', len - (size_t)(p - data))) != NULL; p++) {
+        log->lines++;
+    }
+
+    // Close the rate window once it is full
+    if (log->window_start_ms == 0) {
+        log->window_start_ms = now_ms;
+    } else if (now_ms - log->window_start_ms >= MCP_STDERR_RATE_WINDOW_MS) {
+        log->rate = (double)log->window_bytes * 1000.0 / (double)(now_ms - log->window_start_ms);
+        log->window_start_ms = now_ms;
+        log->window_bytes = 0;
+    }
+    log->window_bytes += len;
+
+    // Keep the newest output: drop the oldest to make room
+    if (len > log->capacity) {
+        log->dropped += len - log->capacity;
+        log->dropped_unreported += len - log->capacity;
+        data += len - log->capacity;
+        len = log->capacity;
+    }
+    if (log->used + len > log->capacity) {
+        size_t drop = log->used + len - log->capacity;
+        log->head = (log->head + drop) % log->capacity;
+        log->used -= drop;
+        log->dropped += drop;
+        log->dropped_unreported += drop;
+    }
+
+    int was_empty = log->used == 0;
+    size_t tail = (log->head + log->used) % log->capacity;
+    size_t first = log->capacity - tail < len ? log->capacity - tail : len;
+    memcpy(log->ring + tail, data, first);
+    memcpy(log->ring, data + first, len - first);
+    log->used += len;
+    if (was_empty) {
+        pthread_cond_signal(&log->cond);
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+void mcp_stderr_stats(MCPStderrLog *log, long long now_ms, MCPStderrStats *stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (!log) {
+        return;
+    }
+
+    pthread_mutex_lock(&log->lock);
+    stats->bytes = log->bytes;
+    stats->lines = log->lines;
+    stats->dropped = log->dropped;
+    long long elapsed = now_ms - log->window_start_ms;
+    if (log->window_start_ms == 0) {
+        stats->bytes_per_sec = 0.0;
+    } else if (elapsed >= MCP_STDERR_RATE_WINDOW_MS) {
+        // The current window is over: average it out to now, so a server
+        // that went quiet decays toward 0
+        stats->bytes_per_sec = (double)log->window_bytes * 1000.0 / (double)elapsed;
+    } else {
+        stats->bytes_per_sec = log->rate;
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+void mcp_stderr_close(MCPStderrLog *log) {
+    if (!log) {
+        return;
+    }
+
+    pthread_mutex_lock(&log->lock);
+    log->closing = 1;
+    pthread_cond_signal(&log->cond);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->thread, NULL);
+
+    if (log->file) {
+        fclose(log->file);
+    }
+    pthread_mutex_destroy(&log->lock);
+    pthread_cond_destroy(&log->cond);
+    free(log->ring);
+    free(log->chunk);
+    free(log);
+}
@@ -0,0 +1,61 @@
+/*
+ * mcp_stderr.h - Background capture of an MCP server's stderr
+ *
+ * The thread that reads a server's stderr only copies what it read into a
+ * bounded ring, so a chatty server never waits on the pipe and never holds
+ * up the replies read on the same thread. A flush thread per server writes
+ * the ring to the server's log file and hands each complete line to a
+ * callback (the debug log). When the server writes faster than the ring
+ * is flushed, the oldest output is dropped and the log file says how much.
+ *
+ * The log lives as long as the server config, across restarts of the
+ * server, so the output of a server that crashed is kept.
+ */
+
+#ifndef MCP_STDERR_H
+#define MCP_STDERR_H
+
+#include <stddef.h>
+
+// Bytes of stderr held for the flush thread
+#define MCP_STDERR_RING_SIZE 65536
+
+// Longest line handed to the callback; longer ones are split
+#define MCP_STDERR_MAX_LINE 1024
+
+typedef struct MCPStderrLog MCPStderrLog;
+
+/*
+ * Called on the flush thread for each non-empty line (NUL-terminated,
+ * without the newline)
+ */
+typedef void (*MCPStderrLineFn)(void *ctx, const char *line);
+
+typedef struct {
+    unsigned long long bytes;    // Read from the server in all
+    unsigned long lines;         // Newlines among them
+    unsigned long long dropped;  // Overwritten before they were flushed
+    double bytes_per_sec;        // Over the last second or so, 0 once quiet
+} MCPStderrStats;
+
+/*
+ * Open a log writing to path (NULL = no file) with a ring of capacity
+ * bytes, and start its flush thread
+ * Returns: Log, or NULL on error
+ */
+MCPStderrLog* mcp_stderr_open(const char *path, size_t capacity, MCPStderrLineFn on_line, void *ctx);
+
+/*
+ * Queue output for the flush thread. Never blocks on I/O. now_ms
+ * (CLOCK_MONOTONIC) feeds the rate.
+ */
+void mcp_stderr_append(MCPStderrLog *log, const char *data, size_t len, long long now_ms);
+
+void mcp_stderr_stats(MCPStderrLog *log, long long now_ms, MCPStderrStats *stats);
+
+/*
+ * Flush what is queued, stop the flush thread and close the file
+ */
+void mcp_stderr_close(MCPStderrLog *log);
+
+#endif // MCP_STDERR_H
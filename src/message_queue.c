@@ -7,11 +7,132 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 
 /* ========================================================================
  * TUI Message Queue Implementation
  * ======================================================================== */
 
+static int wakeup_open(TUIMessageQueue *queue) {
+#ifdef __linux__
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd >= 0) {
+        queue->wakeup_read_fd = fd;
+        queue->wakeup_write_fd = fd;
+        return 0;
+    }
+#endif
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < 2; i++) {
+        int flags = fcntl(fds[i], F_GETFL);
+        if (flags < 0 || fcntl(fds[i], F_SETFL, flags | O_NONBLOCK) < 0 ||
+            fcntl(fds[i], F_SETFD, FD_CLOEXEC) < 0) {
+            close(fds[0]);
+            close(fds[1]);
+            return -1;
+        }
+    }
+    queue->wakeup_read_fd = fds[0];
+    queue->wakeup_write_fd = fds[1];
+    return 0;
+}
+
+static void wakeup_close(TUIMessageQueue *queue) {
+    if (queue->wakeup_read_fd >= 0) {
+        close(queue->wakeup_read_fd);
+    }
+    if (queue->wakeup_write_fd >= 0 && queue->wakeup_write_fd != queue->wakeup_read_fd) {
+        close(queue->wakeup_write_fd);
+    }
+    queue->wakeup_read_fd = -1;
+    queue->wakeup_write_fd = -1;
+}
+
+/* A failed write (counter/pipe full) still leaves the fd readable, which is
+ * all the reader needs. Safe to call from any thread. */
+static void wakeup_signal(TUIMessageQueue *queue) {
+    if (queue->wakeup_write_fd < 0) {
+        return;
+    }
+    uint64_t one = 1;
+    ssize_t rc;
+    if (queue->wakeup_write_fd == queue->wakeup_read_fd) {
+        rc = write(queue->wakeup_write_fd, &one, sizeof(one));
+    } else {
+        rc = write(queue->wakeup_write_fd, &one, 1);
+    }
+    (void)rc;
+}
+
+/* Sleep between checks for space while a producer waits on a full queue */
+#define TUI_MSG_POST_RETRY_NS 200000L
+
+static void drain_wakeup(TUIMessageQueue *queue) {
+    char buf[64];
+    while (read(queue->wakeup_read_fd, buf, sizeof(buf)) > 0) {
+    }
+}
+
+static uint64_t queue_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static const char *lane_name(int priority) {
+    return priority == TUI_PRIORITY_URGENT ? "urgent" : "bulk";
+}
+
+static int lane_init(TUIMessageLane *lane, size_t capacity) {
+    memset(lane, 0, sizeof(*lane));
+    lane->messages = calloc(capacity, sizeof(TUIMessageSlot));
+    if (!lane->messages) {
+        return -1;
+    }
+
+    /* Slot i is free for the producer that claims position i */
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&lane->messages[i].sequence, i);
+    }
+
+    lane->capacity = capacity;
+    atomic_init(&lane->head, 0);
+    atomic_init(&lane->tail, 0);
+    atomic_init(&lane->count, 0);
+    atomic_init(&lane->stalled_tail, 0);
+    atomic_init(&lane->posted, 0);
+    atomic_init(&lane->dropped, 0);
+    atomic_init(&lane->waited, 0);
+    return 0;
+}
+
+static void lane_free(TUIMessageLane *lane) {
+    if (!lane->messages) {
+        return;
+    }
+    /* Free heap text of any messages never consumed */
+    for (size_t i = 0; i < lane->capacity; i++) {
+        TUIMessage *msg = &lane->messages[i].msg;
+        if (msg->text != msg->inline_text) {
+            free(msg->text);
+        }
+    }
+    free(lane->messages);
+    lane->messages = NULL;
+}
+
 int tui_msg_queue_init(TUIMessageQueue *queue, size_t capacity) {
     if (!queue || capacity == 0) {
         return -1;
@@ -19,76 +140,168 @@ int tui_msg_queue_init(TUIMessageQueue *queue, size_t capacity) {
 
     memset(queue, 0, sizeof(*queue));
 
-    queue->messages = calloc(capacity, sizeof(TUIMessage));
-    if (!queue->messages) {
+    if (lane_init(&queue->lanes[TUI_PRIORITY_BULK], capacity) != 0 ||
+        lane_init(&queue->lanes[TUI_PRIORITY_URGENT], TUI_MSG_URGENT_CAPACITY) != 0) {
+        lane_free(&queue->lanes[TUI_PRIORITY_BULK]);
         return -1;
     }
 
-    queue->capacity = capacity;
-    queue->head = 0;
-    queue->tail = 0;
-    queue->count = 0;
-    queue->shutdown = false;
+    atomic_init(&queue->shutdown, false);
+    atomic_init(&queue->heap_text, 0);
+    queue->post_timeout_ms = TUI_MSG_POST_TIMEOUT_MS;
+    queue->wakeup_read_fd = -1;
+    queue->wakeup_write_fd = -1;
 
-    if (pthread_mutex_init(&queue->mutex, NULL) != 0) {
-        free(queue->messages);
+    if (wakeup_open(queue) != 0) {
+        LOG_ERROR("[TUI] Failed to create message queue wakeup fd: %s", strerror(errno));
+        for (int i = 0; i < TUI_MSG_PRIORITIES; i++) {
+            lane_free(&queue->lanes[i]);
+        }
         return -1;
     }
 
-    if (pthread_cond_init(&queue->not_empty, NULL) != 0) {
-        pthread_mutex_destroy(&queue->mutex);
-        free(queue->messages);
-        return -1;
+    return 0;
+}
+
+TUIMessagePriority tui_message_priority(TUIMessageType type) {
+    switch (type) {
+        case TUI_MSG_STATUS:
+        case TUI_MSG_ERROR:
+        case TUI_MSG_TOKEN_UPDATE:
+            return TUI_PRIORITY_URGENT;
+        case TUI_MSG_ADD_LINE:
+        case TUI_MSG_CLEAR:        /* Must stay ordered with the lines */
+        case TUI_MSG_TODO_UPDATE:
+        default:
+            return TUI_PRIORITY_BULK;
     }
+}
 
-    return 0;
+/* Claim the next free slot, or NULL if the lane is full */
+static TUIMessageSlot *claim_slot(TUIMessageLane *lane) {
+    size_t pos = atomic_load_explicit(&lane->head, memory_order_relaxed);
+    for (;;) {
+        TUIMessageSlot *slot = &lane->messages[pos % lane->capacity];
+        size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&lane->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                return slot;
+            }
+        } else if (diff < 0) {
+            return NULL;  /* The consumer has not freed this slot yet */
+        } else {
+            pos = atomic_load_explicit(&lane->head, memory_order_relaxed);
+        }
+    }
 }
 
-int post_tui_message(TUIMessageQueue *queue, TUIMessageType type, const char *text) {
-    if (!queue) {
-        return -1;
+/* Claim a slot, waiting up to post_timeout_ms for the consumer to make room.
+ * Gives up at once during shutdown or if the consumer has not moved since
+ * the last post to this lane that timed out. */
+static TUIMessageSlot *claim_slot_wait(TUIMessageQueue *queue, TUIMessageLane *lane) {
+    TUIMessageSlot *slot = claim_slot(lane);
+    if (slot || queue->post_timeout_ms <= 0) {
+        return slot;
     }
 
-    /* Copy text if provided */
-    char *text_copy = NULL;
-    if (text) {
-        text_copy = strdup(text);
-        if (!text_copy) {
-            return -1;
+    size_t tail = atomic_load_explicit(&lane->tail, memory_order_acquire);
+    if (atomic_load(&queue->shutdown) ||
+        atomic_load_explicit(&lane->stalled_tail, memory_order_relaxed) == tail + 1) {
+        return NULL;
+    }
+
+    atomic_fetch_add_explicit(&lane->waited, 1, memory_order_relaxed);
+    long waited_ns = 0;
+    const long limit_ns = (long)queue->post_timeout_ms * 1000000L;
+    while (waited_ns < limit_ns && !atomic_load(&queue->shutdown)) {
+        struct timespec ts = {0, TUI_MSG_POST_RETRY_NS};
+        nanosleep(&ts, NULL);
+        waited_ns += TUI_MSG_POST_RETRY_NS;
+
+        slot = claim_slot(lane);
+        if (slot) {
+            return slot;
         }
     }
 
-    pthread_mutex_lock(&queue->mutex);
+    tail = atomic_load_explicit(&lane->tail, memory_order_acquire);
+    atomic_store_explicit(&lane->stalled_tail, tail + 1, memory_order_relaxed);
+    return NULL;
+}
 
-    /* If queue is full, drop oldest message (FIFO eviction) */
-    if (queue->count == queue->capacity) {
-        TUIMessage *oldest = &queue->messages[queue->tail];
-        LOG_DEBUG("[TUI] Message queue at capacity (%zu) - dropping oldest message (type=%d)",
-                  queue->capacity,
-                  oldest->type);
-        free(oldest->text);
-        oldest->text = NULL;
-        queue->tail = (queue->tail + 1) % queue->capacity;
-        queue->count--;
+static void publish_slot(TUIMessageQueue *queue, TUIMessageLane *lane, TUIMessageSlot *slot) {
+    size_t pos = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+    atomic_fetch_add_explicit(&lane->posted, 1, memory_order_relaxed);
+
+    /* poll()ers only need to hear about empty -> non-empty */
+    if (atomic_fetch_add_explicit(&lane->count, 1, memory_order_acq_rel) <= 0) {
+        wakeup_signal(queue);
     }
+}
 
-    /* Add new message at head */
-    TUIMessage *msg = &queue->messages[queue->head];
+static void count_drop(TUIMessageLane *lane, TUIMessagePriority priority, TUIMessageType type) {
+    size_t dropped = atomic_fetch_add_explicit(&lane->dropped, 1, memory_order_relaxed) + 1;
+    LOG_DEBUG("[TUI] Message queue %s lane full (%zu) - dropped message (type=%d, total dropped=%zu)",
+              lane_name(priority), lane->capacity, type, dropped);
+}
+
+static void fill_slot(TUIMessageLane *lane, TUIMessageSlot *slot,
+                      TUIMessageType type, TUIMessagePriority priority) {
+    TUIMessage *msg = &slot->msg;
     msg->type = type;
-    msg->text = text_copy;
-    msg->priority = 0; /* Reserved for future use */
+    msg->text = NULL;
+    msg->priority = priority;
     msg->prompt_tokens = 0;
     msg->completion_tokens = 0;
     msg->cached_tokens = 0;
+    msg->posted_ns = queue_now_ns();
+    msg->dropped_before = atomic_load_explicit(&lane->dropped, memory_order_relaxed);
+}
 
-    queue->head = (queue->head + 1) % queue->capacity;
-    queue->count++;
+int post_tui_message(TUIMessageQueue *queue, TUIMessageType type, const char *text) {
+    if (!queue) {
+        return -1;
+    }
 
-    /* Signal waiting readers */
-    pthread_cond_signal(&queue->not_empty);
+    TUIMessagePriority priority = tui_message_priority(type);
+    TUIMessageLane *lane = &queue->lanes[priority];
+    if (!lane->messages) {
+        return -1;
+    }
 
-    pthread_mutex_unlock(&queue->mutex);
+    /* Long text goes to the heap; copy it before claiming a slot so the
+     * claimed slot is published without any allocation in between */
+    size_t len = text ? strlen(text) : 0;
+    char *heap_copy = NULL;
+    if (text && len >= TUI_MSG_INLINE_TEXT) {
+        heap_copy = malloc(len + 1);
+        if (!heap_copy) {
+            return -1;
+        }
+        memcpy(heap_copy, text, len + 1);
+    }
+
+    TUIMessageSlot *slot = claim_slot_wait(queue, lane);
+    if (!slot) {
+        free(heap_copy);
+        count_drop(lane, priority, type);
+        return -1;
+    }
 
+    fill_slot(lane, slot, type, priority);
+    if (heap_copy) {
+        slot->msg.text = heap_copy;
+        atomic_fetch_add_explicit(&queue->heap_text, 1, memory_order_relaxed);
+    } else if (text) {
+        memcpy(slot->msg.inline_text, text, len + 1);
+        slot->msg.text = slot->msg.inline_text;
+    }
+
+    publish_slot(queue, lane, slot);
     return 0;
 }
 
@@ -97,99 +310,193 @@ int post_token_update(TUIMessageQueue *queue, int prompt_tokens, int completion_
         return -1;
     }
 
-    pthread_mutex_lock(&queue->mutex);
+    TUIMessagePriority priority = tui_message_priority(TUI_MSG_TOKEN_UPDATE);
+    TUIMessageLane *lane = &queue->lanes[priority];
+    if (!lane->messages) {
+        return -1;
+    }
 
-    /* If queue is full, drop oldest message (FIFO eviction) */
-    if (queue->count == queue->capacity) {
-        TUIMessage *oldest = &queue->messages[queue->tail];
-        LOG_DEBUG("[TUI] Message queue at capacity (%zu) - dropping oldest message (type=%d)",
-                  queue->capacity,
-                  oldest->type);
-        free(oldest->text);
-        oldest->text = NULL;
-        queue->tail = (queue->tail + 1) % queue->capacity;
-        queue->count--;
-    }
-
-    /* Add new token update message */
-    TUIMessage *msg = &queue->messages[queue->head];
-    msg->type = TUI_MSG_TOKEN_UPDATE;
-    msg->text = NULL;
-    msg->priority = 0;
-    msg->prompt_tokens = prompt_tokens;
-    msg->completion_tokens = completion_tokens;
-    msg->cached_tokens = cached_tokens;
+    TUIMessageSlot *slot = claim_slot_wait(queue, lane);
+    if (!slot) {
+        count_drop(lane, priority, TUI_MSG_TOKEN_UPDATE);
+        return -1;
+    }
 
-    queue->head = (queue->head + 1) % queue->capacity;
-    queue->count++;
+    fill_slot(lane, slot, TUI_MSG_TOKEN_UPDATE, priority);
+    slot->msg.prompt_tokens = prompt_tokens;
+    slot->msg.completion_tokens = completion_tokens;
+    slot->msg.cached_tokens = cached_tokens;
 
-    /* Signal waiting readers */
-    pthread_cond_signal(&queue->not_empty);
+    publish_slot(queue, lane, slot);
+    return 0;
+}
 
-    pthread_mutex_unlock(&queue->mutex);
+/* The slot at the consumer's position, or NULL if not yet published */
+static TUIMessageSlot *peek_slot(TUIMessageLane *lane) {
+    size_t pos = atomic_load_explicit(&lane->tail, memory_order_relaxed);
+    TUIMessageSlot *slot = &lane->messages[pos % lane->capacity];
+    size_t seq = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    return (intptr_t)seq - (intptr_t)(pos + 1) < 0 ? NULL : slot;
+}
 
-    return 0;
+static void make_overflow_marker(TUIMessageLane *lane, TUIMessagePriority priority,
+                                 TUIMessage *msg, size_t dropped_total) {
+    size_t lost = dropped_total - lane->dropped_reported;
+    lane->dropped_reported = dropped_total;
+    LOG_WARN("[TUI] %zu message(s) dropped: UI queue %s lane full (capacity %zu)",
+             lost, lane_name(priority), lane->capacity);
+
+    memset(msg, 0, sizeof(*msg));
+    msg->type = TUI_MSG_ERROR;
+    msg->priority = priority;
+    msg->dropped_before = dropped_total;
+    snprintf(msg->inline_text, sizeof(msg->inline_text),
+             "%zu message(s) dropped: UI queue full", lost);
+    msg->text = msg->inline_text;
 }
 
-int poll_tui_message(TUIMessageQueue *queue, TUIMessage *msg) {
-    if (!queue || !msg) {
+int poll_tui_message_lane(TUIMessageQueue *queue, TUIMessagePriority priority, TUIMessage *msg) {
+    if (!queue || !msg || (int)priority < 0 || (int)priority >= TUI_MSG_PRIORITIES) {
         return -1;
     }
 
-    pthread_mutex_lock(&queue->mutex);
+    TUIMessageLane *lane = &queue->lanes[priority];
+    if (!lane->messages) {
+        return -1;
+    }
 
-    /* Check if queue is empty */
-    if (queue->count == 0) {
-        pthread_mutex_unlock(&queue->mutex);
+    TUIMessageSlot *slot = peek_slot(lane);
+    if (!slot) {
+        /* Drops with nothing after them are reported once the lane drains */
+        size_t dropped = atomic_load_explicit(&lane->dropped, memory_order_relaxed);
+        if (dropped > lane->dropped_reported) {
+            make_overflow_marker(lane, priority, msg, dropped);
+            return 1;
+        }
         return 0;
     }
 
-    /* Retrieve message from tail */
-    TUIMessage *src = &queue->messages[queue->tail];
-    msg->type = src->type;
-    msg->text = src->text; /* Transfer ownership to caller */
-    msg->priority = src->priority;
+    /* Announce losses in the place they happened */
+    if (slot->msg.dropped_before > lane->dropped_reported) {
+        make_overflow_marker(lane, priority, msg, slot->msg.dropped_before);
+        return 1;
+    }
 
-    src->text = NULL; /* Clear so we don't double-free */
-    queue->tail = (queue->tail + 1) % queue->capacity;
-    queue->count--;
+    *msg = slot->msg;
+    if (slot->msg.text == slot->msg.inline_text) {
+        msg->text = msg->inline_text;
+    }
+    slot->msg.text = NULL; /* Ownership of heap text moves to the caller */
 
-    pthread_mutex_unlock(&queue->mutex);
+    size_t pos = atomic_load_explicit(&lane->tail, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, pos + lane->capacity, memory_order_release);
+    atomic_store_explicit(&lane->tail, pos + 1, memory_order_release);
+    atomic_fetch_sub_explicit(&lane->count, 1, memory_order_acq_rel);
+
+    uint64_t now = queue_now_ns();
+    uint64_t latency = now > msg->posted_ns ? now - msg->posted_ns : 0;
+    lane->delivered++;
+    lane->latency_total_ns += latency;
+    if (latency > lane->latency_max_ns) {
+        lane->latency_max_ns = latency;
+    }
 
     return 1;
 }
 
+int poll_tui_message(TUIMessageQueue *queue, TUIMessage *msg) {
+    int rc = poll_tui_message_lane(queue, TUI_PRIORITY_URGENT, msg);
+    if (rc != 0) {
+        return rc;
+    }
+    return poll_tui_message_lane(queue, TUI_PRIORITY_BULK, msg);
+}
+
 int wait_tui_message(TUIMessageQueue *queue, TUIMessage *msg) {
     if (!queue || !msg) {
         return -1;
     }
 
-    pthread_mutex_lock(&queue->mutex);
+    for (;;) {
+        int rc = poll_tui_message(queue, msg);
+        if (rc != 0) {
+            return rc;
+        }
+        if (atomic_load(&queue->shutdown)) {
+            return 0;
+        }
 
-    /* Wait until message available or shutdown */
-    while (queue->count == 0 && !queue->shutdown) {
-        pthread_cond_wait(&queue->not_empty, &queue->mutex);
+        /* The timeout covers a producer caught between claim and publish */
+        struct pollfd pfd = {queue->wakeup_read_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 50) > 0) {
+            drain_wakeup(queue);
+        }
     }
+}
 
-    /* Check shutdown flag */
-    if (queue->shutdown && queue->count == 0) {
-        pthread_mutex_unlock(&queue->mutex);
-        return 0;
+void tui_message_release(TUIMessage *msg) {
+    if (!msg) {
+        return;
+    }
+    if (msg->text != msg->inline_text) {
+        free(msg->text);
     }
+    msg->text = NULL;
+}
 
-    /* Retrieve message from tail */
-    TUIMessage *src = &queue->messages[queue->tail];
-    msg->type = src->type;
-    msg->text = src->text; /* Transfer ownership to caller */
-    msg->priority = src->priority;
+static bool lane_pending(TUIMessageLane *lane) {
+    if (!lane->messages) {
+        return false;
+    }
+    return atomic_load_explicit(&lane->count, memory_order_acquire) > 0 ||
+           peek_slot(lane) != NULL ||
+           atomic_load_explicit(&lane->dropped, memory_order_relaxed) > lane->dropped_reported;
+}
 
-    src->text = NULL; /* Clear so we don't double-free */
-    queue->tail = (queue->tail + 1) % queue->capacity;
-    queue->count--;
+bool tui_msg_queue_pending(TUIMessageQueue *queue) {
+    if (!queue) {
+        return false;
+    }
+    for (int i = 0; i < TUI_MSG_PRIORITIES; i++) {
+        if (lane_pending(&queue->lanes[i])) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    pthread_mutex_unlock(&queue->mutex);
+size_t tui_msg_queue_depth(TUIMessageQueue *queue, TUIMessagePriority priority) {
+    if (!queue || (int)priority < 0 || (int)priority >= TUI_MSG_PRIORITIES) {
+        return 0;
+    }
+    long count = atomic_load_explicit(&queue->lanes[priority].count, memory_order_acquire);
+    return count > 0 ? (size_t)count : 0;
+}
 
-    return 1;
+void tui_msg_queue_get_stats(TUIMessageQueue *queue, TUIMessageQueueStats *stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+    if (!queue) {
+        return;
+    }
+    for (int i = 0; i < TUI_MSG_PRIORITIES; i++) {
+        TUIMessageLane *lane = &queue->lanes[i];
+        TUIMessageLaneStats *out = &stats->lanes[i];
+        out->capacity = lane->capacity;
+        out->posted = atomic_load_explicit(&lane->posted, memory_order_relaxed);
+        out->dropped = atomic_load_explicit(&lane->dropped, memory_order_relaxed);
+        out->waited = atomic_load_explicit(&lane->waited, memory_order_relaxed);
+        out->delivered = lane->delivered;
+        out->latency_avg_ns = lane->delivered ? lane->latency_total_ns / lane->delivered : 0;
+        out->latency_max_ns = lane->latency_max_ns;
+
+        stats->posted += out->posted;
+        stats->dropped += out->dropped;
+        stats->waited += out->waited;
+    }
+    stats->heap_text = atomic_load_explicit(&queue->heap_text, memory_order_relaxed);
 }
 
 void tui_msg_queue_shutdown(TUIMessageQueue *queue) {
@@ -197,10 +504,12 @@ void tui_msg_queue_shutdown(TUIMessageQueue *queue) {
         return;
     }
 
-    pthread_mutex_lock(&queue->mutex);
-    queue->shutdown = true;
-    pthread_cond_broadcast(&queue->not_empty);
-    pthread_mutex_unlock(&queue->mutex);
+    atomic_store(&queue->shutdown, true);
+    wakeup_signal(queue);
+}
+
+int tui_msg_queue_wakeup_fd(const TUIMessageQueue *queue) {
+    return queue ? queue->wakeup_read_fd : -1;
 }
 
 void tui_msg_queue_free(TUIMessageQueue *queue) {
@@ -208,17 +517,20 @@ void tui_msg_queue_free(TUIMessageQueue *queue) {
         return;
     }
 
-    /* Free any remaining messages */
-    if (queue->messages) {
-        for (size_t i = 0; i < queue->capacity; i++) {
-            free(queue->messages[i].text);
+    TUIMessageQueueStats stats;
+    tui_msg_queue_get_stats(queue, &stats);
+    for (int i = 0; i < TUI_MSG_PRIORITIES; i++) {
+        const TUIMessageLaneStats *lane = &stats.lanes[i];
+        if (lane->delivered > 0 || lane->dropped > 0) {
+            LOG_INFO("[TUI] Message queue %s lane: %zu posted, %zu dropped, %zu waited, "
+                     "latency avg %.2f ms max %.2f ms",
+                     lane_name(i), lane->posted, lane->dropped, lane->waited,
+                     (double)lane->latency_avg_ns / 1e6, (double)lane->latency_max_ns / 1e6);
         }
-        free(queue->messages);
-        queue->messages = NULL;
+        lane_free(&queue->lanes[i]);
     }
 
-    pthread_mutex_destroy(&queue->mutex);
-    pthread_cond_destroy(&queue->not_empty);
+    wakeup_close(queue);
 }
 
 /* ========================================================================
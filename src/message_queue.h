@@ -10,7 +10,10 @@
 #define MESSAGE_QUEUE_H
 
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /* ========================================================================
  * TUI Message Queue (Worker -> Main Thread)
@@ -28,88 +31,244 @@ typedef enum {
     TUI_MSG_TOKEN_UPDATE    /* Update token usage counts */
 } TUIMessageType;
 
+/* Text shorter than this is stored inside the message (no malloc) */
+#define TUI_MSG_INLINE_TEXT 128
+
+/* How long a producer waits for space in a full lane before dropping */
+#define TUI_MSG_POST_TIMEOUT_MS 50
+
+/* Slots in the urgent lane (the bulk lane size is given to init) */
+#define TUI_MSG_URGENT_CAPACITY 64
+
+/**
+ * Priority lanes. Each lane is its own ring with its own capacity, and the
+ * consumer always empties the urgent lane first, so status, errors and token
+ * counts are never stuck behind (or dropped because of) bulk output.
+ * Messages keep their order within a lane only.
+ */
+typedef enum {
+    TUI_PRIORITY_BULK = 0,  /* Conversation lines, clear, TODO updates */
+    TUI_PRIORITY_URGENT = 1 /* Status, errors, token usage */
+} TUIMessagePriority;
+
+#define TUI_MSG_PRIORITIES 2
+
 /**
  * Message structure for TUI updates
  * Main thread reads these and updates ncurses display
  */
 typedef struct {
     TUIMessageType type;
-    char *text;             /* Owned by queue, freed after processing */
-    int priority;           /* Higher = more urgent (reserved for future) */
+    char *text;             /* Points at inline_text or the heap; release with
+                             * tui_message_release() after processing */
+    int priority;           /* TUIMessagePriority lane it travelled in */
 
     /* Token usage fields (for TUI_MSG_TOKEN_UPDATE) */
     int prompt_tokens;
     int completion_tokens;
     int cached_tokens;
+
+    uint64_t posted_ns;     /* CLOCK_MONOTONIC time of the post */
+    size_t dropped_before;  /* Lane drop count when this was posted */
+    char inline_text[TUI_MSG_INLINE_TEXT];
 } TUIMessage;
 
 /**
- * Thread-safe circular buffer for TUI messages
- * Overflow policy: Drop oldest messages (FIFO eviction)
+ * Preallocated ring slot. The sequence number tells producers and the
+ * consumer whose turn the slot is (bounded MPMC ring, one consumer here).
  */
 typedef struct {
-    TUIMessage *messages;   /* Circular buffer */
-    size_t capacity;        /* Max messages before dropping oldest */
-    size_t head;            /* Next write position */
-    size_t tail;            /* Next read position */
-    size_t count;           /* Current number of messages */
+    _Atomic size_t sequence;
+    TUIMessage msg;
+} TUIMessageSlot;
 
-    pthread_mutex_t mutex;
-    pthread_cond_t not_empty; /* Signals when messages available */
+/**
+ * One lock-free multi-producer, single-consumer ring
+ */
+typedef struct {
+    TUIMessageSlot *messages; /* Preallocated ring of capacity slots */
+    size_t capacity;
+    _Atomic size_t head;    /* Next position producers claim */
+    _Atomic size_t tail;    /* Next position the consumer reads */
+    _Atomic long count;     /* Published minus consumed (may dip below 0 briefly) */
+    _Atomic size_t stalled_tail; /* tail when a post last timed out, +1 (0 = none) */
+
+    _Atomic size_t posted;
+    _Atomic size_t dropped;
+    _Atomic size_t waited;
+
+    /* Consumer only */
+    size_t dropped_reported; /* Drops already announced */
+    size_t delivered;
+    uint64_t latency_total_ns; /* Post-to-poll time of delivered messages */
+    uint64_t latency_max_ns;
+} TUIMessageLane;
 
-    bool shutdown;          /* Set to true to wake up blocked readers */
+/**
+ * Counters for one lane (see tui_msg_queue_get_stats)
+ */
+typedef struct {
+    size_t capacity;
+    size_t posted;          /* Messages accepted */
+    size_t dropped;         /* Messages lost because the lane stayed full */
+    size_t waited;          /* Posts that had to wait for space */
+    size_t delivered;       /* Messages returned by poll */
+    uint64_t latency_avg_ns; /* Mean post-to-poll latency */
+    uint64_t latency_max_ns;
+} TUIMessageLaneStats;
+
+/**
+ * Counters for TUIMessageQueue
+ */
+typedef struct {
+    TUIMessageLaneStats lanes[TUI_MSG_PRIORITIES];
+    size_t posted;          /* Totals over all lanes */
+    size_t dropped;
+    size_t waited;
+    size_t heap_text;       /* Posts whose text was too long to store inline */
+} TUIMessageQueueStats;
+
+/**
+ * Lock-free multi-producer, single-consumer queue for TUI messages
+ *
+ * Any thread may post; only the main thread polls. Posting never takes a
+ * lock. When a lane is full a producer waits up to post_timeout_ms for the
+ * main thread to make room (backpressure). If it is still full the message
+ * is dropped and counted, and the consumer receives an explicit
+ * TUI_MSG_ERROR marker in that lane saying how many messages were lost. A
+ * producer does not wait again until the consumer has made progress, so a
+ * stalled main thread (e.g. during shutdown) cannot hold up the workers.
+ */
+typedef struct {
+    TUIMessageLane lanes[TUI_MSG_PRIORITIES];
+
+    _Atomic bool shutdown;  /* Set to true to wake up blocked readers */
+    int post_timeout_ms;    /* Backpressure limit, TUI_MSG_POST_TIMEOUT_MS by default */
+    _Atomic size_t heap_text;
+
+    /* Becomes readable when a lane goes from empty to non-empty, so the
+     * main loop can poll() on it (eventfd on Linux, pipe elsewhere) */
+    int wakeup_read_fd;
+    int wakeup_write_fd;
 } TUIMessageQueue;
 
 /**
  * Initialize TUI message queue
  *
  * @param queue Queue to initialize
- * @param capacity Maximum number of messages before overflow
+ * @param capacity Number of preallocated slots in the bulk lane (the urgent
+ *                 lane has TUI_MSG_URGENT_CAPACITY)
  * @return 0 on success, -1 on error
  */
 int tui_msg_queue_init(TUIMessageQueue *queue, size_t capacity);
 
+/**
+ * Lane a message type travels in
+ */
+TUIMessagePriority tui_message_priority(TUIMessageType type);
+
 /**
  * Post a message to the TUI queue
- * Non-blocking. If queue is full, drops oldest message.
+ * Lock-free. If its lane is full, waits up to queue->post_timeout_ms for
+ * space, then drops the message (counted and reported to the consumer).
  *
  * @param queue Queue to post to
  * @param type Message type
  * @param text Message text (will be copied, caller retains ownership)
- * @return 0 on success, -1 on error
+ * @return 0 on success, -1 on error or if the message was dropped
  */
 int post_tui_message(TUIMessageQueue *queue, TUIMessageType type, const char *text);
 
 /**
- * Post a token usage update to the TUI queue
- * Non-blocking. If queue is full, drops oldest message.
+ * Post a token usage update to the TUI queue (urgent lane)
+ * Same overflow behaviour as post_tui_message().
  *
  * @param queue Queue to post to
  * @param prompt_tokens Total input tokens
  * @param completion_tokens Total output tokens
  * @param cached_tokens Total cached tokens
- * @return 0 on success, -1 on error
+ * @return 0 on success, -1 on error or if the update was dropped
  */
 int post_token_update(TUIMessageQueue *queue, int prompt_tokens, int completion_tokens, int cached_tokens);
 
 /**
- * Poll for a message from the TUI queue (non-blocking)
+ * Poll for a message from the TUI queue (non-blocking, main thread only)
+ * The urgent lane is emptied before the bulk lane. After messages were
+ * dropped, an overflow marker (TUI_MSG_ERROR) is returned in their place.
  *
  * @param queue Queue to poll
- * @param msg Output parameter for message (caller must free msg->text)
+ * @param msg Output parameter (call tui_message_release() when done)
  * @return 1 if message retrieved, 0 if empty, -1 on error
  */
 int poll_tui_message(TUIMessageQueue *queue, TUIMessage *msg);
 
 /**
- * Wait for a message from the TUI queue (blocking)
+ * Poll one lane only (non-blocking, main thread only), so the caller can
+ * budget bulk output separately from urgent messages
+ *
+ * @param queue Queue to poll
+ * @param priority Lane to poll
+ * @param msg Output parameter (call tui_message_release() when done)
+ * @return 1 if message retrieved, 0 if the lane is empty, -1 on error
+ */
+int poll_tui_message_lane(TUIMessageQueue *queue, TUIMessagePriority priority, TUIMessage *msg);
+
+/**
+ * Wait for a message from the TUI queue (blocking, main thread only)
  *
  * @param queue Queue to wait on
- * @param msg Output parameter for message (caller must free msg->text)
+ * @param msg Output parameter (call tui_message_release() when done)
  * @return 1 if message retrieved, 0 if shutdown, -1 on error
  */
 int wait_tui_message(TUIMessageQueue *queue, TUIMessage *msg);
 
+/**
+ * Free the heap text of a polled message, if any
+ *
+ * @param msg Message returned by poll_tui_message / wait_tui_message
+ */
+void tui_message_release(TUIMessage *msg);
+
+/**
+ * Whether the consumer still has work in any lane: messages that are
+ * published (or being published) or an overflow marker not yet returned.
+ * Use this rather than an empty poll to decide whether to wait on the
+ * wakeup fd.
+ *
+ * @param queue Queue to query
+ * @return true if poll_tui_message may return more
+ */
+bool tui_msg_queue_pending(TUIMessageQueue *queue);
+
+/**
+ * Number of messages waiting in one lane
+ *
+ * @param queue Queue to query
+ * @param priority Lane to query
+ * @return Messages published and not yet polled
+ */
+size_t tui_msg_queue_depth(TUIMessageQueue *queue, TUIMessagePriority priority);
+
+/**
+ * Snapshot the queue counters (latency figures are maintained by the
+ * consumer; call from the main thread for exact values)
+ *
+ * @param queue Queue to query
+ * @param stats Output counters
+ */
+void tui_msg_queue_get_stats(TUIMessageQueue *queue, TUIMessageQueueStats *stats);
+
+/**
+ * File descriptor that becomes readable when messages arrive in an empty
+ * lane (and on shutdown). The reader must drain it before polling the
+ * queue, and keep polling until empty: it is only signalled again once the
+ * queue has been emptied.
+ *
+ * @param queue Queue to query
+ * @return File descriptor, or -1 if unavailable
+ */
+int tui_msg_queue_wakeup_fd(const TUIMessageQueue *queue);
+
 /**
  * Shutdown TUI message queue and wake blocked readers
  *
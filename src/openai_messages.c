@@ -7,6 +7,7 @@
 #include "openai_messages.h"
 #include "logger.h"
 #include "claude_internal.h"
+#include "arena.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -142,8 +143,11 @@ cJSON* build_openai_request(ConversationState *state, int enable_caching) {
         return NULL;
     }
 
-    // Ensure all tool calls have matching results before building request
+    // Ensure all tool calls have matching results before building request.
+    // Injected results join the conversation, so keep them off any active arena.
+    Arena *prev_arena = arena_cjson_push(NULL);
     ensure_tool_results(state);
+    arena_cjson_pop(prev_arena);
 
     LOG_DEBUG("Building OpenAI request (messages: %d, caching: %s)",
               state->count, enable_caching ? "enabled" : "disabled");
@@ -232,7 +236,7 @@ cJSON* build_openai_request(ConversationState *state, int enable_caching) {
                     // Convert output to string
                     char *output_str = cJSON_PrintUnformatted(c->tool_output);
                     cJSON_AddStringToObject(tool_msg, "content", output_str ? output_str : "{}");
-                    free(output_str);
+                    cJSON_free(output_str);
 
                     cJSON_AddItemToArray(messages_array, tool_msg);
                 }
@@ -271,7 +275,7 @@ cJSON* build_openai_request(ConversationState *state, int enable_caching) {
 
                     char *args_str = cJSON_PrintUnformatted(c->tool_params);
                     cJSON_AddStringToObject(func, "arguments", args_str ? args_str : "{}");
-                    free(args_str);
+                    cJSON_free(args_str);
 
                     cJSON_AddItemToObject(tc, "function", func);
                     cJSON_AddItemToArray(tool_calls, tc);
@@ -7,6 +7,8 @@
 #include "claude_internal.h"  // Must be first to get ApiResponse definition
 #include "openai_provider.h"
 #include "logger.h"
+#include "trace.h"
+#include "arena.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -138,16 +140,20 @@ static ApiCallResult openai_call_api(Provider *self, ConversationState *state) {
     }
 
     // Build request JSON using OpenAI message format
+    // The request tree is dead once serialized, so build it in the turn arena
     int enable_caching = is_prompt_caching_enabled();
+    Arena *prev_arena = arena_cjson_push(arena_turn());
     cJSON *request = build_openai_request(state, enable_caching);
     if (!request) {
+        arena_cjson_pop(prev_arena);
         result.error_message = strdup("Failed to build request JSON");
         result.is_retryable = 0;
         return result;
     }
 
-    char *openai_json = cJSON_PrintUnformatted(request);
+    char *openai_json = arena_cjson_print(request);
     cJSON_Delete(request);
+    arena_cjson_pop(prev_arena);
 
     if (!openai_json) {
         result.error_message = strdup("Failed to serialize request JSON");
@@ -247,8 +253,10 @@ static ApiCallResult openai_call_api(Provider *self, ConversationState *state) {
 
     struct timespec start, end;
     clock_gettime(CLOCK_MONOTONIC, &start);
+    int64_t perform_start_us = trace_now_us();
     CURLcode res = curl_easy_perform(curl);
     clock_gettime(CLOCK_MONOTONIC, &end);
+    trace_curl_phases(curl, "openai", perform_start_us);
 
     result.duration_ms = (end.tv_sec - start.tv_sec) * 1000 +
                          (end.tv_nsec - start.tv_nsec) / 1000000;
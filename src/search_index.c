@@ -0,0 +1,364 @@
+/**
+ * search_index.c - Incremental trigram index for searching conversation text
+ */
+
+#include "search_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+static char fold_ascii(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+// Trigrams never contain a NUL byte, so 0 is free to mark empty slots
+static uint32_t trigram_at(const char *s) {
+    return ((uint32_t)(unsigned char)s[0] << 16) |
+           ((uint32_t)(unsigned char)s[1] << 8) |
+           (uint32_t)(unsigned char)s[2];
+}
+
+static int slot_hash(uint32_t trigram, int slot_count) {
+    uint32_t h = trigram * 2654435761u;
+    h ^= h >> 15;
+    return (int)(h & (uint32_t)(slot_count - 1));
+}
+
+// Slot holding trigram, or the empty slot where it would go
+static SearchPosting *find_slot(SearchPosting *slots, int slot_count, uint32_t trigram) {
+    int i = slot_hash(trigram, slot_count);
+    while (slots[i].trigram != 0 && slots[i].trigram != trigram) {
+        i = (i + 1) & (slot_count - 1);
+    }
+    return &slots[i];
+}
+
+static const SearchPosting *lookup(const SearchIndex *index, uint32_t trigram) {
+    if (index->slot_count == 0) {
+        return NULL;
+    }
+    const SearchPosting *slot = find_slot(index->slots, index->slot_count, trigram);
+    return slot->trigram != 0 ? slot : NULL;
+}
+
+// Keep the table at most 70% full
+static int reserve_slots(SearchIndex *index, int needed) {
+    if ((int64_t)(index->slot_used + needed) * 10 <= (int64_t)index->slot_count * 7) {
+        return 0;
+    }
+    int new_count = index->slot_count > 0 ? index->slot_count : 1024;
+    while ((int64_t)(index->slot_used + needed) * 10 > (int64_t)new_count * 7) {
+        new_count *= 2;
+    }
+    SearchPosting *slots = calloc((size_t)new_count, sizeof(SearchPosting));
+    if (!slots) {
+        return -1;
+    }
+    for (int i = 0; i < index->slot_count; i++) {
+        if (index->slots[i].trigram != 0) {
+            *find_slot(slots, new_count, index->slots[i].trigram) = index->slots[i];
+        }
+    }
+    free(index->slots);
+    index->slots = slots;
+    index->slot_count = new_count;
+    return 0;
+}
+
+static int posting_append(SearchPosting *posting, int doc) {
+    if (posting->count > 0 && posting->docs[posting->count - 1] == doc) {
+        return 0;  // Trigram seen earlier in the same document
+    }
+    if (posting->count == posting->capacity) {
+        int new_capacity = posting->capacity > 0 ? posting->capacity * 2 : 4;
+        int *docs = realloc(posting->docs, (size_t)new_capacity * sizeof(int));
+        if (!docs) {
+            return -1;
+        }
+        posting->docs = docs;
+        posting->capacity = new_capacity;
+    }
+    posting->docs[posting->count++] = doc;
+    return 0;
+}
+
+void search_index_init(SearchIndex *index) {
+    if (index) {
+        memset(index, 0, sizeof(*index));
+    }
+}
+
+void search_index_reset(SearchIndex *index) {
+    if (!index) {
+        return;
+    }
+    index->doc_count = 0;
+    for (int i = 0; i < index->slot_count; i++) {
+        free(index->slots[i].docs);
+    }
+    if (index->slots) {
+        memset(index->slots, 0, (size_t)index->slot_count * sizeof(SearchPosting));
+    }
+    index->slot_used = 0;
+}
+
+void search_index_free(SearchIndex *index) {
+    if (!index) {
+        return;
+    }
+    search_index_reset(index);
+    free(index->docs);
+    free(index->slots);
+    memset(index, 0, sizeof(*index));
+}
+
+int search_index_add(SearchIndex *index, int id, const char *const *parts, int nparts) {
+    if (!index || nparts < 0 || nparts > SEARCH_INDEX_MAX_PARTS) {
+        return -1;
+    }
+
+    size_t part_len[SEARCH_INDEX_MAX_PARTS];
+    size_t len = 0;
+    for (int p = 0; p < nparts; p++) {
+        part_len[p] = parts[p] ? strlen(parts[p]) : 0;
+        len += part_len[p];
+    }
+    if (len > (size_t)INT32_MAX) {
+        return -1;
+    }
+
+    if (index->doc_count == index->doc_capacity) {
+        int new_capacity = index->doc_capacity > 0 ? index->doc_capacity * 2 : 64;
+        SearchDoc *docs = realloc(index->docs, (size_t)new_capacity * sizeof(SearchDoc));
+        if (!docs) {
+            return -1;
+        }
+        index->docs = docs;
+        index->doc_capacity = new_capacity;
+    }
+
+    // Folded copy for the trigram walk only; the index does not keep it
+    char *text = malloc(len + 1);
+    if (!text) {
+        return -1;
+    }
+    size_t pos = 0;
+    for (int p = 0; p < nparts; p++) {
+        for (size_t i = 0; i < part_len[p]; i++) {
+            text[pos++] = fold_ascii(parts[p][i]);
+        }
+    }
+    text[len] = '\0';
+
+    // The table grows as new trigrams turn up, not by the document's length:
+    // a long log repeats the same few trigrams over and over. There is always
+    // room for one more before a trigram is inserted.
+    int ntrigrams = len >= 3 ? (int)len - 2 : 0;
+    if (ntrigrams > 0 && reserve_slots(index, 1) != 0) {
+        free(text);
+        return -1;
+    }
+
+    int doc = index->doc_count;
+    for (int i = 0; i < ntrigrams; i++) {
+        uint32_t trigram = trigram_at(text + i);
+        SearchPosting *slot = find_slot(index->slots, index->slot_count, trigram);
+        int added = slot->trigram == 0;
+        if (added) {
+            slot->trigram = trigram;
+            index->slot_used++;
+        }
+        // Trigrams [0, appended) have this document in their posting list
+        int appended = -1;
+        if (posting_append(slot, doc) != 0) {
+            appended = i;
+        } else if (added && reserve_slots(index, 1) != 0) {
+            appended = i + 1;
+        }
+        if (appended >= 0) {
+            // Undo this document's postings so no list points past doc_count
+            for (int k = 0; k < appended; k++) {
+                SearchPosting *s = find_slot(index->slots, index->slot_count, trigram_at(text + k));
+                if (s->count > 0 && s->docs[s->count - 1] == doc) {
+                    s->count--;
+                }
+            }
+            free(text);
+            return -1;
+        }
+    }
+
+    index->docs[doc].id = id;
+    index->docs[doc].len = (int)len;
+    index->doc_count++;
+    free(text);
+    return 0;
+}
+
+static int posting_contains(const SearchPosting *posting, int doc) {
+    int lo = 0;
+    int hi = posting->count - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (posting->docs[mid] == doc) {
+            return 1;
+        }
+        if (posting->docs[mid] < doc) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return 0;
+}
+
+static int add_match(SearchMatches *out, int id, int offset, int len) {
+    if (out->count == out->capacity) {
+        int new_capacity = out->capacity > 0 ? out->capacity * 2 : 64;
+        SearchMatch *items = realloc(out->items, (size_t)new_capacity * sizeof(SearchMatch));
+        if (!items) {
+            return -1;
+        }
+        out->items = items;
+        out->capacity = new_capacity;
+    }
+    SearchMatch *m = &out->items[out->count++];
+    m->id = id;
+    m->offset = offset;
+    m->len = len;
+    return 0;
+}
+
+// Folded text of one document, fetched from the caller
+typedef struct {
+    SearchTextFn get_text;
+    void *ctx;
+    char *buf;
+    size_t capacity;
+} DocText;
+
+static const char *load_doc(DocText *text, const SearchDoc *doc) {
+    const char *parts[SEARCH_INDEX_MAX_PARTS];
+    int nparts = text->get_text(text->ctx, doc->id, parts);
+    if (nparts < 0 || nparts > SEARCH_INDEX_MAX_PARTS) {
+        nparts = 0;
+    }
+    size_t needed = (size_t)doc->len + 1;
+    if (needed > text->capacity) {
+        size_t new_capacity = text->capacity > 0 ? text->capacity : 4096;
+        while (new_capacity < needed) {
+            new_capacity *= 2;
+        }
+        char *buf = realloc(text->buf, new_capacity);
+        if (!buf) {
+            return NULL;
+        }
+        text->buf = buf;
+        text->capacity = new_capacity;
+    }
+    // Copy no more than was indexed, in case the caller's text changed
+    size_t pos = 0;
+    for (int p = 0; p < nparts && pos < (size_t)doc->len; p++) {
+        for (const char *c = parts[p]; c && *c && pos < (size_t)doc->len; c++) {
+            text->buf[pos++] = fold_ascii(*c);
+        }
+    }
+    text->buf[pos] = '\0';
+    return text->buf;
+}
+
+// Record every non-overlapping occurrence of needle in one document
+static int scan_doc(DocText *text, const SearchDoc *doc, const char *needle, int needle_len,
+                    SearchMatches *out) {
+    const char *start = load_doc(text, doc);
+    if (!start) {
+        return -1;
+    }
+    const char *p = start;
+    while ((p = strstr(p, needle)) != NULL) {
+        if (add_match(out, doc->id, (int)(p - start), needle_len) != 0) {
+            return -1;
+        }
+        p += needle_len;
+    }
+    return 0;
+}
+
+int search_index_find(const SearchIndex *index, const char *query,
+                      SearchTextFn get_text, void *ctx, SearchMatches *out) {
+    if (!out) {
+        return -1;
+    }
+    out->count = 0;
+    if (!index || !query || query[0] == '\0' || !get_text) {
+        return 0;
+    }
+
+    int qlen = (int)strlen(query);
+    char *needle = malloc((size_t)qlen + 1);
+    if (!needle) {
+        return -1;
+    }
+    for (int i = 0; i <= qlen; i++) {
+        needle[i] = fold_ascii(query[i]);
+    }
+
+    DocText text = {get_text, ctx, NULL, 0};
+    int rc = 0;
+    if (qlen < 3) {
+        for (int d = 0; d < index->doc_count && rc == 0; d++) {
+            if (index->docs[d].len >= qlen) {
+                rc = scan_doc(&text, &index->docs[d], needle, qlen, out);
+            }
+        }
+        free(text.buf);
+        free(needle);
+        return rc == 0 ? out->count : -1;
+    }
+
+    // Posting lists of the query's trigrams; any missing trigram means no match
+    int nlists = qlen - 2;
+    const SearchPosting **lists = malloc((size_t)nlists * sizeof(*lists));
+    if (!lists) {
+        free(needle);
+        return -1;
+    }
+    int shortest = 0;
+    for (int i = 0; i < nlists; i++) {
+        lists[i] = lookup(index, trigram_at(needle + i));
+        if (!lists[i]) {
+            free(lists);
+            free(needle);
+            return 0;
+        }
+        if (lists[i]->count < lists[shortest]->count) {
+            shortest = i;
+        }
+    }
+
+    const SearchPosting *base = lists[shortest];
+    for (int k = 0; k < base->count && rc == 0; k++) {
+        int doc = base->docs[k];
+        int candidate = 1;
+        for (int i = 0; i < nlists && candidate; i++) {
+            if (i != shortest && lists[i] != base) {
+                candidate = posting_contains(lists[i], doc);
+            }
+        }
+        if (candidate) {
+            rc = scan_doc(&text, &index->docs[doc], needle, qlen, out);
+        }
+    }
+
+    free(text.buf);
+    free(lists);
+    free(needle);
+    return rc == 0 ? out->count : -1;
+}
+
+void search_matches_free(SearchMatches *matches) {
+    if (!matches) {
+        return;
+    }
+    free(matches->items);
+    memset(matches, 0, sizeof(*matches));
+}
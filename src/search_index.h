@@ -0,0 +1,95 @@
+/**
+ * search_index.h - Incremental trigram index for searching conversation text
+ *
+ * Every distinct three-byte sequence (trigram) of a document's
+ * ASCII-lowercased text gets the document appended to that trigram's
+ * posting list. Documents are only ever appended, so adding one costs
+ * O(length) and never touches the others. The index keeps no copy of the
+ * text: the caller supplies it again when candidates are verified, so text
+ * the caller has moved out of memory stays out until a search needs it.
+ *
+ * A query of three or more bytes intersects the posting lists of its
+ * trigrams, starting from the shortest, and only the surviving documents are
+ * scanned for the exact match. Shorter queries fall back to scanning every
+ * document. Matching is case-insensitive for ASCII; other bytes compare as
+ * is, so match offsets are byte offsets into the original text.
+ */
+
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <stdint.h>
+
+#define SEARCH_INDEX_MAX_PARTS 4
+
+typedef struct {
+    int id;                         // Caller's id for the document
+    int len;                        // Bytes in all parts together
+} SearchDoc;
+
+typedef struct {
+    uint32_t trigram;               // 0 = empty slot
+    int *docs;                      // Positions in SearchIndex.docs, ascending
+    int count;
+    int capacity;
+} SearchPosting;
+
+typedef struct {
+    SearchDoc *docs;
+    int doc_count;
+    int doc_capacity;
+
+    SearchPosting *slots;           // Open-addressed by trigram
+    int slot_count;                 // Power of two (0 before the first add)
+    int slot_used;
+} SearchIndex;
+
+typedef struct {
+    int id;                         // Document id as passed to search_index_add()
+    int offset;                     // Byte offset of the match in the document
+    int len;
+} SearchMatch;
+
+typedef struct {
+    SearchMatch *items;             // Ordered by document, then offset
+    int count;
+    int capacity;
+} SearchMatches;
+
+/**
+ * Supplies the parts of document id, as they were when it was added.
+ * Fills parts[] (up to SEARCH_INDEX_MAX_PARTS) and returns how many.
+ */
+typedef int (*SearchTextFn)(void *ctx, int id, const char **parts);
+
+void search_index_init(SearchIndex *index);
+
+/**
+ * Free memory held by the index (the struct itself is not freed)
+ */
+void search_index_free(SearchIndex *index);
+
+/**
+ * Drop every document
+ */
+void search_index_reset(SearchIndex *index);
+
+/**
+ * Add a document made of up to SEARCH_INDEX_MAX_PARTS strings laid end to
+ * end (NULL parts are skipped). Ids must be added in ascending order.
+ * Returns 0 on success, -1 on allocation failure (the document is then
+ * not searchable, the rest of the index is unaffected)
+ */
+int search_index_add(SearchIndex *index, int id, const char *const *parts, int nparts);
+
+/**
+ * Find every non-overlapping occurrence of query, replacing the contents of
+ * out. get_text is asked for the text of each candidate document.
+ * Returns the number of matches, or -1 on allocation failure.
+ */
+int search_index_find(const SearchIndex *index, const char *query,
+                      SearchTextFn get_text, void *ctx, SearchMatches *out);
+
+void search_matches_free(SearchMatches *matches);
+
+#endif // SEARCH_INDEX_H
@@ -0,0 +1,154 @@
+/**
+ * spill_file.c - Append-only, memory-mapped store for cold conversation text
+ */
+
+#include "spill_file.h"
+#include "logger.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+void spill_file_init(SpillFile *spill) {
+    if (!spill) {
+        return;
+    }
+    spill->fd = -1;
+    spill->map = NULL;
+    spill->map_size = 0;
+    spill->size = 0;
+    spill->map_min = SPILL_FILE_MAP_MIN;
+}
+
+int spill_file_open(SpillFile *spill, const char *dir) {
+    if (!spill) {
+        return -1;
+    }
+    if (spill->fd >= 0) {
+        return 0;
+    }
+    if (!dir || dir[0] == '\0') {
+        dir = getenv("TMPDIR");
+    }
+    if (!dir || dir[0] == '\0') {
+        dir = "/tmp";
+    }
+
+    char path[4096];
+    int n = snprintf(path, sizeof(path), "%s/claude-c-spill-XXXXXX", dir);
+    if (n < 0 || (size_t)n >= sizeof(path)) {
+        LOG_ERROR("[Spill] Temporary directory path too long: %s", dir);
+        return -1;
+    }
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        LOG_ERROR("[Spill] Failed to create spill file in %s: %s", dir, strerror(errno));
+        return -1;
+    }
+    unlink(path);
+
+    spill->fd = fd;
+    spill->size = 0;
+    LOG_DEBUG("[Spill] Opened spill file in %s", dir);
+    return 0;
+}
+
+static int write_all(int fd, const char *data, size_t len, off_t offset) {
+    while (len > 0) {
+        ssize_t written = pwrite(fd, data, len, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += written;
+        len -= (size_t)written;
+        offset += (off_t)written;
+    }
+    return 0;
+}
+
+// Map at least `needed` bytes of the file
+static int ensure_mapped(SpillFile *spill, size_t needed) {
+    if (needed <= spill->map_size) {
+        return 0;
+    }
+    size_t map_size = spill->map_size > 0 ? spill->map_size : spill->map_min;
+    if (map_size == 0) {
+        map_size = SPILL_FILE_MAP_MIN;
+    }
+    while (map_size < needed) {
+        map_size *= 2;
+    }
+    void *map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, spill->fd, 0);
+    if (map == MAP_FAILED) {
+        LOG_ERROR("[Spill] Failed to map %zu bytes of spill file: %s", map_size, strerror(errno));
+        return -1;
+    }
+    if (spill->map) {
+        munmap(spill->map, spill->map_size);
+    }
+    spill->map = map;
+    spill->map_size = map_size;
+    return 0;
+}
+
+int spill_file_append(SpillFile *spill, const char *data, size_t len, size_t *offset) {
+    if (!spill || spill->fd < 0 || !data || !offset) {
+        return -1;
+    }
+    size_t start = spill->size;
+    if (write_all(spill->fd, data, len, (off_t)start) != 0 ||
+        write_all(spill->fd, "", 1, (off_t)(start + len)) != 0) {
+        LOG_ERROR("[Spill] Failed to write %zu bytes to spill file: %s", len, strerror(errno));
+        return -1;
+    }
+    if (ensure_mapped(spill, start + len + 1) != 0) {
+        return -1;  // The bytes stay in the file but are never referenced
+    }
+    spill->size = start + len + 1;
+    *offset = start;
+    return 0;
+}
+
+const char *spill_file_get(const SpillFile *spill, size_t offset) {
+    if (!spill || !spill->map || offset >= spill->size) {
+        return "";
+    }
+    return spill->map + offset;
+}
+
+void spill_file_release(SpillFile *spill) {
+    if (spill && spill->map) {
+        madvise(spill->map, spill->map_size, MADV_DONTNEED);
+    }
+}
+
+int spill_file_reset(SpillFile *spill) {
+    if (!spill || spill->fd < 0) {
+        return 0;
+    }
+    spill_file_release(spill);
+    if (ftruncate(spill->fd, 0) != 0) {
+        LOG_ERROR("[Spill] Failed to truncate spill file: %s", strerror(errno));
+        return -1;
+    }
+    spill->size = 0;
+    return 0;
+}
+
+void spill_file_close(SpillFile *spill) {
+    if (!spill) {
+        return;
+    }
+    if (spill->map) {
+        munmap(spill->map, spill->map_size);
+    }
+    if (spill->fd >= 0) {
+        close(spill->fd);
+    }
+    spill_file_init(spill);
+}
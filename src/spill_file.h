@@ -0,0 +1,62 @@
+/**
+ * spill_file.h - Append-only, memory-mapped store for cold conversation text
+ *
+ * Text moved out of the heap is appended to an unlinked temporary file and
+ * read back through a shared read-only mapping of it. Pages of the mapping
+ * are clean and file-backed, so the kernel faults them in when spilled text
+ * is drawn and can drop them again under memory pressure; the process only
+ * keeps offsets.
+ *
+ * The mapping is replaced when the file outgrows it, so pointers returned by
+ * spill_file_get() are valid only until the next append.
+ */
+
+#ifndef SPILL_FILE_H
+#define SPILL_FILE_H
+
+#include <stddef.h>
+
+#define SPILL_FILE_MAP_MIN (64u * 1024u * 1024u)  // Smallest mapping (address space only)
+
+typedef struct {
+    int fd;                         // -1 when not open
+    char *map;                      // Read-only view of the file (NULL = none yet)
+    size_t map_size;                // Mapped length, may run past the end of the file
+    size_t size;                    // Bytes appended so far
+    size_t map_min;                 // First mapping size (SPILL_FILE_MAP_MIN)
+} SpillFile;
+
+void spill_file_init(SpillFile *spill);
+
+/**
+ * Create the backing file in dir (NULL = $TMPDIR or /tmp). The file is
+ * unlinked right away so it disappears with the process.
+ * Returns 0 on success, -1 on failure
+ */
+int spill_file_open(SpillFile *spill, const char *dir);
+
+/**
+ * Append len bytes plus a terminating NUL; *offset receives where they start.
+ * Returns 0 on success, -1 on I/O or mapping failure (nothing is stored)
+ */
+int spill_file_append(SpillFile *spill, const char *data, size_t len, size_t *offset);
+
+/**
+ * NUL-terminated text stored at offset by spill_file_append()
+ */
+const char *spill_file_get(const SpillFile *spill, size_t offset);
+
+/**
+ * Drop the pages read so far from this process's resident set. The text
+ * stays in the file and is faulted back in on the next read.
+ */
+void spill_file_release(SpillFile *spill);
+
+/**
+ * Discard everything appended (the file stays open)
+ */
+int spill_file_reset(SpillFile *spill);
+
+void spill_file_close(SpillFile *spill);
+
+#endif // SPILL_FILE_H
@@ -0,0 +1,162 @@
+/**
+ * tool_registry.c - Name-indexed table of the tools offered to the model
+ */
+
+#include "tool_registry.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TOOL_REGISTRY_MIN_SLOTS 64
+
+// FNV-1a
+static uint32_t name_hash(const char *name) {
+    uint32_t h = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h ^= *p;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Slot holding name, or the empty slot where it would go
+static int find_slot(const ToolRegistry *registry, const char *name) {
+    int mask = registry->slot_count - 1;
+    int i = (int)(name_hash(name) & (uint32_t)mask);
+    while (registry->slots[i] != 0 &&
+           strcmp(registry->entries[registry->slots[i] - 1].name, name) != 0) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+// Hash entries [0, count) into a table of slot_count slots
+static int rebuild_slots(ToolRegistry *registry, int slot_count) {
+    int *slots = calloc((size_t)slot_count, sizeof(int));
+    if (!slots) {
+        return -1;
+    }
+    free(registry->slots);
+    registry->slots = slots;
+    registry->slot_count = slot_count;
+    for (int i = 0; i < registry->count; i++) {
+        slots[find_slot(registry, registry->entries[i].name)] = i + 1;
+    }
+    return 0;
+}
+
+static void entry_free(ToolEntry *entry) {
+    free(entry->name);
+    free(entry->mcp_name);
+    cJSON_Delete(entry->definition);
+    memset(entry, 0, sizeof(*entry));
+}
+
+void tool_registry_init(ToolRegistry *registry) {
+    if (registry) {
+        memset(registry, 0, sizeof(*registry));
+    }
+}
+
+void tool_registry_free(ToolRegistry *registry) {
+    if (!registry) {
+        return;
+    }
+    for (int i = 0; i < registry->count; i++) {
+        entry_free(&registry->entries[i]);
+    }
+    free(registry->entries);
+    free(registry->slots);
+    tool_registry_init(registry);
+}
+
+// Append an entry (name and definition already filled in) and index it
+static int add_entry(ToolRegistry *registry, ToolEntry *entry) {
+    if (!entry->name || tool_registry_find(registry, entry->name)) {
+        entry_free(entry);
+        return -1;
+    }
+    if (registry->count == registry->capacity) {
+        int capacity = registry->capacity > 0 ? registry->capacity * 2 : 16;
+        ToolEntry *entries = realloc(registry->entries, (size_t)capacity * sizeof(ToolEntry));
+        if (!entries) {
+            entry_free(entry);
+            return -1;
+        }
+        registry->entries = entries;
+        registry->capacity = capacity;
+    }
+    if ((registry->count + 1) * 2 >= registry->slot_count) {
+        int slot_count = registry->slot_count > 0 ? registry->slot_count * 2 : TOOL_REGISTRY_MIN_SLOTS;
+        if (rebuild_slots(registry, slot_count) != 0) {
+            entry_free(entry);
+            return -1;
+        }
+    }
+    registry->entries[registry->count] = *entry;
+    registry->slots[find_slot(registry, entry->name)] = registry->count + 1;
+    registry->count++;
+    return 0;
+}
+
+int tool_registry_add_builtin(ToolRegistry *registry, const char *name, ToolHandler handler,
+                              int needs_mcp, cJSON *definition) {
+    if (!registry || !name || !handler || registry->count > registry->builtin_count) {
+        cJSON_Delete(definition);
+        return -1;
+    }
+    ToolEntry entry = {0};
+    entry.name = strdup(name);
+    entry.kind = TOOL_KIND_BUILTIN;
+    entry.handler = handler;
+    entry.needs_mcp = needs_mcp;
+    entry.definition = definition;
+    if (add_entry(registry, &entry) != 0) {
+        return -1;
+    }
+    registry->builtin_count++;
+    return 0;
+}
+
+int tool_registry_add_mcp(ToolRegistry *registry, const char *name, struct MCPServer *server,
+                          const char *mcp_name, cJSON *definition) {
+    if (!registry || !name || !server || !mcp_name) {
+        cJSON_Delete(definition);
+        return -1;
+    }
+    ToolEntry entry = {0};
+    entry.name = strdup(name);
+    entry.kind = TOOL_KIND_MCP;
+    entry.server = server;
+    entry.mcp_name = strdup(mcp_name);
+    entry.definition = definition;
+    if (!entry.mcp_name) {
+        entry_free(&entry);
+        return -1;
+    }
+    return add_entry(registry, &entry);
+}
+
+void tool_registry_clear_mcp(ToolRegistry *registry) {
+    if (!registry || registry->count == registry->builtin_count) {
+        return;
+    }
+    for (int i = registry->builtin_count; i < registry->count; i++) {
+        entry_free(&registry->entries[i]);
+    }
+    registry->count = registry->builtin_count;
+
+    // Clear the table in place; it is already large enough
+    memset(registry->slots, 0, (size_t)registry->slot_count * sizeof(int));
+    for (int i = 0; i < registry->count; i++) {
+        registry->slots[find_slot(registry, registry->entries[i].name)] = i + 1;
+    }
+}
+
+const ToolEntry* tool_registry_find(const ToolRegistry *registry, const char *name) {
+    if (!registry || !name || registry->slot_count == 0) {
+        return NULL;
+    }
+    int slot = registry->slots[find_slot(registry, name)];
+    return slot > 0 ? &registry->entries[slot - 1] : NULL;
+}
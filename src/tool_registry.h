@@ -0,0 +1,83 @@
+/**
+ * tool_registry.h - Name-indexed table of the tools offered to the model
+ *
+ * Built-in tools and the tools of MCP servers share one table keyed by the
+ * name the model calls them by (e.g. "Bash" or "mcp_github_search_repos").
+ * Each entry carries what a call needs: the handler of a built-in tool, or
+ * the MCP server and the server's own name for the tool. Entries keep the
+ * order they were added in, which is the order their definitions are
+ * offered in, and an open-addressed hash of the names resolves a tool call
+ * in O(1).
+ *
+ * Built-in entries live as long as the registry; MCP entries are dropped
+ * and added again as a group whenever the servers' tool lists change. The
+ * registry does no locking of its own.
+ */
+
+#ifndef TOOL_REGISTRY_H
+#define TOOL_REGISTRY_H
+
+#include <stddef.h>
+#include <cjson/cJSON.h>
+
+struct ConversationState;
+struct MCPServer;
+
+typedef cJSON* (*ToolHandler)(cJSON *params, struct ConversationState *state);
+
+typedef enum {
+    TOOL_KIND_BUILTIN,              // Runs handler
+    TOOL_KIND_MCP                   // Calls mcp_name on server
+} ToolKind;
+
+typedef struct {
+    char *name;                     // Name offered to the model
+    ToolKind kind;
+    ToolHandler handler;            // TOOL_KIND_BUILTIN
+    int needs_mcp;                  // Built-in offered only when MCP servers are configured
+    struct MCPServer *server;       // TOOL_KIND_MCP
+    char *mcp_name;                 // TOOL_KIND_MCP: the server's name for the tool
+    cJSON *definition;              // Definition offered to the model (NULL = not offered)
+} ToolEntry;
+
+typedef struct {
+    ToolEntry *entries;             // Built-in entries first, then MCP entries
+    int count;
+    int capacity;
+    int builtin_count;
+    int *slots;                     // Entry index + 1 by name hash, 0 = empty
+    int slot_count;                 // Power of two, more than twice count
+} ToolRegistry;
+
+void tool_registry_init(ToolRegistry *registry);
+
+void tool_registry_free(ToolRegistry *registry);
+
+/**
+ * Add a built-in tool. Built-in tools are added before any MCP tool.
+ * definition is owned by the registry from here on, even on failure.
+ * Returns 0 on success, -1 if the name is taken or memory runs out
+ */
+int tool_registry_add_builtin(ToolRegistry *registry, const char *name, ToolHandler handler,
+                              int needs_mcp, cJSON *definition);
+
+/**
+ * Add the tool mcp_name of an MCP server under name. definition is owned
+ * by the registry from here on, even on failure.
+ * Returns 0 on success, -1 if the name is taken or memory runs out
+ */
+int tool_registry_add_mcp(ToolRegistry *registry, const char *name, struct MCPServer *server,
+                          const char *mcp_name, cJSON *definition);
+
+/**
+ * Drop every MCP tool, keeping the built-in ones
+ */
+void tool_registry_clear_mcp(ToolRegistry *registry);
+
+/**
+ * Entry added under name, NULL if there is none. The pointer is valid
+ * until the registry next changes.
+ */
+const ToolEntry* tool_registry_find(const ToolRegistry *registry, const char *name);
+
+#endif // TOOL_REGISTRY_H
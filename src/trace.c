@@ -0,0 +1,235 @@
+/**
+ * trace.c - Chrome trace-event JSON writer
+ *
+ * Events are appended to the file as they complete, one per line, so a
+ * trace from a crashed session is still loadable (the viewers accept a
+ * missing closing bracket).
+ */
+
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define TRACE_ARGS_MAX 512
+#define TRACE_NAME_MAX 256
+
+static FILE *g_trace_file = NULL;
+static pthread_mutex_t g_trace_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile int g_trace_enabled = 0;
+static int g_trace_first_event = 1;
+static struct timespec g_trace_epoch;
+static int g_trace_pid = 0;
+
+// Small sequential thread ids keep the viewer's track list readable
+static int g_trace_next_tid = 1;
+static _Thread_local int t_trace_tid = 0;
+
+static int trace_thread_id(void) {
+    if (t_trace_tid == 0) {
+        pthread_mutex_lock(&g_trace_mutex);
+        t_trace_tid = g_trace_next_tid++;
+        pthread_mutex_unlock(&g_trace_mutex);
+    }
+    return t_trace_tid;
+}
+
+/**
+ * Copy name into buf with JSON string escaping (quotes, backslashes and
+ * control characters). Truncates rather than failing.
+ */
+static void json_escape(const char *src, char *buf, size_t buf_size) {
+    size_t out = 0;
+    for (const char *p = src ? src : ""; *p && out + 7 < buf_size; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\') {
+            buf[out++] = '\\';
+            buf[out++] = (char)c;
+        } else if (c < 0x20) {
+            out += (size_t)snprintf(buf + out, buf_size - out, "\\u%04x", c);
+        } else {
+            buf[out++] = (char)c;
+        }
+    }
+    buf[out] = '\0';
+}
+
+int trace_init(const char *path) {
+    if (!path || path[0] == '\0') {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_trace_mutex);
+    if (g_trace_file) {
+        pthread_mutex_unlock(&g_trace_mutex);
+        return 0;
+    }
+
+    g_trace_file = fopen(path, "w");
+    if (!g_trace_file) {
+        pthread_mutex_unlock(&g_trace_mutex);
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &g_trace_epoch);
+    g_trace_pid = (int)getpid();
+    g_trace_first_event = 1;
+    fputs("[\n", g_trace_file);
+    fprintf(g_trace_file,
+            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":0,"
+            "\"args\":{\"name\":\"claude-c\"}}",
+            g_trace_pid);
+    g_trace_first_event = 0;
+    g_trace_enabled = 1;
+    pthread_mutex_unlock(&g_trace_mutex);
+
+    return 0;
+}
+
+int trace_init_from_env(void) {
+    const char *path = getenv("CLAUDE_C_TRACE");
+    if (!path || path[0] == '\0') {
+        return 0;
+    }
+    return trace_init(path);
+}
+
+int trace_enabled(void) {
+    return g_trace_enabled;
+}
+
+int64_t trace_now_us(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)(now.tv_sec - g_trace_epoch.tv_sec) * 1000000 +
+           (int64_t)(now.tv_nsec - g_trace_epoch.tv_nsec) / 1000;
+}
+
+static void trace_write_event(const char *name, const char *cat,
+                              int64_t start_us, int64_t dur_us,
+                              const char *args_fmt, va_list ap) {
+    char escaped_name[TRACE_NAME_MAX];
+    char args[TRACE_ARGS_MAX];
+
+    json_escape(name, escaped_name, sizeof(escaped_name));
+    args[0] = '\0';
+    if (args_fmt) {
+        vsnprintf(args, sizeof(args), args_fmt, ap);
+    }
+
+    int tid = trace_thread_id();
+    if (dur_us < 0) {
+        dur_us = 0;
+    }
+
+    pthread_mutex_lock(&g_trace_mutex);
+    if (g_trace_file) {
+        fprintf(g_trace_file,
+                "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                "\"ts\":%lld,\"dur\":%lld,\"args\":{%s}}",
+                g_trace_first_event ? "" : ",\n",
+                escaped_name, cat ? cat : "default", g_trace_pid, tid,
+                (long long)start_us, (long long)dur_us, args);
+        g_trace_first_event = 0;
+    }
+    pthread_mutex_unlock(&g_trace_mutex);
+}
+
+void trace_complete(const char *name, const char *cat,
+                    int64_t start_us, int64_t dur_us,
+                    const char *args_fmt, ...) {
+    if (!g_trace_enabled) {
+        return;
+    }
+
+    va_list ap;
+    va_start(ap, args_fmt);
+    trace_write_event(name, cat, start_us, dur_us, args_fmt, ap);
+    va_end(ap);
+}
+
+void trace_span_begin(TraceSpan *span, const char *name, const char *cat) {
+    if (!span) {
+        return;
+    }
+    span->name = name;
+    span->cat = cat;
+    span->start_us = g_trace_enabled ? trace_now_us() : -1;
+}
+
+void trace_span_end(TraceSpan *span, const char *args_fmt, ...) {
+    if (!span || !g_trace_enabled || span->start_us < 0) {
+        return;
+    }
+
+    int64_t end_us = trace_now_us();
+    va_list ap;
+    va_start(ap, args_fmt);
+    trace_write_event(span->name, span->cat, span->start_us,
+                      end_us - span->start_us, args_fmt, ap);
+    va_end(ap);
+    span->start_us = -1;
+}
+
+void trace_curl_phases(CURL *curl, const char *provider, int64_t perform_start_us) {
+    if (!g_trace_enabled || !curl) {
+        return;
+    }
+
+    // Each *_TIME_T value is cumulative from the start of the transfer
+    curl_off_t namelookup = 0, connect = 0, appconnect = 0;
+    curl_off_t starttransfer = 0, total = 0;
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &namelookup);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &appconnect);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &starttransfer);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+
+    // Reused connections report 0 for the setup phases
+    curl_off_t tls_end = appconnect > 0 ? appconnect : connect;
+
+    struct {
+        const char *name;
+        curl_off_t begin;
+        curl_off_t end;
+    } phases[] = {
+        {"http.dns", 0, namelookup},
+        {"http.connect", namelookup, connect},
+        {"http.tls", connect, tls_end},
+        {"http.ttfb", tls_end, starttransfer},
+        {"http.transfer", starttransfer, total},
+    };
+
+    for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); i++) {
+        if (phases[i].end <= phases[i].begin) {
+            continue;
+        }
+        trace_complete(phases[i].name, "http",
+                       perform_start_us + (int64_t)phases[i].begin,
+                       (int64_t)(phases[i].end - phases[i].begin),
+                       "\"provider\":\"%s\"", provider ? provider : "unknown");
+    }
+}
+
+void trace_flush(void) {
+    pthread_mutex_lock(&g_trace_mutex);
+    if (g_trace_file) {
+        fflush(g_trace_file);
+    }
+    pthread_mutex_unlock(&g_trace_mutex);
+}
+
+void trace_shutdown(void) {
+    pthread_mutex_lock(&g_trace_mutex);
+    g_trace_enabled = 0;
+    if (g_trace_file) {
+        fputs("\n]\n", g_trace_file);
+        fclose(g_trace_file);
+        g_trace_file = NULL;
+    }
+    pthread_mutex_unlock(&g_trace_mutex);
+}
@@ -0,0 +1,99 @@
+/**
+ * trace.h - Opt-in Chrome trace-event export for profiling agent turns
+ *
+ * Writes "complete" (ph:"X") events in the Chrome trace-event JSON format,
+ * loadable in chrome://tracing or https://ui.perfetto.dev. Tracing is off
+ * unless CLAUDE_C_TRACE is set; when disabled every call is a cheap no-op.
+ *
+ * Usage:
+ *   trace_init_from_env();           // At startup (reads CLAUDE_C_TRACE)
+ *
+ *   TraceSpan span;
+ *   trace_span_begin(&span, "build_request", "api");
+ *   ...
+ *   trace_span_end(&span, "\"messages\":%d", count);
+ *
+ *   trace_shutdown();                // At exit (closes the JSON array)
+ *
+ * Environment Variables:
+ *   CLAUDE_C_TRACE - Path of the trace file to write (e.g., /tmp/claude.trace.json)
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <curl/curl.h>
+
+/**
+ * An in-progress span. Lives on the caller's stack; name and category
+ * must outlive the span (string literals in practice).
+ */
+typedef struct {
+    const char *name;
+    const char *cat;
+    int64_t start_us;       /* -1 when tracing was disabled at begin */
+} TraceSpan;
+
+/**
+ * Start writing trace events to the given file (truncates it)
+ * Returns 0 on success, -1 on failure
+ */
+int trace_init(const char *path);
+
+/**
+ * Initialize from CLAUDE_C_TRACE. Does nothing if the variable is unset.
+ * Returns 0 on success or when disabled, -1 if the file could not be opened
+ */
+int trace_init_from_env(void);
+
+/**
+ * Returns 1 if trace events are currently being recorded
+ */
+int trace_enabled(void);
+
+/**
+ * Microseconds since tracing was initialized (monotonic clock)
+ */
+int64_t trace_now_us(void);
+
+/**
+ * Record a complete event with an explicit start and duration.
+ * args_fmt is a printf format producing the body of a JSON object
+ * (e.g. "\"status\":%ld"), or NULL for no args.
+ */
+void trace_complete(const char *name, const char *cat,
+                    int64_t start_us, int64_t dur_us,
+                    const char *args_fmt, ...)
+    __attribute__((format(printf, 5, 6)));
+
+/**
+ * Begin a span on the calling thread
+ */
+void trace_span_begin(TraceSpan *span, const char *name, const char *cat);
+
+/**
+ * End a span and record it. args_fmt behaves as in trace_complete().
+ */
+void trace_span_end(TraceSpan *span, const char *args_fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * Record the libcurl phase breakdown (DNS, connect, TLS, time to first
+ * byte, body transfer) of a finished transfer as child spans of the
+ * request. perform_start_us is when curl_easy_perform() was called.
+ */
+void trace_curl_phases(CURL *curl, const char *provider, int64_t perform_start_us);
+
+/**
+ * Write buffered events to the trace file. Called after every API call;
+ * a file left without its closing bracket by a crash still loads.
+ */
+void trace_flush(void);
+
+/**
+ * Close the JSON array and the trace file
+ */
+void trace_shutdown(void);
+
+#endif // TRACE_H
@@ -15,7 +15,9 @@
 #include "colorscheme.h"
 #include "fallback_colors.h"
 #include "logger.h"
+#include "trace.h"
 #include "indicators.h"
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -27,8 +29,10 @@
 #include <time.h>
 #include <strings.h>
 #include "message_queue.h"
+#include "tui_events.h"
 #include "history_file.h"
 #include "array_resize.h"
+#include "gap_buffer.h"
 
 #define INITIAL_CONV_CAPACITY 1000
 #define INPUT_BUFFER_SIZE 8192
@@ -37,6 +41,10 @@
 #define CONV_WIN_PADDING 1      // Lines of padding between conv window and input window
 #define STATUS_WIN_HEIGHT 1     // Single-line status window
 #define TUI_MAX_MESSAGES_PER_FRAME 10  // Max messages processed per frame
+#define TUI_MAX_LINES_PER_FRAME 4096   // Max conversation lines drawn per frame
+#define TUI_FRAME_NS 16666667ULL        // Minimum gap between message batches (~60 FPS)
+#define TUI_RESIDENT_TEXT_DEFAULT_MB 32 // Entry text kept in memory (TUI_RESIDENT_TEXT_MB)
+#define TUI_SPILL_MIN_BYTES 4096        // Smaller entries are never spilled
 
 // Paste heuristic control: default OFF (use bracketed paste only)
 // Enable by setting env var TUI_PASTE_HEURISTIC=1
@@ -79,6 +87,7 @@ static void validate_tui_windows(TUIState *tui) {
 static void handle_resize(int sig) {
     (void)sig;
     g_resize_flag = 1;
+    tui_events_notify_resize();
 }
 #endif
 
@@ -109,7 +118,8 @@ static uint64_t status_spinner_interval_ns(void) {
     return (uint64_t)SPINNER_DELAY_MS * (uint64_t)1000000;
 }
 
-static void render_status_window(TUIState *tui) {
+// Draw the status window without refreshing it
+static void draw_status_window(TUIState *tui) {
     if (!tui || !tui->wm.status_win) {
         return;
     }
@@ -240,7 +250,13 @@ static void render_status_window(TUIState *tui) {
         }
     }
     */
+}
 
+static void render_status_window(TUIState *tui) {
+    if (!tui || !tui->wm.status_win) {
+        return;
+    }
+    draw_status_window(tui);
     wrefresh(tui->wm.status_win);
 }
 
@@ -450,7 +466,14 @@ static int add_conversation_entry(TUIState *tui, const char *prefix, const char
     ConversationEntry *entry = &tui->entries[tui->entries_count];
     entry->prefix = prefix ? strdup(prefix) : NULL;
     entry->text = text ? strdup(text) : NULL;
+    entry->text_len = entry->text ? strlen(entry->text) : 0;
+    entry->spilled = 0;
+    entry->spill_offset = 0;
     entry->color_pair = color_pair;
+    entry->line_start = 0;
+    entry->line_count = 0;
+    entry->line_stale = 0;
+    memset(&entry->wrap, 0, sizeof(entry->wrap));
 
     if ((prefix && !entry->prefix) || (text && !entry->text)) {
         free(entry->prefix);
@@ -460,6 +483,7 @@ static int add_conversation_entry(TUIState *tui, const char *prefix, const char
     }
 
     tui->entries_count++;
+    tui->resident_text_bytes += entry->text_len;
     return 0;
 }
 
@@ -470,15 +494,316 @@ static void free_conversation_entries(TUIState *tui) {
     for (int i = 0; i < tui->entries_count; i++) {
         free(tui->entries[i].prefix);
         free(tui->entries[i].text);
+        wrap_index_free(&tui->entries[i].wrap);
     }
     free(tui->entries);
     tui->entries = NULL;
     tui->entries_count = 0;
     tui->entries_capacity = 0;
+    tui->stale_entries = 0;
+    tui->resident_text_bytes = 0;
+    tui->spill_next = 0;
+    spill_file_reset(&tui->spill);
+
+    // Matches refer to entries by index
+    search_index_reset(&tui->search_index);
+    tui->search_matches.count = 0;
+    tui->search_current = -1;
+}
+
+// ============================================================================
+// Conversation layout (virtualized view)
+// ============================================================================
+//
+// Entries are laid out by wrap_index instead of letting ncurses wrap them,
+// so the number of lines an entry occupies is known without drawing it.
+// Only the lines under the viewport (plus the WindowManager's margin) are
+// ever written to the pad.
+
+static int map_conversation_color(TUIColorPair color_pair) {
+    switch (color_pair) {
+        case COLOR_PAIR_DEFAULT:
+        case COLOR_PAIR_FOREGROUND:
+            return NCURSES_PAIR_FOREGROUND;
+        case COLOR_PAIR_USER:
+            return NCURSES_PAIR_USER;
+        case COLOR_PAIR_ASSISTANT:
+            return NCURSES_PAIR_ASSISTANT;
+        case COLOR_PAIR_TOOL:
+            return NCURSES_PAIR_TOOL;
+        case COLOR_PAIR_STATUS:
+            return NCURSES_PAIR_STATUS;
+        case COLOR_PAIR_ERROR:
+            return NCURSES_PAIR_ERROR;
+        case COLOR_PAIR_PROMPT:
+            return NCURSES_PAIR_PROMPT;
+        case COLOR_PAIR_TODO_COMPLETED:
+            return NCURSES_PAIR_TODO_COMPLETED;
+        case COLOR_PAIR_TODO_IN_PROGRESS:
+            return NCURSES_PAIR_TODO_IN_PROGRESS;
+        case COLOR_PAIR_TODO_PENDING:
+            return NCURSES_PAIR_TODO_PENDING;
+        default:
+            return NCURSES_PAIR_FOREGROUND;
+    }
+}
+
+// Parts of an entry as laid out: "<prefix> <text>". Spilled text is read
+// through the spill file's mapping, so the parts are valid only until the
+// next entry is spilled.
+static void conversation_entry_text(const TUIState *tui, const ConversationEntry *entry,
+                                    WrapText *text) {
+    const char *body = entry->spilled ? spill_file_get(&tui->spill, entry->spill_offset) : entry->text;
+    text->nparts = 0;
+    if (entry->prefix && entry->prefix[0] != '\0') {
+        text->parts[text->nparts++] = entry->prefix;
+        text->parts[text->nparts++] = " ";
+    }
+    if (body && body[0] != '\0') {
+        text->parts[text->nparts++] = body;
+    }
+}
+
+static int conversation_entry_lines(const TUIState *tui, ConversationEntry *entry, int width) {
+    WrapText text;
+    conversation_entry_text(tui, entry, &text);
+    return wrap_index_rows(&entry->wrap, &text, width);
+}
+
+// Byte offset of each part within the entry as the search index sees it
+static void conversation_entry_part_starts(const WrapText *text, int *part_start) {
+    int offset = 0;
+    for (int i = 0; i < text->nparts; i++) {
+        part_start[i] = offset;
+        offset += (int)strlen(text->parts[i]);
+    }
+}
+
+// Search matches inside one entry (a slice of tui->search_matches)
+typedef struct {
+    const SearchMatch *items;
+    int count;
+    int current;                        // Index in items of the current match (-1 = none)
+} EntryMatches;
+
+static void conversation_entry_matches(const TUIState *tui, int entry_index, EntryMatches *out) {
+    const SearchMatches *all = &tui->search_matches;
+    int lo = 0;
+    int hi = all->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (all->items[mid].id < entry_index) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    int end = lo;
+    while (end < all->count && all->items[end].id == entry_index) {
+        end++;
+    }
+    out->items = all->items + lo;
+    out->count = end - lo;
+    out->current = (tui->search_current >= lo && tui->search_current < end)
+        ? tui->search_current - lo : -1;
+}
+
+typedef struct {
+    WINDOW *win;
+    int row_base;                       // Window row of entry row 0
+    attr_t part_attrs[WRAP_TEXT_MAX_PARTS];
+    int part_start[WRAP_TEXT_MAX_PARTS];
+    EntryMatches matches;
+    int next_match;                     // First match not yet passed by the glyphs drawn
+} EntryDrawContext;
+
+// Highlight for the glyph at entry offset `offset`; glyphs arrive in order
+static attr_t entry_match_attr(EntryDrawContext *draw, int offset) {
+    const EntryMatches *m = &draw->matches;
+    while (draw->next_match < m->count &&
+           m->items[draw->next_match].offset + m->items[draw->next_match].len <= offset) {
+        draw->next_match++;
+    }
+    if (draw->next_match < m->count && m->items[draw->next_match].offset <= offset) {
+        return draw->next_match == m->current ? (attr_t)(A_REVERSE | A_UNDERLINE) : (attr_t)A_REVERSE;
+    }
+    return A_NORMAL;
+}
+
+// WrapEmitFn: put one glyph of an entry into the pad
+static void draw_entry_glyph(void *ctx, int part, int offset, int row, int col,
+                             const char *bytes, int len, int cells) {
+    EntryDrawContext *draw = (EntryDrawContext *)ctx;
+    if (cells == 0 && col == 0) {
+        return;  // Combining mark with nothing to its left on this row
+    }
+    if (wmove(draw->win, draw->row_base + row, col) != OK) {
+        return;
+    }
+    attr_t attr = draw->part_attrs[part];
+    if (bytes && draw->matches.count > 0) {
+        attr |= entry_match_attr(draw, draw->part_start[part] + offset);
+    }
+    wattrset(draw->win, (int)attr);
+    if (bytes) {
+        waddnstr(draw->win, bytes, len);
+    } else {
+        for (int i = 0; i < cells; i++) {
+            waddch(draw->win, ' ');
+        }
+    }
 }
 
-// Expand pad capacity if needed
-// Pad capacity growth is centralized in WindowManager now.
+// Draw an entry's lines [first_row, first_row + max_rows) into win at win_row
+static void draw_conversation_entry(const TUIState *tui, ConversationEntry *entry,
+                                    int width, WINDOW *win, int first_row, int win_row,
+                                    int max_rows, const EntryMatches *matches) {
+    EntryDrawContext draw;
+    WrapText text;
+    int mapped_pair = map_conversation_color(entry->color_pair);
+    int use_colors = has_colors();
+
+    conversation_entry_text(tui, entry, &text);
+    draw.win = win;
+    draw.row_base = win_row - first_row;
+    conversation_entry_part_starts(&text, draw.part_start);
+    draw.matches = *matches;
+    draw.next_match = 0;
+    for (int i = 0; i < text.nparts; i++) {
+        draw.part_attrs[i] = A_NORMAL;
+    }
+    if (use_colors) {
+        int has_prefix = entry->prefix && entry->prefix[0] != '\0';
+        attr_t prefix_attr = (attr_t)(COLOR_PAIR(mapped_pair) | A_BOLD);
+        attr_t text_attr = (attr_t)COLOR_PAIR(has_prefix ? NCURSES_PAIR_FOREGROUND : mapped_pair);
+        for (int i = 0; i < text.nparts; i++) {
+            draw.part_attrs[i] = (has_prefix && i < 2) ? prefix_attr : text_attr;
+        }
+    }
+
+    wrap_index_draw(&entry->wrap, &text, width, first_row, max_rows, draw_entry_glyph, &draw);
+    wattrset(win, A_NORMAL);
+}
+
+// Index of the entry containing content line `line` (binary search)
+static int find_entry_for_line(const TUIState *tui, int line) {
+    int lo = 0;
+    int hi = tui->entries_count - 1;
+    while (lo < hi) {
+        int mid = lo + (hi - lo + 1) / 2;
+        if (tui->entries[mid].line_start <= line) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+// ConversationRenderFn: draw content lines into the WindowManager's pad
+static void render_conversation_lines(void *ctx, WINDOW *pad, int first_line,
+                                      int pad_row, int count) {
+    TUIState *tui = (TUIState *)ctx;
+    if (!tui || tui->entries_count == 0 || count <= 0) return;
+
+    int end_line = first_line + count;
+    for (int i = find_entry_for_line(tui, first_line); i < tui->entries_count; i++) {
+        ConversationEntry *entry = &tui->entries[i];
+        if (entry->line_start >= end_line) break;
+
+        int from = first_line > entry->line_start ? first_line - entry->line_start : 0;
+        int to = end_line - entry->line_start;
+        if (to > entry->line_count) to = entry->line_count;
+        EntryMatches matches;
+        conversation_entry_matches(tui, i, &matches);
+        draw_conversation_entry(tui, entry, tui->layout_width, pad, from,
+                                pad_row + (entry->line_start + from - first_line), to - from,
+                                &matches);
+    }
+}
+
+// Recompute the line index at the current screen width without wrapping
+// any text. Entries laid out at this width recently answer from their wrap
+// cache; the rest get a row count scaled from the old width and are marked
+// stale, to be wrapped when they come into view (settle_conversation).
+static int relayout_conversation(TUIState *tui) {
+    int old_width = tui->layout_width;
+    int width = tui->wm.screen_width > 0 ? tui->wm.screen_width : 1;
+    int line = 0;
+    tui->layout_width = width;
+    tui->stale_entries = 0;
+    for (int i = 0; i < tui->entries_count; i++) {
+        ConversationEntry *entry = &tui->entries[i];
+        int rows = wrap_index_cached_rows(&entry->wrap, width);
+        entry->line_start = line;
+        entry->line_stale = rows < 0;
+        if (rows < 0) {
+            long estimate = old_width > 0
+                ? ((long)entry->line_count * old_width + width - 1) / width : 1;
+            rows = estimate < 1 ? 1 : estimate > INT_MAX / 2 ? INT_MAX / 2 : (int)estimate;
+            tui->stale_entries++;
+        }
+        entry->line_count = rows;
+        line += rows;
+    }
+    return line;
+}
+
+// Wrap the stale entries from entry `first` up to content line last_line
+// and move the lines after them. The viewport keeps showing the same text:
+// the scroll offset moves with the entries above it, or stays at the bottom.
+// Returns nonzero if any line moved.
+static int settle_conversation(TUIState *tui, int first, int last_line) {
+    if (tui->stale_entries == 0 || first < 0 || first >= tui->entries_count) {
+        return 0;
+    }
+
+    int top = tui->wm.conv_scroll_offset;
+    int at_bottom = top >= window_manager_get_max_scroll(&tui->wm);
+    int shift = 0;                      // Lines gained above the viewport
+    int delta = 0;                      // Lines gained so far
+    int i = first;
+    for (; i < tui->entries_count; i++) {
+        ConversationEntry *entry = &tui->entries[i];
+        int old_start = entry->line_start;
+        entry->line_start += delta;
+        if (entry->line_start >= last_line + shift) {
+            break;
+        }
+        if (!entry->line_stale) {
+            continue;
+        }
+        int old_count = entry->line_count;
+        entry->line_count = conversation_entry_lines(tui, entry, tui->layout_width);
+        entry->line_stale = 0;
+        tui->stale_entries--;
+        if (old_start + old_count <= top) {
+            shift += entry->line_count - old_count;
+        }
+        delta += entry->line_count - old_count;
+    }
+    if (delta == 0) {
+        return 0;
+    }
+    for (; i < tui->entries_count; i++) {
+        tui->entries[i].line_start += delta;
+    }
+
+    ConversationEntry *last = &tui->entries[tui->entries_count - 1];
+    window_manager_invalidate_conversation(&tui->wm);
+    window_manager_set_content_lines(&tui->wm, last->line_start + last->line_count);
+    tui->wm.conv_scroll_offset = at_bottom ? window_manager_get_max_scroll(&tui->wm) : top + shift;
+    return 1;
+}
+
+// ConversationLayoutFn: wrap the stale entries the pad is about to show
+static int settle_conversation_lines(void *ctx, int first_line, int last_line) {
+    TUIState *tui = (TUIState *)ctx;
+    if (!tui || tui->stale_entries == 0 || tui->entries_count == 0) {
+        return 0;
+    }
+    return settle_conversation(tui, find_entry_for_line(tui, first_line), last_line);
+}
 
 // Helper: Refresh conversation window viewport (using pad)
 static void refresh_conversation_viewport(TUIState *tui) {
@@ -486,6 +811,232 @@ static void refresh_conversation_viewport(TUIState *tui) {
     window_manager_refresh_conversation(&tui->wm);
 }
 
+// ============================================================================
+// Conversation search
+// ============================================================================
+//
+// Entries are added to tui->search_index as they arrive, so a search only
+// verifies the entries that contain every trigram of the pattern. Matches
+// are byte offsets into "<prefix> <text>"; the wrap index turns them into
+// content lines when the view jumps to one.
+
+typedef struct {
+    int part_start[WRAP_TEXT_MAX_PARTS];
+    int target;                         // Entry offset to find
+    int row;                            // Row of the first glyph at or after target (-1 = none yet)
+} EntryLocateContext;
+
+// WrapEmitFn: note the row the target offset is laid out on
+static void locate_entry_glyph(void *ctx, int part, int offset, int row, int col,
+                               const char *bytes, int len, int cells) {
+    EntryLocateContext *locate = (EntryLocateContext *)ctx;
+    (void)col;
+    (void)len;
+    (void)cells;
+    if (locate->row < 0 && bytes &&
+        locate->part_start[part] + offset >= locate->target) {
+        locate->row = row;
+    }
+}
+
+// Content line holding the start of a match
+static int search_match_line(TUIState *tui, const SearchMatch *match) {
+    settle_conversation(tui, match->id, tui->entries[match->id].line_start + 1);
+    ConversationEntry *entry = &tui->entries[match->id];
+    WrapText text;
+    EntryLocateContext locate;
+
+    conversation_entry_text(tui, entry, &text);
+    conversation_entry_part_starts(&text, locate.part_start);
+    locate.target = match->offset;
+    locate.row = -1;
+    wrap_index_draw(&entry->wrap, &text, tui->layout_width, 0, entry->line_count,
+                    locate_entry_glyph, &locate);
+    return entry->line_start + (locate.row > 0 ? locate.row : 0);
+}
+
+// Redraw the conversation at scroll offset `offset` (clamped) with the
+// current highlights
+static void search_show_conversation(TUIState *tui, int offset) {
+    int max_scroll = window_manager_get_max_scroll(&tui->wm);
+    if (offset > max_scroll) offset = max_scroll;
+    if (offset < 0) offset = 0;
+    tui->wm.conv_scroll_offset = offset;
+    window_manager_invalidate_conversation(&tui->wm);
+    refresh_conversation_viewport(tui);
+}
+
+// Make match `index` current, scroll it into view and report it in the status bar
+static void search_show_match(TUIState *tui, int index) {
+    tui->search_current = index;
+    int line = search_match_line(tui, &tui->search_matches.items[index]);
+    int offset = tui->wm.conv_scroll_offset;
+    int viewport_h = tui->wm.conv_viewport_height > 0 ? tui->wm.conv_viewport_height : 1;
+    if (line < offset || line >= offset + viewport_h) {
+        offset = line - viewport_h / 3;
+    }
+    search_show_conversation(tui, offset);
+
+    char status[128];
+    snprintf(status, sizeof(status), "/%s [%d/%d]",
+             tui->search_pattern ? tui->search_pattern : "", index + 1, tui->search_matches.count);
+    tui_update_status(tui, status);
+}
+
+// SearchTextFn: the parts of an entry, reading spilled text back from disk
+static int search_entry_text(void *ctx, int id, const char **parts) {
+    const TUIState *tui = (const TUIState *)ctx;
+    if (id < 0 || id >= tui->entries_count) {
+        return 0;
+    }
+    WrapText text;
+    conversation_entry_text(tui, &tui->entries[id], &text);
+    for (int i = 0; i < text.nparts; i++) {
+        parts[i] = text.parts[i];
+    }
+    return text.nparts;
+}
+
+static int search_run(TUIState *tui, const char *pattern) {
+    int count = search_index_find(&tui->search_index, pattern, search_entry_text, tui,
+                                  &tui->search_matches);
+    if (count < 0) {
+        LOG_ERROR("[TUI] Failed to allocate memory for search matches");
+        tui->search_matches.count = 0;
+        count = 0;
+    }
+    tui->search_current = -1;
+    return count;
+}
+
+// First match in or after the entry at the top of the viewport
+static int search_first_visible_match(const TUIState *tui, int scroll_offset) {
+    if (tui->entries_count == 0) {
+        return 0;
+    }
+    int entry = find_entry_for_line(tui, scroll_offset);
+    for (int i = 0; i < tui->search_matches.count; i++) {
+        if (tui->search_matches.items[i].id >= entry) {
+            return i;
+        }
+    }
+    return 0;  // Wrap around to the first match
+}
+
+static int search_set_pattern(TUIState *tui, const char *pattern) {
+    if (tui->search_pattern && strcmp(tui->search_pattern, pattern) == 0) {
+        return 0;
+    }
+    char *copy = strdup(pattern);
+    if (!copy) {
+        LOG_ERROR("[TUI] Failed to allocate memory for search pattern");
+        return -1;
+    }
+    free(tui->search_pattern);
+    tui->search_pattern = copy;
+    return 0;
+}
+
+// Called as the pattern is typed: jump to the first match from where the
+// search started, or back to that position if nothing matches
+static void search_preview(TUIState *tui, const char *pattern) {
+    if (pattern[0] != '\0' && search_run(tui, pattern) > 0) {
+        search_set_pattern(tui, pattern);
+        search_show_match(tui, search_first_visible_match(tui, tui->search_saved_scroll));
+    } else {
+        tui->search_matches.count = 0;
+        tui->search_current = -1;
+        search_show_conversation(tui, tui->search_saved_scroll);
+    }
+}
+
+// Enter on the search prompt; an empty pattern repeats the last search
+static void search_commit(TUIState *tui, const char *pattern) {
+    if (pattern[0] == '\0') {
+        if (!tui->search_pattern) {
+            return;
+        }
+        pattern = tui->search_pattern;
+    }
+    if (search_set_pattern(tui, pattern) != 0) {
+        return;
+    }
+    if (search_run(tui, tui->search_pattern) > 0) {
+        search_show_match(tui, search_first_visible_match(tui, tui->search_saved_scroll));
+    } else {
+        search_show_conversation(tui, tui->search_saved_scroll);
+        char status[128];
+        snprintf(status, sizeof(status), "Pattern not found: %s", tui->search_pattern);
+        tui_update_status(tui, status);
+    }
+}
+
+// Esc on the search prompt: drop the highlights and go back
+static void search_cancel(TUIState *tui) {
+    tui->search_matches.count = 0;
+    tui->search_current = -1;
+    search_show_conversation(tui, tui->search_saved_scroll);
+}
+
+// n / N: move to the next (direction > 0) or previous match. The search is
+// rerun first so entries added since the last one are included.
+static void search_step(TUIState *tui, int direction) {
+    if (!tui->search_pattern) {
+        return;
+    }
+    SearchMatch from = {0, 0, 0};
+    int have_from = tui->search_current >= 0 && tui->search_current < tui->search_matches.count;
+    if (have_from) {
+        from = tui->search_matches.items[tui->search_current];
+    }
+
+    int count = search_run(tui, tui->search_pattern);
+    if (count == 0) {
+        search_show_conversation(tui, tui->wm.conv_scroll_offset);
+        char status[128];
+        snprintf(status, sizeof(status), "Pattern not found: %s", tui->search_pattern);
+        tui_update_status(tui, status);
+        return;
+    }
+    if (!have_from) {
+        search_show_match(tui, search_first_visible_match(tui, tui->wm.conv_scroll_offset));
+        return;
+    }
+
+    // Index of the first match after `from` (matches are in entry, offset order)
+    int after = 0;
+    while (after < count) {
+        const SearchMatch *m = &tui->search_matches.items[after];
+        if (m->id > from.id || (m->id == from.id && m->offset > from.offset)) {
+            break;
+        }
+        after++;
+    }
+    int index;
+    if (direction > 0) {
+        index = after % count;
+    } else {
+        // Step back over `from` itself if it still matches
+        int at = after - 1;
+        int same = at >= 0 && tui->search_matches.items[at].id == from.id &&
+                   tui->search_matches.items[at].offset == from.offset;
+        index = same ? at - 1 : at;
+        if (index < 0) index += count;
+    }
+    search_show_match(tui, index);
+}
+
+// Esc in normal mode: remove the search highlights
+static void search_clear_highlight(TUIState *tui) {
+    if (tui->search_matches.count == 0) {
+        return;
+    }
+    tui->search_matches.count = 0;
+    tui->search_current = -1;
+    search_show_conversation(tui, tui->wm.conv_scroll_offset);
+    tui_update_status(tui, "");
+}
+
 // UTF-8 helper functions (from lineedit.c)
 static int utf8_char_length(unsigned char first_byte) {
     if ((first_byte & 0x80) == 0) return 1;  // 0xxxxxxx
@@ -504,29 +1055,29 @@ static int is_word_boundary(char c) {
     return !isalnum(c) && c != '_';
 }
 
-static int move_backward_word(const char *buffer, int cursor_pos) {
+static int move_backward_word(const GapBuffer *text, int cursor_pos) {
     if (cursor_pos <= 0) return 0;
     int pos = cursor_pos - 1;
-    while (pos > 0 && is_word_boundary(buffer[pos])) pos--;
-    while (pos > 0 && !is_word_boundary(buffer[pos])) pos--;
-    if (pos > 0 && is_word_boundary(buffer[pos])) pos++;
+    while (pos > 0 && is_word_boundary(gap_buffer_at(text, pos))) pos--;
+    while (pos > 0 && !is_word_boundary(gap_buffer_at(text, pos))) pos--;
+    if (pos > 0 && is_word_boundary(gap_buffer_at(text, pos))) pos++;
     return pos;
 }
 
-static int move_forward_word(const char *buffer, int cursor_pos, int buffer_len) {
+static int move_forward_word(const GapBuffer *text, int cursor_pos) {
+    int buffer_len = gap_buffer_length(text);
     if (cursor_pos >= buffer_len) return buffer_len;
     int pos = cursor_pos;
-    while (pos < buffer_len && !is_word_boundary(buffer[pos])) pos++;
-    while (pos < buffer_len && is_word_boundary(buffer[pos])) pos++;
+    while (pos < buffer_len && !is_word_boundary(gap_buffer_at(text, pos))) pos++;
+    while (pos < buffer_len && is_word_boundary(gap_buffer_at(text, pos))) pos++;
     return pos;
 }
 
-// Input buffer management
+// Input buffer management. The text lives in a gap buffer kept at the
+// cursor, which also tracks how the text wraps, so a keystroke costs O(1)
+// plus redrawing the visible rows however long the input is.
 struct TUIInputBuffer {
-    char *buffer;
-    size_t capacity;
-    int length;
-    int cursor;
+    GapBuffer text;
     WINDOW *win;
     int win_width;
     int win_height;
@@ -545,35 +1096,6 @@ struct TUIInputBuffer {
     int paste_placeholder_len; // Length of placeholder in buffer
 };
 
-// Calculate how many visual lines are needed for the current buffer
-// Note: This assumes first line includes the prompt
-static int calculate_needed_lines(const char *buffer, int buffer_len, int available_width, int prompt_len) {
-    if (buffer_len == 0) return 1;
-
-    int lines = 1;
-    int current_col = prompt_len;  // First line starts after prompt
-    int current_line = 0;
-
-    for (int i = 0; i < buffer_len; i++) {
-        if (buffer[i] == '\n') {
-            lines++;
-            current_line++;
-            current_col = 0;  // Newlines don't have prompt
-        } else {
-            current_col++;
-            // First line has prompt, others don't
-            int line_width = (current_line == 0) ? available_width + prompt_len : available_width;
-            if (current_col >= line_width) {
-                lines++;
-                current_line++;
-                current_col = 0;
-            }
-        }
-    }
-
-    return lines;
-}
-
 // Resize input window dynamically (called from redraw)
 static int resize_input_window(TUIState *tui, int desired_lines) {
     if (!tui || !tui->is_initialized) return -1;
@@ -608,16 +1130,11 @@ static int input_init(TUIState *tui) {
         return -1;
     }
 
-    input->buffer = malloc(INPUT_BUFFER_SIZE);
-    if (!input->buffer) {
+    if (gap_buffer_init(&input->text, INPUT_BUFFER_SIZE) != 0) {
         free(input);
         return -1;
     }
 
-    input->capacity = INPUT_BUFFER_SIZE;
-    input->buffer[0] = '\0';
-    input->length = 0;
-    input->cursor = 0;
     input->win = tui->wm.input_win;
     input->view_offset = 0;
     input->line_scroll_offset = 0;
@@ -648,11 +1165,7 @@ static void input_free(TUIState *tui) {
         return;
     }
 
-    free(tui->input_buffer->buffer);
-    tui->input_buffer->buffer = NULL;
-    tui->input_buffer->capacity = 0;
-    tui->input_buffer->length = 0;
-    tui->input_buffer->cursor = 0;
+    gap_buffer_free(&tui->input_buffer->text);
 
     free(tui->input_buffer->paste_content);
     tui->input_buffer->paste_content = NULL;
@@ -663,6 +1176,15 @@ static void input_free(TUIState *tui) {
     tui->input_buffer = NULL;
 }
 
+// Replace the input text (history recall) and put the cursor at its end
+static void input_set_text(TUIInputBuffer *input, const char *text) {
+    if (gap_buffer_set_text(&input->text, text, (int)strlen(text)) != 0) {
+        LOG_WARN("[TUI] Failed to grow input buffer for recalled text");
+    }
+    input->view_offset = 0;
+    input->line_scroll_offset = 0;
+}
+
 // Insert character(s) at cursor position
 static int input_insert_char(TUIInputBuffer *input, const unsigned char *utf8_char, int char_bytes) {
     if (!input) {
@@ -691,103 +1213,53 @@ static int input_insert_char(TUIInputBuffer *input, const unsigned char *utf8_ch
         return 0;
     }
 
-    if (input->length + char_bytes >= (int)input->capacity - 1) {
-        return -1;  // Buffer full
-    }
-
-    // Make space for the new character(s)
-    memmove(&input->buffer[input->cursor + char_bytes],
-            &input->buffer[input->cursor],
-            (size_t)(input->length - input->cursor + 1));
-
-    // Copy the character bytes
-    for (int i = 0; i < char_bytes; i++) {
-        input->buffer[input->cursor + i] = (char)utf8_char[i];
+    if (gap_buffer_insert(&input->text, (const char *)utf8_char, char_bytes) != 0) {
+        LOG_ERROR("[TUI] Failed to grow input buffer");
+        return -1;
     }
-
-    input->length += char_bytes;
-    input->cursor += char_bytes;
     return 0;
 }
 
 // Delete character at cursor position (forward delete)
 static int input_delete_char(TUIInputBuffer *input) {
-    if (!input || input->cursor >= input->length) {
+    if (!input || gap_buffer_cursor(&input->text) >= gap_buffer_length(&input->text)) {
         return 0;  // Nothing to delete
     }
 
     // Find the length of the UTF-8 character at cursor
-    int char_len = utf8_char_length((unsigned char)input->buffer[input->cursor]);
-
-    // Delete the character by moving subsequent text left
-    memmove(&input->buffer[input->cursor],
-            &input->buffer[input->cursor + char_len],
-            (size_t)(input->length - input->cursor - char_len + 1));
-
-    input->length -= char_len;
-    return char_len;
+    int cursor = gap_buffer_cursor(&input->text);
+    int char_len = utf8_char_length((unsigned char)gap_buffer_at(&input->text, cursor));
+    return gap_buffer_delete_forward(&input->text, char_len);
 }
 
 // Delete character before cursor (backspace)
 static int input_backspace(TUIInputBuffer *input) {
-    if (!input || input->cursor <= 0) {
-        return 0;  // Nothing to delete
+    if (!input) {
+        return 0;
     }
-
-    memmove(&input->buffer[input->cursor - 1],
-            &input->buffer[input->cursor],
-            (size_t)(input->length - input->cursor + 1));
-    input->length--;
-    input->cursor--;
-    return 1;
+    return gap_buffer_delete_backward(&input->text, 1);
 }
 
 // Delete word before cursor (Alt+Backspace)
 static int input_delete_word_backward(TUIInputBuffer *input) {
-    if (!input || input->cursor <= 0) {
+    if (!input) {
         return 0;
     }
 
-    int word_start = input->cursor - 1;
-    while (word_start > 0 && is_word_boundary(input->buffer[word_start])) {
-        word_start--;
-    }
-    while (word_start > 0 && !is_word_boundary(input->buffer[word_start])) {
-        word_start--;
-    }
-    if (word_start > 0 && is_word_boundary(input->buffer[word_start])) {
-        word_start++;
-    }
-
-    int delete_count = input->cursor - word_start;
-    if (delete_count > 0) {
-        memmove(&input->buffer[word_start],
-                &input->buffer[input->cursor],
-                (size_t)(input->length - input->cursor + 1));
-        input->length -= delete_count;
-        input->cursor = word_start;
-    }
-
-    return delete_count;
+    int cursor = gap_buffer_cursor(&input->text);
+    int word_start = move_backward_word(&input->text, cursor);
+    return gap_buffer_delete_backward(&input->text, cursor - word_start);
 }
 
 // Delete word forward (Alt+d)
 static int input_delete_word_forward(TUIInputBuffer *input) {
-    if (!input || input->cursor >= input->length) {
+    if (!input) {
         return 0;
     }
 
-    int word_end = move_forward_word(input->buffer, input->cursor, input->length);
-    int delete_count = word_end - input->cursor;
-
-    if (delete_count > 0) {
-        memmove(&input->buffer[input->cursor],
-                &input->buffer[word_end],
-                (size_t)(input->length - word_end + 1));
-        input->length -= delete_count;
-    }
-
-    return delete_count;
+    int cursor = gap_buffer_cursor(&input->text);
+    int word_end = move_forward_word(&input->text, cursor);
+    return gap_buffer_delete_forward(&input->text, word_end - cursor);
 }
 
 // Threshold for when to use placeholder vs direct insertion (characters)
@@ -801,28 +1273,16 @@ static void input_finalize_paste(TUIInputBuffer *input) {
 
     int insert_pos = input->paste_start_pos;
     if (insert_pos < 0) insert_pos = 0;
-    if (insert_pos > input->length) insert_pos = input->length;
+    if (insert_pos > gap_buffer_length(&input->text)) insert_pos = gap_buffer_length(&input->text);
+    gap_buffer_set_cursor(&input->text, insert_pos);
 
     // For small pastes, insert directly without placeholder
     if (input->paste_content_len < PASTE_PLACEHOLDER_THRESHOLD) {
-        // Check if we have space in buffer
-        if (input->length + (int)input->paste_content_len >= (int)input->capacity - 1) {
-            LOG_WARN("[TUI] Not enough space for pasted content (%zu chars)", input->paste_content_len);
+        if (gap_buffer_insert(&input->text, input->paste_content,
+                              (int)input->paste_content_len) != 0) {
+            LOG_WARN("[TUI] Not enough memory for pasted content (%zu chars)", input->paste_content_len);
             return;
         }
-
-        int paste_len = (int)input->paste_content_len;
-
-        // Make space for paste content
-        memmove(&input->buffer[insert_pos + paste_len],
-                &input->buffer[insert_pos],
-                (size_t)(input->length - insert_pos + 1));
-
-        // Copy paste content directly
-        memcpy(&input->buffer[insert_pos], input->paste_content, input->paste_content_len);
-
-        input->length += paste_len;
-        input->cursor = insert_pos + paste_len;
         input->paste_placeholder_len = 0;  // No placeholder used
 
         LOG_DEBUG("[TUI] Inserted paste content directly at position %d (%zu chars)",
@@ -840,22 +1300,10 @@ static void input_finalize_paste(TUIInputBuffer *input) {
         placeholder_len = sizeof(placeholder) - 1;
     }
 
-    // Check if we have space in buffer
-    if (input->length + placeholder_len >= (int)input->capacity - 1) {
-        LOG_WARN("[TUI] Not enough space for paste placeholder");
+    if (gap_buffer_insert(&input->text, placeholder, placeholder_len) != 0) {
+        LOG_WARN("[TUI] Not enough memory for paste placeholder");
         return;
     }
-
-    // Make space for placeholder
-    memmove(&input->buffer[insert_pos + placeholder_len],
-            &input->buffer[insert_pos],
-            (size_t)(input->length - insert_pos + 1));
-
-    // Copy placeholder
-    memcpy(&input->buffer[insert_pos], placeholder, (size_t)placeholder_len);
-
-    input->length += placeholder_len;
-    input->cursor = insert_pos + placeholder_len;
     input->paste_placeholder_len = placeholder_len;
 
     LOG_DEBUG("[TUI] Inserted paste placeholder at position %d: %s",
@@ -887,8 +1335,8 @@ static void input_redraw(TUIState *tui, const char *prompt) {
     int available_width = input->win_width - prompt_len;
     if (available_width < 10) available_width = 10;
 
-    // Calculate how many lines we need to display all content
-    int needed_lines = calculate_needed_lines(input->buffer, input->length, available_width, prompt_len);
+    // Row count and cursor position come from the input's row index
+    int needed_lines = gap_buffer_rows(&input->text, available_width);
 
     // Request window resize (this will be a no-op if size hasn't changed)
     resize_input_window(tui, needed_lines);
@@ -902,20 +1350,12 @@ static void input_redraw(TUIState *tui, const char *prompt) {
     available_width = input->win_width - prompt_len;
     if (available_width < 10) available_width = 10;
 
-    // Calculate cursor line position
+    // Calculate cursor line position (the first line starts after the prompt)
     int cursor_line = 0;
-    int cursor_col = prompt_len;
-    for (int i = 0; i < input->cursor; i++) {
-        if (input->buffer[i] == '\n') {
-            cursor_line++;
-            cursor_col = 0;
-        } else {
-            cursor_col++;
-            if (cursor_col >= available_width + prompt_len) {
-                cursor_line++;
-                cursor_col = 0;
-            }
-        }
+    int cursor_col = 0;
+    gap_buffer_cursor_row(&input->text, available_width, &cursor_line, &cursor_col);
+    if (cursor_line == 0) {
+        cursor_col += prompt_len;
     }
 
     // Adjust vertical scroll to keep cursor visible
@@ -963,50 +1403,29 @@ static void input_redraw(TUIState *tui, const char *prompt) {
         wattron(win, COLOR_PAIR(NCURSES_PAIR_FOREGROUND));
     }
 
-    int current_line = 0;
-    int screen_y = 1;
-    int screen_x = (current_line == 0) ? prompt_len + 1 : 1;
-
-    for (int i = 0; i < input->length && screen_y <= input->win_height; i++) {
-        // Skip lines before scroll offset
-        if (current_line < input->line_scroll_offset) {
-            if (input->buffer[i] == '\n') {
-                current_line++;
-                screen_x = 0;
-            } else {
-                screen_x++;
-                if (screen_x >= available_width + ((current_line == 0) ? prompt_len : 0)) {
-                    current_line++;
-                    screen_x = 0;
-                }
-            }
-            continue;
-        }
-
-        // Render character
-        char c = input->buffer[i];
-        if (c == '\n') {
-            mvwaddch(win, screen_y, screen_x, (unsigned char)'+' | A_DIM);
-            screen_y++;
-            current_line++;
-            screen_x = 1;  // Reset to left edge (after border)
-        } else {
-            // Cast to unsigned char then to chtype to avoid sign-conversion warnings
-            mvwaddch(win, screen_y, screen_x, (chtype)(unsigned char)c);
-            screen_x++;
-
-            // Check if we need to wrap
-            int line_width = available_width;
-            if (current_line == input->line_scroll_offset && input->line_scroll_offset == 0) {
-                line_width += prompt_len;  // First line includes prompt
+    // Only the visible rows are laid out and drawn
+    int drawn = 0;
+    while (drawn < input->win_height) {
+        GapBufferRow rows[16];
+        int want = input->win_height - drawn < 16 ? input->win_height - drawn : 16;
+        int n = gap_buffer_layout_rows(&input->text, available_width,
+                                       input->line_scroll_offset + drawn, rows, want);
+        for (int k = 0; k < n; k++) {
+            int screen_y = drawn + k + 1;
+            int screen_x = (input->line_scroll_offset + drawn + k == 0) ? prompt_len + 1 : 1;
+            for (int j = 0; j < rows[k].len; j++) {
+                // Cast to unsigned char then to chtype to avoid sign-conversion warnings
+                char c = gap_buffer_at(&input->text, rows[k].start + j);
+                mvwaddch(win, screen_y, screen_x + j, (chtype)(unsigned char)c);
             }
-
-            if (screen_x > line_width) {
-                screen_y++;
-                current_line++;
-                screen_x = 1;
+            if (rows[k].newline) {
+                mvwaddch(win, screen_y, screen_x + rows[k].len, (unsigned char)'+' | A_DIM);
             }
         }
+        if (n < want) {
+            break;
+        }
+        drawn += n;
     }
 
     if (has_colors()) {
@@ -1017,24 +1436,6 @@ static void input_redraw(TUIState *tui, const char *prompt) {
     int cursor_screen_y = cursor_line - input->line_scroll_offset + 1;
     int cursor_screen_x = cursor_col + 1;  // +1 for border
 
-    // Recalculate cursor_col relative to its line
-    int temp_line = 0;
-    int temp_col = (temp_line == 0) ? prompt_len : 0;
-    for (int i = 0; i < input->cursor; i++) {
-        if (input->buffer[i] == '\n') {
-            temp_line++;
-            temp_col = 0;
-        } else {
-            temp_col++;
-            int line_width = available_width + ((temp_line == 0) ? prompt_len : 0);
-            if (temp_col >= line_width) {
-                temp_line++;
-                temp_col = 0;
-            }
-        }
-    }
-    cursor_screen_x = temp_col + 1;
-
     // Bounds check for cursor position
     if (cursor_screen_y >= 1 && cursor_screen_y <= input->win_height &&
         cursor_screen_x >= 1 && cursor_screen_x <= input->win_width) {
@@ -1134,13 +1535,32 @@ int tui_init(TUIState *tui) {
         endwin();
         return -1;
     }
-    // Start with zero content lines
+    // Start with zero content lines; the pad is drawn from the entries
     window_manager_set_content_lines(&tui->wm, 0);
+    window_manager_set_conversation_renderer(&tui->wm, render_conversation_lines, tui);
+    window_manager_set_conversation_layout(&tui->wm, settle_conversation_lines);
 
     // Initialize conversation entries
     tui->entries = NULL;
     tui->entries_count = 0;
     tui->entries_capacity = 0;
+    tui->layout_width = 0;
+    tui->stale_entries = 0;
+    spill_file_init(&tui->spill);
+    tui->resident_text_bytes = 0;
+    tui->resident_text_limit = TUI_RESIDENT_TEXT_DEFAULT_MB * 1024u * 1024u;
+    const char *resident = getenv("TUI_RESIDENT_TEXT_MB");
+    if (resident) {
+        long v = strtol(resident, NULL, 10);
+        if (v >= 1 && v <= 65536) tui->resident_text_limit = (size_t)v * 1024u * 1024u;
+    }
+    tui->spill_next = 0;
+    tui->spill_failed = 0;
+    search_index_init(&tui->search_index);
+    memset(&tui->search_matches, 0, sizeof(tui->search_matches));
+    tui->search_pattern = NULL;
+    tui->search_current = -1;
+    tui->search_saved_scroll = 0;
     tui->status_message = NULL;
     tui->status_visible = 0;
     tui->status_spinner_active = 0;
@@ -1189,6 +1609,9 @@ int tui_init(TUIState *tui) {
     // Register resize handler (if available)
 #ifdef SIGWINCH
     signal(SIGWINCH, handle_resize);
+    // On Linux the signal is read from a signalfd by the event loop instead.
+    // Must happen before the worker threads start so they inherit the mask.
+    tui_events_capture_resize();
 #endif
 
     tui->is_initialized = 1;
@@ -1214,6 +1637,11 @@ void tui_cleanup(TUIState *tui) {
 
     // Free conversation entries
     free_conversation_entries(tui);
+    search_index_free(&tui->search_index);
+    search_matches_free(&tui->search_matches);
+    free(tui->search_pattern);
+    tui->search_pattern = NULL;
+    spill_file_close(&tui->spill);
 
     // Free input state
     input_free(tui);
@@ -1263,139 +1691,150 @@ void tui_cleanup(TUIState *tui) {
     }
 }
 
-void tui_add_conversation_line(TUIState *tui, const char *prefix, const char *text, TUIColorPair color_pair) {
-    if (!tui || !tui->is_initialized) return;
+// Show the conversation after lines were added: stage the conversation,
+// status and input windows and write them to the terminal in one doupdate()
+static void present_conversation(TUIState *tui) {
+    window_manager_stage_conversation(&tui->wm);
 
-    // Validate conversation pad exists (critical - prevent segfault)
-    if (!tui->wm.conv_pad) {
-        LOG_ERROR("[TUI] Cannot add conversation line - conv_pad is NULL");
-        return;
+    if (tui->wm.status_height > 0 && tui->wm.status_win) {
+        draw_status_window(tui);
+        wnoutrefresh(tui->wm.status_win);
     }
 
-    // Add entry to conversation history
-    if (add_conversation_entry(tui, prefix, text, color_pair) != 0) {
-        LOG_ERROR("[TUI] Failed to add conversation entry");
-        return;
+    // Redraw input window to ensure it stays visible
+    if (tui->wm.input_win) {
+        touchwin(tui->wm.input_win);
+        wnoutrefresh(tui->wm.input_win);
     }
+    doupdate();
+}
 
-    // Get pad dimensions
-    int pad_height, pad_width;
-    getmaxyx(tui->wm.conv_pad, pad_height, pad_width);
-    (void)pad_height;
-
-    // Calculate how many lines this entry will take when wrapped
-    int prefix_len = (prefix && prefix[0] != '\0') ? (int)strlen(prefix) + 1 : 0; // +1 for space
-    int text_len = (text && text[0] != '\0') ? (int)strlen(text) : 0;
-
-    // Estimate wrapped lines (conservative)
-    int estimated_lines = 1; // At least 1 line
-    if (text_len > 0) {
-        estimated_lines = ((prefix_len + text_len) / pad_width) + 2; // +2 for newline and safety
+void tui_begin_conversation_batch(TUIState *tui) {
+    if (tui) {
+        tui->conversation_batch++;
     }
+}
 
-    // Ensure pad has enough capacity (centralized via WindowManager)
-    int current_lines = window_manager_get_content_lines(&tui->wm);
-    int needed_capacity = current_lines + estimated_lines + 100;
-    if (needed_capacity > tui->wm.conv_pad_capacity) {
-        if (window_manager_ensure_pad_capacity(&tui->wm, needed_capacity) != 0) {
-            LOG_ERROR("[TUI] Failed to ensure pad capacity via WindowManager");
+void tui_end_conversation_batch(TUIState *tui) {
+    if (tui && tui->conversation_batch > 0 && --tui->conversation_batch == 0 &&
+        tui->conversation_dirty) {
+        tui->conversation_dirty = 0;
+        if (tui->is_initialized && tui->wm.conv_pad) {
+            present_conversation(tui);
         }
     }
+}
 
-    // Map color pair
-    int mapped_pair = NCURSES_PAIR_FOREGROUND;
-    switch (color_pair) {
-        case COLOR_PAIR_DEFAULT:
-        case COLOR_PAIR_FOREGROUND:
-            mapped_pair = NCURSES_PAIR_FOREGROUND;
-            break;
-        case COLOR_PAIR_USER:
-            mapped_pair = NCURSES_PAIR_USER;
-            break;
-        case COLOR_PAIR_ASSISTANT:
-            mapped_pair = NCURSES_PAIR_ASSISTANT;
-            break;
-        case COLOR_PAIR_TOOL:
-            mapped_pair = NCURSES_PAIR_TOOL;
-            break;
-        case COLOR_PAIR_STATUS:
-            mapped_pair = NCURSES_PAIR_STATUS;
-            break;
-        case COLOR_PAIR_ERROR:
-            mapped_pair = NCURSES_PAIR_ERROR;
-            break;
-        case COLOR_PAIR_PROMPT:
-            mapped_pair = NCURSES_PAIR_PROMPT;
-            break;
-        case COLOR_PAIR_TODO_COMPLETED:
-            mapped_pair = NCURSES_PAIR_TODO_COMPLETED;
-            break;
-        case COLOR_PAIR_TODO_IN_PROGRESS:
-            mapped_pair = NCURSES_PAIR_TODO_IN_PROGRESS;
-            break;
-        case COLOR_PAIR_TODO_PENDING:
-            mapped_pair = NCURSES_PAIR_TODO_PENDING;
-            break;
-        default:
-            /* Keep default mapped_pair (foreground) */
-            break;
+// Move the text of old, large entries out of memory once the resident text
+// passes its limit, down to half the limit. Entries whose lines are in or
+// near the pad stay resident; spilled text is read back through the spill
+// file's mapping when it is drawn or searched.
+static void spill_cold_entries(TUIState *tui) {
+    if (tui->resident_text_bytes <= tui->resident_text_limit || tui->spill_failed) {
+        return;
+    }
+    if (tui->spill.fd < 0 && spill_file_open(&tui->spill, NULL) != 0) {
+        LOG_WARN("[TUI] Conversation text will stay in memory (no spill file)");
+        tui->spill_failed = 1;
+        return;
     }
 
-    // Move to end of pad
-    int start_line = window_manager_get_content_lines(&tui->wm);
-    wmove(tui->wm.conv_pad, start_line, 0);
+    int margin = tui->wm.conv_pad_capacity > 0 ? tui->wm.conv_pad_capacity : 1;
+    int hot_first = tui->wm.conv_scroll_offset - margin;
+    int hot_last = tui->wm.conv_scroll_offset + tui->wm.conv_viewport_height + margin;
+    size_t target = tui->resident_text_limit / 2;
+    int spilled = 0;
 
-    // Write prefix if present
-    if (prefix && prefix[0] != '\0') {
-        if (has_colors()) {
-            wattron(tui->wm.conv_pad, COLOR_PAIR(mapped_pair) | A_BOLD);
+    for (int i = tui->spill_next; i < tui->entries_count && tui->resident_text_bytes > target; i++) {
+        ConversationEntry *entry = &tui->entries[i];
+        if (entry->spilled || entry->text_len < TUI_SPILL_MIN_BYTES) {
+            continue;
         }
-        waddstr(tui->wm.conv_pad, prefix);
-        waddch(tui->wm.conv_pad, ' ');
-        if (has_colors()) {
-            wattroff(tui->wm.conv_pad, COLOR_PAIR(mapped_pair) | A_BOLD);
+        if (entry->line_start < hot_last && entry->line_start + entry->line_count > hot_first) {
+            continue;
+        }
+        size_t offset;
+        if (spill_file_append(&tui->spill, entry->text, entry->text_len, &offset) != 0) {
+            LOG_WARN("[TUI] Spilling conversation text failed; keeping it in memory");
+            tui->spill_failed = 1;
+            break;
         }
+        free(entry->text);
+        entry->text = NULL;
+        entry->spilled = 1;
+        entry->spill_offset = offset;
+        tui->resident_text_bytes -= entry->text_len;
+        spilled++;
     }
 
-    // Write text
-    if (text && text[0] != '\0') {
-        int text_pair = (prefix && prefix[0] != '\0') ? NCURSES_PAIR_FOREGROUND : mapped_pair;
-        if (has_colors()) {
-            wattron(tui->wm.conv_pad, COLOR_PAIR(text_pair));
-        }
-        waddstr(tui->wm.conv_pad, text);
-        if (has_colors()) {
-            wattroff(tui->wm.conv_pad, COLOR_PAIR(text_pair));
-        }
+    while (tui->spill_next < tui->entries_count &&
+           (tui->entries[tui->spill_next].spilled ||
+            tui->entries[tui->spill_next].text_len < TUI_SPILL_MIN_BYTES)) {
+        tui->spill_next++;
     }
 
-    // Add newline
-    waddch(tui->wm.conv_pad, '\n');
+    if (spilled > 0) {
+        // Spilled text paged in by scrolling or searching leaves the RSS too
+        spill_file_release(&tui->spill);
+        LOG_DEBUG("[TUI] Spilled %d entries, %zu bytes of text resident",
+                  spilled, tui->resident_text_bytes);
+    }
+}
+
+void tui_add_conversation_line(TUIState *tui, const char *prefix, const char *text, TUIColorPair color_pair) {
+    if (!tui || !tui->is_initialized) return;
+
+    // Validate conversation pad exists (critical - prevent segfault)
+    if (!tui->wm.conv_pad) {
+        LOG_ERROR("[TUI] Cannot add conversation line - conv_pad is NULL");
+        return;
+    }
 
-    // Update total lines (get actual cursor position after wrapping)
-    int cur_y, cur_x;
-    getyx(tui->wm.conv_pad, cur_y, cur_x);
-    (void)cur_x;
-    window_manager_set_content_lines(&tui->wm, cur_y);
+    // Add entry to conversation history
+    if (add_conversation_entry(tui, prefix, text, color_pair) != 0) {
+        LOG_ERROR("[TUI] Failed to add conversation entry");
+        return;
+    }
 
-    LOG_DEBUG("[TUI] Added line, total_lines now %d (estimated %d, actual %d)",
-              window_manager_get_content_lines(&tui->wm), estimated_lines, cur_y - start_line);
+    // Extend the line index; the WindowManager draws the new lines only if
+    // they land inside its pad
+    if (tui->layout_width != tui->wm.screen_width) {
+        relayout_conversation(tui);
+        window_manager_invalidate_conversation(&tui->wm);
+    }
+    ConversationEntry *entry = &tui->entries[tui->entries_count - 1];
+    entry->line_start = tui->entries_count > 1
+        ? tui->entries[tui->entries_count - 2].line_start + tui->entries[tui->entries_count - 2].line_count
+        : 0;
+    entry->line_count = conversation_entry_lines(tui, entry, tui->layout_width);
+    if (entry->line_stale) {
+        entry->line_stale = 0;
+        tui->stale_entries--;
+    }
+    window_manager_set_content_lines(&tui->wm, entry->line_start + entry->line_count);
 
-    // Auto-scroll to bottom only in INSERT mode (preserve scroll position in NORMAL mode)
-    if (tui->mode == TUI_MODE_INSERT) {
-        window_manager_scroll_to_bottom(&tui->wm);
+    WrapText search_text;
+    conversation_entry_text(tui, entry, &search_text);
+    if (search_index_add(&tui->search_index, tui->entries_count - 1,
+                         search_text.parts, search_text.nparts) != 0) {
+        LOG_WARN("[TUI] Failed to index conversation entry for search");
     }
-    window_manager_refresh_conversation(&tui->wm);
+    spill_cold_entries(tui);
 
-    if (tui->wm.status_height > 0) {
-        render_status_window(tui);
+    LOG_DEBUG("[TUI] Added line, total_lines now %d (entry lines %d)",
+              window_manager_get_content_lines(&tui->wm), entry->line_count);
+
+    // Auto-scroll to bottom only in INSERT mode (preserve scroll position in NORMAL mode).
+    // The offset is set directly; present_conversation() does the one refresh.
+    if (tui->mode == TUI_MODE_INSERT) {
+        tui->wm.conv_scroll_offset = window_manager_get_max_scroll(&tui->wm);
     }
 
-    // Redraw input window to ensure it stays visible
-    if (tui->wm.input_win) {
-        touchwin(tui->wm.input_win);
-        wrefresh(tui->wm.input_win);
+    if (tui->conversation_batch > 0) {
+        tui->conversation_dirty = 1;
+        return;
     }
+    present_conversation(tui);
 }
 
 void tui_render_todo_list(TUIState *tui, const TodoList *list) {
@@ -1513,8 +1952,7 @@ void tui_clear_conversation(TUIState *tui) {
     // Free all conversation entries
     free_conversation_entries(tui);
 
-    // Clear pad and reset content lines
-    werase(tui->wm.conv_pad);
+    // Reset content lines (invalidates the pad)
     window_manager_set_content_lines(&tui->wm, 0);
 
     // Add a system message indicating the clear
@@ -1527,10 +1965,9 @@ void tui_clear_conversation(TUIState *tui) {
 void tui_handle_resize(TUIState *tui) {
     if (!tui || !tui->is_initialized) return;
 
-    // Temporarily save scroll position and reset to 0 to avoid accessing
-    // invalid pad coordinates during rebuild
+    // Remember whether the view was following the bottom of the conversation
     int saved_scroll_offset = tui->wm.conv_scroll_offset;
-    tui->wm.conv_scroll_offset = 0;
+    int was_at_bottom = saved_scroll_offset >= window_manager_get_max_scroll(&tui->wm);
 
     // Get new screen dimensions to recalculate max input height
     int screen_height, screen_width;
@@ -1568,110 +2005,17 @@ void tui_handle_resize(TUIState *tui) {
         LOG_DEBUG("[TUI] Updated input buffer window pointer after resize");
     }
 
-    // Estimate needed capacity for all entries (conservative: 2 lines per entry minimum)
-    int estimated_lines = (tui->entries_count * 2) + 100;
-    if (window_manager_ensure_pad_capacity(&tui->wm, estimated_lines) != 0) {
-        LOG_ERROR("[TUI] Failed to ensure pad capacity before rebuild");
-        return;
+    // Rebuild the line index for the new width. Nothing is wrapped or drawn
+    // here; the refresh below wraps and renders just the visible entries.
+    if (tui->layout_width != tui->wm.screen_width) {
+        window_manager_set_content_lines(&tui->wm, relayout_conversation(tui));
     }
+    window_manager_invalidate_conversation(&tui->wm);
 
-    // Rebuild pad content from stored entries (ensures wrapping updates with new width)
-    werase(tui->wm.conv_pad);
-    int pad_height, pad_width;
-    getmaxyx(tui->wm.conv_pad, pad_height, pad_width);
-
-    for (int i = 0; i < tui->entries_count; i++) {
-        ConversationEntry *entry = &tui->entries[i];
-
-        // Safety check: ensure we're not writing beyond pad capacity
-        int cur_y, cur_x;
-        getyx(tui->wm.conv_pad, cur_y, cur_x);
-        (void)cur_x;
-
-        if (cur_y >= pad_height - 1) {
-            LOG_WARN("[TUI] Pad capacity exceeded during resize rebuild at entry %d/%d (cur_y=%d, pad_height=%d)",
-                     i, tui->entries_count, cur_y, pad_height);
-            // Expand pad capacity on-the-fly
-            int new_capacity = pad_height * 2;
-            if (window_manager_ensure_pad_capacity(&tui->wm, new_capacity) != 0) {
-                LOG_ERROR("[TUI] Failed to expand pad during rebuild");
-                break;
-            }
-            // Refresh pad dimensions after expansion
-            getmaxyx(tui->wm.conv_pad, pad_height, pad_width);
-        }
-
-                int mapped_pair = NCURSES_PAIR_FOREGROUND;
-                switch (entry->color_pair) {
-                    case COLOR_PAIR_DEFAULT:
-                    case COLOR_PAIR_FOREGROUND:
-                        mapped_pair = NCURSES_PAIR_FOREGROUND;
-                        break;
-                    case COLOR_PAIR_USER:
-                        mapped_pair = NCURSES_PAIR_USER;
-                        break;
-                    case COLOR_PAIR_ASSISTANT:
-                        mapped_pair = NCURSES_PAIR_ASSISTANT;
-                        break;
-                    case COLOR_PAIR_TOOL:
-                    case COLOR_PAIR_STATUS:
-                        mapped_pair = NCURSES_PAIR_STATUS;
-                        break;
-                    case COLOR_PAIR_ERROR:
-                        mapped_pair = NCURSES_PAIR_ERROR;
-                        break;
-                    case COLOR_PAIR_PROMPT:
-                        mapped_pair = NCURSES_PAIR_PROMPT;
-                        break;
-                    case COLOR_PAIR_TODO_COMPLETED:
-                        mapped_pair = NCURSES_PAIR_TODO_COMPLETED;
-                        break;
-                    case COLOR_PAIR_TODO_IN_PROGRESS:
-                        mapped_pair = NCURSES_PAIR_TODO_IN_PROGRESS;
-                        break;
-                    case COLOR_PAIR_TODO_PENDING:
-                        mapped_pair = NCURSES_PAIR_TODO_PENDING;
-                        break;
-                    default:
-                        /* Keep default mapped_pair (foreground) */
-                        break;
-                }
-
-        if (entry->prefix && entry->prefix[0] != '\0') {
-            if (has_colors()) {
-                wattron(tui->wm.conv_pad, COLOR_PAIR(mapped_pair) | A_BOLD);
-            }
-            waddstr(tui->wm.conv_pad, entry->prefix);
-            waddch(tui->wm.conv_pad, ' ');
-            if (has_colors()) {
-                wattroff(tui->wm.conv_pad, COLOR_PAIR(mapped_pair) | A_BOLD);
-            }
-        }
-
-        if (entry->text && entry->text[0] != '\0') {
-            int text_pair = (entry->prefix && entry->prefix[0] != '\0') ? NCURSES_PAIR_FOREGROUND : mapped_pair;
-            if (has_colors()) {
-                wattron(tui->wm.conv_pad, COLOR_PAIR(text_pair));
-            }
-            waddstr(tui->wm.conv_pad, entry->text);
-            if (has_colors()) {
-                wattroff(tui->wm.conv_pad, COLOR_PAIR(text_pair));
-            }
-        }
-
-        waddch(tui->wm.conv_pad, '\n');
-    }
-
-    // Get final cursor position to determine actual content lines
-    int cur_y, cur_x;
-    getyx(tui->wm.conv_pad, cur_y, cur_x);
-    (void)cur_x;
-    window_manager_set_content_lines(&tui->wm, cur_y);
-
-    // Restore scroll position (clamped to valid range by window manager)
-    tui->wm.conv_scroll_offset = saved_scroll_offset;
-    int max_scroll = cur_y - tui->wm.conv_viewport_height;
-    if (max_scroll < 0) max_scroll = 0;
+    // Restore scroll position (clamped to valid range), sticking to the bottom
+    // if that is where the view was
+    int max_scroll = window_manager_get_max_scroll(&tui->wm);
+    tui->wm.conv_scroll_offset = was_at_bottom ? max_scroll : saved_scroll_offset;
     if (tui->wm.conv_scroll_offset > max_scroll) {
         tui->wm.conv_scroll_offset = max_scroll;
     }
@@ -1790,7 +2134,12 @@ static int handle_command_mode_input(TUIState *tui, int ch, const char *prompt)
         return 0;
     }
 
+    int searching = tui->command_buffer[0] == '/';
+
     if (ch == 27) {  // ESC - cancel command mode
+        if (searching) {
+            search_cancel(tui);
+        }
         tui->mode = TUI_MODE_NORMAL;
         tui->command_buffer_len = 0;
         if (tui->command_buffer) {
@@ -1802,12 +2151,18 @@ static int handle_command_mode_input(TUIState *tui, int ch, const char *prompt)
         input_redraw(tui, prompt);
         return 0;
     } else if (ch == KEY_BACKSPACE || ch == 127 || ch == 8) {  // Backspace
-        if (tui->command_buffer_len > 1) {  // Keep the ':'
+        if (tui->command_buffer_len > 1) {  // Keep the ':' or '/'
             tui->command_buffer_len--;
             tui->command_buffer[tui->command_buffer_len] = '\0';
+            if (searching) {
+                search_preview(tui, tui->command_buffer + 1);
+            }
             input_redraw(tui, prompt);
         } else {
-            // Backspace on just ':' exits command mode
+            // Backspace on just ':' or '/' exits command mode
+            if (searching) {
+                search_cancel(tui);
+            }
             tui->mode = TUI_MODE_NORMAL;
             tui->command_buffer_len = 0;
             tui->command_buffer[0] = '\0';
@@ -1819,9 +2174,11 @@ static int handle_command_mode_input(TUIState *tui, int ch, const char *prompt)
         return 0;
     } else if (ch == 13 || ch == 10) {  // Enter - execute command
         // Parse and execute command
-        const char *cmd = tui->command_buffer + 1;  // Skip the ':'
+        const char *cmd = tui->command_buffer + 1;  // Skip the ':' or '/'
 
-        if (strcmp(cmd, "q") == 0 || strcmp(cmd, "quit") == 0) {
+        if (searching) {
+            search_commit(tui, cmd);
+        } else if (strcmp(cmd, "q") == 0 || strcmp(cmd, "quit") == 0) {
             // Quit command
             return -1;
         } else if (strcmp(cmd, "w") == 0 || strcmp(cmd, "write") == 0) {
@@ -1851,6 +2208,9 @@ static int handle_command_mode_input(TUIState *tui, int ch, const char *prompt)
         if (tui->command_buffer_len < tui->command_buffer_capacity - 1) {
             tui->command_buffer[tui->command_buffer_len++] = (char)ch;
             tui->command_buffer[tui->command_buffer_len] = '\0';
+            if (searching) {
+                search_preview(tui, tui->command_buffer + 1);
+            }
             input_redraw(tui, prompt);
         }
         return 0;
@@ -1912,8 +2272,9 @@ static int handle_normal_mode_input(TUIState *tui, int ch, const char *prompt) {
             return 0;  // Mode switched, continue processing (not submission)
 
         case ':':  // Enter command mode
+        case '/':  // Search the conversation (typed into the command buffer)
             tui->mode = TUI_MODE_COMMAND;
-            // Initialize command buffer with ':'
+            // Initialize command buffer with ':' or '/'
             if (!tui->command_buffer) {
                 tui->command_buffer_capacity = 256;
                 tui->command_buffer = malloc((size_t)tui->command_buffer_capacity);
@@ -1923,9 +2284,10 @@ static int handle_normal_mode_input(TUIState *tui, int ch, const char *prompt) {
                     return 0;
                 }
             }
-            tui->command_buffer[0] = ':';
+            tui->command_buffer[0] = (char)ch;
             tui->command_buffer[1] = '\0';
             tui->command_buffer_len = 1;
+            tui->search_saved_scroll = tui->wm.conv_scroll_offset;
             if (tui->wm.status_height > 0) {
                 render_status_window(tui);
             }
@@ -1972,6 +2334,21 @@ static int handle_normal_mode_input(TUIState *tui, int ch, const char *prompt) {
             tui->normal_mode_last_key = 'g';
             break;
 
+        case 'n':  // Next search match
+            search_step(tui, 1);
+            input_redraw(tui, prompt);
+            break;
+
+        case 'N':  // Previous search match
+            search_step(tui, -1);
+            input_redraw(tui, prompt);
+            break;
+
+        case 27:  // Esc: clear search highlights
+            search_clear_highlight(tui);
+            input_redraw(tui, prompt);
+            break;
+
         case 'G':  // Go to bottom
             window_manager_scroll_to_bottom(&tui->wm);
             refresh_conversation_viewport(tui);
@@ -1979,7 +2356,7 @@ static int handle_normal_mode_input(TUIState *tui, int ch, const char *prompt) {
             break;
 
         case 'q':  // Quit (when input is empty)
-            if (tui->input_buffer && tui->input_buffer->length == 0) {
+            if (tui->input_buffer && gap_buffer_length(&tui->input_buffer->text) == 0) {
                 return -1;  // Signal quit
             }
             break;
@@ -2026,13 +2403,9 @@ static int check_paste_timeout(TUIState *tui, const char *prompt) {
                  input->paste_content_len);
 
         // For heuristic mode, remove the already-inserted characters
-        int chars_to_remove = input->cursor - input->paste_start_pos;
+        int chars_to_remove = gap_buffer_cursor(&input->text) - input->paste_start_pos;
         if (chars_to_remove > 0) {
-            memmove(&input->buffer[input->paste_start_pos],
-                    &input->buffer[input->cursor],
-                    (size_t)(input->length - input->cursor + 1));
-            input->length -= chars_to_remove;
-            input->cursor = input->paste_start_pos;
+            gap_buffer_delete_backward(&input->text, chars_to_remove);
         }
 
         // Insert placeholder or content directly
@@ -2092,7 +2465,7 @@ int tui_process_input_char(TUIState *tui, int ch, const char *prompt) {
                 // For heuristic mode, we've already inserted some characters
                 // Need to capture what we've inserted so far
                 int chars_already_inserted = input->rapid_input_count;
-                input->paste_start_pos = input->cursor - chars_already_inserted;
+                input->paste_start_pos = gap_buffer_cursor(&input->text) - chars_already_inserted;
                 if (input->paste_start_pos < 0) input->paste_start_pos = 0;
 
                 // Allocate paste buffer if not already allocated
@@ -2110,9 +2483,8 @@ int tui_process_input_char(TUIState *tui, int ch, const char *prompt) {
                 if (input->paste_content) {
                     input->paste_content_len = (size_t)chars_already_inserted;
                     if (input->paste_content_len > 0) {
-                        memcpy(input->paste_content,
-                               &input->buffer[input->paste_start_pos],
-                               input->paste_content_len);
+                        gap_buffer_copy(&input->text, input->paste_start_pos,
+                                        (int)input->paste_content_len, input->paste_content);
                     }
                 }
 
@@ -2138,30 +2510,23 @@ int tui_process_input_char(TUIState *tui, int ch, const char *prompt) {
         input_redraw(tui, prompt);
         return 0;
     } else if (ch == 1) {  // Ctrl+A: beginning of line
-        input->cursor = 0;
+        gap_buffer_set_cursor(&input->text, 0);
         input_redraw(tui, prompt);
     } else if (ch == 5) {  // Ctrl+E: end of line
-        input->cursor = input->length;
+        gap_buffer_set_cursor(&input->text, gap_buffer_length(&input->text));
         input_redraw(tui, prompt);
     } else if (ch == 4) {  // Ctrl+D: EOF
         return -1;
     } else if (ch == 11) {  // Ctrl+K: kill to end of line
-        input->buffer[input->cursor] = '\0';
-        input->length = input->cursor;
+        gap_buffer_delete_forward(&input->text,
+                                  gap_buffer_length(&input->text) - gap_buffer_cursor(&input->text));
         input_redraw(tui, prompt);
     } else if (ch == 21) {  // Ctrl+U: kill to beginning of line
-        if (input->cursor > 0) {
-            memmove(input->buffer,
-                    &input->buffer[input->cursor],
-                    (size_t)(input->length - input->cursor + 1));
-            input->length -= input->cursor;
-            input->cursor = 0;
+        if (gap_buffer_delete_backward(&input->text, gap_buffer_cursor(&input->text)) > 0) {
             input_redraw(tui, prompt);
         }
     } else if (ch == 12) {  // Ctrl+L: clear input
-        input->buffer[0] = '\0';
-        input->length = 0;
-        input->cursor = 0;
+        gap_buffer_clear(&input->text);
         input->paste_mode = 0;  // Reset paste mode
         input->rapid_input_count = 0;
         input_redraw(tui, prompt);
@@ -2174,54 +2539,36 @@ int tui_process_input_char(TUIState *tui, int ch, const char *prompt) {
             input_redraw(tui, prompt);
         }
     } else if (ch == KEY_LEFT) {  // Left arrow
-        if (input->cursor > 0) {
-            input->cursor--;
+        int cursor = gap_buffer_cursor(&input->text);
+        if (cursor > 0) {
+            gap_buffer_set_cursor(&input->text, cursor - 1);
             input_redraw(tui, prompt);
         }
     } else if (ch == KEY_RIGHT) {  // Right arrow
-        if (input->cursor < input->length) {
-            input->cursor++;
+        int cursor = gap_buffer_cursor(&input->text);
+        if (cursor < gap_buffer_length(&input->text)) {
+            gap_buffer_set_cursor(&input->text, cursor + 1);
             input_redraw(tui, prompt);
         }
     } else if (ch == KEY_HOME) {  // Home
-        input->cursor = 0;
+        gap_buffer_set_cursor(&input->text, 0);
         input_redraw(tui, prompt);
     } else if (ch == KEY_END) {  // End
-        input->cursor = input->length;
+        gap_buffer_set_cursor(&input->text, gap_buffer_length(&input->text));
         input_redraw(tui, prompt);
     } else if (ch == 16) {  // Ctrl+P: previous input history
         if (tui->input_history_count > 0) {
             if (tui->input_history_pos == -1) {
                 free(tui->input_saved_before_history);
-                tui->input_saved_before_history = strdup(tui->input_buffer->buffer);
+                const char *current = gap_buffer_text(&input->text);
+                tui->input_saved_before_history = strdup(current ? current : "");
                 tui->input_history_pos = tui->input_history_count;  // one past last
             }
             if (tui->input_history_pos > 0) {
                 tui->input_history_pos--;
                 const char *hist = tui->input_history[tui->input_history_pos];
                 if (hist) {
-                    size_t len = strlen(hist);
-
-                    // Dynamically resize input buffer if history entry is too large
-                    if (len >= (size_t)tui->input_buffer->capacity) {
-                        size_t new_capacity = len + 1024;  // Add some extra space
-                        void *buf_ptr = (void *)tui->input_buffer->buffer;
-                        if (buffer_reserve(&buf_ptr, &tui->input_buffer->capacity, new_capacity) == 0) {
-                            tui->input_buffer->buffer = (char *)buf_ptr;
-                            LOG_DEBUG("[TUI] Expanded input buffer to %zu bytes for history entry", new_capacity);
-                        } else {
-                            // If resize fails, truncate to current capacity
-                            LOG_WARN("[TUI] Failed to expand input buffer, truncating history entry");
-                            len = (size_t)tui->input_buffer->capacity - 1;
-                        }
-                    }
-
-                    memcpy(tui->input_buffer->buffer, hist, len);
-                    tui->input_buffer->buffer[len] = '\0';
-                    tui->input_buffer->length = (int)len;
-                    tui->input_buffer->cursor = (int)len;
-                    tui->input_buffer->view_offset = 0;
-                    tui->input_buffer->line_scroll_offset = 0;
+                    input_set_text(input, hist);
                     input_redraw(tui, prompt);
                 }
             }
@@ -2232,55 +2579,13 @@ int tui_process_input_char(TUIState *tui, int ch, const char *prompt) {
             if (tui->input_history_pos >= tui->input_history_count) {
                 // restore saved input
                 const char *saved = tui->input_saved_before_history ? tui->input_saved_before_history : "";
-                size_t len = strlen(saved);
-
-                // Dynamically resize input buffer if saved input is too large
-                if (len >= (size_t)tui->input_buffer->capacity) {
-                    size_t new_capacity = len + 1024;  // Add some extra space
-                    void *buf_ptr = (void *)tui->input_buffer->buffer;
-                    if (buffer_reserve(&buf_ptr, &tui->input_buffer->capacity, new_capacity) == 0) {
-                        tui->input_buffer->buffer = (char *)buf_ptr;
-                        LOG_DEBUG("[TUI] Expanded input buffer to %zu bytes for saved input", new_capacity);
-                    } else {
-                        // If resize fails, truncate to current capacity
-                        LOG_WARN("[TUI] Failed to expand input buffer, truncating saved input");
-                        len = (size_t)tui->input_buffer->capacity - 1;
-                    }
-                }
-
-                memcpy(tui->input_buffer->buffer, saved, len);
-                tui->input_buffer->buffer[len] = '\0';
-                tui->input_buffer->length = (int)len;
-                tui->input_buffer->cursor = (int)len;
-                tui->input_buffer->view_offset = 0;
-                tui->input_buffer->line_scroll_offset = 0;
+                input_set_text(input, saved);
                 tui->input_history_pos = -1;
                 input_redraw(tui, prompt);
             } else {
                 const char *hist = tui->input_history[tui->input_history_pos];
                 if (hist) {
-                    size_t len = strlen(hist);
-
-                    // Dynamically resize input buffer if history entry is too large
-                    if (len >= (size_t)tui->input_buffer->capacity) {
-                        size_t new_capacity = len + 1024;  // Add some extra space
-                        void *buf_ptr = (void *)tui->input_buffer->buffer;
-                        if (buffer_reserve(&buf_ptr, &tui->input_buffer->capacity, new_capacity) == 0) {
-                            tui->input_buffer->buffer = (char *)buf_ptr;
-                            LOG_DEBUG("[TUI] Expanded input buffer to %zu bytes for history entry", new_capacity);
-                        } else {
-                            // If resize fails, truncate to current capacity
-                            LOG_WARN("[TUI] Failed to expand input buffer, truncating history entry");
-                            len = (size_t)tui->input_buffer->capacity - 1;
-                        }
-                    }
-
-                    memcpy(tui->input_buffer->buffer, hist, len);
-                    tui->input_buffer->buffer[len] = '\0';
-                    tui->input_buffer->length = (int)len;
-                    tui->input_buffer->cursor = (int)len;
-                    tui->input_buffer->view_offset = 0;
-                    tui->input_buffer->line_scroll_offset = 0;
+                    input_set_text(input, hist);
                     input_redraw(tui, prompt);
                 }
             }
@@ -2374,7 +2679,7 @@ int tui_process_input_char(TUIState *tui, int ch, const char *prompt) {
             if (ch1 == '2' && ch2 == '0' && ch3 == '0' && ch4 == '~') {
                 // Bracketed paste start
                 input->paste_mode = 1;
-                input->paste_start_pos = input->cursor;
+                input->paste_start_pos = gap_buffer_cursor(&input->text);
                 input->paste_content_len = 0;
                 // Allocate paste buffer if not already allocated
                 if (!input->paste_content) {
@@ -2407,10 +2712,12 @@ int tui_process_input_char(TUIState *tui, int ch, const char *prompt) {
 
         // Handle Alt key combinations
         if (next_ch == 'b' || next_ch == 'B') {  // Alt+b: backward word
-            input->cursor = move_backward_word(input->buffer, input->cursor);
+            gap_buffer_set_cursor(&input->text,
+                                  move_backward_word(&input->text, gap_buffer_cursor(&input->text)));
             input_redraw(tui, prompt);
         } else if (next_ch == 'f' || next_ch == 'F') {  // Alt+f: forward word
-            input->cursor = move_forward_word(input->buffer, input->cursor, input->length);
+            gap_buffer_set_cursor(&input->text,
+                                  move_forward_word(&input->text, gap_buffer_cursor(&input->text)));
             input_redraw(tui, prompt);
         } else if (next_ch == 'd' || next_ch == 'D') {  // Alt+d: delete next word
             if (input_delete_word_forward(input) > 0) {
@@ -2443,16 +2750,22 @@ int tui_process_input_char(TUIState *tui, int ch, const char *prompt) {
 }
 
 const char* tui_get_input_buffer(TUIState *tui) {
-    if (!tui || !tui->input_buffer || tui->input_buffer->length == 0) {
+    if (!tui || !tui->input_buffer || gap_buffer_length(&tui->input_buffer->text) == 0) {
         return NULL;
     }
 
     TUIInputBuffer *input = tui->input_buffer;
+    const char *buffer = gap_buffer_text(&input->text);
+    int length = gap_buffer_length(&input->text);
+    if (!buffer) {
+        LOG_ERROR("[TUI] Failed to allocate input text");
+        return NULL;
+    }
 
     // If there's no paste content, return buffer as-is
     if (!input->paste_content || input->paste_content_len == 0 ||
         input->paste_placeholder_len == 0) {
-        return input->buffer;
+        return buffer;
     }
 
     // We have paste content that needs to be reconstructed
@@ -2463,12 +2776,12 @@ const char* tui_get_input_buffer(TUIState *tui) {
     size_t before_len = (size_t)input->paste_start_pos;
     size_t after_start = (size_t)(input->paste_start_pos + input->paste_placeholder_len);
     size_t after_len = 0;
-    if (after_start <= (size_t)input->length) {
-        after_len = (size_t)input->length - after_start;
+    if (after_start <= (size_t)length) {
+        after_len = (size_t)length - after_start;
     } else {
         // Inconsistent indices; avoid underflow and return best-effort buffer
-        LOG_WARN("[TUI] Paste reconstruction index out of range (after_start=%zu, length=%d)", after_start, input->length);
-        after_start = (size_t)input->length;
+        LOG_WARN("[TUI] Paste reconstruction index out of range (after_start=%zu, length=%d)", after_start, length);
+        after_start = (size_t)length;
         after_len = 0;
     }
     size_t total_len = before_len + input->paste_content_len + after_len;
@@ -2483,7 +2796,7 @@ const char* tui_get_input_buffer(TUIState *tui) {
         char *new_buf = realloc(reconstructed, reconstructed_capacity);
         if (!new_buf) {
             LOG_ERROR("[TUI] Failed to allocate buffer for paste reconstruction");
-            return input->buffer;  // Fallback to placeholder version
+            return buffer;  // Fallback to placeholder version
         }
         reconstructed = new_buf;
     }
@@ -2491,7 +2804,7 @@ const char* tui_get_input_buffer(TUIState *tui) {
     // Reconstruct: before + paste_content + after
     char *dest = reconstructed;
     if (before_len > 0) {
-        memcpy(dest, input->buffer, before_len);
+        memcpy(dest, buffer, before_len);
         dest += before_len;
     }
     if (input->paste_content_len > 0) {
@@ -2499,7 +2812,7 @@ const char* tui_get_input_buffer(TUIState *tui) {
         dest += input->paste_content_len;
     }
     if (after_len > 0) {
-        memcpy(dest, &input->buffer[after_start], after_len);
+        memcpy(dest, &buffer[after_start], after_len);
         dest += after_len;
     }
     *dest = '\0';
@@ -2515,9 +2828,7 @@ void tui_clear_input_buffer(TUIState *tui) {
         return;
     }
 
-    tui->input_buffer->buffer[0] = '\0';
-    tui->input_buffer->length = 0;
-    tui->input_buffer->cursor = 0;
+    gap_buffer_clear(&tui->input_buffer->text);
     tui->input_buffer->view_offset = 0;
     tui->input_buffer->line_scroll_offset = 0;
     tui->input_buffer->paste_mode = 0;  // Reset paste mode on clear
@@ -2671,34 +2982,115 @@ static void dispatch_tui_message(TUIState *tui, TUIMessage *msg) {
     }
 }
 
+static int is_conversation_line(const TUIMessage *msg) {
+    return msg->type == TUI_MSG_ADD_LINE || msg->type == TUI_MSG_ERROR;
+}
+
+// Apply queued messages. The urgent lane (status, errors, token counts) is
+// emptied first, so those never wait behind bulk output. Then up to
+// max_messages bulk messages are applied; a run of consecutive conversation
+// lines counts as one message (up to TUI_MAX_LINES_PER_FRAME lines) and is
+// drawn with a single screen update, so a large diff lands in one frame.
+// *more is set if the budget ran out before the queue did.
 static int process_tui_messages(TUIState *tui,
                                 TUIMessageQueue *msg_queue,
-                                int max_messages) {
+                                int max_messages,
+                                int *more) {
+    if (more) {
+        *more = 0;
+    }
     if (!tui || !msg_queue || max_messages <= 0) {
         return 0;
     }
 
     int processed = 0;
+    int urgent = 0;
+    int units = 0;
+    int lines = 0;
+    int in_line_run = 0;
     TUIMessage msg = {0};
+    TraceSpan span;
+    trace_span_begin(&span, "tui_dispatch", "tui");
+    tui_begin_conversation_batch(tui);
 
-    while (processed < max_messages) {
-        int rc = poll_tui_message(msg_queue, &msg);
+    // Bounded by the lane size so a flood of status updates cannot stall input
+    while (urgent < TUI_MSG_URGENT_CAPACITY &&
+           poll_tui_message_lane(msg_queue, TUI_PRIORITY_URGENT, &msg) == 1) {
+        dispatch_tui_message(tui, &msg);
+        tui_message_release(&msg);
+        urgent++;
+        processed++;
+    }
+
+    // Once the budget is spent an open run of lines may still continue; the
+    // queue cannot be peeked, so a message ending the run is applied too
+    int empty = 0;
+    while (lines < TUI_MAX_LINES_PER_FRAME && (units < max_messages || in_line_run)) {
+        int rc = poll_tui_message_lane(msg_queue, TUI_PRIORITY_BULK, &msg);
         if (rc <= 0) {
             if (rc < 0) {
                 LOG_WARN("[TUI] Failed to poll message queue");
             }
+            empty = 1;
             break;
         }
 
+        if (is_conversation_line(&msg)) {
+            if (!in_line_run) {
+                units++;
+            }
+            in_line_run = 1;
+            lines++;
+        } else {
+            units++;
+            in_line_run = 0;
+        }
+
         dispatch_tui_message(tui, &msg);
-        free(msg.text);
-        msg.text = NULL;
+        tui_message_release(&msg);
         processed++;
     }
 
+    tui_end_conversation_batch(tui);
+    if (more) {
+        // An empty poll can still race a post that is being published
+        *more = !empty || tui_msg_queue_pending(msg_queue);
+    }
+
+    // Idle polls are not interesting; only record batches that did work
+    if (processed > 0) {
+        trace_span_end(&span, "\"messages\":%d,\"urgent\":%d,\"lines\":%d",
+                       processed, urgent, lines);
+    }
+
     return processed;
 }
 
+// Milliseconds until check_paste_timeout() would end heuristic paste mode,
+// or -1 if not pasting
+static int paste_timeout_remaining_ms(TUIState *tui) {
+    if (!tui || !tui->input_buffer) {
+        return -1;
+    }
+    TUIInputBuffer *input = tui->input_buffer;
+    if (!input->paste_mode || input->rapid_input_count == 0) {
+        return -1;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long elapsed_ms = (now.tv_sec - input->last_input_time.tv_sec) * 1000 +
+                      (now.tv_nsec - input->last_input_time.tv_nsec) / 1000000;
+    long remaining = g_paste_timeout_ms - elapsed_ms + 1;
+    return remaining > 0 ? (int)remaining : 0;
+}
+
+static int min_timeout_ms(int a, int b) {
+    if (a < 0) return b;
+    if (b < 0) return a;
+    return a < b ? a : b;
+}
+
 int tui_event_loop(TUIState *tui, const char *prompt,
                    InputSubmitCallback submit_callback,
                    InterruptCallback interrupt_callback,
@@ -2711,7 +3103,18 @@ int tui_event_loop(TUIState *tui, const char *prompt,
 
     TUIMessageQueue *msg_queue = (TUIMessageQueue *)msg_queue_ptr;
     int running = 1;
-    const long frame_time_us = 16667;  // ~60 FPS (1/60 second in microseconds)
+
+    // The loop sleeps in poll() until input, a queued message, a resize or a
+    // spinner tick arrives; nothing is drawn while idle. Queued messages are
+    // applied at most once per frame so bursts of output coalesce.
+    TUIEvents events;
+    if (tui_events_init(&events, STDIN_FILENO, tui_msg_queue_wakeup_fd(msg_queue)) != 0) {
+        LOG_ERROR("[TUI] Failed to set up event sources");
+        return -1;
+    }
+    int input_pending = 1;          // ncurses may still hold buffered input
+    int messages_pending = msg_queue != NULL;
+    uint64_t last_flush_ns = 0;
 
     // Clear input buffer at start
     tui_clear_input_buffer(tui);
@@ -2722,11 +3125,30 @@ int tui_event_loop(TUIState *tui, const char *prompt,
     tui_redraw_input(tui, prompt);
 
     while (running) {
-        struct timespec frame_start;
-        clock_gettime(CLOCK_MONOTONIC, &frame_start);
+        // Work out how long we may sleep
+        int timeout_ms = -1;
+        if (input_pending) {
+            timeout_ms = 0;
+        }
+        if (messages_pending) {
+            uint64_t now = monotonic_time_ns();
+            uint64_t due = last_flush_ns + TUI_FRAME_NS;
+            timeout_ms = min_timeout_ms(timeout_ms,
+                                        due > now ? (int)((due - now + 999999) / 1000000) : 0);
+        }
+        timeout_ms = min_timeout_ms(timeout_ms, paste_timeout_remaining_ms(tui));
+
+        int spinner_visible = tui->status_spinner_active && tui->status_visible;
+        tui_events_set_timer(&events, spinner_visible ? status_spinner_interval_ns() : 0);
+
+        int ready = tui_events_wait(&events, timeout_ms);
+        if (ready < 0) {
+            LOG_ERROR("[TUI] Waiting for events failed, exiting event loop");
+            break;
+        }
 
         // 1. Check for resize
-        if (g_resize_flag) {
+        if ((ready & TUI_EVENT_RESIZE) || g_resize_flag) {
             g_resize_flag = 0;
             tui_handle_resize(tui);
 
@@ -2745,124 +3167,130 @@ int tui_event_loop(TUIState *tui, const char *prompt,
         // 2. Check for paste timeout (even when no input arrives)
         check_paste_timeout(tui, prompt);
 
-        // 3. Poll for input (non-blocking)
+        // 3. Read input (non-blocking)
         // If in paste mode, drain all available input quickly
-        int chars_processed = 0;
-        // Drain more than 1 char per frame to avoid artificial delays/lag on quick typing
-        int max_chars_per_frame = (tui->input_buffer && tui->input_buffer->paste_mode) ? 10000 : 32;
-
-        while (chars_processed < max_chars_per_frame) {
-            int ch = tui_poll_input(tui);
-            if (ch == ERR) {
-                break;  // No more input available
-            }
+        if ((ready & TUI_EVENT_INPUT) || input_pending) {
+            int chars_processed = 0;
+            // Drain more than 1 char per pass to avoid artificial delays/lag on quick typing
+            int max_chars_per_frame = (tui->input_buffer && tui->input_buffer->paste_mode) ? 10000 : 32;
+
+            input_pending = 1;
+            while (chars_processed < max_chars_per_frame) {
+                int ch = tui_poll_input(tui);
+                if (ch == ERR) {
+                    input_pending = 0;
+                    break;  // No more input available
+                }
 
-            chars_processed++;
+                chars_processed++;
 
-            int result = tui_process_input_char(tui, ch, prompt);
+                int result = tui_process_input_char(tui, ch, prompt);
 
-            // Notify about keypress (after processing, and only for normal input)
-            // Skip for Ctrl+C (result==2) since interrupt callback handles that
-            if (keypress_callback && result == 0) {
-                keypress_callback(user_data);
-            }
-            if (result == 1) {
-                // Enter pressed - submit input
-                const char *input = tui_get_input_buffer(tui);
-                if (input && strlen(input) > 0) {
-                    LOG_DEBUG("[TUI] Submitting input (%zu bytes)", strlen(input));
-                    // Save to persistent history (keep DB open)
-                    // Append to in-memory history with simple de-dup of last entry
-                    if (tui->history_file) {
-                        history_file_append(tui->history_file, input);
-                    }
-                    if (tui->input_history_count == 0 ||
-                        strcmp(tui->input_history[tui->input_history_count - 1], input) != 0) {
-                        // Ensure capacity
-                        if (tui->input_history_count >= tui->input_history_capacity) {
-                            int new_cap = tui->input_history_capacity > 0 ? tui->input_history_capacity * 2 : 100;
-                            char **new_arr = realloc(tui->input_history, (size_t)new_cap * sizeof(char*));
-                            if (new_arr) {
-                                tui->input_history = new_arr;
-                                tui->input_history_capacity = new_cap;
+                // Notify about keypress (after processing, and only for normal input)
+                // Skip for Ctrl+C (result==2) since interrupt callback handles that
+                if (keypress_callback && result == 0) {
+                    keypress_callback(user_data);
+                }
+                if (result == 1) {
+                    // Enter pressed - submit input
+                    const char *input = tui_get_input_buffer(tui);
+                    if (input && strlen(input) > 0) {
+                        LOG_DEBUG("[TUI] Submitting input (%zu bytes)", strlen(input));
+                        // Save to persistent history (keep DB open)
+                        // Append to in-memory history with simple de-dup of last entry
+                        if (tui->history_file) {
+                            history_file_append(tui->history_file, input);
+                        }
+                        if (tui->input_history_count == 0 ||
+                            strcmp(tui->input_history[tui->input_history_count - 1], input) != 0) {
+                            // Ensure capacity
+                            if (tui->input_history_count >= tui->input_history_capacity) {
+                                int new_cap = tui->input_history_capacity > 0 ? tui->input_history_capacity * 2 : 100;
+                                char **new_arr = realloc(tui->input_history, (size_t)new_cap * sizeof(char*));
+                                if (new_arr) {
+                                    tui->input_history = new_arr;
+                                    tui->input_history_capacity = new_cap;
+                                }
+                            }
+                            if (tui->input_history_count < tui->input_history_capacity) {
+                                tui->input_history[tui->input_history_count++] = strdup(input);
                             }
                         }
-                        if (tui->input_history_count < tui->input_history_capacity) {
-                            tui->input_history[tui->input_history_count++] = strdup(input);
+                        // Reset history navigation state after submit
+                        free(tui->input_saved_before_history);
+                        tui->input_saved_before_history = NULL;
+                        tui->input_history_pos = -1;
+                        // Call the callback
+                        int callback_result = submit_callback(input, user_data);
+
+                        // Clear input buffer after submission
+                        tui_clear_input_buffer(tui);
+                        tui_redraw_input(tui, prompt);
+
+                        // Check if callback wants to exit
+                        if (callback_result != 0) {
+                            LOG_DEBUG("[TUI] Callback requested exit (code=%d)", callback_result);
+                            running = 0;
                         }
                     }
-                    // Reset history navigation state after submit
-                    free(tui->input_saved_before_history);
-                    tui->input_saved_before_history = NULL;
-                    tui->input_history_pos = -1;
-                    // Call the callback
-                    int callback_result = submit_callback(input, user_data);
-
-                    // Clear input buffer after submission
-                    tui_clear_input_buffer(tui);
-                    tui_redraw_input(tui, prompt);
-
-                    // Check if callback wants to exit
-                    if (callback_result != 0) {
-                        LOG_DEBUG("[TUI] Callback requested exit (code=%d)", callback_result);
-                        running = 0;
+                    break;  // Stop processing after submission
+                } else if (result == 2) {
+                    // Ctrl+C pressed - interrupt requested
+                    LOG_DEBUG("[TUI] Interrupt requested (Ctrl+C)");
+                    if (interrupt_callback) {
+                        int interrupt_result = interrupt_callback(user_data);
+                        if (interrupt_result != 0) {
+                            LOG_DEBUG("[TUI] Interrupt callback requested exit (code=%d)", interrupt_result);
+                            running = 0;
+                        }
                     }
+                    // Stay in INSERT mode after interrupt (user can press Esc/Ctrl+[ to enter NORMAL mode if desired)
+                    break;  // Stop processing after interrupt
+                } else if (result == -1) {
+                    // EOF/quit signal
+                    LOG_DEBUG("[TUI] Input processing returned EOF/quit");
+                    running = 0;
+                    break;
                 }
-                break;  // Stop processing after submission
-            } else if (result == 2) {
-                // Ctrl+C pressed - interrupt requested
-                LOG_DEBUG("[TUI] Interrupt requested (Ctrl+C)");
-                if (interrupt_callback) {
-                    int interrupt_result = interrupt_callback(user_data);
-                    if (interrupt_result != 0) {
-                        LOG_DEBUG("[TUI] Interrupt callback requested exit (code=%d)", interrupt_result);
-                        running = 0;
-                    }
+
+                // If not in paste mode anymore, stop draining; the next pass
+                // picks up the remaining input without sleeping
+                if (tui->input_buffer && !tui->input_buffer->paste_mode) {
+                    break;
                 }
-                // Stay in INSERT mode after interrupt (user can press Esc/Ctrl+[ to enter NORMAL mode if desired)
-                break;  // Stop processing after interrupt
-            } else if (result == -1) {
-                // EOF/quit signal
-                LOG_DEBUG("[TUI] Input processing returned EOF/quit");
-                running = 0;
-                break;
             }
 
-            // If not in paste mode anymore, stop draining and process one char per frame
-            if (tui->input_buffer && !tui->input_buffer->paste_mode) {
-                break;
+            if (chars_processed > 1) {
+                LOG_DEBUG("[TUI] Fast-drained %d characters in paste mode", chars_processed);
             }
         }
 
-        if (chars_processed > 1) {
-            LOG_DEBUG("[TUI] Fast-drained %d characters in paste mode", chars_processed);
-        }
-
-        // 4. Process TUI message queue (if provided)
-        if (msg_queue) {
-            int messages_processed = process_tui_messages(tui, msg_queue, TUI_MAX_MESSAGES_PER_FRAME);
-            if (messages_processed > 0) {
-                LOG_DEBUG("[TUI] Processed %d queued message(s)", messages_processed);
-                tui_redraw_input(tui, prompt);
+        // 4. Apply queued messages, at most once per frame
+        if (ready & TUI_EVENT_MESSAGE) {
+            messages_pending = 1;
+        }
+        if (running && messages_pending) {
+            uint64_t now = monotonic_time_ns();
+            if (now - last_flush_ns >= TUI_FRAME_NS) {
+                int messages_processed = process_tui_messages(tui, msg_queue, TUI_MAX_MESSAGES_PER_FRAME,
+                                                              &messages_pending);
+                last_flush_ns = now;
+                // The wakeup fd only fires again once the queue is empty, so
+                // messages_pending keeps the loop going until then
+                if (messages_processed > 0) {
+                    LOG_DEBUG("[TUI] Processed %d queued message(s)", messages_processed);
+                    tui_redraw_input(tui, prompt);
+                }
             }
         }
 
-        // Update spinner animation if active
-        status_spinner_tick(tui);
-
-        // 5. Sleep to maintain frame rate
-        struct timespec frame_end;
-        clock_gettime(CLOCK_MONOTONIC, &frame_end);
-
-        long elapsed_ns = (frame_end.tv_sec - frame_start.tv_sec) * 1000000000L +
-                         (frame_end.tv_nsec - frame_start.tv_nsec);
-        long elapsed_us = elapsed_ns / 1000;
-
-        if (elapsed_us < frame_time_us) {
-            usleep((useconds_t)(frame_time_us - elapsed_us));
-      }
+        // 5. Update spinner animation if active
+        if (ready & TUI_EVENT_TIMER) {
+            status_spinner_tick(tui);
+        }
     }
 
+    tui_events_free(&events);
     return 0;
 }
 
@@ -2875,7 +3303,7 @@ void tui_drain_message_queue(TUIState *tui, const char *prompt, void *msg_queue_
     int processed = 0;
 
     do {
-        processed = process_tui_messages(tui, msg_queue, TUI_MAX_MESSAGES_PER_FRAME);
+        processed = process_tui_messages(tui, msg_queue, TUI_MAX_MESSAGES_PER_FRAME, NULL);
         if (processed > 0) {
             if (prompt) {
                 tui_redraw_input(tui, prompt);
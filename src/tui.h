@@ -15,6 +15,9 @@
 #include "todo.h"
 #include "window_manager.h"
 #include "history_file.h"
+#include "wrap_index.h"
+#include "search_index.h"
+#include "spill_file.h"
 
 // Forward declaration for WINDOW type (not actually used, kept for compatibility)
 typedef struct _win_st WINDOW;
@@ -39,15 +42,22 @@ typedef enum {
 // Conversation message entry
 typedef struct {
     char *prefix;            // Role prefix (e.g., "[User]", "[Assistant]")
-    char *text;              // Message text
+    char *text;              // Message text (NULL once spilled)
+    size_t text_len;         // strlen(text)
+    int spilled;             // Text lives in TUIState.spill at spill_offset
+    size_t spill_offset;
     TUIColorPair color_pair; // Color for display
+    int line_start;          // First wrapped line at TUIState.layout_width
+    int line_count;          // Wrapped lines at TUIState.layout_width
+    int line_stale;          // line_count is an estimate until the entry is in view
+    WrapIndex wrap;          // Row layout cached for recent widths
 } ConversationEntry;
 
 // TUI Mode (Vim-like)
 typedef enum {
     TUI_MODE_NORMAL,   // Normal mode (vim-like navigation, default for conversation viewing)
     TUI_MODE_INSERT,   // Insert mode (text input for sending messages)
-    TUI_MODE_COMMAND   // Command mode (entered with ':' from normal mode)
+    TUI_MODE_COMMAND   // Command mode (entered with ':' or '/' from normal mode)
 } TUIMode;
 
 // TUI State
@@ -58,10 +68,22 @@ typedef struct {
     // Input buffer state
     TUIInputBuffer *input_buffer;
 
-    // Conversation entries (source of truth used to rebuild pad on resize)
+    // Conversation entries (source of truth; only the visible lines are drawn)
     ConversationEntry *entries;
     int entries_count;
     int entries_capacity;
+    int layout_width;        // Width the entry line index was computed for
+    int stale_entries;       // Entries with line_stale set
+    int conversation_batch;  // > 0 while appended lines wait for one redraw
+    int conversation_dirty;  // Lines were appended during the batch
+
+    // Entry text above resident_text_limit is moved to the spill file,
+    // oldest first, skipping entries near the viewport
+    SpillFile spill;
+    size_t resident_text_bytes;   // Text of entries that are not spilled
+    size_t resident_text_limit;
+    int spill_next;          // Entries before this are spilled or too small to spill
+    int spill_failed;        // Spill file unusable; keep everything in memory
 
     // Status state
     char *status_message;    // Current status text (owned by TUI)
@@ -78,10 +100,17 @@ typedef struct {
     // Modes
     TUIMode mode;            // Current input mode (NORMAL, INSERT, or COMMAND)
     int normal_mode_last_key; // Previous key in normal mode (for gg, G combos)
-    char *command_buffer;    // Buffer for command mode input (starts with ':')
+    char *command_buffer;    // Buffer for command mode input (starts with ':' or '/')
     int command_buffer_len;  // Length of command buffer
     int command_buffer_capacity; // Capacity of command buffer
 
+    // Conversation search ('/' in normal mode)
+    SearchIndex search_index;     // Trigram index of entry text, keyed by entry index
+    SearchMatches search_matches; // Matches of search_pattern, in entry order
+    char *search_pattern;         // Last pattern searched for (NULL = none)
+    int search_current;           // Current match in search_matches (-1 = none)
+    int search_saved_scroll;      // Scroll offset to restore if the prompt is cancelled
+
     int is_initialized;      // Whether TUI has been set up
 
     // Persistent input history (memory + DB)
@@ -106,6 +135,11 @@ void tui_cleanup(TUIState *tui);
 // color_pair: Color pair to use for the message
 void tui_add_conversation_line(TUIState *tui, const char *prefix, const char *text, TUIColorPair color_pair);
 
+// Defer drawing of lines added until the matching tui_end_conversation_batch(),
+// then show them with one screen update. Batches nest.
+void tui_begin_conversation_batch(TUIState *tui);
+void tui_end_conversation_batch(TUIState *tui);
+
 // Update the status line
 void tui_update_status(TUIState *tui, const char *status_text);
 
@@ -0,0 +1,228 @@
+/**
+ * tui_events.c - Event sources the TUI main loop blocks on
+ */
+
+#include "tui_events.h"
+#include "logger.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#endif
+
+// Write end of the resize self-pipe, read by the signal handler
+static volatile sig_atomic_t g_resize_write_fd = -1;
+static int g_resize_pipe[2] = {-1, -1};
+#ifdef __linux__
+static int g_resize_blocked = 0;
+#endif
+
+static uint64_t events_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int set_nonblock_cloexec(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        return -1;
+    }
+    return fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+// Read until the fd would block; works for pipes, eventfd, signalfd and timerfd
+static void drain_fd(int fd) {
+    char buf[256];
+    while (read(fd, buf, sizeof(buf)) > 0) {
+    }
+}
+
+void tui_events_capture_resize(void) {
+#if defined(__linux__) && defined(SIGWINCH)
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGWINCH);
+    if (pthread_sigmask(SIG_BLOCK, &mask, NULL) == 0) {
+        g_resize_blocked = 1;
+    } else {
+        LOG_WARN("[TUI] Failed to block SIGWINCH, using the signal handler");
+    }
+#endif
+}
+
+void tui_events_notify_resize(void) {
+    int fd = g_resize_write_fd;
+    if (fd >= 0) {
+        int saved_errno = errno;
+        char byte = 1;
+        ssize_t rc = write(fd, &byte, 1);  // A full pipe already means "resized"
+        (void)rc;
+        errno = saved_errno;
+    }
+}
+
+static int open_resize_fd(void) {
+#if defined(__linux__) && defined(SIGWINCH)
+    if (g_resize_blocked) {
+        sigset_t mask;
+        sigemptyset(&mask);
+        sigaddset(&mask, SIGWINCH);
+        int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (fd >= 0) {
+            return fd;
+        }
+        // Let the handler see the signal again
+        LOG_WARN("[TUI] signalfd failed (%s), using the signal handler", strerror(errno));
+        pthread_sigmask(SIG_UNBLOCK, &mask, NULL);
+        g_resize_blocked = 0;
+    }
+#endif
+    if (g_resize_pipe[0] < 0) {
+        if (pipe(g_resize_pipe) != 0) {
+            return -1;
+        }
+        if (set_nonblock_cloexec(g_resize_pipe[0]) != 0 ||
+            set_nonblock_cloexec(g_resize_pipe[1]) != 0) {
+            close(g_resize_pipe[0]);
+            close(g_resize_pipe[1]);
+            g_resize_pipe[0] = g_resize_pipe[1] = -1;
+            return -1;
+        }
+        g_resize_write_fd = g_resize_pipe[1];
+    }
+    return g_resize_pipe[0];
+}
+
+int tui_events_init(TUIEvents *events, int input_fd, int queue_fd) {
+    if (!events) {
+        return -1;
+    }
+    memset(events, 0, sizeof(*events));
+    events->input_fd = input_fd;
+    events->queue_fd = queue_fd;
+    events->timer_fd = -1;
+
+    events->resize_fd = open_resize_fd();
+    if (events->resize_fd < 0) {
+        LOG_WARN("[TUI] No resize event source; resizes are picked up on the next event");
+    }
+
+#ifdef __linux__
+    events->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (events->timer_fd < 0) {
+        LOG_DEBUG("[TUI] timerfd unavailable, timing the spinner with the poll timeout");
+    }
+#endif
+    return 0;
+}
+
+void tui_events_set_timer(TUIEvents *events, uint64_t interval_ns) {
+    if (!events || events->timer_interval_ns == interval_ns) {
+        return;
+    }
+    events->timer_interval_ns = interval_ns;
+    events->timer_deadline_ns = interval_ns ? events_now_ns() + interval_ns : 0;
+
+#ifdef __linux__
+    if (events->timer_fd >= 0) {
+        struct itimerspec spec;
+        memset(&spec, 0, sizeof(spec));
+        spec.it_interval.tv_sec = (time_t)(interval_ns / 1000000000ULL);
+        spec.it_interval.tv_nsec = (long)(interval_ns % 1000000000ULL);
+        spec.it_value = spec.it_interval;
+        if (timerfd_settime(events->timer_fd, 0, &spec, NULL) != 0) {
+            LOG_WARN("[TUI] timerfd_settime failed: %s", strerror(errno));
+        }
+        drain_fd(events->timer_fd);
+    }
+#endif
+}
+
+int tui_events_wait(TUIEvents *events, int timeout_ms) {
+    if (!events) {
+        return -1;
+    }
+
+    struct pollfd fds[4];
+    int kinds[4];
+    nfds_t nfds = 0;
+    const int sources[4][2] = {
+        {events->input_fd, TUI_EVENT_INPUT},
+        {events->queue_fd, TUI_EVENT_MESSAGE},
+        {events->resize_fd, TUI_EVENT_RESIZE},
+        {events->timer_fd, TUI_EVENT_TIMER},
+    };
+    for (int i = 0; i < 4; i++) {
+        if (sources[i][0] >= 0) {
+            fds[nfds].fd = sources[i][0];
+            fds[nfds].events = POLLIN;
+            fds[nfds].revents = 0;
+            kinds[nfds] = sources[i][1];
+            nfds++;
+        }
+    }
+
+    // Without a timerfd the timer is just a deadline for the poll timeout
+    int soft_timer = events->timer_fd < 0 && events->timer_interval_ns > 0;
+    if (soft_timer) {
+        uint64_t now = events_now_ns();
+        uint64_t wait_ns = events->timer_deadline_ns > now ? events->timer_deadline_ns - now : 0;
+        int timer_ms = (int)((wait_ns + 999999) / 1000000);
+        if (timeout_ms < 0 || timer_ms < timeout_ms) {
+            timeout_ms = timer_ms;
+        }
+    }
+
+    int rc = poll(fds, nfds, timeout_ms);
+    if (rc < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    int ready = 0;
+    for (nfds_t i = 0; rc > 0 && i < nfds; i++) {
+        short revents = fds[i].revents;
+        if (!revents) {
+            continue;
+        }
+        if (kinds[i] == TUI_EVENT_INPUT) {
+            if (revents & (POLLHUP | POLLNVAL)) {
+                // Terminal went away: stop polling it so the loop cannot spin
+                LOG_WARN("[TUI] Terminal input closed");
+                events->input_fd = -1;
+            }
+        } else {
+            drain_fd(fds[i].fd);
+        }
+        ready |= kinds[i];
+    }
+
+    if (soft_timer && events_now_ns() >= events->timer_deadline_ns) {
+        ready |= TUI_EVENT_TIMER;
+        events->timer_deadline_ns = events_now_ns() + events->timer_interval_ns;
+    }
+    return ready;
+}
+
+void tui_events_free(TUIEvents *events) {
+    if (!events) {
+        return;
+    }
+    // The resize pipe is process-wide and stays open for the signal handler
+    if (events->resize_fd >= 0 && events->resize_fd != g_resize_pipe[0]) {
+        close(events->resize_fd);
+    }
+    if (events->timer_fd >= 0) {
+        close(events->timer_fd);
+    }
+    events->resize_fd = -1;
+    events->timer_fd = -1;
+}
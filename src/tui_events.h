@@ -0,0 +1,73 @@
+/**
+ * tui_events.h - Event sources the TUI main loop blocks on
+ *
+ * The event loop sleeps in a single poll() until one of these is ready:
+ * - terminal input (stdin)
+ * - the TUI message queue's wakeup fd (written by post_tui_message)
+ * - SIGWINCH (a signalfd on Linux, a self-pipe written by the signal
+ *   handler elsewhere)
+ * - the spinner timer (a timerfd on Linux, the poll timeout elsewhere)
+ *
+ * Nothing runs while the terminal is idle, so an idle session costs no CPU.
+ */
+
+#ifndef TUI_EVENTS_H
+#define TUI_EVENTS_H
+
+#include <stdint.h>
+
+// Bits returned by tui_events_wait()
+#define TUI_EVENT_INPUT   0x01
+#define TUI_EVENT_MESSAGE 0x02
+#define TUI_EVENT_RESIZE  0x04
+#define TUI_EVENT_TIMER   0x08
+
+typedef struct {
+    int input_fd;               // Terminal input, -1 if none
+    int queue_fd;               // Message queue wakeup fd, -1 if none
+    int resize_fd;              // signalfd or read end of the resize pipe
+    int timer_fd;               // timerfd, -1 if unavailable
+    uint64_t timer_interval_ns; // 0 = timer disarmed
+    uint64_t timer_deadline_ns; // Next expiry when there is no timerfd
+} TUIEvents;
+
+/**
+ * Route SIGWINCH to the event loop. On Linux the signal is blocked in the
+ * calling thread and read through a signalfd; call this from the main
+ * thread before any worker threads start so they inherit the mask.
+ * Elsewhere the installed handler must call tui_events_notify_resize().
+ */
+void tui_events_capture_resize(void);
+
+/**
+ * Wake the event loop for a resize. Async-signal-safe; used by the
+ * SIGWINCH handler where no signalfd is available.
+ */
+void tui_events_notify_resize(void);
+
+/**
+ * Set up the event sources. input_fd / queue_fd may be -1.
+ * Returns 0 on success, -1 on error.
+ */
+int tui_events_init(TUIEvents *events, int input_fd, int queue_fd);
+
+/**
+ * Arm a periodic timer (interval_ns > 0) or disarm it (0). Re-arming with
+ * the current interval is a no-op so the phase is kept.
+ */
+void tui_events_set_timer(TUIEvents *events, uint64_t interval_ns);
+
+/**
+ * Block until an event is ready or timeout_ms passes (-1 = no timeout).
+ * Resize, timer and queue wakeups are consumed; input is left for the
+ * caller to read. Returns a mask of TUI_EVENT_* bits (0 on timeout or
+ * interruption), or -1 on error.
+ */
+int tui_events_wait(TUIEvents *events, int timeout_ms);
+
+/**
+ * Close the fds owned by the event set
+ */
+void tui_events_free(TUIEvents *events);
+
+#endif // TUI_EVENTS_H
@@ -16,7 +16,7 @@ const WindowManagerConfig DEFAULT_WINDOW_CONFIG = {
     .status_height = 1,
     // No gap between status and input by default
     .padding = 0,
-    .initial_pad_capacity = 1000
+    .render_margin = 50
 };
 
 // ============================================================================
@@ -84,35 +84,95 @@ static void clear_gap_between_status_and_input(WindowManager *wm) {
     }
 }
 
-// Copy content from old pad to new pad (for capacity expansion)
-static int copy_pad_content(WINDOW *old_pad, WINDOW *new_pad,
-                           int lines_to_copy, int width) {
-    if (!old_pad || !new_pad || lines_to_copy <= 0 || width <= 0) {
-        return 0;
+// Pad height needed for the current viewport plus margins
+static int conv_pad_rows(const WindowManager *wm) {
+    int margin = wm->config.render_margin > 0 ? wm->config.render_margin : 0;
+    int rows = wm->conv_viewport_height + 2 * margin;
+    return rows > 0 ? rows : 1;
+}
+
+// (Re)create the conversation pad at the current size. Content is not
+// copied; the pad is redrawn from the renderer on the next refresh.
+static int create_conv_pad(WindowManager *wm) {
+    int rows = conv_pad_rows(wm);
+    int cols = wm->screen_width > 0 ? wm->screen_width : 1;
+    WINDOW *pad = newpad(rows, cols);
+    if (!pad) {
+        return -1;
     }
+    // Rows are addressed explicitly; writing the bottom-right cell must not
+    // scroll the pad
+    scrollok(pad, FALSE);
 
-    // Get actual dimensions of both pads to avoid out-of-bounds access
-    int old_h, old_w, new_h, new_w;
-    getmaxyx(old_pad, old_h, old_w);
-    getmaxyx(new_pad, new_h, new_w);
+    if (wm->conv_pad) {
+        delwin(wm->conv_pad);
+    }
+    wm->conv_pad = pad;
+    wm->conv_pad_capacity = rows;
+    wm->conv_pad_first_line = 0;
+    wm->conv_pad_valid = 0;
+    return 0;
+}
 
-    // Clamp copy dimensions to actual pad sizes
-    if (lines_to_copy > old_h) lines_to_copy = old_h;
-    if (lines_to_copy > new_h) lines_to_copy = new_h;
-    if (width > old_w) width = old_w;
-    if (width > new_w) width = new_w;
+// Draw content lines [from, to) into the pad at their current pad rows
+static void render_conv_lines(WindowManager *wm, int from, int to) {
+    if (!wm->conv_render) {
+        return;
+    }
+    int pad_end = wm->conv_pad_first_line + wm->conv_pad_capacity;
+    if (from < wm->conv_pad_first_line) from = wm->conv_pad_first_line;
+    if (to > pad_end) to = pad_end;
+    if (to > wm->conv_pad_content_lines) to = wm->conv_pad_content_lines;
+    if (from >= to) {
+        return;
+    }
+    wm->conv_render(wm->conv_render_ctx, wm->conv_pad, from,
+                    from - wm->conv_pad_first_line, to - from);
+}
 
-    LOG_DEBUG("[WM] Copying %d lines from old pad to new pad (width=%d, old=%dx%d, new=%dx%d)",
-              lines_to_copy, width, old_w, old_h, new_w, new_h);
+static void clamp_scroll(WindowManager *wm) {
+    int max_scroll = wm->conv_pad_content_lines - wm->conv_viewport_height;
+    if (max_scroll < 0) max_scroll = 0;
 
-    for (int y = 0; y < lines_to_copy; y++) {
-        for (int x = 0; x < width; x++) {
-            chtype ch = mvwinch(old_pad, y, x);
-            mvwaddch(new_pad, y, x, ch);
+    if (wm->conv_scroll_offset < 0) {
+        wm->conv_scroll_offset = 0;
+    } else if (wm->conv_scroll_offset > max_scroll) {
+        wm->conv_scroll_offset = max_scroll;
+    }
+}
+
+// Make sure the pad holds the lines under the viewport, redrawing it around
+// the viewport (with render_margin lines of slack on both sides) if not
+static void cover_viewport(WindowManager *wm) {
+    int top = wm->conv_scroll_offset;
+    int bottom = top + wm->conv_viewport_height;
+    if (wm->conv_pad_valid && top >= wm->conv_pad_first_line &&
+        bottom <= wm->conv_pad_first_line + wm->conv_pad_capacity) {
+        return;
+    }
+
+    int first = top - wm->config.render_margin;
+    if (first < 0) first = 0;
+
+    // Settling the layout can move the viewport onto other lines; settle
+    // again around where it lands (a few rounds at most in practice)
+    for (int round = 0; wm->conv_layout && round < 4; round++) {
+        if (!wm->conv_layout(wm->conv_render_ctx, first, first + wm->conv_pad_capacity)) {
+            break;
         }
+        clamp_scroll(wm);
+        top = wm->conv_scroll_offset;
+        first = top - wm->config.render_margin;
+        if (first < 0) first = 0;
     }
 
-    return 0;
+    werase(wm->conv_pad);
+    wm->conv_pad_first_line = first;
+    wm->conv_pad_valid = 1;
+    render_conv_lines(wm, first, first + wm->conv_pad_capacity);
+
+    LOG_DEBUG("[WM] Rendered conversation lines %d-%d (scroll=%d, content=%d)",
+              first, first + wm->conv_pad_capacity, top, wm->conv_pad_content_lines);
 }
 
 // ============================================================================
@@ -148,17 +208,14 @@ int window_manager_init(WindowManager *wm, const WindowManagerConfig *config) {
              wm->screen_width, wm->screen_height);
 
     // Create conversation pad
-    wm->conv_pad_capacity = wm->config.initial_pad_capacity;
-    wm->conv_pad = newpad(wm->conv_pad_capacity, wm->screen_width);
-    if (!wm->conv_pad) {
+    if (create_conv_pad(wm) != 0) {
         LOG_ERROR("[WM] Failed to create conversation pad");
         return -1;
     }
-    scrollok(wm->conv_pad, TRUE);
     wm->conv_pad_content_lines = 0;
     wm->conv_scroll_offset = 0;
 
-    LOG_DEBUG("[WM] Created conversation pad (capacity=%d, width=%d)",
+    LOG_DEBUG("[WM] Created conversation pad (rows=%d, width=%d)",
               wm->conv_pad_capacity, wm->screen_width);
 
     // Create status window (if enabled)
@@ -253,42 +310,16 @@ int window_manager_resize_screen(WindowManager *wm) {
     // Recalculate layout
     calculate_layout(wm);
 
-    // Save current content for restoration
-    int old_content_lines = wm->conv_pad_content_lines;
     int old_scroll_offset = wm->conv_scroll_offset;
-    int old_capacity = wm->conv_pad_capacity;
 
-    // Recreate conversation pad with new width
-    WINDOW *old_pad = wm->conv_pad;
-    wm->conv_pad = newpad(wm->conv_pad_capacity, wm->screen_width);
-    if (!wm->conv_pad) {
+    // Recreate conversation pad for the new geometry. Nothing is copied: the
+    // visible lines are redrawn from the renderer on the next refresh.
+    if (create_conv_pad(wm) != 0) {
         LOG_ERROR("[WM] Failed to recreate conversation pad");
-        wm->conv_pad = old_pad;  // Restore old pad
         return -1;
     }
-    scrollok(wm->conv_pad, TRUE);
-
-    // Copy content from old pad (but content will be re-rendered by caller)
-    // We just need to preserve the pad structure
-    // Be very defensive about bounds: don't copy more than either pad can hold
-    int lines_to_copy = old_content_lines;
-    if (lines_to_copy > old_capacity) lines_to_copy = old_capacity;
-    if (lines_to_copy > wm->conv_pad_capacity) lines_to_copy = wm->conv_pad_capacity;
-
-    int width_to_copy = old_width < wm->screen_width ? old_width : wm->screen_width;
-
-    // Additional safety: verify old_pad is still valid before copying
-    if (old_pad && lines_to_copy > 0 && width_to_copy > 0) {
-        copy_pad_content(old_pad, wm->conv_pad, lines_to_copy, width_to_copy);
-    }
 
-    // Delete old pad after copy is complete
-    if (old_pad) {
-        delwin(old_pad);
-        old_pad = NULL;
-    }
-
-    LOG_DEBUG("[WM] Recreated conversation pad (capacity=%d, width=%d)",
+    LOG_DEBUG("[WM] Recreated conversation pad (rows=%d, width=%d)",
               wm->conv_pad_capacity, wm->screen_width);
 
     // Recreate status window (if enabled)
@@ -339,46 +370,29 @@ int window_manager_resize_screen(WindowManager *wm) {
     return 0;
 }
 
-int window_manager_ensure_pad_capacity(WindowManager *wm, int needed_lines) {
-    if (!wm || !wm->is_initialized) {
-        LOG_ERROR("[WM] Cannot expand pad on uninitialized window manager");
-        return -1;
-    }
-
-    // Already have enough capacity?
-    if (needed_lines <= wm->conv_pad_capacity) {
-        return 0;
+void window_manager_set_conversation_renderer(WindowManager *wm,
+                                              ConversationRenderFn render, void *ctx) {
+    if (!wm) {
+        return;
     }
+    wm->conv_render = render;
+    wm->conv_render_ctx = ctx;
+    wm->conv_pad_valid = 0;
+}
 
-    // Calculate new capacity (double until it fits)
-    int new_capacity = wm->conv_pad_capacity;
-    while (new_capacity < needed_lines) {
-        new_capacity *= 2;
+void window_manager_set_conversation_layout(WindowManager *wm, ConversationLayoutFn layout) {
+    if (!wm) {
+        return;
     }
+    wm->conv_layout = layout;
+    wm->conv_pad_valid = 0;
+}
 
-    LOG_INFO("[WM] Expanding pad capacity from %d to %d lines",
-             wm->conv_pad_capacity, new_capacity);
-
-    // Create new larger pad
-    WINDOW *new_pad = newpad(new_capacity, wm->screen_width);
-    if (!new_pad) {
-        LOG_ERROR("[WM] Failed to create expanded pad");
-        return -1;
+void window_manager_invalidate_conversation(WindowManager *wm) {
+    if (!wm) {
+        return;
     }
-    scrollok(new_pad, TRUE);
-
-    // Copy existing content
-    copy_pad_content(wm->conv_pad, new_pad,
-                    wm->conv_pad_content_lines, wm->screen_width);
-
-    // Replace old pad
-    delwin(wm->conv_pad);
-    wm->conv_pad = new_pad;
-    wm->conv_pad_capacity = new_capacity;
-
-    LOG_DEBUG("[WM] Pad expansion complete (new_capacity=%d)", new_capacity);
-
-    return 0;
+    wm->conv_pad_valid = 0;
 }
 
 int window_manager_resize_input(WindowManager *wm, int desired_content_lines) {
@@ -435,6 +449,12 @@ int window_manager_resize_input(WindowManager *wm, int desired_content_lines) {
     }
     keypad(wm->input_win, TRUE);
 
+    // A taller viewport needs a taller pad; a shorter one still fits
+    if (conv_pad_rows(wm) > wm->conv_pad_capacity && create_conv_pad(wm) != 0) {
+        LOG_ERROR("[WM] Failed to grow conversation pad for new viewport");
+        return -1;
+    }
+
     // Adjust scroll offset if viewport changed
     int max_scroll = wm->conv_pad_content_lines - wm->conv_viewport_height;
     if (max_scroll < 0) max_scroll = 0;
@@ -452,7 +472,7 @@ int window_manager_resize_input(WindowManager *wm, int desired_content_lines) {
 // Refresh Operations
 // ============================================================================
 
-void window_manager_refresh_conversation(WindowManager *wm) {
+void window_manager_stage_conversation(WindowManager *wm) {
     if (!wm || !wm->is_initialized || !wm->conv_pad) {
         return;
     }
@@ -462,25 +482,28 @@ void window_manager_refresh_conversation(WindowManager *wm) {
     }
 
     // Clamp scroll offset to valid range
-    int max_scroll = wm->conv_pad_content_lines - wm->conv_viewport_height;
-    if (max_scroll < 0) max_scroll = 0;
+    clamp_scroll(wm);
 
-    if (wm->conv_scroll_offset < 0) {
-        wm->conv_scroll_offset = 0;
-    } else if (wm->conv_scroll_offset > max_scroll) {
-        wm->conv_scroll_offset = max_scroll;
-    }
+    cover_viewport(wm);
 
-    // Refresh pad viewport
-    // prefresh(pad, pad_y, pad_x, screen_y1, screen_x1, screen_y2, screen_x2)
+    // Stage pad viewport
+    // pnoutrefresh(pad, pad_y, pad_x, screen_y1, screen_x1, screen_y2, screen_x2)
     int y2 = wm->conv_viewport_height - 1;
     int x2 = wm->screen_width - 1;
     if (y2 < 0) y2 = 0;
     if (x2 < 0) x2 = 0;
-    prefresh(wm->conv_pad,
-             wm->conv_scroll_offset, 0,  // pad position
-             0, 0,                        // screen top-left
-             y2, x2);                     // screen bottom-right
+    pnoutrefresh(wm->conv_pad,
+                 wm->conv_scroll_offset - wm->conv_pad_first_line, 0,  // pad position
+                 0, 0,                        // screen top-left
+                 y2, x2);                     // screen bottom-right
+}
+
+void window_manager_refresh_conversation(WindowManager *wm) {
+    if (!wm || !wm->is_initialized || !wm->conv_pad) {
+        return;
+    }
+    window_manager_stage_conversation(wm);
+    doupdate();
 }
 
 void window_manager_refresh_status(WindowManager *wm) {
@@ -594,7 +617,15 @@ void window_manager_set_content_lines(WindowManager *wm, int lines) {
         return;
     }
 
+    int old_lines = wm->conv_pad_content_lines;
     wm->conv_pad_content_lines = lines;
+    if (lines < old_lines) {
+        wm->conv_pad_valid = 0;
+    } else if (lines > old_lines && wm->conv_pad_valid) {
+        // Appended lines that land inside the pad are drawn now; the rest
+        // are drawn when the viewport moves onto them
+        render_conv_lines(wm, old_lines, lines);
+    }
     LOG_DEBUG("[WM] Content lines set to %d", lines);
 }
 
@@ -642,9 +673,9 @@ int window_manager_validate(WindowManager *wm) {
                 wm->conv_viewport_height, wm->screen_height);
     }
 
-    if (wm->conv_pad_content_lines > wm->conv_pad_capacity) {
-        LOG_WARN("[WM] VALIDATION: content_lines=%d exceeds capacity=%d",
-                wm->conv_pad_content_lines, wm->conv_pad_capacity);
+    if (wm->conv_pad_capacity < wm->conv_viewport_height) {
+        LOG_WARN("[WM] VALIDATION: pad rows=%d smaller than viewport=%d",
+                wm->conv_pad_capacity, wm->conv_viewport_height);
     }
 
     if (wm->conv_scroll_offset < 0) {
@@ -675,11 +706,11 @@ void window_manager_get_status(WindowManager *wm, char *buffer, size_t buffer_si
     }
 
     snprintf(buffer, buffer_size,
-             "[WM] screen=%dx%d, conv_viewport=%d, content=%d/%d, scroll=%d/%d, "
+             "[WM] screen=%dx%d, conv_viewport=%d, content=%d, pad=%d@%d, scroll=%d/%d, "
              "status=%d, input=%d",
              wm->screen_width, wm->screen_height,
              wm->conv_viewport_height,
-             wm->conv_pad_content_lines, wm->conv_pad_capacity,
+             wm->conv_pad_content_lines, wm->conv_pad_capacity, wm->conv_pad_first_line,
              wm->conv_scroll_offset, window_manager_get_max_scroll(wm),
              wm->status_height, wm->input_height);
 }
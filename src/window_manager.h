@@ -3,7 +3,7 @@
  *
  * This module provides robust window management for the TUI, including:
  * - Window creation, destruction, and resizing
- * - Pad management with automatic capacity expansion
+ * - Virtualized conversation viewport (only visible lines are drawn)
  * - Scroll offset management
  * - Layout calculations
  * - Defensive validation
@@ -24,21 +24,40 @@ typedef struct {
     int max_input_height;     // Maximum input window height
     int status_height;        // Status window height (0 to disable)
     int padding;              // Padding between windows
-    int initial_pad_capacity; // Initial pad capacity (lines)
+    int render_margin;        // Lines drawn beyond each edge of the viewport
 } WindowManagerConfig;
 
+// Conversation renderer supplied by the owner of the content.
+// Draws content lines [first_line, first_line + count) into pad rows starting
+// at pad_row. The rows are blank on entry.
+typedef void (*ConversationRenderFn)(void *ctx, WINDOW *pad, int first_line,
+                                     int pad_row, int count);
+
+// Called with the renderer's ctx before the pad is redrawn over content
+// lines [first_line, last_line), so the owner can settle the layout of those
+// lines first. It may change the content line count and the scroll offset.
+// Returns nonzero if it moved any lines.
+typedef int (*ConversationLayoutFn)(void *ctx, int first_line, int last_line);
+
 // Window manager state
 typedef struct {
     // Screen dimensions
     int screen_width;
     int screen_height;
 
-    // Conversation pad (virtual scrollable window)
+    // Conversation pad: a fixed-size window onto the content. It holds the
+    // viewport plus render_margin lines on either side and is redrawn through
+    // conv_render when the viewport scrolls out of it.
     WINDOW *conv_pad;
-    int conv_pad_capacity;      // Total pad height (allocated)
-    int conv_pad_content_lines; // Actual content lines (used)
+    int conv_pad_capacity;      // Pad height (viewport + 2 * render_margin)
+    int conv_pad_first_line;    // Content line drawn in pad row 0
+    int conv_pad_valid;         // Pad rows reflect current content
+    int conv_pad_content_lines; // Total content lines
     int conv_viewport_height;   // Visible area height
     int conv_scroll_offset;     // Current scroll position (0 = top)
+    ConversationRenderFn conv_render;
+    ConversationLayoutFn conv_layout;
+    void *conv_render_ctx;
 
     // Status window
     WINDOW *status_win;
@@ -77,10 +96,16 @@ void window_manager_destroy(WindowManager *wm);
 // Returns: 0 on success, -1 on failure
 int window_manager_resize_screen(WindowManager *wm);
 
-// Ensure conversation pad has at least the specified capacity
-// Automatically expands pad and copies content if needed
-// Returns: 0 on success, -1 on failure
-int window_manager_ensure_pad_capacity(WindowManager *wm, int needed_lines);
+// Set the callback that draws conversation content into the pad
+void window_manager_set_conversation_renderer(WindowManager *wm,
+                                              ConversationRenderFn render, void *ctx);
+
+// Set the callback that settles the layout of lines about to be drawn
+void window_manager_set_conversation_layout(WindowManager *wm, ConversationLayoutFn layout);
+
+// Mark the pad stale (content was relaid out or removed); the next refresh
+// redraws the visible range
+void window_manager_invalidate_conversation(WindowManager *wm);
 
 // Resize input window to accommodate the specified number of content lines
 // Automatically adjusts conversation viewport height
@@ -94,6 +119,11 @@ int window_manager_resize_input(WindowManager *wm, int desired_content_lines);
 // Refresh conversation pad viewport (must be called after content changes)
 void window_manager_refresh_conversation(WindowManager *wm);
 
+// Like window_manager_refresh_conversation() but only stages the viewport
+// (pnoutrefresh); the caller updates the terminal with doupdate() after
+// staging other windows, so several changes reach the screen in one write
+void window_manager_stage_conversation(WindowManager *wm);
+
 // Refresh status window (must be called after status changes)
 void window_manager_refresh_status(WindowManager *wm);
 
@@ -128,6 +158,8 @@ int window_manager_get_max_scroll(WindowManager *wm);
 // ============================================================================
 
 // Update content line count (call after adding/removing content)
+// Growing the count draws the new lines if they fall inside the pad;
+// shrinking it invalidates the pad
 void window_manager_set_content_lines(WindowManager *wm, int lines);
 
 // Get current content line count
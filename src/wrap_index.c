@@ -0,0 +1,328 @@
+/**
+ * wrap_index.c - Width-cached line-wrap index for conversation text
+ */
+
+#define _XOPEN_SOURCE 600
+#include "wrap_index.h"
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+// Wide and fullwidth blocks (Unicode East Asian Width W/F), used when the
+// C library cannot classify a code point (non-UTF-8 locale)
+static const uint32_t g_wide_ranges[][2] = {
+    {0x1100, 0x115F}, {0x2E80, 0x303E}, {0x3041, 0x33FF}, {0x3400, 0x4DBF},
+    {0x4E00, 0x9FFF}, {0xA000, 0xA4CF}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF},
+    {0xFE30, 0xFE4F}, {0xFF00, 0xFF60}, {0xFFE0, 0xFFE6}, {0x1F300, 0x1F64F},
+    {0x1F900, 0x1F9FF}, {0x20000, 0x2FFFD}, {0x30000, 0x3FFFD},
+};
+
+// Combining marks and zero-width characters, same fallback use
+static const uint32_t g_zero_ranges[][2] = {
+    {0x0300, 0x036F}, {0x200B, 0x200F}, {0x20D0, 0x20FF}, {0xFE00, 0xFE0F},
+    {0xFE20, 0xFE2F},
+};
+
+static int in_ranges(uint32_t cp, const uint32_t (*ranges)[2], size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (cp >= ranges[i][0] && cp <= ranges[i][1]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int wrap_codepoint_width(uint32_t cp) {
+    if (cp < 0x20 || (cp >= 0x7F && cp < 0xA0)) {
+        return -1;
+    }
+    // Prefer the C library so the layout agrees with what ncurses draws
+    int w = wcwidth((wchar_t)cp);
+    if (w >= 0) {
+        return w;
+    }
+    if (in_ranges(cp, g_wide_ranges, sizeof(g_wide_ranges) / sizeof(g_wide_ranges[0]))) {
+        return 2;
+    }
+    if (in_ranges(cp, g_zero_ranges, sizeof(g_zero_ranges) / sizeof(g_zero_ranges[0]))) {
+        return 0;
+    }
+    return 1;
+}
+
+// Decode one UTF-8 sequence. Returns its length, or 0 if it is malformed.
+static int utf8_decode(const unsigned char *s, uint32_t *cp) {
+    unsigned char c = s[0];
+    int len;
+    uint32_t v;
+
+    if (c < 0x80) {
+        *cp = c;
+        return 1;
+    } else if ((c & 0xE0) == 0xC0) {
+        len = 2;
+        v = c & 0x1Fu;
+    } else if ((c & 0xF0) == 0xE0) {
+        len = 3;
+        v = c & 0x0Fu;
+    } else if ((c & 0xF8) == 0xF0) {
+        len = 4;
+        v = c & 0x07u;
+    } else {
+        return 0;
+    }
+
+    for (int i = 1; i < len; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            return 0;  // Also stops at the terminating NUL
+        }
+        v = (v << 6) | (s[i] & 0x3Fu);
+    }
+    if ((len == 2 && v < 0x80) || (len == 3 && v < 0x800) || (len == 4 && v < 0x10000) ||
+        v > 0x10FFFF || (v >= 0xD800 && v <= 0xDFFF)) {
+        return 0;
+    }
+    *cp = v;
+    return len;
+}
+
+// ============================================================================
+// Layout walk
+// ============================================================================
+
+typedef struct {
+    int width;
+    int row;
+    int col;
+    // Counting: row starts are recorded into layout
+    WrapLayout *layout;
+    int checkpoint_capacity;
+    // Drawing: glyphs on rows [first_row, last_row) go to emit
+    WrapEmitFn emit;
+    void *ctx;
+    int first_row;
+    int last_row;
+} WrapWalk;
+
+static void record_checkpoint(WrapWalk *walk, int part, int offset) {
+    WrapLayout *layout = walk->layout;
+    if (!layout || walk->row % WRAP_INDEX_CHECKPOINT != 0) {
+        return;
+    }
+    int k = walk->row / WRAP_INDEX_CHECKPOINT - 1;
+    if (k != layout->ncheckpoints) {
+        return;  // An earlier allocation failed; draw walks further instead
+    }
+    if (k >= walk->checkpoint_capacity) {
+        int new_capacity = walk->checkpoint_capacity ? walk->checkpoint_capacity * 2 : 8;
+        WrapPos *grown = realloc(layout->checkpoints, (size_t)new_capacity * sizeof(WrapPos));
+        if (!grown) {
+            return;
+        }
+        layout->checkpoints = grown;
+        walk->checkpoint_capacity = new_capacity;
+    }
+    layout->checkpoints[k].part = part;
+    layout->checkpoints[k].offset = offset;
+    layout->ncheckpoints++;
+}
+
+// Start a new row whose first byte is at (part, offset).
+// Returns 1 if drawing is done.
+static int next_row(WrapWalk *walk, int part, int offset) {
+    walk->row++;
+    walk->col = 0;
+    if (walk->emit && walk->row >= walk->last_row) {
+        return 1;
+    }
+    record_checkpoint(walk, part, offset);
+    return 0;
+}
+
+// Walk the text from start, which must be the first byte of row walk->row.
+// Returns the number of rows when counting.
+static int wrap_walk(WrapWalk *walk, const WrapText *text, WrapPos start) {
+    int width = walk->width;
+
+    for (int part = start.part; part < text->nparts; part++) {
+        const char *s = text->parts[part];
+        if (!s) {
+            continue;
+        }
+        int off = part == start.part ? start.offset : 0;
+
+        while (s[off]) {
+            const unsigned char *p = (const unsigned char *)s + off;
+            const char *bytes = s + off;
+            char caret[2];
+            int len = 1;
+            int nbytes = 1;
+            int cells;
+
+            if (*p == '\n') {
+                off++;
+                if (next_row(walk, part, off)) {
+                    return walk->row;
+                }
+                continue;
+            } else if (*p == '\r') {
+                off++;
+                continue;
+            } else if (*p == '\t') {
+                if (walk->col >= width && next_row(walk, part, off)) {
+                    return walk->row;
+                }
+                cells = WRAP_TAB_WIDTH - (walk->col % WRAP_TAB_WIDTH);
+                if (walk->col + cells > width) {
+                    cells = width - walk->col;
+                }
+                bytes = NULL;
+                nbytes = 0;
+            } else if (*p < 0x20 || *p == 0x7F) {
+                // Shown as ^X, like ncurses does for control characters
+                caret[0] = '^';
+                caret[1] = (char)(*p ^ 0x40);
+                bytes = caret;
+                nbytes = 2;
+                cells = 2;
+            } else {
+                uint32_t cp;
+                len = utf8_decode(p, &cp);
+                cells = len > 0 ? wrap_codepoint_width(cp) : -1;
+                if (len == 0) {
+                    len = 1;
+                }
+                if (cells < 0) {
+                    bytes = "?";
+                    nbytes = 1;
+                    cells = 1;
+                } else {
+                    nbytes = len;
+                }
+            }
+
+            if (cells > width) {
+                cells = width;
+            }
+            if (cells > 0 && walk->col + cells > width && next_row(walk, part, off)) {
+                return walk->row;
+            }
+            if (walk->emit && walk->row >= walk->first_row) {
+                walk->emit(walk->ctx, part, off, walk->row, walk->col, bytes, nbytes, cells);
+            }
+            walk->col += cells;
+            off += len;
+        }
+    }
+    return walk->row + 1;
+}
+
+// ============================================================================
+// Cache
+// ============================================================================
+
+static void layout_clear(WrapLayout *layout) {
+    free(layout->checkpoints);
+    memset(layout, 0, sizeof(*layout));
+}
+
+static WrapLayout* get_layout(WrapIndex *index, const WrapText *text, int width) {
+    WrapLayout *victim = &index->slots[0];
+    index->clock++;
+
+    for (int i = 0; i < WRAP_INDEX_WIDTHS; i++) {
+        WrapLayout *slot = &index->slots[i];
+        if (slot->width == width) {
+            slot->last_used = index->clock;
+            return slot;
+        }
+        if (slot->width == 0 || (victim->width != 0 && slot->last_used < victim->last_used)) {
+            victim = slot;
+        }
+    }
+
+    // Miss: lay the text out once at this width, evicting the least
+    // recently used layout
+    layout_clear(victim);
+    victim->width = width;
+    victim->last_used = index->clock;
+
+    WrapWalk walk;
+    memset(&walk, 0, sizeof(walk));
+    walk.width = width;
+    walk.layout = victim;
+    WrapPos start = {0, 0};
+    victim->rows = wrap_walk(&walk, text, start);
+    return victim;
+}
+
+int wrap_index_rows(WrapIndex *index, const WrapText *text, int width) {
+    if (!index || !text) {
+        return 1;
+    }
+    if (width < 1) {
+        width = 1;
+    }
+    return get_layout(index, text, width)->rows;
+}
+
+int wrap_index_cached_rows(const WrapIndex *index, int width) {
+    if (!index) {
+        return -1;
+    }
+    for (int i = 0; i < WRAP_INDEX_WIDTHS; i++) {
+        if (index->slots[i].width == width) {
+            return index->slots[i].rows;
+        }
+    }
+    return -1;
+}
+
+void wrap_index_draw(WrapIndex *index, const WrapText *text, int width,
+                     int first_row, int max_rows, WrapEmitFn emit, void *ctx) {
+    if (!index || !text || !emit || max_rows <= 0) {
+        return;
+    }
+    if (width < 1) {
+        width = 1;
+    }
+    if (first_row < 0) {
+        first_row = 0;
+    }
+    WrapLayout *layout = get_layout(index, text, width);
+    if (first_row >= layout->rows) {
+        return;
+    }
+
+    WrapWalk walk;
+    memset(&walk, 0, sizeof(walk));
+    walk.width = width;
+    walk.emit = emit;
+    walk.ctx = ctx;
+    walk.first_row = first_row;
+    walk.last_row = first_row + max_rows;
+
+    WrapPos start = {0, 0};
+    int k = first_row / WRAP_INDEX_CHECKPOINT;
+    if (k > layout->ncheckpoints) {
+        k = layout->ncheckpoints;
+    }
+    if (k > 0) {
+        start = layout->checkpoints[k - 1];
+        walk.row = k * WRAP_INDEX_CHECKPOINT;
+    }
+    wrap_walk(&walk, text, start);
+}
+
+void wrap_index_reset(WrapIndex *index) {
+    if (!index) {
+        return;
+    }
+    for (int i = 0; i < WRAP_INDEX_WIDTHS; i++) {
+        layout_clear(&index->slots[i]);
+    }
+}
+
+void wrap_index_free(WrapIndex *index) {
+    wrap_index_reset(index);
+}
@@ -0,0 +1,99 @@
+/**
+ * wrap_index.h - Width-cached line-wrap index for conversation text
+ *
+ * Lays out UTF-8 text into rows of a given terminal width the same way the
+ * conversation view draws it: wide (East Asian) characters take two cells
+ * and never straddle the right edge, combining marks take none, tabs stop
+ * every 8 columns and control characters are shown as ^X.
+ *
+ * Each index remembers the layout for the last WRAP_INDEX_WIDTHS widths it
+ * was asked about. A layout stores the row count plus the start position of
+ * every WRAP_INDEX_CHECKPOINT'th row, so drawing rows [r, r + n) of a long
+ * entry only walks from the nearest checkpoint instead of from the start.
+ *
+ * Text is passed as a list of parts (e.g. prefix, separator, body) that are
+ * laid out as one stream; the draw callback reports which part each glyph
+ * came from so callers can style parts differently.
+ */
+
+#ifndef WRAP_INDEX_H
+#define WRAP_INDEX_H
+
+#include <stdint.h>
+
+#define WRAP_INDEX_WIDTHS 4         // Layouts cached per index (LRU)
+#define WRAP_INDEX_CHECKPOINT 16    // Rows between stored row starts
+#define WRAP_TEXT_MAX_PARTS 4
+#define WRAP_TAB_WIDTH 8
+
+typedef struct {
+    const char *parts[WRAP_TEXT_MAX_PARTS];
+    int nparts;
+} WrapText;
+
+typedef struct {
+    int part;                   // Index into WrapText.parts
+    int offset;                 // Byte offset within that part
+} WrapPos;
+
+typedef struct {
+    int width;                  // 0 = unused slot
+    int rows;
+    unsigned int last_used;     // LRU stamp
+    int ncheckpoints;
+    WrapPos *checkpoints;       // checkpoints[k] = start of row (k + 1) * WRAP_INDEX_CHECKPOINT
+} WrapLayout;
+
+typedef struct {
+    WrapLayout slots[WRAP_INDEX_WIDTHS];
+    unsigned int clock;
+} WrapIndex;
+
+/**
+ * Called for each glyph drawn by wrap_index_draw()
+ * part/offset: Source byte the glyph starts at, in text->parts[part]
+ * row/col: Row within the text and starting cell
+ * bytes/len: Bytes to draw, or NULL for `cells` blank cells (tabs). Not
+ *            always inside the text: control characters come as "^X" and
+ *            invalid UTF-8 as "?", so use offset to locate the glyph
+ * cells: Number of cells the glyph occupies (0 for combining marks)
+ */
+typedef void (*WrapEmitFn)(void *ctx, int part, int offset, int row, int col,
+                           const char *bytes, int len, int cells);
+
+/**
+ * Cells a code point occupies: 2 for wide/fullwidth, 0 for combining and
+ * zero-width characters, 1 otherwise, -1 if it is not printable
+ */
+int wrap_codepoint_width(uint32_t cp);
+
+/**
+ * Number of rows the text occupies at width (>= 1), computing and caching
+ * the layout on first use for that width
+ */
+int wrap_index_rows(WrapIndex *index, const WrapText *text, int width);
+
+/**
+ * Row count at width if a layout for it is cached, else -1. Does not touch
+ * the text or the LRU order.
+ */
+int wrap_index_cached_rows(const WrapIndex *index, int width);
+
+/**
+ * Draw rows [first_row, first_row + max_rows) of the text at width through
+ * emit. Only the rows from the nearest checkpoint onward are walked.
+ */
+void wrap_index_draw(WrapIndex *index, const WrapText *text, int width,
+                     int first_row, int max_rows, WrapEmitFn emit, void *ctx);
+
+/**
+ * Drop all cached layouts (call if the text changes)
+ */
+void wrap_index_reset(WrapIndex *index);
+
+/**
+ * Free memory held by the index (the struct itself is not freed)
+ */
+void wrap_index_free(WrapIndex *index);
+
+#endif // WRAP_INDEX_H
@@ -0,0 +1,223 @@
+/*
+ * Unit Tests for the per-turn arena allocator
+ *
+ * Tests the arena including:
+ * - Alignment and ownership of allocations
+ * - Growth past the first block
+ * - Reset reuses memory and coalesces blocks
+ * - cJSON trees built inside a push/pop scope come from the arena
+ * - arena_cjson_print() returns heap memory
+ * - Each thread gets its own turn arena
+ *
+ * Compilation: make test-arena
+ * Usage: ./test_arena
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <cjson/cJSON.h>
+
+#include "../src/arena.h"
+
+// Test framework colors
+#define COLOR_RESET "\033[0m"
+#define COLOR_GREEN "\033[32m"
+#define COLOR_RED "\033[31m"
+#define COLOR_CYAN "\033[36m"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void print_test_result(const char *test_name, int passed) {
+    tests_run++;
+    if (passed) {
+        tests_passed++;
+        printf(COLOR_GREEN "✓ PASS" COLOR_RESET " %s\n", test_name);
+    } else {
+        tests_failed++;
+        printf(COLOR_RED "✗ FAIL" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_summary(void) {
+    printf("\n" COLOR_CYAN "Test Summary:" COLOR_RESET "\n");
+    printf("Tests run: %d\n", tests_run);
+    printf(COLOR_GREEN "Tests passed: %d\n" COLOR_RESET, tests_passed);
+    if (tests_failed > 0) {
+        printf(COLOR_RED "Tests failed: %d\n" COLOR_RESET, tests_failed);
+    } else {
+        printf(COLOR_GREEN "All tests passed!\n" COLOR_RESET);
+    }
+}
+
+static void test_alloc_alignment(void) {
+    Arena *arena = arena_create(0);
+    int ok = arena != NULL;
+    for (size_t size = 1; ok && size < 100; size += 7) {
+        void *p = arena_alloc(arena, size);
+        ok = p && ((uintptr_t)p % _Alignof(max_align_t)) == 0 && arena_owns(arena, p);
+        if (ok) {
+            memset(p, 0xAB, size);
+        }
+    }
+    arena_destroy(arena);
+    print_test_result("Allocations are aligned and owned", ok);
+}
+
+static void test_strdup_and_ownership(void) {
+    Arena *arena = arena_create(0);
+    char *s = arena_strdup(arena, "hello arena");
+    char *heap = malloc(16);
+    int ok = s && strcmp(s, "hello arena") == 0 &&
+             arena_owns(arena, s) && !arena_owns(arena, heap) && !arena_owns(arena, NULL);
+    free(heap);
+    arena_destroy(arena);
+    print_test_result("arena_strdup copies and ownership excludes heap pointers", ok);
+}
+
+static void test_growth(void) {
+    Arena *arena = arena_create(1024);
+    void *first = arena_alloc(arena, 100);
+    void *big = arena_alloc(arena, 64 * 1024);
+    void *after = arena_alloc(arena, 100);
+    int ok = first && big && after &&
+             arena_owns(arena, first) && arena_owns(arena, big) && arena_owns(arena, after) &&
+             arena_bytes_used(arena) >= 64 * 1024 + 200;
+    if (big) {
+        memset(big, 0, 64 * 1024);
+    }
+    arena_destroy(arena);
+    print_test_result("Arena grows past its first block", ok);
+}
+
+static void test_reset_reuses_memory(void) {
+    Arena *arena = arena_create(4096);
+    void *a = arena_alloc(arena, 128);
+    arena_reset(arena);
+    void *b = arena_alloc(arena, 128);
+    int ok = a && a == b && arena_bytes_used(arena) == 128;
+    arena_destroy(arena);
+    print_test_result("Reset reuses the same block", ok);
+}
+
+static void test_reset_coalesces(void) {
+    Arena *arena = arena_create(1024);
+    for (int i = 0; i < 200; i++) {
+        arena_alloc(arena, 500);
+    }
+    size_t used = arena_bytes_used(arena);
+    arena_reset(arena);
+
+    // The whole previous turn now fits in the single retained block
+    void *first = arena_alloc(arena, 16);
+    int ok = used >= 100000 && first != NULL && arena_peak_bytes(arena) == used;
+    char *last = NULL;
+    for (int i = 1; i < 200; i++) {
+        last = arena_alloc(arena, 500);
+    }
+    // Same block: distance between first and last allocation is contiguous
+    ok = ok && last && (uintptr_t)last > (uintptr_t)first &&
+         (uintptr_t)last - (uintptr_t)first < used;
+    arena_destroy(arena);
+    print_test_result("Reset coalesces blocks into one sized for the turn", ok);
+}
+
+static void test_cjson_routing(void) {
+    Arena *arena = arena_create(0);
+    Arena *prev = arena_cjson_push(arena);
+
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddStringToObject(obj, "role", "user");
+    cJSON_AddNumberToObject(obj, "n", 42);
+    cJSON *parsed = cJSON_Parse("{\"a\":[1,2,3],\"b\":\"text\"}");
+    int ok = obj && parsed && arena_owns(arena, obj) && arena_owns(arena, obj->child) &&
+             arena_owns(arena, parsed);
+
+    char *json = arena_cjson_print(obj);
+    ok = ok && json && !arena_owns(arena, json) && strcmp(json, "{\"role\":\"user\",\"n\":42}") == 0;
+
+    char *in_arena = cJSON_PrintUnformatted(parsed);
+    ok = ok && in_arena && arena_owns(arena, in_arena);
+    cJSON_free(in_arena);
+
+    // Deleting arena trees is a no-op, heap trees are freed normally
+    cJSON_Delete(obj);
+    cJSON_Delete(parsed);
+    arena_cjson_pop(prev);
+
+    cJSON *heap_obj = cJSON_CreateObject();
+    ok = ok && heap_obj && !arena_owns(arena, heap_obj);
+    cJSON_Delete(heap_obj);
+
+    free(json);
+    arena_destroy(arena);
+    print_test_result("cJSON allocations follow the pushed arena", ok);
+}
+
+static void test_cjson_nested_heap_scope(void) {
+    Arena *arena = arena_create(0);
+    Arena *prev = arena_cjson_push(arena);
+
+    Arena *inner_prev = arena_cjson_push(NULL);
+    cJSON *persistent = cJSON_CreateString("kept");
+    arena_cjson_pop(inner_prev);
+
+    cJSON *transient = cJSON_CreateString("dropped");
+    int ok = persistent && transient &&
+             !arena_owns(arena, persistent) && arena_owns(arena, transient);
+    arena_cjson_pop(prev);
+
+    arena_destroy(arena);
+    ok = ok && strcmp(persistent->valuestring, "kept") == 0;
+    cJSON_Delete(persistent);
+    print_test_result("Pushing NULL routes allocations back to the heap", ok);
+}
+
+static void *turn_arena_thread(void *arg) {
+    Arena **out = arg;
+    *out = arena_turn();
+    arena_alloc(*out, 64);
+    arena_turn_reset();
+    return NULL;
+}
+
+static void test_turn_arena_per_thread(void) {
+    Arena *main_arena = arena_turn();
+    Arena *thread_arena = NULL;
+    pthread_t thread;
+    int ok = main_arena && main_arena == arena_turn();
+    if (pthread_create(&thread, NULL, turn_arena_thread, &thread_arena) == 0) {
+        pthread_join(thread, NULL);
+        ok = ok && thread_arena && thread_arena != main_arena;
+    } else {
+        ok = 0;
+    }
+
+    arena_alloc(main_arena, 100);
+    arena_turn_reset();
+    ok = ok && arena_bytes_used(main_arena) == 0;
+    print_test_result("Each thread has its own turn arena", ok);
+}
+
+int main(void) {
+    printf(COLOR_CYAN "Running Arena Allocator tests..." COLOR_RESET "\n\n");
+    arena_cjson_init();
+
+    test_alloc_alignment();
+    test_strdup_and_ownership();
+    test_growth();
+    test_reset_reuses_memory();
+    test_reset_coalesces();
+    test_cjson_routing();
+    test_cjson_nested_heap_scope();
+    test_turn_arena_per_thread();
+
+    print_summary();
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -8,6 +8,7 @@
  * - Invalid input handling
  * - Round-trip encoding/decoding
  * - Binary data handling
+ * - Decoding in place
  *
  * Compilation: make test-base64
  * Usage: ./test_base64
@@ -265,6 +266,34 @@ static void test_base64_binary_data(void) {
     print_test_result(test_name, passed);
 }
 
+static void test_base64_decode_in_place(void) {
+    const char *test_name = "test_base64_decode_in_place";
+
+    int passed = 1;
+    for (size_t len = 0; len <= 64 && passed; len++) {
+        unsigned char data[64];
+        for (size_t i = 0; i < len; i++) {
+            data[i] = (unsigned char)(i * 37 + 11);
+        }
+
+        size_t encoded_length;
+        char *encoded = base64_encode(data, len, &encoded_length);
+        if (!encoded) {
+            passed = 0;
+            break;
+        }
+
+        size_t decoded_length = base64_decode_in_place(encoded, encoded_length);
+        passed = decoded_length == len &&
+                 memcmp(encoded, data, len) == 0 &&
+                 encoded[len] == '\0';
+        free(encoded);
+    }
+
+    passed = passed && base64_decode_in_place(NULL, 4) == 0;
+    print_test_result(test_name, passed);
+}
+
 static void test_base64_null_parameters(void) {
     const char *test_name = "test_base64_null_parameters";
 
@@ -395,6 +424,7 @@ int main(void) {
     test_base64_decode_two_padding();
     test_base64_roundtrip();
     test_base64_binary_data();
+    test_base64_decode_in_place();
     test_base64_null_parameters();
     test_base64_invalid_characters();
     test_base64_length_calculation();
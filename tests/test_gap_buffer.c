@@ -0,0 +1,242 @@
+/*
+ * Unit Tests for the input gap buffer
+ *
+ * Tests the gap buffer and its visual-row index including:
+ * - Insert, delete and cursor movement across the gap
+ * - Growing past the initial capacity and replacing the text
+ * - Row count and cursor row/column against a full rescan of the text
+ * - Listing rows around the cursor, including after a width change
+ * - Random edits compared with a plain string model
+ *
+ * Compilation: make test-gap-buffer
+ * Usage: ./test_gap_buffer
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/gap_buffer.h"
+
+// Test framework colors
+#define COLOR_RESET "\033[0m"
+#define COLOR_GREEN "\033[32m"
+#define COLOR_RED "\033[31m"
+#define COLOR_CYAN "\033[36m"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void print_test_result(const char *test_name, int passed) {
+    tests_run++;
+    if (passed) {
+        tests_passed++;
+        printf(COLOR_GREEN "✓ PASS" COLOR_RESET " %s\n", test_name);
+    } else {
+        tests_failed++;
+        printf(COLOR_RED "✗ FAIL" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_summary(void) {
+    printf("\n" COLOR_CYAN "Test Summary:" COLOR_RESET "\n");
+    printf("Tests run: %d\n", tests_run);
+    printf(COLOR_GREEN "Tests passed: %d\n" COLOR_RESET, tests_passed);
+    if (tests_failed > 0) {
+        printf(COLOR_RED "Tests failed: %d\n" COLOR_RESET, tests_failed);
+    } else {
+        printf(COLOR_GREEN "All tests passed!\n" COLOR_RESET);
+    }
+}
+
+// Reference layout: the scan the input box used to do on every redraw.
+// Fills row_start[] (if given) and returns the row count; *cursor_row and
+// *cursor_col receive the position of byte offset `cursor`.
+static int scan_layout(const char *text, int len, int width, int cursor,
+                       int *cursor_row, int *cursor_col, int *row_start) {
+    int row = 0;
+    int col = 0;
+    if (row_start) row_start[0] = 0;
+    for (int i = 0; i <= len; i++) {
+        if (i == cursor) {
+            *cursor_row = row;
+            *cursor_col = col;
+        }
+        if (i == len) break;
+        if (text[i] == '\n' || ++col >= width) {
+            row++;
+            col = 0;
+            if (row_start) row_start[row] = i + 1;
+        }
+    }
+    return row + 1;
+}
+
+// Compare the buffer against the model string at width
+static int matches_model(GapBuffer *gb, const char *model, int cursor, int width) {
+    int len = (int)strlen(model);
+    if (gap_buffer_length(gb) != len || gap_buffer_cursor(gb) != cursor) {
+        return 0;
+    }
+    const char *text = gap_buffer_text(gb);
+    if (!text || strcmp(text, model) != 0) {
+        return 0;
+    }
+
+    int *row_start = malloc(((size_t)len + 2) * sizeof(int));
+    int want_row = 0, want_col = 0;
+    int want_rows = scan_layout(model, len, width, cursor, &want_row, &want_col, row_start);
+    int row = -1, col = -1;
+    gap_buffer_cursor_row(gb, width, &row, &col);
+    int ok = gap_buffer_rows(gb, width) == want_rows && row == want_row && col == want_col;
+
+    // Every row, listed starting from a few places
+    GapBufferRow rows[8];
+    for (int first = 0; ok && first < want_rows; first += 3) {
+        int n = gap_buffer_layout_rows(gb, width, first, rows, 8);
+        int expect = want_rows - first < 8 ? want_rows - first : 8;
+        ok = n == expect;
+        for (int k = 0; ok && k < n; k++) {
+            int r = first + k;
+            int end = r + 1 < want_rows ? row_start[r + 1] : len;
+            int has_newline = end > row_start[r] && model[end - 1] == '\n';
+            ok = rows[k].start == row_start[r] &&
+                 rows[k].len == end - row_start[r] - has_newline &&
+                 rows[k].newline == has_newline;
+        }
+    }
+    ok = ok && gap_buffer_layout_rows(gb, width, want_rows, rows, 8) == 0;
+    free(row_start);
+    return ok;
+}
+
+static void test_basic_editing(void) {
+    GapBuffer gb;
+    int ok = gap_buffer_init(&gb, 16) == 0;
+    ok = ok && gap_buffer_insert(&gb, "hello world", 11) == 0;
+    gap_buffer_set_cursor(&gb, 5);
+    ok = ok && gap_buffer_insert(&gb, ",", 1) == 0;
+    ok = ok && matches_model(&gb, "hello, world", 6, 80);
+
+    ok = ok && gap_buffer_delete_backward(&gb, 1) == 1;
+    ok = ok && gap_buffer_delete_forward(&gb, 1) == 1;
+    ok = ok && matches_model(&gb, "helloworld", 5, 80);
+    ok = ok && gap_buffer_at(&gb, 4) == 'o' && gap_buffer_at(&gb, 5) == 'w';
+
+    char copy[8] = {0};
+    gap_buffer_copy(&gb, 3, 4, copy);
+    ok = ok && strcmp(copy, "lowo") == 0;
+
+    // Deleting past either end stops at the end
+    gap_buffer_set_cursor(&gb, 2);
+    ok = ok && gap_buffer_delete_backward(&gb, 10) == 2;
+    ok = ok && gap_buffer_delete_forward(&gb, 100) == 8;
+    ok = ok && matches_model(&gb, "", 0, 80);
+    gap_buffer_free(&gb);
+    print_test_result("Insert, delete and cursor moves across the gap", ok);
+}
+
+static void test_growth_and_set_text(void) {
+    GapBuffer gb;
+    int ok = gap_buffer_init(&gb, 16) == 0;
+    char big[5000];
+    for (int i = 0; i < (int)sizeof(big) - 1; i++) {
+        big[i] = (char)((i % 50 == 49) ? '\n' : 'a' + i % 26);
+    }
+    big[sizeof(big) - 1] = '\0';
+    ok = ok && gap_buffer_insert(&gb, big, (int)strlen(big)) == 0;
+    ok = ok && matches_model(&gb, big, (int)strlen(big), 30);
+
+    ok = ok && gap_buffer_set_text(&gb, "one\ntwo", 7) == 0;
+    ok = ok && matches_model(&gb, "one\ntwo", 7, 30);
+    gap_buffer_clear(&gb);
+    ok = ok && matches_model(&gb, "", 0, 30);
+    gap_buffer_free(&gb);
+    print_test_result("Buffer grows past its capacity and text can be replaced", ok);
+}
+
+static void test_wrapping(void) {
+    GapBuffer gb;
+    int ok = gap_buffer_init(&gb, 64) == 0;
+
+    // A line exactly as wide as the box pushes its newline to the next row
+    ok = ok && gap_buffer_insert(&gb, "abcd\nef", 7) == 0;
+    ok = ok && gap_buffer_rows(&gb, 4) == 3;
+    ok = ok && matches_model(&gb, "abcd\nef", 7, 4);
+
+    // Width changes recompute the row sums
+    ok = ok && gap_buffer_rows(&gb, 2) == 5 && matches_model(&gb, "abcd\nef", 7, 2);
+    ok = ok && gap_buffer_rows(&gb, 80) == 2 && matches_model(&gb, "abcd\nef", 7, 80);
+
+    // Cursor at the start of a wrapped row
+    gap_buffer_set_cursor(&gb, 2);
+    int row = -1, col = -1;
+    gap_buffer_cursor_row(&gb, 2, &row, &col);
+    ok = ok && row == 1 && col == 0;
+    gap_buffer_free(&gb);
+    print_test_result("Rows and cursor position follow the input box wrapping", ok);
+}
+
+// Tiny deterministic PRNG so failures reproduce
+static unsigned int rng_state = 4242;
+static unsigned int rng(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (rng_state >> 16) & 0x7fff;
+}
+
+static void test_random_edits(void) {
+    static const char alphabet[] = "ab \n";
+    GapBuffer gb;
+    char model[4096] = "";
+    int cursor = 0;
+    int ok = gap_buffer_init(&gb, 16) == 0;
+
+    for (int step = 0; step < 3000 && ok; step++) {
+        int len = (int)strlen(model);
+        unsigned int op = rng() % 6;
+        if (op <= 1 && len < 3000) {
+            char ins[8];
+            int n = 1 + (int)(rng() % 6);
+            for (int i = 0; i < n; i++) {
+                ins[i] = alphabet[rng() % 4];
+            }
+            memmove(model + cursor + n, model + cursor, (size_t)(len - cursor + 1));
+            memcpy(model + cursor, ins, (size_t)n);
+            cursor += n;
+            ok = gap_buffer_insert(&gb, ins, n) == 0;
+        } else if (op == 2) {
+            int n = (int)(rng() % 4);
+            int k = n < cursor ? n : cursor;
+            memmove(model + cursor - k, model + cursor, (size_t)(len - cursor + 1));
+            cursor -= k;
+            ok = gap_buffer_delete_backward(&gb, n) == k;
+        } else if (op == 3) {
+            int n = (int)(rng() % 4);
+            int k = n < len - cursor ? n : len - cursor;
+            memmove(model + cursor, model + cursor + k, (size_t)(len - cursor - k + 1));
+            ok = gap_buffer_delete_forward(&gb, n) == k;
+        } else {
+            cursor = (int)(rng() % (unsigned int)(len + 1));
+            gap_buffer_set_cursor(&gb, cursor);
+        }
+        int width = 1 + (int)(rng() % 7);
+        ok = ok && matches_model(&gb, model, cursor, width);
+    }
+    gap_buffer_free(&gb);
+    print_test_result("Random edits match a plain string and a full layout rescan", ok);
+}
+
+int main(void) {
+    printf(COLOR_CYAN "Running Gap Buffer tests..." COLOR_RESET "\n\n");
+
+    test_basic_editing();
+    test_growth_and_set_text();
+    test_wrapping();
+    test_random_edits();
+
+    print_summary();
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,317 @@
+/*
+ * Unit Tests for the in-process line diff
+ *
+ * Tests the Myers line diff including:
+ * - Identical texts, empty texts and trailing-newline handling
+ * - Hunk headers and context lines in unified format
+ * - Splitting distant changes into hunks and merging close ones
+ * - Rendering a hunk partially (collapsed output)
+ * - Random edits: the script rebuilds the new text and is minimal
+ * - A large file with a one-line change
+ *
+ * Compilation: make test-line-diff
+ * Usage: ./test_line_diff
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/line_diff.h"
+
+// Test framework colors
+#define COLOR_RESET "\033[0m"
+#define COLOR_GREEN "\033[32m"
+#define COLOR_RED "\033[31m"
+#define COLOR_CYAN "\033[36m"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void print_test_result(const char *test_name, int passed) {
+    tests_run++;
+    if (passed) {
+        tests_passed++;
+        printf(COLOR_GREEN "✓ PASS" COLOR_RESET " %s\n", test_name);
+    } else {
+        tests_failed++;
+        printf(COLOR_RED "✗ FAIL" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_summary(void) {
+    printf("\n" COLOR_CYAN "Test Summary:" COLOR_RESET "\n");
+    printf("Tests run: %d\n", tests_run);
+    printf(COLOR_GREEN "Tests passed: %d\n" COLOR_RESET, tests_passed);
+    if (tests_failed > 0) {
+        printf(COLOR_RED "Tests failed: %d\n" COLOR_RESET, tests_failed);
+    } else {
+        printf(COLOR_GREEN "All tests passed!\n" COLOR_RESET);
+    }
+}
+
+// Collects rendered lines joined with '|'
+typedef struct {
+    char buf[8192];
+    size_t len;
+    int lines;
+} Capture;
+
+static void capture_line(void *ctx, const char *line) {
+    Capture *cap = ctx;
+    int n = snprintf(cap->buf + cap->len, sizeof(cap->buf) - cap->len, "%s|", line);
+    if (n > 0 && (size_t)n < sizeof(cap->buf) - cap->len) {
+        cap->len += (size_t)n;
+    }
+    cap->lines++;
+}
+
+static void render_all(const LineDiff *diff, Capture *cap) {
+    memset(cap, 0, sizeof(*cap));
+    for (int h = 0; h < diff->hunk_count; h++) {
+        line_diff_render_hunk(diff, h, -1, capture_line, cap);
+    }
+}
+
+static void test_identical(void) {
+    LineDiff diff;
+    int ok = line_diff_compute(&diff, "a\nb\nc\n", "a\nb\nc\n", LINE_DIFF_CONTEXT) == 0;
+    ok = ok && diff.hunk_count == 0 && diff.added == 0 && diff.removed == 0;
+    line_diff_free(&diff);
+
+    ok = ok && line_diff_compute(&diff, NULL, "", LINE_DIFF_CONTEXT) == 0;
+    ok = ok && diff.hunk_count == 0 && diff.old_count == 0 && diff.new_count == 0;
+    line_diff_free(&diff);
+    print_test_result("Identical and empty texts produce no hunks", ok);
+}
+
+static void test_single_change(void) {
+    LineDiff diff;
+    Capture cap;
+    int ok = line_diff_compute(&diff, "1\n2\n3\n4\n5\n6\n7\n8\n9\n",
+                               "1\n2\n3\n4\nfive\n6\n7\n8\n9\n", LINE_DIFF_CONTEXT) == 0;
+    ok = ok && diff.hunk_count == 1 && diff.added == 1 && diff.removed == 1;
+    render_all(&diff, &cap);
+    ok = ok && strcmp(cap.buf, "@@ -2,7 +2,7 @@| 2| 3| 4|-5|+five| 6| 7| 8|") == 0;
+    line_diff_free(&diff);
+    print_test_result("A changed line is shown with three lines of context", ok);
+}
+
+static void test_edges(void) {
+    LineDiff diff;
+    Capture cap;
+
+    // Insert at the start, delete at the end
+    int ok = line_diff_compute(&diff, "b\nc\n", "a\nb\n", 1) == 0;
+    render_all(&diff, &cap);
+    ok = ok && strcmp(cap.buf, "@@ -1,2 +1,2 @@|+a| b|-c|") == 0;
+    line_diff_free(&diff);
+
+    // New content in an empty file
+    ok = ok && line_diff_compute(&diff, "", "x\ny\n", 3) == 0;
+    render_all(&diff, &cap);
+    ok = ok && strcmp(cap.buf, "@@ -0,0 +1,2 @@|+x|+y|") == 0;
+    line_diff_free(&diff);
+
+    // Only the trailing newline differs
+    ok = ok && line_diff_compute(&diff, "a\nb", "a\nb\n", 3) == 0;
+    ok = ok && diff.old_count == 2 && diff.new_count == 2 && diff.hunk_count == 0;
+    line_diff_free(&diff);
+    print_test_result("Changes at the edges and in empty files have correct headers", ok);
+}
+
+static void test_hunk_grouping(void) {
+    // 40 lines; change line 5 and line 30 (far apart), then 5 and 10 (close)
+    char old_text[512] = "";
+    char far_text[512] = "";
+    char near_text[512] = "";
+    for (int i = 1; i <= 40; i++) {
+        char line[16];
+        snprintf(line, sizeof(line), "%d\n", i);
+        strcat(old_text, line);
+        strcat(far_text, (i == 5 || i == 30) ? "x\n" : line);
+        strcat(near_text, (i == 5 || i == 10) ? "x\n" : line);
+    }
+
+    LineDiff diff;
+    int ok = line_diff_compute(&diff, old_text, far_text, 3) == 0;
+    ok = ok && diff.hunk_count == 2 &&
+         diff.hunks[0].old_start == 1 && diff.hunks[0].old_count == 7 &&
+         diff.hunks[1].old_start == 26 && diff.hunks[1].new_count == 7;
+    line_diff_free(&diff);
+
+    // Lines 5 and 10 are within 2 * context of each other: one hunk
+    ok = ok && line_diff_compute(&diff, old_text, near_text, 3) == 0;
+    ok = ok && diff.hunk_count == 1 && diff.hunks[0].old_count == 12 &&
+         diff.hunks[0].added == 2 && diff.hunks[0].removed == 2;
+    line_diff_free(&diff);
+    print_test_result("Distant changes get separate hunks, close ones are merged", ok);
+}
+
+static void test_partial_render(void) {
+    LineDiff diff;
+    Capture cap;
+    memset(&cap, 0, sizeof(cap));
+    int ok = line_diff_compute(&diff, "", "1\n2\n3\n4\n5\n", 3) == 0;
+    ok = ok && line_diff_render_hunk(&diff, 0, 2, capture_line, &cap) == 3;
+    ok = ok && strcmp(cap.buf, "@@ -0,0 +1,5 @@|+1|+2|") == 0;
+    ok = ok && line_diff_render_hunk(&diff, 1, -1, capture_line, &cap) == -1;
+    line_diff_free(&diff);
+    print_test_result("A hunk can be rendered partially and reports the rest", ok);
+}
+
+// Tiny deterministic PRNG so failures reproduce
+static unsigned int rng_state = 12345;
+static unsigned int rng(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (rng_state >> 16) & 0x7fff;
+}
+
+static int lcs_length(const char **a, int n, const char **b, int m) {
+    int *prev = calloc((size_t)m + 1, sizeof(int));
+    int *cur = calloc((size_t)m + 1, sizeof(int));
+    for (int i = 1; i <= n; i++) {
+        for (int j = 1; j <= m; j++) {
+            if (strcmp(a[i - 1], b[j - 1]) == 0) {
+                cur[j] = prev[j - 1] + 1;
+            } else {
+                cur[j] = prev[j] > cur[j - 1] ? prev[j] : cur[j - 1];
+            }
+        }
+        int *tmp = prev;
+        prev = cur;
+        cur = tmp;
+    }
+    int result = prev[m];
+    free(prev);
+    free(cur);
+    return result;
+}
+
+static void test_random_edits(void) {
+    static const char *alphabet[] = {"a", "b", "c", "d", "e"};
+    int ok = 1;
+
+    for (int round = 0; round < 300 && ok; round++) {
+        const char *a[40];
+        const char *b[40];
+        int n = (int)(rng() % 30);
+        int m = 0;
+        for (int i = 0; i < n; i++) {
+            a[i] = alphabet[rng() % 5];
+        }
+        // Derive b from a with random deletes, inserts and replacements
+        for (int i = 0; i <= n && m < 40; i++) {
+            unsigned int r = rng() % 10;
+            if (r == 0 && m < 40) {
+                b[m++] = alphabet[rng() % 5];
+            }
+            if (i < n && r != 1 && m < 40) {
+                b[m++] = r == 2 ? alphabet[rng() % 5] : a[i];
+            }
+        }
+
+        char old_text[256] = "";
+        char new_text[256] = "";
+        for (int i = 0; i < n; i++) {
+            strcat(old_text, a[i]);
+            strcat(old_text, "\n");
+        }
+        for (int j = 0; j < m; j++) {
+            strcat(new_text, b[j]);
+            strcat(new_text, "\n");
+        }
+
+        LineDiff diff;
+        if (line_diff_compute(&diff, old_text, new_text, 0) != 0) {
+            ok = 0;
+            break;
+        }
+
+        // Minimal: insertions + deletions = n + m - 2 * LCS
+        int lcs = lcs_length(a, n, b, m);
+        ok = diff.added + diff.removed == n + m - 2 * lcs;
+
+        // Applying the script to the old text rebuilds the new text
+        char rebuilt[256] = "";
+        int old_pos = 0;
+        for (int h = 0; h < diff.hunk_count && ok; h++) {
+            const LineDiffHunk *hunk = &diff.hunks[h];
+            for (; old_pos < hunk->old_start; old_pos++) {
+                strcat(rebuilt, a[old_pos]);
+                strcat(rebuilt, "\n");
+            }
+            for (int k = 0; k < hunk->op_count; k++) {
+                const LineDiffOp *op = &diff.ops[hunk->first_op + k];
+                if (op->kind == LINE_DIFF_INSERT) {
+                    strcat(rebuilt, b[op->line]);
+                    strcat(rebuilt, "\n");
+                } else if (op->kind == LINE_DIFF_DELETE) {
+                    old_pos++;
+                } else {
+                    strcat(rebuilt, a[old_pos++]);
+                    strcat(rebuilt, "\n");
+                }
+            }
+        }
+        for (; old_pos < n; old_pos++) {
+            strcat(rebuilt, a[old_pos]);
+            strcat(rebuilt, "\n");
+        }
+        ok = ok && strcmp(rebuilt, new_text) == 0;
+        line_diff_free(&diff);
+    }
+    print_test_result("Random edits: minimal script that rebuilds the new text", ok);
+}
+
+static void test_large_file(void) {
+    int lines = 200000;
+    size_t cap = (size_t)lines * 16;
+    char *old_text = malloc(cap);
+    char *new_text = malloc(cap);
+    size_t old_len = 0;
+    size_t new_len = 0;
+    for (int i = 0; i < lines; i++) {
+        old_len += (size_t)snprintf(old_text + old_len, cap - old_len, "line %d\n", i);
+        new_len += (size_t)snprintf(new_text + new_len, cap - new_len,
+                                    i == lines / 2 ? "changed %d\n" : "line %d\n", i);
+    }
+
+    LineDiff diff;
+    int ok = line_diff_compute(&diff, old_text, new_text, 3) == 0;
+    ok = ok && diff.hunk_count == 1 && diff.added == 1 && diff.removed == 1 &&
+         diff.op_count == 8 && diff.hunks[0].old_start == lines / 2 - 3;
+    line_diff_free(&diff);
+
+    // Completely different texts still finish (as a replacement)
+    for (size_t i = 0; i < new_len; i++) {
+        if (new_text[i] == 'l') {
+            new_text[i] = 'L';
+        }
+    }
+    ok = ok && line_diff_compute(&diff, old_text, new_text, 3) == 0;
+    ok = ok && diff.added == lines && diff.removed == lines;
+    line_diff_free(&diff);
+
+    free(old_text);
+    free(new_text);
+    print_test_result("Large files with small or total changes diff quickly", ok);
+}
+
+int main(void) {
+    printf(COLOR_CYAN "Running Line Diff tests..." COLOR_RESET "\n\n");
+
+    test_identical();
+    test_single_change();
+    test_edges();
+    test_hunk_grouping();
+    test_partial_render();
+    test_random_edits();
+    test_large_file();
+
+    print_summary();
+    return tests_failed > 0 ? 1 : 0;
+}
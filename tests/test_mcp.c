@@ -2,15 +2,28 @@
  * test_mcp.c - Basic MCP integration tests
  *
  * Tests MCP configuration loading and basic functionality.
- * Does not require actual MCP servers to be running.
+ * Does not require actual MCP servers to be running: the stdio transport
+ * tests start this binary again with --fake-server, which answers JSON-RPC
+ * on stdin/stdout like a small MCP server, and the HTTP transport tests
+ * talk to a fake server on a loopback port.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <stdint.h>
 #include <assert.h>
+#include <time.h>
 #include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
 #include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <cjson/cJSON.h>
 
 // Stub logger functions for testing
 #pragma GCC diagnostic push
@@ -21,6 +34,13 @@ void log_message(int level, const char *file, int line, const char *fmt, ...) {
 #pragma GCC diagnostic pop
 
 #include "../src/mcp.h"
+#include "../src/base64.h"
+
+// Path of this binary, started again as the fake server
+static const char *self_path = NULL;
+
+// Tool schema cache of this run, so tests never touch ~/.cache
+static char cache_dir[64];
 
 // Test helper: Create a temporary config file
 static char* create_test_config(const char *json_content) {
@@ -357,7 +377,1608 @@ static void test_mkdir_p_func(void) {
     printf("PASSED\\n");
 }
 
-int main(void) {
+// Fake server: write one JSON-RPC message per line
+static void fake_send(cJSON *message) {
+    char *str = cJSON_PrintUnformatted(message);
+    if (str) {
+        printf("%s\n", str);
+        fflush(stdout);
+        free(str);
+    }
+    cJSON_Delete(message);
+}
+
+static void fake_reply(cJSON *id, cJSON *result) {
+    cJSON *reply = cJSON_CreateObject();
+    cJSON_AddStringToObject(reply, "jsonrpc", "2.0");
+    cJSON_AddItemToObject(reply, "id", cJSON_Duplicate(id, 1));
+    cJSON_AddItemToObject(reply, "result", result);
+    fake_send(reply);
+}
+
+static cJSON* fake_text_result(const char *text) {
+    cJSON *result = cJSON_CreateObject();
+    cJSON *content = cJSON_AddArrayToObject(result, "content");
+    cJSON *item = cJSON_CreateObject();
+    cJSON_AddStringToObject(item, "type", "text");
+    cJSON_AddStringToObject(item, "text", text);
+    cJSON_AddItemToArray(content, item);
+    return result;
+}
+
+static void fake_add_tool(cJSON *tools, const char *name) {
+    cJSON *tool = cJSON_CreateObject();
+    cJSON_AddStringToObject(tool, "name", name);
+    cJSON_AddStringToObject(tool, "description", name);
+    cJSON *schema = cJSON_AddObjectToObject(tool, "inputSchema");
+    cJSON_AddStringToObject(schema, "type", "object");
+    cJSON_AddItemToArray(tools, tool);
+}
+
+// Fake server: replies to sleep calls that are not due yet
+#define FAKE_MAX_DEFERRED 64
+
+typedef struct {
+    cJSON *id;
+    int ms;
+    struct timespec due;
+} FakeDeferred;
+
+static long fake_ms_until(const struct timespec *due) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long ms = (due->tv_sec - now.tv_sec) * 1000 + (due->tv_nsec - now.tv_nsec) / 1000000;
+    return ms > 0 ? ms : 0;
+}
+
+/*
+ * Tools: echo (returns arguments.text, after a log notification and a ping
+ * to the client), sleep (replies "slept <ms>" after arguments.ms, while
+ * other requests are served), peak (most sleep calls outstanding at once),
+ * image (arguments.size bytes of PNG content), pongs (how many pings the
+ * client answered), grow (adds a tool "extra" and sends tools/list_changed),
+ * flood (sends arguments.count pings without reading the answers, then
+ * replies; not listed) and exit (exits without replying). echo with arguments.updated first
+ * reports that resource as changed. Any URI reads as "<uri> #<n>", n
+ * counting the reads. subscribes (resources/subscribe requests so far) and
+ * relist (sends resources/list_changed) are not listed either, nor is
+ * hang (sends tools/list_changed and leaves tools/list unanswered from
+ * then on). The one listed resource is named "list #<n>", n counting the
+ * listings. FAKE_MCP_INIT_DELAY_MS in its environment delays
+ * the reply to initialize.
+ */
+static int run_fake_server(void) {
+    static char input[1 << 20];
+    size_t used = 0;
+    FakeDeferred deferred[FAKE_MAX_DEFERRED];
+    int deferred_count = 0;
+    int peak = 0;
+    int pongs = 0;
+    int grown = 0;
+    int resource_reads = 0;
+    int subscribes = 0;
+    int listings = 0;
+    int hang_lists = 0;
+    const char *init_delay = getenv("FAKE_MCP_INIT_DELAY_MS");
+
+    for (;;) {
+        // Sleep until the next deferred reply is due or a request arrives
+        int wait_ms = -1;
+        for (int i = 0; i < deferred_count; i++) {
+            long ms = fake_ms_until(&deferred[i].due);
+            if (wait_ms < 0 || ms < wait_ms) {
+                wait_ms = (int)ms;
+            }
+        }
+        struct pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+        int ready = poll(&pfd, 1, wait_ms);
+
+        for (int i = 0; i < deferred_count; i++) {
+            if (fake_ms_until(&deferred[i].due) == 0) {
+                char text[32];
+                snprintf(text, sizeof(text), "slept %d", deferred[i].ms);
+                fake_reply(deferred[i].id, fake_text_result(text));
+                cJSON_Delete(deferred[i].id);
+                deferred[i--] = deferred[--deferred_count];
+            }
+        }
+        if (ready <= 0) {
+            continue;
+        }
+
+        ssize_t n = read(STDIN_FILENO, input + used, sizeof(input) - used - 1);
+        if (n <= 0) {
+            break;
+        }
+        used += (size_t)n;
+        input[used] = '\0';
+
+        char *line = input;
+        char *newline;
+        while ((newline = strchr(line, '\n')) != NULL) {
+            *newline = '\0';
+            cJSON *msg = cJSON_Parse(line);
+            line = newline + 1;
+            if (!msg) {
+                continue;
+            }
+            cJSON *id = cJSON_GetObjectItem(msg, "id");
+            cJSON *method = cJSON_GetObjectItem(msg, "method");
+            cJSON *params = cJSON_GetObjectItem(msg, "params");
+
+            if (!method) {
+                if (cJSON_IsString(id) && cJSON_GetObjectItem(msg, "result")) {
+                    pongs++;
+                }
+            } else if (!id) {
+                // Notifications need no reply
+            } else if (strcmp(method->valuestring, "initialize") == 0) {
+                if (init_delay) {
+                    usleep((useconds_t)atoi(init_delay) * 1000u);
+                }
+                cJSON *result = cJSON_CreateObject();
+                cJSON_AddStringToObject(result, "protocolVersion", "2024-11-05");
+                cJSON *capabilities = cJSON_AddObjectToObject(result, "capabilities");
+                cJSON *resources = cJSON_AddObjectToObject(capabilities, "resources");
+                cJSON_AddTrueToObject(resources, "subscribe");
+                fake_reply(id, result);
+            } else if (strcmp(method->valuestring, "resources/read") == 0) {
+                const char *uri = cJSON_GetStringValue(cJSON_GetObjectItem(params, "uri"));
+                char text[256];
+                snprintf(text, sizeof(text), "%s #%d", uri ? uri : "", ++resource_reads);
+                cJSON *result = cJSON_CreateObject();
+                cJSON *contents = cJSON_AddArrayToObject(result, "contents");
+                cJSON *item = cJSON_CreateObject();
+                cJSON_AddStringToObject(item, "uri", uri ? uri : "");
+                cJSON_AddStringToObject(item, "mimeType", "text/plain");
+                cJSON_AddStringToObject(item, "text", text);
+                cJSON_AddItemToArray(contents, item);
+                fake_reply(id, result);
+            } else if (strcmp(method->valuestring, "resources/subscribe") == 0) {
+                subscribes++;
+                fake_reply(id, cJSON_CreateObject());
+            } else if (strcmp(method->valuestring, "resources/list") == 0) {
+                char name[32];
+                snprintf(name, sizeof(name), "list #%d", ++listings);
+                cJSON *result = cJSON_CreateObject();
+                cJSON *resources = cJSON_AddArrayToObject(result, "resources");
+                cJSON *item = cJSON_CreateObject();
+                cJSON_AddStringToObject(item, "uri", "file:///a.md");
+                cJSON_AddStringToObject(item, "name", name);
+                cJSON_AddItemToArray(resources, item);
+                fake_reply(id, result);
+            } else if (strcmp(method->valuestring, "tools/list") == 0 && hang_lists) {
+                // Left unanswered
+            } else if (strcmp(method->valuestring, "tools/list") == 0) {
+                cJSON *result = cJSON_CreateObject();
+                cJSON *tools = cJSON_AddArrayToObject(result, "tools");
+                fake_add_tool(tools, "echo");
+                fake_add_tool(tools, "sleep");
+                fake_add_tool(tools, "peak");
+                fake_add_tool(tools, "image");
+                fake_add_tool(tools, "pongs");
+                fake_add_tool(tools, "exit");
+                fake_add_tool(tools, "grow");
+                if (grown) {
+                    fake_add_tool(tools, "extra");
+                }
+                fake_reply(id, result);
+            } else if (strcmp(method->valuestring, "tools/call") == 0) {
+                const char *name = cJSON_GetStringValue(cJSON_GetObjectItem(params, "name"));
+                cJSON *args = cJSON_GetObjectItem(params, "arguments");
+                char text[32];
+                if (name && strcmp(name, "echo") == 0) {
+                    const char *updated = cJSON_GetStringValue(cJSON_GetObjectItem(args, "updated"));
+                    if (updated) {
+                        cJSON *change = cJSON_CreateObject();
+                        cJSON_AddStringToObject(change, "jsonrpc", "2.0");
+                        cJSON_AddStringToObject(change, "method", "notifications/resources/updated");
+                        cJSON *change_params = cJSON_AddObjectToObject(change, "params");
+                        cJSON_AddStringToObject(change_params, "uri", updated);
+                        fake_send(change);
+                    }
+
+                    cJSON *note = cJSON_CreateObject();
+                    cJSON_AddStringToObject(note, "jsonrpc", "2.0");
+                    cJSON_AddStringToObject(note, "method", "notifications/message");
+                    cJSON *note_params = cJSON_AddObjectToObject(note, "params");
+                    cJSON_AddStringToObject(note_params, "level", "info");
+                    cJSON_AddStringToObject(note_params, "data", "echoing");
+                    fake_send(note);
+
+                    cJSON *ping = cJSON_CreateObject();
+                    cJSON_AddStringToObject(ping, "jsonrpc", "2.0");
+                    cJSON_AddStringToObject(ping, "id", "ping");
+                    cJSON_AddStringToObject(ping, "method", "ping");
+                    fake_send(ping);
+
+                    fprintf(stderr, "echo called\n");
+                    const char *echo = cJSON_GetStringValue(cJSON_GetObjectItem(args, "text"));
+                    fake_reply(id, fake_text_result(echo ? echo : ""));
+                } else if (name && strcmp(name, "sleep") == 0 && deferred_count < FAKE_MAX_DEFERRED) {
+                    cJSON *ms = cJSON_GetObjectItem(args, "ms");
+                    FakeDeferred *d = &deferred[deferred_count++];
+                    d->id = cJSON_Duplicate(id, 1);
+                    d->ms = cJSON_IsNumber(ms) ? ms->valueint : 0;
+                    clock_gettime(CLOCK_MONOTONIC, &d->due);
+                    d->due.tv_sec += d->ms / 1000;
+                    d->due.tv_nsec += (long)(d->ms % 1000) * 1000000L;
+                    if (d->due.tv_nsec >= 1000000000L) {
+                        d->due.tv_sec++;
+                        d->due.tv_nsec -= 1000000000L;
+                    }
+                    if (deferred_count > peak) {
+                        peak = deferred_count;
+                    }
+                } else if (name && strcmp(name, "peak") == 0) {
+                    snprintf(text, sizeof(text), "%d", peak);
+                    peak = 0;
+                    fake_reply(id, fake_text_result(text));
+                } else if (name && strcmp(name, "image") == 0) {
+                    cJSON *size = cJSON_GetObjectItem(args, "size");
+                    size_t bytes = cJSON_IsNumber(size) ? (size_t)size->valueint : 0;
+                    unsigned char *image = malloc(bytes + 1);
+                    for (size_t i = 0; i < bytes; i++) {
+                        image[i] = (unsigned char)(i * 7 + i / 251);
+                    }
+                    size_t encoded_len = 0;
+                    char *encoded = base64_encode(image, bytes, &encoded_len);
+
+                    cJSON *result = cJSON_CreateObject();
+                    cJSON *content = cJSON_AddArrayToObject(result, "content");
+                    cJSON *item = cJSON_CreateObject();
+                    cJSON_AddStringToObject(item, "type", "image");
+                    cJSON_AddStringToObject(item, "data", encoded);
+                    cJSON_AddStringToObject(item, "mimeType", "image/png");
+                    cJSON_AddItemToArray(content, item);
+                    fake_reply(id, result);
+                    free(encoded);
+                    free(image);
+                } else if (name && strcmp(name, "pongs") == 0) {
+                    snprintf(text, sizeof(text), "%d", pongs);
+                    fake_reply(id, fake_text_result(text));
+                } else if (name && strcmp(name, "grow") == 0) {
+                    grown = 1;
+                    cJSON *note = cJSON_CreateObject();
+                    cJSON_AddStringToObject(note, "jsonrpc", "2.0");
+                    cJSON_AddStringToObject(note, "method", "notifications/tools/list_changed");
+                    fake_send(note);
+                    fake_reply(id, fake_text_result("grown"));
+                } else if (name && strcmp(name, "subscribes") == 0) {
+                    snprintf(text, sizeof(text), "%d", subscribes);
+                    fake_reply(id, fake_text_result(text));
+                } else if (name && strcmp(name, "hang") == 0) {
+                    hang_lists = 1;
+                    cJSON *note = cJSON_CreateObject();
+                    cJSON_AddStringToObject(note, "jsonrpc", "2.0");
+                    cJSON_AddStringToObject(note, "method", "notifications/tools/list_changed");
+                    fake_send(note);
+                    fake_reply(id, fake_text_result("hung"));
+                } else if (name && strcmp(name, "relist") == 0) {
+                    cJSON *note = cJSON_CreateObject();
+                    cJSON_AddStringToObject(note, "jsonrpc", "2.0");
+                    cJSON_AddStringToObject(note, "method", "notifications/resources/list_changed");
+                    fake_send(note);
+                    fake_reply(id, fake_text_result("relisted"));
+                } else if (name && strcmp(name, "flood") == 0) {
+                    cJSON *count = cJSON_GetObjectItem(args, "count");
+                    int pings = cJSON_IsNumber(count) ? count->valueint : 0;
+                    for (int i = 0; i < pings; i++) {
+                        cJSON *ping = cJSON_CreateObject();
+                        cJSON_AddStringToObject(ping, "jsonrpc", "2.0");
+                        cJSON_AddStringToObject(ping, "id", "ping");
+                        cJSON_AddStringToObject(ping, "method", "ping");
+                        fake_send(ping);
+                    }
+                    fake_reply(id, fake_text_result("flooded"));
+                } else if (name && strcmp(name, "exit") == 0) {
+                    // A child left behind keeps stdout open for linger ms
+                    cJSON *code = cJSON_GetObjectItem(args, "code");
+                    cJSON *linger = cJSON_GetObjectItem(args, "linger");
+                    if (cJSON_IsNumber(linger) && fork() == 0) {
+                        usleep((useconds_t)linger->valueint * 1000);
+                        _exit(0);
+                    }
+                    exit(cJSON_IsNumber(code) ? code->valueint : 0);
+                }
+            }
+            cJSON_Delete(msg);
+        }
+
+        // Keep the partial line for the next read
+        used = strlen(line);
+        memmove(input, line, used + 1);
+    }
+
+    return 0;
+}
+
+// Test helper: Load a config with one fake server and connect to it
+static MCPConfig* connect_fake_server(int max_in_flight) {
+    char config_json[1024];
+    snprintf(config_json, sizeof(config_json),
+             "{\"mcpServers\": {\"fake\": {\"command\": \"%s\", \"args\": [\"--fake-server\"], "
+             "\"maxInFlight\": %d}}}",
+             self_path, max_in_flight);
+
+    char *config_path = create_test_config(config_json);
+    assert(config_path != NULL);
+    MCPConfig *config = mcp_load_config(config_path);
+    remove_test_config(config_path);
+    assert(config != NULL);
+    assert(mcp_connect_server(config->servers[0]) == 0);
+    return config;
+}
+
+// Test helper: Call a tool with one string or number argument
+static MCPToolResult* call_fake_tool(MCPServer *server, const char *tool,
+                                     const char *key, const char *text, int number) {
+    cJSON *args = cJSON_CreateObject();
+    if (key && text) {
+        cJSON_AddStringToObject(args, key, text);
+    } else if (key) {
+        cJSON_AddNumberToObject(args, key, number);
+    }
+    MCPToolResult *result = mcp_call_tool(server, tool, args);
+    cJSON_Delete(args);
+    assert(result != NULL);
+    return result;
+}
+
+static double elapsed_seconds(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Test 11: Requests over the stdio transport
+static void test_stdio_round_trips(void) {
+    printf("Test 11: Stdio transport round trips... ");
+
+    MCPConfig *config = connect_fake_server(MCP_DEFAULT_MAX_IN_FLIGHT);
+    MCPServer *server = config->servers[0];
+    assert(mcp_discover_tools(server) == 7);
+
+    // Replies are delivered as they arrive, not on a polling tick
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < 200; i++) {
+        char text[32];
+        snprintf(text, sizeof(text), "hello %d", i);
+        MCPToolResult *result = call_fake_tool(server, "echo", "text", text, 0);
+        assert(!result->is_error);
+        assert(result->result && strcmp(result->result, text) == 0);
+        mcp_free_tool_result(result);
+    }
+    assert(elapsed_seconds(&start) < 2.0);
+
+    // Every ping the server sent in between was answered
+    MCPToolResult *result = call_fake_tool(server, "pongs", NULL, NULL, 0);
+    assert(result->result && strcmp(result->result, "200") == 0);
+    mcp_free_tool_result(result);
+
+    mcp_free_config(config);
+    printf("PASSED\n");
+}
+
+// Test 12: A late reply is dropped, not taken as the next request's reply
+static void test_stdio_timeout(void) {
+    printf("Test 12: Stdio transport timeout... ");
+
+    MCPConfig *config = connect_fake_server(MCP_DEFAULT_MAX_IN_FLIGHT);
+    MCPServer *server = config->servers[0];
+
+    setenv("CLAUDE_MCP_TIMEOUT_MS", "200", 1);
+    MCPToolResult *result = call_fake_tool(server, "sleep", "ms", NULL, 600);
+    assert(result->is_error);
+    mcp_free_tool_result(result);
+    unsetenv("CLAUDE_MCP_TIMEOUT_MS");
+
+    usleep(600000);  // Let the late reply arrive first
+    result = call_fake_tool(server, "echo", "text", "after timeout", 0);
+    assert(!result->is_error);
+    assert(result->result && strcmp(result->result, "after timeout") == 0);
+    mcp_free_tool_result(result);
+
+    mcp_free_config(config);
+    printf("PASSED\n");
+}
+
+// Test 13: A server that exits fails the waiting call right away
+static void test_stdio_server_exit(void) {
+    printf("Test 13: Stdio transport server exit... ");
+
+    MCPConfig *config = connect_fake_server(MCP_DEFAULT_MAX_IN_FLIGHT);
+    MCPServer *server = config->servers[0];
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    MCPToolResult *result = call_fake_tool(server, "exit", NULL, NULL, 0);
+    assert(result->is_error);
+    mcp_free_tool_result(result);
+
+    result = call_fake_tool(server, "echo", "text", "gone", 0);
+    assert(result->is_error);
+    mcp_free_tool_result(result);
+    assert(elapsed_seconds(&start) < 5.0);
+
+    mcp_free_config(config);
+    printf("PASSED\n");
+}
+
+typedef struct {
+    MCPServer *server;
+    int ms;
+    int ok;
+} SleepCall;
+
+static void* sleep_call_thread(void *arg) {
+    SleepCall *call = arg;
+    MCPToolResult *result = call_fake_tool(call->server, "sleep", "ms", NULL, call->ms);
+    char expected[32];
+    snprintf(expected, sizeof(expected), "slept %d", call->ms);
+    call->ok = !result->is_error && result->result && strcmp(result->result, expected) == 0;
+    mcp_free_tool_result(result);
+    return NULL;
+}
+
+// Make `calls` sleep calls of 100, 120, ... ms at once, one thread each
+static double run_parallel_sleeps(MCPServer *server, int calls) {
+    pthread_t threads[8];
+    SleepCall sleeps[8];
+    assert(calls <= 8);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < calls; i++) {
+        // Later calls finish first, so replies come back out of order
+        sleeps[i].server = server;
+        sleeps[i].ms = 100 + 20 * (calls - 1 - i);
+        sleeps[i].ok = 0;
+        assert(pthread_create(&threads[i], NULL, sleep_call_thread, &sleeps[i]) == 0);
+    }
+    for (int i = 0; i < calls; i++) {
+        pthread_join(threads[i], NULL);
+        assert(sleeps[i].ok);
+    }
+    return elapsed_seconds(&start);
+}
+
+static int peak_sleeps(MCPServer *server) {
+    MCPToolResult *result = call_fake_tool(server, "peak", NULL, NULL, 0);
+    int peak = result->result ? atoi(result->result) : -1;
+    mcp_free_tool_result(result);
+    return peak;
+}
+
+// Test 14: Calls from several threads are outstanding together
+static void test_stdio_concurrent_calls(void) {
+    printf("Test 14: Stdio transport concurrent calls... ");
+
+    MCPConfig *config = connect_fake_server(MCP_DEFAULT_MAX_IN_FLIGHT);
+    MCPServer *server = config->servers[0];
+
+    // Six calls of 100-200 ms overlap instead of taking 0.9 s in a row
+    double elapsed = run_parallel_sleeps(server, 6);
+    assert(peak_sleeps(server) == 6);
+    assert(elapsed < 0.6);
+    mcp_free_config(config);
+
+    // maxInFlight caps how many are sent at once
+    config = connect_fake_server(2);
+    server = config->servers[0];
+    run_parallel_sleeps(server, 6);
+    assert(peak_sleeps(server) == 2);
+    mcp_free_config(config);
+
+    printf("PASSED\n");
+}
+
+// Test 15: Replies far larger than one read arrive whole
+static void test_stdio_large_reply(void) {
+    printf("Test 15: Stdio transport large reply... ");
+
+    MCPConfig *config = connect_fake_server(MCP_DEFAULT_MAX_IN_FLIGHT);
+    MCPServer *server = config->servers[0];
+
+    // About 4 MB of base64 on a single line, decoded into the blob
+    const size_t sizes[2] = {3000000, 1};
+    for (int k = 0; k < 2; k++) {
+        MCPToolResult *result = call_fake_tool(server, "image", "size", NULL, (int)sizes[k]);
+        assert(!result->is_error);
+        assert(result->blob && result->blob_size == sizes[k]);
+        assert(result->mime_type && strcmp(result->mime_type, "image/png") == 0);
+        const unsigned char *blob = result->blob;
+        for (size_t i = 0; i < sizes[k]; i++) {
+            assert(blob[i] == (unsigned char)(i * 7 + i / 251));
+        }
+        mcp_free_tool_result(result);
+    }
+
+    // Small replies still come through after the buffer shrinks back
+    MCPToolResult *result = call_fake_tool(server, "echo", "text", "small again", 0);
+    assert(result->result && strcmp(result->result, "small again") == 0);
+    mcp_free_tool_result(result);
+
+    mcp_free_config(config);
+    printf("PASSED\n");
+}
+
+// Test helper: Load a config with `count` fake servers fake0, fake1, ...
+// whose initialize replies take delay_ms
+static MCPConfig* load_fake_servers(int count, int delay_ms) {
+    char config_json[4096];
+    size_t off = (size_t)snprintf(config_json, sizeof(config_json), "{\"mcpServers\": {");
+    for (int i = 0; i < count; i++) {
+        off += (size_t)snprintf(config_json + off, sizeof(config_json) - off,
+                                "%s\"fake%d\": {\"command\": \"%s\", \"args\": [\"--fake-server\"], "
+                                "\"env\": {\"FAKE_MCP_INIT_DELAY_MS\": \"%d\"}}",
+                                i > 0 ? ", " : "", i, self_path, delay_ms);
+    }
+    snprintf(config_json + off, sizeof(config_json) - off, "}}");
+
+    char *config_path = create_test_config(config_json);
+    assert(config_path != NULL);
+    MCPConfig *config = mcp_load_config(config_path);
+    remove_test_config(config_path);
+    assert(config != NULL && config->server_count == count);
+    return config;
+}
+
+// Test 16: Servers start together in the background
+static void test_background_startup(void) {
+    printf("Test 16: Background server startup... ");
+
+    // Four servers taking 300 ms each would need 1.2 s one after another
+    MCPConfig *config = load_fake_servers(4, 300);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    assert(mcp_start_servers(config) == 4);
+
+    // Nothing is offered while they start, and asking does not block
+    cJSON *tools = mcp_get_all_tools(config);
+    assert(tools && cJSON_GetArraySize(tools) == 0);
+    cJSON_Delete(tools);
+    char *status = mcp_get_status(config);
+    assert(status && strstr(status, "starting") != NULL);
+    free(status);
+    assert(elapsed_seconds(&start) < 0.2);
+
+    mcp_wait_for_servers(config);
+    assert(elapsed_seconds(&start) < 1.0);
+
+    tools = mcp_get_all_tools(config);
+    assert(tools && cJSON_GetArraySize(tools) == 4 * 7);
+    cJSON_Delete(tools);
+
+    for (int i = 0; i < config->server_count; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "mcp_fake%d_echo", i);
+        MCPServer *server = mcp_find_tool_server(config, name);
+        assert(server != NULL);
+        MCPToolResult *result = call_fake_tool(server, "echo", "text", name, 0);
+        assert(result->result && strcmp(result->result, name) == 0);
+        mcp_free_tool_result(result);
+    }
+
+    mcp_free_config(config);
+    printf("PASSED\n");
+}
+
+// Test 17: Freeing the config does not wait out a slow startup
+static void test_free_while_starting(void) {
+    printf("Test 17: Free config while servers start... ");
+
+    MCPConfig *config = load_fake_servers(2, 5000);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    assert(mcp_start_servers(config) == 2);
+    usleep(100000);
+    mcp_free_config(config);
+    assert(elapsed_seconds(&start) < 2.0);
+
+    printf("PASSED\n");
+}
+
+static int count_tools(MCPConfig *config) {
+    cJSON *tools = mcp_get_all_tools(config);
+    assert(tools != NULL);
+    int count = cJSON_GetArraySize(tools);
+    cJSON_Delete(tools);
+    return count;
+}
+
+static int count_cache_files(void) {
+    int count = 0;
+    DIR *dir = opendir(cache_dir);
+    struct dirent *entry;
+    while (dir && (entry = readdir(dir)) != NULL) {
+        if (strstr(entry->d_name, ".json")) {
+            count++;
+        }
+    }
+    if (dir) {
+        closedir(dir);
+    }
+    return count;
+}
+
+// Test 18: Cached tool schemas are offered before the server is up
+static void test_cached_tool_schemas(void) {
+    printf("Test 18: Cached tool schemas... ");
+
+    // The first start has no cache and writes one
+    MCPConfig *config = load_fake_servers(1, 400);
+    int files = count_cache_files();
+    assert(mcp_start_servers(config) == 1);
+    assert(count_tools(config) == 0);
+    mcp_wait_for_servers(config);
+    assert(count_tools(config) == 7);
+    assert(count_cache_files() == files + 1);
+    mcp_free_config(config);
+
+    // The same command line starts with those tools at once
+    config = load_fake_servers(1, 400);
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    assert(mcp_start_servers(config) == 1);
+    assert(count_tools(config) == 7);
+    char *status = mcp_get_status(config);
+    assert(status && strstr(status, "starting (7 tools, cached)") != NULL);
+    free(status);
+    assert(elapsed_seconds(&start) < 0.2);
+
+    // A call waits for the startup instead of failing
+    MCPServer *server = mcp_find_tool_server(config, "mcp_fake0_echo");
+    assert(server != NULL);
+    MCPToolResult *result = call_fake_tool(server, "echo", "text", "early", 0);
+    assert(!result->is_error && result->result && strcmp(result->result, "early") == 0);
+    mcp_free_tool_result(result);
+
+    // Discovery found the cached list current
+    mcp_wait_for_servers(config);
+    status = mcp_get_status(config);
+    assert(status && strstr(status, "connected (7 tools)") != NULL);
+    free(status);
+    assert(count_cache_files() == files + 1);
+    mcp_free_config(config);
+
+    // Another command line does not share the cache
+    config = load_fake_servers(1, 0);
+    assert(mcp_start_servers(config) == 1);
+    assert(count_tools(config) == 0);
+    mcp_free_config(config);
+
+    printf("PASSED\n");
+}
+
+// Test 19: tools/list_changed and a changed list update tools and cache
+static void test_tool_list_changes(void) {
+    printf("Test 19: Tool list changes... ");
+
+    MCPConfig *config = load_fake_servers(1, 10);
+    assert(mcp_start_servers(config) == 1);
+    mcp_wait_for_servers(config);
+    assert(count_tools(config) == 7);
+
+    MCPToolResult *result = call_fake_tool(config->servers[0], "grow", NULL, NULL, 0);
+    assert(!result->is_error);
+    mcp_free_tool_result(result);
+
+    // Fetched again in the background, without blocking the caller
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (count_tools(config) != 8) {
+        assert(elapsed_seconds(&start) < 2.0);
+        usleep(10000);
+    }
+    assert(mcp_find_tool_server(config, "mcp_fake0_extra") != NULL);
+    mcp_free_config(config);
+
+    // The next start offers the new list, then finds the server has 7 again
+    config = load_fake_servers(1, 10);
+    assert(mcp_start_servers(config) == 1);
+    assert(count_tools(config) == 8);
+    mcp_wait_for_servers(config);
+    assert(count_tools(config) == 7);
+    mcp_free_config(config);
+
+    config = load_fake_servers(1, 10);
+    assert(mcp_start_servers(config) == 1);
+    assert(count_tools(config) == 7);
+    mcp_free_config(config);
+
+    printf("PASSED\n");
+}
+
+/*
+ * Fake HTTP server: a small streamable HTTP MCP server on 127.0.0.1, run
+ * on threads of the test itself (one per connection, HTTP/1.1 keep-alive)
+ * so tests can look at what it received.
+ *
+ * Tools: echo (an SSE reply led by a log notification and a ping), sleep
+ * (JSON reply after arguments.ms), push (a ping on the listening stream),
+ * drop (cuts the reply stream after its first event; the reply is replayed
+ * to a GET with Last-Event-ID), droplisten (sends "retry: 50" and an event
+ * on the listening stream, then closes it) and expire (forgets the session,
+ * so the next request gets 404).
+ */
+#define FAKE_HTTP_MAX_THREADS 64
+
+typedef struct {
+    pthread_mutex_t lock;
+    int listen_fd;
+    int port;
+    int stop;
+    pthread_t accept_thread;
+    pthread_t threads[FAKE_HTTP_MAX_THREADS];
+    int thread_count;
+
+    int session;                 // Current session number (0 = none)
+    int inits;
+    int connections;
+    int listens;                 // GETs opened as the listening stream
+    int listen_fd_open;          // Connection carrying the listening stream (-1 = none)
+    int close_listen;            // Ask the listening stream to end
+    int pongs;
+    int deletes;
+    char resumed_from[32];       // Last-Event-ID of the last resuming GET
+    char listen_resumed_from[32];
+    char *replay;                // Reply held for the stream cut by "drop"
+} FakeHttp;
+
+static FakeHttp fake_http;
+
+static int fake_write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void fake_http_respond(int fd, const char *status, const char *body) {
+    char head[256];
+    int session = 0;
+    pthread_mutex_lock(&fake_http.lock);
+    session = fake_http.session;
+    pthread_mutex_unlock(&fake_http.lock);
+    size_t len = body ? strlen(body) : 0;
+    snprintf(head, sizeof(head),
+             "HTTP/1.1 %s\r\n%sMcp-Session-Id: s%d\r\nContent-Length: %zu\r\n\r\n",
+             status, body ? "Content-Type: application/json\r\n" : "", session, len);
+    fake_write_all(fd, head, strlen(head));
+    if (body) {
+        fake_write_all(fd, body, len);
+    }
+}
+
+static void fake_sse_begin(int fd) {
+    static const char head[] =
+        "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nTransfer-Encoding: chunked\r\n\r\n";
+    fake_write_all(fd, head, sizeof(head) - 1);
+}
+
+// One SSE chunk: "id: <id>\ndata: <json>\n\n" (id and data optional)
+static int fake_sse_event(int fd, const char *id, const char *extra, const char *data) {
+    char chunk[4096];
+    int len = snprintf(chunk + 16, sizeof(chunk) - 32, "%s%s%s%s%s%s\n",
+                       extra ? extra : "", id ? "id: " : "", id ? id : "", id ? "\n" : "",
+                       data ? "data: " : "", data ? data : "");
+    if (data) {
+        len += snprintf(chunk + 16 + len, sizeof(chunk) - 32 - (size_t)len, "\n");
+    }
+    char size[16];
+    int size_len = snprintf(size, sizeof(size), "%x\r\n", len);
+    memcpy(chunk + 16 - size_len, size, (size_t)size_len);
+    memcpy(chunk + 16 + len, "\r\n", 2);
+    return fake_write_all(fd, chunk + 16 - size_len, (size_t)(size_len + len + 2));
+}
+
+static void fake_sse_end(int fd) {
+    fake_write_all(fd, "0\r\n\r\n", 5);
+}
+
+static char* fake_message(cJSON *message) {
+    char *str = cJSON_PrintUnformatted(message);
+    cJSON_Delete(message);
+    return str;
+}
+
+static char* fake_result_message(cJSON *id, cJSON *result) {
+    cJSON *reply = cJSON_CreateObject();
+    cJSON_AddStringToObject(reply, "jsonrpc", "2.0");
+    cJSON_AddItemToObject(reply, "id", cJSON_Duplicate(id, 1));
+    cJSON_AddItemToObject(reply, "result", result);
+    return fake_message(reply);
+}
+
+static char* fake_ping_message(void) {
+    cJSON *ping = cJSON_CreateObject();
+    cJSON_AddStringToObject(ping, "jsonrpc", "2.0");
+    cJSON_AddStringToObject(ping, "id", "ping");
+    cJSON_AddStringToObject(ping, "method", "ping");
+    return fake_message(ping);
+}
+
+// Value of header `name` in the request head, copied into out
+static int fake_header(const char *head, const char *name, char *out, size_t size) {
+    size_t name_len = strlen(name);
+    for (const char *line = strstr(head, "\r\n"); line; line = strstr(line, "\r\n")) {
+        line += 2;
+        if (strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            const char *value = line + name_len + 1;
+            while (*value == ' ') {
+                value++;
+            }
+            size_t len = strcspn(value, "\r");
+            if (len >= size) {
+                len = size - 1;
+            }
+            memcpy(out, value, len);
+            out[len] = '\0';
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// The listening stream: held open until the client or a tool ends it
+static void fake_http_listen(int fd, const char *last_event_id) {
+    pthread_mutex_lock(&fake_http.lock);
+    fake_http.listens++;
+    fake_http.listen_fd_open = fd;
+    fake_http.close_listen = 0;
+    if (last_event_id) {
+        snprintf(fake_http.listen_resumed_from, sizeof(fake_http.listen_resumed_from), "%s", last_event_id);
+    }
+    fake_sse_begin(fd);
+    pthread_mutex_unlock(&fake_http.lock);
+
+    for (;;) {
+        pthread_mutex_lock(&fake_http.lock);
+        int done = fake_http.close_listen || fake_http.stop;
+        pthread_mutex_unlock(&fake_http.lock);
+        if (done) {
+            break;
+        }
+        struct pollfd pfd = {fd, POLLIN, 0};
+        char byte;
+        if (poll(&pfd, 1, 20) > 0 && recv(fd, &byte, 1, 0) <= 0) {
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&fake_http.lock);
+    if (fake_http.listen_fd_open == fd) {
+        fake_http.listen_fd_open = -1;
+    }
+    pthread_mutex_unlock(&fake_http.lock);
+}
+
+// Answer one POSTed JSON-RPC message. Returns -1 to close the connection.
+static int fake_http_post(int fd, const char *body) {
+    cJSON *msg = cJSON_Parse(body);
+    if (!msg) {
+        fake_http_respond(fd, "400 Bad Request", NULL);
+        return 0;
+    }
+    cJSON *id = cJSON_GetObjectItem(msg, "id");
+    cJSON *method = cJSON_GetObjectItem(msg, "method");
+    cJSON *params = cJSON_GetObjectItem(msg, "params");
+    const char *name = cJSON_GetStringValue(cJSON_GetObjectItem(params, "name"));
+    cJSON *args = cJSON_GetObjectItem(params, "arguments");
+    int rc = 0;
+
+    if (!method || !id) {
+        if (!method && cJSON_IsString(id) && cJSON_GetObjectItem(msg, "result")) {
+            pthread_mutex_lock(&fake_http.lock);
+            fake_http.pongs++;
+            pthread_mutex_unlock(&fake_http.lock);
+        }
+        fake_http_respond(fd, "202 Accepted", NULL);
+    } else if (strcmp(method->valuestring, "initialize") == 0) {
+        pthread_mutex_lock(&fake_http.lock);
+        fake_http.inits++;
+        fake_http.session = fake_http.inits;
+        pthread_mutex_unlock(&fake_http.lock);
+        cJSON *result = cJSON_CreateObject();
+        cJSON_AddStringToObject(result, "protocolVersion", "2024-11-05");
+        cJSON_AddObjectToObject(result, "capabilities");
+        char *reply = fake_result_message(id, result);
+        fake_http_respond(fd, "200 OK", reply);
+        free(reply);
+    } else if (strcmp(method->valuestring, "tools/list") == 0) {
+        cJSON *result = cJSON_CreateObject();
+        cJSON *tools = cJSON_AddArrayToObject(result, "tools");
+        fake_add_tool(tools, "echo");
+        fake_add_tool(tools, "sleep");
+        fake_add_tool(tools, "push");
+        fake_add_tool(tools, "drop");
+        fake_add_tool(tools, "droplisten");
+        fake_add_tool(tools, "expire");
+        char *reply = fake_result_message(id, result);
+        fake_http_respond(fd, "200 OK", reply);
+        free(reply);
+    } else if (name && strcmp(name, "echo") == 0) {
+        cJSON *note = cJSON_CreateObject();
+        cJSON_AddStringToObject(note, "jsonrpc", "2.0");
+        cJSON_AddStringToObject(note, "method", "notifications/message");
+        cJSON *note_params = cJSON_AddObjectToObject(note, "params");
+        cJSON_AddStringToObject(note_params, "level", "info");
+        cJSON_AddStringToObject(note_params, "data", "echoing");
+        char *note_str = fake_message(note);
+        char *ping = fake_ping_message();
+        const char *echo = cJSON_GetStringValue(cJSON_GetObjectItem(args, "text"));
+        char *reply = fake_result_message(id, fake_text_result(echo ? echo : ""));
+
+        fake_sse_begin(fd);
+        fake_sse_event(fd, NULL, NULL, note_str);
+        fake_sse_event(fd, NULL, NULL, ping);
+        fake_sse_event(fd, NULL, NULL, reply);
+        fake_sse_end(fd);
+        free(note_str);
+        free(ping);
+        free(reply);
+    } else if (name && strcmp(name, "sleep") == 0) {
+        cJSON *ms = cJSON_GetObjectItem(args, "ms");
+        int delay = cJSON_IsNumber(ms) ? ms->valueint : 0;
+        usleep((useconds_t)delay * 1000u);
+        char text[32];
+        snprintf(text, sizeof(text), "slept %d", delay);
+        char *reply = fake_result_message(id, fake_text_result(text));
+        fake_http_respond(fd, "200 OK", reply);
+        free(reply);
+    } else if (name && strcmp(name, "push") == 0) {
+        char *ping = fake_ping_message();
+        pthread_mutex_lock(&fake_http.lock);
+        int pushed = fake_http.listen_fd_open >= 0 &&
+                     fake_sse_event(fake_http.listen_fd_open, NULL, NULL, ping) == 0;
+        pthread_mutex_unlock(&fake_http.lock);
+        free(ping);
+        char *reply = fake_result_message(id, fake_text_result(pushed ? "pushed" : "no stream"));
+        fake_http_respond(fd, "200 OK", reply);
+        free(reply);
+    } else if (name && strcmp(name, "drop") == 0) {
+        cJSON *note = cJSON_CreateObject();
+        cJSON_AddStringToObject(note, "jsonrpc", "2.0");
+        cJSON_AddStringToObject(note, "method", "notifications/message");
+        cJSON_AddObjectToObject(note, "params");
+        char *note_str = fake_message(note);
+        pthread_mutex_lock(&fake_http.lock);
+        free(fake_http.replay);
+        fake_http.replay = fake_result_message(id, fake_text_result("replayed"));
+        pthread_mutex_unlock(&fake_http.lock);
+
+        fake_sse_begin(fd);
+        fake_sse_event(fd, "d1", NULL, note_str);
+        free(note_str);
+        rc = -1;  // Cut the stream without ending it
+    } else if (name && strcmp(name, "droplisten") == 0) {
+        char *ping = fake_ping_message();
+        pthread_mutex_lock(&fake_http.lock);
+        if (fake_http.listen_fd_open >= 0) {
+            fake_sse_event(fake_http.listen_fd_open, "l1", "retry: 50\n", ping);
+            fake_http.close_listen = 1;
+        }
+        pthread_mutex_unlock(&fake_http.lock);
+        free(ping);
+        char *reply = fake_result_message(id, fake_text_result("dropped"));
+        fake_http_respond(fd, "200 OK", reply);
+        free(reply);
+    } else if (name && strcmp(name, "expire") == 0) {
+        char *reply = fake_result_message(id, fake_text_result("expired"));
+        fake_http_respond(fd, "200 OK", reply);
+        free(reply);
+        pthread_mutex_lock(&fake_http.lock);
+        fake_http.session = -1;
+        fake_http.close_listen = 1;
+        pthread_mutex_unlock(&fake_http.lock);
+    } else {
+        fake_http_respond(fd, "400 Bad Request", NULL);
+    }
+
+    cJSON_Delete(msg);
+    return rc;
+}
+
+static void* fake_http_connection(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    static const size_t cap = 1 << 16;
+    char *buf = malloc(cap + 1);
+    size_t used = 0;
+
+    for (;;) {
+        char *end = NULL;
+        while (!(end = strstr(buf, "\r\n\r\n"))) {
+            ssize_t n = used < cap ? recv(fd, buf + used, cap - used, 0) : -1;
+            if (n <= 0) {
+                goto done;
+            }
+            used += (size_t)n;
+            buf[used] = '\0';
+        }
+        *end = '\0';
+        char *body = end + 4;
+        char value[64];
+        size_t body_len = fake_header(buf, "Content-Length", value, sizeof(value)) ? (size_t)atol(value) : 0;
+        while ((size_t)(body - buf) + body_len > used) {
+            ssize_t n = used < cap ? recv(fd, buf + used, cap - used, 0) : -1;
+            if (n <= 0) {
+                goto done;
+            }
+            used += (size_t)n;
+        }
+        char saved = body[body_len];
+        body[body_len] = '\0';
+
+        char session[32] = "";
+        fake_header(buf, "Mcp-Session-Id", session, sizeof(session));
+        pthread_mutex_lock(&fake_http.lock);
+        char current[32];
+        snprintf(current, sizeof(current), "s%d", fake_http.session);
+        int known = strcmp(session, current) == 0;
+        pthread_mutex_unlock(&fake_http.lock);
+
+        int rc = 0;
+        char last_event_id[32];
+        int resuming = fake_header(buf, "Last-Event-ID", last_event_id, sizeof(last_event_id));
+        if (strncmp(buf, "POST ", 5) == 0) {
+            if (!known && !strstr(body, "\"initialize\"")) {
+                fake_http_respond(fd, "404 Not Found", NULL);
+            } else {
+                rc = fake_http_post(fd, body);
+            }
+        } else if (strncmp(buf, "GET ", 4) == 0 && !known) {
+            fake_http_respond(fd, "404 Not Found", NULL);
+        } else if (strncmp(buf, "GET ", 4) == 0 && resuming && strcmp(last_event_id, "d1") == 0) {
+            pthread_mutex_lock(&fake_http.lock);
+            snprintf(fake_http.resumed_from, sizeof(fake_http.resumed_from), "%s", last_event_id);
+            char *replay = fake_http.replay;
+            fake_http.replay = NULL;
+            pthread_mutex_unlock(&fake_http.lock);
+            fake_sse_begin(fd);
+            fake_sse_event(fd, "d2", NULL, replay);
+            fake_sse_end(fd);
+            free(replay);
+        } else if (strncmp(buf, "GET ", 4) == 0) {
+            fake_http_listen(fd, resuming ? last_event_id : NULL);
+            rc = -1;
+        } else if (strncmp(buf, "DELETE ", 7) == 0) {
+            pthread_mutex_lock(&fake_http.lock);
+            fake_http.deletes += known;
+            pthread_mutex_unlock(&fake_http.lock);
+            fake_http_respond(fd, known ? "200 OK" : "404 Not Found", NULL);
+        } else {
+            fake_http_respond(fd, "405 Method Not Allowed", NULL);
+        }
+        if (rc != 0) {
+            break;
+        }
+
+        // Keep what followed this request for the next one
+        body[body_len] = saved;
+        size_t consumed = (size_t)(body - buf) + body_len;
+        memmove(buf, buf + consumed, used - consumed);
+        used -= consumed;
+        buf[used] = '\0';
+    }
+
+done:
+    free(buf);
+    close(fd);
+    return NULL;
+}
+
+static void* fake_http_accept(void *arg) {
+    (void)arg;
+    for (;;) {
+        pthread_mutex_lock(&fake_http.lock);
+        int stop = fake_http.stop;
+        pthread_mutex_unlock(&fake_http.lock);
+        if (stop) {
+            break;
+        }
+        struct pollfd pfd = {fake_http.listen_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 20) <= 0) {
+            continue;
+        }
+        int fd = accept(fake_http.listen_fd, NULL, NULL);
+        if (fd < 0) {
+            continue;
+        }
+        pthread_mutex_lock(&fake_http.lock);
+        if (fake_http.thread_count < FAKE_HTTP_MAX_THREADS &&
+            pthread_create(&fake_http.threads[fake_http.thread_count], NULL,
+                           fake_http_connection, (void *)(intptr_t)fd) == 0) {
+            fake_http.thread_count++;
+            fake_http.connections++;
+        } else {
+            close(fd);
+        }
+        pthread_mutex_unlock(&fake_http.lock);
+    }
+    return NULL;
+}
+
+static void fake_http_start(void) {
+    memset(&fake_http, 0, sizeof(fake_http));
+    pthread_mutex_init(&fake_http.lock, NULL);
+    fake_http.listen_fd_open = -1;
+
+    fake_http.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    assert(fake_http.listen_fd >= 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(fake_http.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+    assert(listen(fake_http.listen_fd, 16) == 0);
+    socklen_t len = sizeof(addr);
+    assert(getsockname(fake_http.listen_fd, (struct sockaddr *)&addr, &len) == 0);
+    fake_http.port = ntohs(addr.sin_port);
+    assert(pthread_create(&fake_http.accept_thread, NULL, fake_http_accept, NULL) == 0);
+}
+
+// Stop the server once the client has closed its connections
+static void fake_http_stop(void) {
+    pthread_mutex_lock(&fake_http.lock);
+    fake_http.stop = 1;
+    pthread_mutex_unlock(&fake_http.lock);
+    pthread_join(fake_http.accept_thread, NULL);
+    for (int i = 0; i < fake_http.thread_count; i++) {
+        pthread_join(fake_http.threads[i], NULL);
+    }
+    close(fake_http.listen_fd);
+    free(fake_http.replay);
+    pthread_mutex_destroy(&fake_http.lock);
+}
+
+static int fake_http_get(const int *field) {
+    pthread_mutex_lock(&fake_http.lock);
+    int value = *field;
+    pthread_mutex_unlock(&fake_http.lock);
+    return value;
+}
+
+// Wait up to two seconds for a counter of the fake server to reach value
+static int fake_http_wait(const int *field, int value) {
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (fake_http_get(field) < value) {
+        if (elapsed_seconds(&start) > 2.0) {
+            return 0;
+        }
+        usleep(5000);
+    }
+    return 1;
+}
+
+// Test helper: Load a config with the fake HTTP server and connect to it
+static MCPConfig* connect_fake_http_server(void) {
+    char config_json[1024];
+    snprintf(config_json, sizeof(config_json),
+             "{\"mcpServers\": {\"web\": {\"url\": \"http://127.0.0.1:%d/mcp\", "
+             "\"headers\": {\"X-Test\": \"1\"}}}}",
+             fake_http.port);
+
+    char *config_path = create_test_config(config_json);
+    assert(config_path != NULL);
+    MCPConfig *config = mcp_load_config(config_path);
+    remove_test_config(config_path);
+    assert(config != NULL && config->servers[0]->transport == MCP_TRANSPORT_SSE);
+    assert(config->servers[0]->header_count == 1);
+    assert(mcp_connect_server(config->servers[0]) == 0);
+    return config;
+}
+
+// Test 20: Requests over the streamable HTTP transport
+static void test_http_round_trips(void) {
+    printf("Test 20: HTTP transport round trips... ");
+
+    fake_http_start();
+    MCPConfig *config = connect_fake_http_server();
+    MCPServer *server = config->servers[0];
+    assert(mcp_discover_tools(server) == 6);
+
+    // SSE replies carry a notification and a ping ahead of the result
+    for (int i = 0; i < 50; i++) {
+        char text[32];
+        snprintf(text, sizeof(text), "hello %d", i);
+        MCPToolResult *result = call_fake_tool(server, "echo", "text", text, 0);
+        assert(!result->is_error);
+        assert(result->result && strcmp(result->result, text) == 0);
+        mcp_free_tool_result(result);
+    }
+    assert(fake_http_wait(&fake_http.pongs, 50));
+
+    // Connections are kept alive: the listening stream plus a few for requests
+    assert(fake_http_get(&fake_http.connections) <= 4);
+    assert(fake_http_get(&fake_http.inits) == 1);
+
+    mcp_free_config(config);
+    fake_http_stop();
+    printf("PASSED\n");
+}
+
+// Test 21: Calls from several threads are outstanding together
+static void test_http_concurrent_calls(void) {
+    printf("Test 21: HTTP transport concurrent calls... ");
+
+    fake_http_start();
+    MCPConfig *config = connect_fake_http_server();
+    double elapsed = run_parallel_sleeps(config->servers[0], 6);
+    assert(elapsed < 0.6);
+    mcp_free_config(config);
+    fake_http_stop();
+
+    printf("PASSED\n");
+}
+
+// Test 22: Listening stream, resumed streams and an expired session
+static void test_http_session_recovery(void) {
+    printf("Test 22: HTTP transport session recovery... ");
+
+    fake_http_start();
+    MCPConfig *config = connect_fake_http_server();
+    MCPServer *server = config->servers[0];
+    assert(fake_http_wait(&fake_http.listens, 1));
+
+    // A ping pushed on the listening stream is answered
+    MCPToolResult *result = call_fake_tool(server, "push", NULL, NULL, 0);
+    assert(result->result && strcmp(result->result, "pushed") == 0);
+    mcp_free_tool_result(result);
+    assert(fake_http_wait(&fake_http.pongs, 1));
+
+    // A reply stream cut after an event is resumed from it
+    result = call_fake_tool(server, "drop", NULL, NULL, 0);
+    assert(!result->is_error && result->result && strcmp(result->result, "replayed") == 0);
+    mcp_free_tool_result(result);
+    pthread_mutex_lock(&fake_http.lock);
+    assert(strcmp(fake_http.resumed_from, "d1") == 0);
+    pthread_mutex_unlock(&fake_http.lock);
+
+    // A dropped listening stream reopens after "retry:", from its last event
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    result = call_fake_tool(server, "droplisten", NULL, NULL, 0);
+    mcp_free_tool_result(result);
+    assert(fake_http_wait(&fake_http.listens, 2));
+    assert(elapsed_seconds(&start) < 0.5);
+    pthread_mutex_lock(&fake_http.lock);
+    assert(strcmp(fake_http.listen_resumed_from, "l1") == 0);
+    pthread_mutex_unlock(&fake_http.lock);
+
+    // After the session expires the next call initializes again and succeeds
+    result = call_fake_tool(server, "expire", NULL, NULL, 0);
+    mcp_free_tool_result(result);
+    result = call_fake_tool(server, "echo", "text", "again", 0);
+    assert(!result->is_error && result->result && strcmp(result->result, "again") == 0);
+    mcp_free_tool_result(result);
+    assert(fake_http_get(&fake_http.inits) == 2);
+    assert(fake_http_wait(&fake_http.listens, 3));
+
+    // Closing ends the session on the server
+    mcp_free_config(config);
+    assert(fake_http_get(&fake_http.deletes) == 1);
+    fake_http_stop();
+
+    printf("PASSED\n");
+}
+
+// Test 23: A server that exits is restarted, sooner the first time
+static void test_server_restart(void) {
+    printf("Test 23: Server restart with backoff... ");
+
+    MCPConfig *config = load_fake_servers(1, 0);
+    assert(mcp_start_servers(config) == 1);
+    mcp_wait_for_servers(config);
+    MCPServer *server = config->servers[0];
+
+    double recovered[2];
+    for (int k = 0; k < 2; k++) {
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        // The second time a child keeps stdout open; the exit is noticed anyway
+        cJSON *args = cJSON_CreateObject();
+        cJSON_AddNumberToObject(args, "code", 3);
+        if (k == 1) {
+            cJSON_AddNumberToObject(args, "linger", 3000);
+        }
+        MCPToolResult *result = mcp_call_tool(server, "exit", args);
+        cJSON_Delete(args);
+        assert(result && result->is_error);
+        mcp_free_tool_result(result);
+
+        // Calls fail at once while it is down
+        result = call_fake_tool(server, "echo", "text", "down", 0);
+        assert(result->is_error && result->result && strstr(result->result, "is down") != NULL);
+        mcp_free_tool_result(result);
+        assert(elapsed_seconds(&start) < 0.4);
+
+        char *status = mcp_get_status(config);
+        assert(status && strstr(status, "down (7 tools), exited with status 3, restart in") != NULL);
+        free(status);
+
+        // Back after the backoff, with its tools
+        for (;;) {
+            result = call_fake_tool(server, "echo", "text", "back", 0);
+            int back = !result->is_error && result->result && strcmp(result->result, "back") == 0;
+            mcp_free_tool_result(result);
+            if (back) {
+                break;
+            }
+            assert(elapsed_seconds(&start) < 5.0);
+            usleep(20000);
+        }
+        recovered[k] = elapsed_seconds(&start);
+        assert(count_tools(config) == 7);
+    }
+    assert(recovered[0] >= 0.5 && recovered[1] >= 1.0);
+
+    char *status = mcp_get_status(config);
+    assert(status && strstr(status, "connected (7 tools)") != NULL);
+    assert(strstr(status, "latency avg") != NULL);
+    assert(strstr(status, "restarted 2 times") != NULL);
+    free(status);
+
+    mcp_free_config(config);
+    printf("PASSED\n");
+}
+
+static int resource_is(MCPConfig *config, const char *uri, const char *expected) {
+    MCPResourceContent *content = mcp_read_resource(config, "fake0", uri);
+    assert(content != NULL);
+    int ok = !content->is_error && content->text && strcmp(content->text, expected) == 0 &&
+             content->mime_type && strcmp(content->mime_type, "text/plain") == 0 &&
+             content->uri && strcmp(content->uri, uri) == 0;
+    mcp_free_resource_content(content);
+    return ok;
+}
+
+// Test 24: Resource contents are read from memory until they expire or change
+static void test_resource_cache(void) {
+    printf("Test 24: Resource content cache... ");
+
+    MCPConfig *config = load_fake_servers(1, 0);
+    assert(mcp_start_servers(config) == 1);
+    mcp_wait_for_servers(config);
+
+    // The second read of each resource does not reach the server
+    assert(resource_is(config, "file:///a.md", "file:///a.md #1"));
+    assert(resource_is(config, "file:///a.md", "file:///a.md #1"));
+    assert(resource_is(config, "file:///b.md", "file:///b.md #2"));
+    assert(resource_is(config, "file:///b.md", "file:///b.md #2"));
+
+    // A change the server reports is read again; other resources stay
+    MCPToolResult *result = call_fake_tool(config->servers[0], "echo", "updated", "file:///a.md", 0);
+    assert(!result->is_error);
+    mcp_free_tool_result(result);
+    assert(resource_is(config, "file:///a.md", "file:///a.md #3"));
+    assert(resource_is(config, "file:///a.md", "file:///a.md #3"));
+    assert(resource_is(config, "file:///b.md", "file:///b.md #2"));
+
+    char *status = mcp_get_status(config);
+    assert(status && strstr(status, "Resource cache: 2 entries") != NULL);
+    assert(strstr(status, "4 hits, 3 misses") != NULL);
+    free(status);
+    mcp_free_config(config);
+
+    // Entries expire
+    setenv("CLAUDE_MCP_RESOURCE_CACHE_TTL_MS", "200", 1);
+    config = load_fake_servers(1, 0);
+    assert(mcp_start_servers(config) == 1);
+    mcp_wait_for_servers(config);
+    assert(resource_is(config, "file:///a.md", "file:///a.md #1"));
+    assert(resource_is(config, "file:///a.md", "file:///a.md #1"));
+    usleep(300000);
+    assert(resource_is(config, "file:///a.md", "file:///a.md #2"));
+    mcp_free_config(config);
+
+    // A TTL of 0 turns the cache off
+    setenv("CLAUDE_MCP_RESOURCE_CACHE_TTL_MS", "0", 1);
+    config = load_fake_servers(1, 0);
+    assert(mcp_start_servers(config) == 1);
+    mcp_wait_for_servers(config);
+    assert(resource_is(config, "file:///a.md", "file:///a.md #1"));
+    assert(resource_is(config, "file:///a.md", "file:///a.md #2"));
+    status = mcp_get_status(config);
+    assert(status && strstr(status, "Resource cache") == NULL);
+    free(status);
+    mcp_free_config(config);
+    unsetenv("CLAUDE_MCP_RESOURCE_CACHE_TTL_MS");
+
+    printf("PASSED\n");
+}
+
+// Test 25: A server's stderr reaches its log file, also across a restart
+static void test_stderr_capture(void) {
+    printf("Test 25: Stderr capture... ");
+
+    MCPConfig *config = load_fake_servers(1, 0);
+    assert(mcp_start_servers(config) == 1);
+    mcp_wait_for_servers(config);
+    MCPServer *server = config->servers[0];
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    MCPToolResult *result = call_fake_tool(server, "echo", "text", "before", 0);
+    assert(!result->is_error);
+    mcp_free_tool_result(result);
+
+    cJSON *args = cJSON_CreateObject();
+    cJSON_AddNumberToObject(args, "code", 3);
+    result = mcp_call_tool(server, "exit", args);
+    cJSON_Delete(args);
+    mcp_free_tool_result(result);
+    for (;;) {
+        result = call_fake_tool(server, "echo", "text", "after", 0);
+        int back = !result->is_error;
+        mcp_free_tool_result(result);
+        if (back) {
+            break;
+        }
+        assert(elapsed_seconds(&start) < 5.0);
+        usleep(20000);
+    }
+
+    char *status = mcp_get_status(config);
+    assert(status && strstr(status, ", stderr 1 KB (") != NULL);
+    free(status);
+    mcp_free_config(config);
+
+    // Closing the config flushed everything; the restart did not truncate
+    FILE *f = fopen(".claude-c/mcp/fake0.log", "r");
+    assert(f != NULL);
+    char line[256];
+    int echoes = 0;
+    while (fgets(line, sizeof(line), f)) {
+        echoes += strcmp(line, "echo called\n") == 0;
+    }
+    fclose(f);
+    assert(echoes == 2);
+
+    printf("PASSED\n");
+}
+
+// Test 26: Answering a flood of pings does not stop the client reading
+static void test_ping_flood(void) {
+    printf("Test 26: Ping flood... ");
+
+    MCPConfig *config = connect_fake_server(MCP_DEFAULT_MAX_IN_FLIGHT);
+    MCPServer *server = config->servers[0];
+
+    // The answers fill the server's stdin long before it reads them, while
+    // it is still writing pings to its stdout
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    MCPToolResult *result = call_fake_tool(server, "flood", "count", NULL, 20000);
+    assert(!result->is_error);
+    assert(result->result && strcmp(result->result, "flooded") == 0);
+    mcp_free_tool_result(result);
+    assert(elapsed_seconds(&start) < 5.0);
+
+    // Some answers were dropped, the rest came before this request
+    result = call_fake_tool(server, "pongs", NULL, NULL, 0);
+    assert(result->result);
+    int pongs = atoi(result->result);
+    assert(pongs > 0 && pongs < 20000);
+    mcp_free_tool_result(result);
+
+    result = call_fake_tool(server, "echo", "text", "still here", 0);
+    assert(result->result && strcmp(result->result, "still here") == 0);
+    mcp_free_tool_result(result);
+
+    mcp_free_config(config);
+    printf("PASSED\n");
+}
+
+// Test helper: Whether the fake server answers tool with text
+static int fake_tool_says(MCPServer *server, const char *tool, const char *text) {
+    MCPToolResult *result = call_fake_tool(server, tool, NULL, NULL, 0);
+    int ok = result->result && strcmp(result->result, text) == 0;
+    mcp_free_tool_result(result);
+    return ok;
+}
+
+// Test helper: Whether the resource listing holds one resource, called name
+static int listing_is(MCPConfig *config, const char *name) {
+    MCPResourceList *list = mcp_list_resources(config, NULL);
+    int ok = list && !list->is_error && list->count == 1 &&
+             list->resources[0]->name && strcmp(list->resources[0]->name, name) == 0;
+    mcp_free_resource_list(list);
+    return ok;
+}
+
+// Test 27: Resources are subscribed to once per connection, and the
+// listing is kept until the server reports that it changed
+static void test_resource_subscriptions(void) {
+    printf("Test 27: Resource subscriptions and listing... ");
+
+    MCPConfig *config = load_fake_servers(1, 0);
+    assert(mcp_start_servers(config) == 1);
+    mcp_wait_for_servers(config);
+    MCPServer *server = config->servers[0];
+
+    // A change makes the next read miss the cache, not subscribe again
+    assert(resource_is(config, "file:///a.md", "file:///a.md #1"));
+    MCPToolResult *result = call_fake_tool(server, "echo", "updated", "file:///a.md", 0);
+    mcp_free_tool_result(result);
+    assert(resource_is(config, "file:///a.md", "file:///a.md #2"));
+    assert(resource_is(config, "file:///b.md", "file:///b.md #3"));
+    assert(fake_tool_says(server, "subscribes", "2"));
+
+    assert(listing_is(config, "list #1"));
+    assert(listing_is(config, "list #1"));
+    assert(fake_tool_says(server, "relist", "relisted"));
+    assert(listing_is(config, "list #2"));
+    assert(listing_is(config, "list #2"));
+
+    // A new connection is a new server process: subscribe and list again
+    mcp_disconnect_server(server);
+    assert(mcp_connect_server(server) == 0);
+    assert(resource_is(config, "file:///a.md", "file:///a.md #1"));
+    assert(resource_is(config, "file:///a.md", "file:///a.md #1"));
+    assert(fake_tool_says(server, "subscribes", "1"));
+    assert(listing_is(config, "list #1"));
+
+    mcp_free_config(config);
+    printf("PASSED\n");
+}
+
+// Test 28: A tools/list that gets no reply holds up no other server
+static void test_slow_refresh(void) {
+    printf("Test 28: Slow tool refresh... ");
+
+    MCPConfig *config = load_fake_servers(2, 0);
+    assert(mcp_start_servers(config) == 2);
+    mcp_wait_for_servers(config);
+
+    assert(fake_tool_says(config->servers[0], "hang", "hung"));
+    usleep(100000);  // The refresh of fake0 is waiting for its reply
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    MCPToolResult *result = call_fake_tool(config->servers[1], "exit", NULL, NULL, 0);
+    assert(result->is_error);
+    mcp_free_tool_result(result);
+
+    // fake1 is back after its backoff, not after fake0's request timeout
+    for (;;) {
+        result = call_fake_tool(config->servers[1], "echo", "text", "back", 0);
+        int back = !result->is_error && result->result && strcmp(result->result, "back") == 0;
+        mcp_free_tool_result(result);
+        if (back) {
+            break;
+        }
+        assert(elapsed_seconds(&start) < 5.0);
+        usleep(20000);
+    }
+
+    // The refresh still waiting gives up when the config is freed
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    mcp_free_config(config);
+    assert(elapsed_seconds(&start) < 5.0);
+    printf("PASSED\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "--fake-server") == 0) {
+        return run_fake_server();
+    }
+    self_path = argv[0];
+
+    snprintf(cache_dir, sizeof(cache_dir), "/tmp/mcp_test_cache_XXXXXX");
+    assert(mkdtemp(cache_dir) != NULL);
+    setenv("CLAUDE_MCP_CACHE_DIR", cache_dir, 1);
+
     printf("=== MCP Integration Tests ===\\n\\n");
 
     test_mcp_init();
@@ -370,6 +1991,29 @@ int main(void) {
     test_mcp_get_status();
     test_find_tool_server();
     test_mkdir_p_func();
+    test_stdio_round_trips();
+    test_stdio_timeout();
+    test_stdio_server_exit();
+    test_stdio_concurrent_calls();
+    test_stdio_large_reply();
+    test_background_startup();
+    test_free_while_starting();
+    test_cached_tool_schemas();
+    test_tool_list_changes();
+    test_http_round_trips();
+    test_http_concurrent_calls();
+    test_http_session_recovery();
+    test_server_restart();
+    test_resource_cache();
+    test_stderr_capture();
+    test_ping_flood();
+    test_resource_subscriptions();
+    test_slow_refresh();
+
+    char cleanup[128];
+    snprintf(cleanup, sizeof(cleanup), "rm -rf %s", cache_dir);
+    int cleanup_result = system(cleanup);
+    (void)cleanup_result;
 
     printf("\\n=== All MCP tests passed! ===\\n");
     return 0;
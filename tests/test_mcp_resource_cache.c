@@ -0,0 +1,244 @@
+/*
+ * Unit Tests for the MCP resource cache
+ *
+ * Tests the in-memory cache of resource contents including:
+ * - Contents copied in and out, keyed by server and URI
+ * - Entries expiring after their TTL
+ * - Least recently used entries evicted to stay within the byte limit
+ * - Invalidation of one resource or a whole server
+ * - Reads that raced an invalidation kept out
+ * - Many entries after the table grows
+ *
+ * Compilation: make test-mcp-resource-cache
+ * Usage: ./test_mcp_resource_cache
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/mcp_resource_cache.h"
+
+// Test framework colors
+#define COLOR_RESET "\033[0m"
+#define COLOR_GREEN "\033[32m"
+#define COLOR_RED "\033[31m"
+#define COLOR_CYAN "\033[36m"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void print_test_result(const char *test_name, int passed) {
+    tests_run++;
+    if (passed) {
+        tests_passed++;
+        printf(COLOR_GREEN "✓ PASS" COLOR_RESET " %s\n", test_name);
+    } else {
+        tests_failed++;
+        printf(COLOR_RED "✗ FAIL" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_summary(void) {
+    printf("\n" COLOR_CYAN "Test Summary:" COLOR_RESET "\n");
+    printf("Tests run: %d\n", tests_run);
+    printf(COLOR_GREEN "Tests passed: %d\n" COLOR_RESET, tests_passed);
+    if (tests_failed > 0) {
+        printf(COLOR_RED "Tests failed: %d\n" COLOR_RESET, tests_failed);
+    } else {
+        printf(COLOR_GREEN "All tests passed!\n" COLOR_RESET);
+    }
+}
+
+// Store text under (server, uri) as of now_ms
+static int put_text(MCPResourceCache *cache, const char *server, const char *uri,
+                    const char *text, long long now_ms) {
+    char mime_type[] = "text/plain";
+    MCPResourceCacheValue value = {mime_type, strdup(text), NULL, 0};
+    int rc = mcp_resource_cache_put(cache, server, uri, &value, now_ms, mcp_resource_cache_epoch(cache));
+    free(value.text);
+    return rc;
+}
+
+// Whether (server, uri) is cached with text as of now_ms
+static int has_text(MCPResourceCache *cache, const char *server, const char *uri,
+                    const char *text, long long now_ms) {
+    MCPResourceCacheValue value;
+    int hit = mcp_resource_cache_get(cache, server, uri, now_ms, &value);
+    int ok = hit && value.text && strcmp(value.text, text) == 0;
+    mcp_resource_cache_value_clear(&value);
+    return ok;
+}
+
+static void test_round_trip(void) {
+    MCPResourceCache *cache = mcp_resource_cache_new(1 << 20, 1000);
+    int ok = cache != NULL;
+
+    unsigned char blob[300];
+    for (size_t i = 0; i < sizeof(blob); i++) {
+        blob[i] = (unsigned char)(i * 13);
+    }
+    char mime_type[] = "image/png";
+    char text[] = "# Guide\n";
+    MCPResourceCacheValue value = {mime_type, text, blob, sizeof(blob)};
+    ok = ok && mcp_resource_cache_put(cache, "docs", "file:///guide.md", &value, 0,
+                                      mcp_resource_cache_epoch(cache)) == 0;
+
+    // The caller's buffers are not kept
+    text[0] = 'X';
+    blob[0] = 0xff;
+
+    MCPResourceCacheValue got;
+    ok = ok && mcp_resource_cache_get(cache, "docs", "file:///guide.md", 10, &got) == 1;
+    ok = ok && got.mime_type && strcmp(got.mime_type, "image/png") == 0;
+    ok = ok && got.text && strcmp(got.text, "# Guide\n") == 0;
+    ok = ok && got.blob_size == sizeof(blob) && ((unsigned char *)got.blob)[0] == 0 &&
+         ((unsigned char *)got.blob)[299] == (unsigned char)(299 * 13);
+    mcp_resource_cache_value_clear(&got);
+
+    // The same URI on another server, or another URI, is not a hit
+    ok = ok && mcp_resource_cache_get(cache, "other", "file:///guide.md", 10, &got) == 0;
+    ok = ok && !got.text && !got.blob;
+    ok = ok && !has_text(cache, "docs", "file:///guide", "# Guide\n", 10);
+
+    // Storing again replaces the entry
+    ok = ok && put_text(cache, "docs", "file:///guide.md", "v2", 20) == 0;
+    ok = ok && has_text(cache, "docs", "file:///guide.md", "v2", 30);
+
+    MCPResourceCacheStats stats;
+    mcp_resource_cache_stats(cache, &stats);
+    ok = ok && stats.entries == 1 && stats.hits == 2 && stats.misses == 2 && stats.bytes > 0;
+
+    mcp_resource_cache_free(cache);
+    print_test_result("Contents are copied in and out by server and URI", ok);
+}
+
+static void test_ttl(void) {
+    MCPResourceCache *cache = mcp_resource_cache_new(1 << 20, 1000);
+    int ok = put_text(cache, "docs", "a", "alpha", 5000) == 0;
+    ok = ok && has_text(cache, "docs", "a", "alpha", 5999);
+    ok = ok && !has_text(cache, "docs", "a", "alpha", 6000);
+
+    // The expired entry is gone, not just hidden
+    MCPResourceCacheStats stats;
+    mcp_resource_cache_stats(cache, &stats);
+    ok = ok && stats.entries == 0 && stats.bytes == 0;
+    mcp_resource_cache_free(cache);
+
+    // A TTL of 0 caches nothing, and a NULL cache is accepted everywhere
+    ok = ok && mcp_resource_cache_new(1 << 20, 0) == NULL;
+    ok = ok && put_text(NULL, "docs", "a", "alpha", 0) == -1;
+    ok = ok && !has_text(NULL, "docs", "a", "alpha", 0);
+    mcp_resource_cache_invalidate(NULL, "docs", NULL);
+    mcp_resource_cache_free(NULL);
+    print_test_result("Entries expire after their TTL", ok);
+}
+
+static void test_lru_eviction(void) {
+    char text[1001];
+    memset(text, 'x', 1000);
+    text[1000] = '\0';
+
+    // Room for three 1000-byte entries and their bookkeeping, not four
+    MCPResourceCache *cache = mcp_resource_cache_new(3600, 60000);
+    int ok = put_text(cache, "s", "a", text, 0) == 0;
+    ok = ok && put_text(cache, "s", "b", text, 1) == 0;
+    ok = ok && put_text(cache, "s", "c", text, 2) == 0;
+
+    // Reading a makes b the least recently used
+    ok = ok && has_text(cache, "s", "a", text, 3);
+    ok = ok && put_text(cache, "s", "d", text, 4) == 0;
+    ok = ok && !has_text(cache, "s", "b", text, 5);
+    ok = ok && has_text(cache, "s", "a", text, 5);
+    ok = ok && has_text(cache, "s", "c", text, 5);
+    ok = ok && has_text(cache, "s", "d", text, 5);
+
+    MCPResourceCacheStats stats;
+    mcp_resource_cache_stats(cache, &stats);
+    ok = ok && stats.entries == 3 && stats.bytes <= 3600;
+
+    // A value larger than the whole cache is not stored and evicts nothing
+    char *huge = malloc(5000);
+    memset(huge, 'y', 4999);
+    huge[4999] = '\0';
+    ok = ok && put_text(cache, "s", "huge", huge, 6) == -1;
+    mcp_resource_cache_stats(cache, &stats);
+    ok = ok && stats.entries == 3;
+    free(huge);
+
+    mcp_resource_cache_free(cache);
+    print_test_result("Least recently used entries are evicted first", ok);
+}
+
+static void test_invalidation(void) {
+    MCPResourceCache *cache = mcp_resource_cache_new(1 << 20, 60000);
+    int ok = put_text(cache, "one", "a", "1a", 0) == 0;
+    ok = ok && put_text(cache, "one", "b", "1b", 0) == 0;
+    ok = ok && put_text(cache, "two", "a", "2a", 0) == 0;
+
+    mcp_resource_cache_invalidate(cache, "one", "a");
+    ok = ok && !has_text(cache, "one", "a", "1a", 1);
+    ok = ok && has_text(cache, "one", "b", "1b", 1);
+    ok = ok && has_text(cache, "two", "a", "2a", 1);
+
+    mcp_resource_cache_invalidate(cache, "one", NULL);
+    ok = ok && !has_text(cache, "one", "b", "1b", 1);
+    ok = ok && has_text(cache, "two", "a", "2a", 1);
+
+    // A read that started before a change was reported is not stored
+    unsigned long epoch = mcp_resource_cache_epoch(cache);
+    mcp_resource_cache_invalidate(cache, "two", "c");
+    char stale[] = "stale";
+    MCPResourceCacheValue value = {NULL, stale, NULL, 0};
+    ok = ok && mcp_resource_cache_put(cache, "two", "c", &value, 2, epoch) == -1;
+    ok = ok && !has_text(cache, "two", "c", "stale", 3);
+    ok = ok && mcp_resource_cache_put(cache, "two", "c", &value, 2,
+                                      mcp_resource_cache_epoch(cache)) == 0;
+    ok = ok && has_text(cache, "two", "c", "stale", 3);
+
+    mcp_resource_cache_free(cache);
+    print_test_result("Invalidation drops entries and keeps racing reads out", ok);
+}
+
+static void test_many_entries(void) {
+    enum { ENTRIES = 5000 };
+    MCPResourceCache *cache = mcp_resource_cache_new(64u << 20, 60000);
+    char uri[64];
+    char text[64];
+    int ok = cache != NULL;
+    for (int i = 0; i < ENTRIES && ok; i++) {
+        snprintf(uri, sizeof(uri), "file:///doc/%d", i);
+        snprintf(text, sizeof(text), "contents %d", i);
+        ok = put_text(cache, (i % 2) ? "odd" : "even", uri, text, 0) == 0;
+    }
+    for (int i = 0; i < ENTRIES && ok; i++) {
+        snprintf(uri, sizeof(uri), "file:///doc/%d", i);
+        snprintf(text, sizeof(text), "contents %d", i);
+        ok = has_text(cache, (i % 2) ? "odd" : "even", uri, text, 1) &&
+             !has_text(cache, (i % 2) ? "even" : "odd", uri, text, 1);
+    }
+
+    mcp_resource_cache_invalidate(cache, "odd", NULL);
+    MCPResourceCacheStats stats;
+    mcp_resource_cache_stats(cache, &stats);
+    ok = ok && stats.entries == ENTRIES / 2;
+
+    mcp_resource_cache_free(cache);
+    print_test_result("Thousands of entries resolve after the table grows", ok);
+}
+
+int main(void) {
+    printf(COLOR_CYAN "Running MCP Resource Cache tests..." COLOR_RESET "\n\n");
+
+    test_round_trip();
+    test_ttl();
+    test_lru_eviction();
+    test_invalidation();
+    test_many_entries();
+
+    print_summary();
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,219 @@
+/*
+ * Unit Tests for the MCP stderr capture
+ *
+ * Tests the ring the reader thread queues a server's stderr into including:
+ * - Output written to the log file and handed out line by line
+ * - Lines split across reads joined, overlong lines split
+ * - The oldest output dropped when the ring overflows, and noted in the file
+ * - The byte rate over the last window
+ * - A NULL path or NULL log accepted
+ *
+ * Compilation: make test-mcp-stderr
+ * Usage: ./test_mcp_stderr
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/mcp_stderr.h"
+
+// Test framework colors
+#define COLOR_RESET "\033[0m"
+#define COLOR_GREEN "\033[32m"
+#define COLOR_RED "\033[31m"
+#define COLOR_CYAN "\033[36m"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void print_test_result(const char *test_name, int passed) {
+    tests_run++;
+    if (passed) {
+        tests_passed++;
+        printf(COLOR_GREEN "✓ PASS" COLOR_RESET " %s\n", test_name);
+    } else {
+        tests_failed++;
+        printf(COLOR_RED "✗ FAIL" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_summary(void) {
+    printf("\n" COLOR_CYAN "Test Summary:" COLOR_RESET "\n");
+    printf("Tests run: %d\n", tests_run);
+    printf(COLOR_GREEN "Tests passed: %d\n" COLOR_RESET, tests_passed);
+    if (tests_failed > 0) {
+        printf(COLOR_RED "Tests failed: %d\n" COLOR_RESET, tests_failed);
+    } else {
+        printf(COLOR_GREEN "All tests passed!\n" COLOR_RESET);
+    }
+}
+
+// Lines handed to the callback; read only after mcp_stderr_close()
+typedef struct {
+    char *lines[64];
+    int count;
+} LineList;
+
+static void collect_line(void *ctx, const char *line) {
+    LineList *list = ctx;
+    if (list->count < 64) {
+        list->lines[list->count++] = strdup(line);
+    }
+}
+
+static void clear_lines(LineList *list) {
+    for (int i = 0; i < list->count; i++) {
+        free(list->lines[i]);
+    }
+    list->count = 0;
+}
+
+static void log_path(char *path, size_t size, const char *name) {
+    snprintf(path, size, "/tmp/test_mcp_stderr_%d_%s.log", (int)getpid(), name);
+}
+
+// Contents of path (caller frees), or NULL
+static char* read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    char *data = calloc(1, 65536);
+    if (data) {
+        size_t n = fread(data, 1, 65535, f);
+        data[n] = '\0';
+    }
+    fclose(f);
+    return data;
+}
+
+static void test_lines(void) {
+    char path[256];
+    log_path(path, sizeof(path), "lines");
+    LineList list = {{0}, 0};
+
+    MCPStderrLog *log = mcp_stderr_open(path, MCP_STDERR_RING_SIZE, collect_line, &list);
+    int ok = log != NULL;
+    mcp_stderr_append(log, "starting up\nlisten", 18, 1);
+    mcp_stderr_append(log, "ing on stdio\r\n\n", 15, 2);
+    mcp_stderr_append(log, "no newline at the end", 21, 3);
+
+    MCPStderrStats stats;
+    mcp_stderr_stats(log, 3, &stats);
+    ok = ok && stats.bytes == 54 && stats.lines == 3 && stats.dropped == 0;
+    mcp_stderr_close(log);
+
+    // Whole lines, without the empty one or the carriage return, and the
+    // unterminated one flushed on close
+    ok = ok && list.count == 3;
+    ok = ok && list.count > 0 && strcmp(list.lines[0], "starting up") == 0;
+    ok = ok && list.count > 1 && strcmp(list.lines[1], "listening on stdio") == 0;
+    ok = ok && list.count > 2 && strcmp(list.lines[2], "no newline at the end") == 0;
+
+    // The file gets the output as it was written
+    char *data = read_file(path);
+    ok = ok && data &&
+         strcmp(data, "starting up\nlistening on stdio\r\n\nno newline at the end") == 0;
+    free(data);
+    unlink(path);
+    clear_lines(&list);
+    print_test_result("Output reaches the file and the callback line by line", ok);
+}
+
+static void test_long_line(void) {
+    LineList list = {{0}, 0};
+    size_t len = MCP_STDERR_MAX_LINE * 2 + 10;
+    char *text = malloc(len + 1);
+    memset(text, 'a', len);
+    text[len] = '\n';
+
+    MCPStderrLog *log = mcp_stderr_open(NULL, MCP_STDERR_RING_SIZE, collect_line, &list);
+    int ok = log != NULL;
+    mcp_stderr_append(log, text, len + 1, 1);
+    mcp_stderr_close(log);
+
+    ok = ok && list.count == 3;
+    ok = ok && list.count == 3 && strlen(list.lines[0]) == MCP_STDERR_MAX_LINE &&
+         strlen(list.lines[1]) == MCP_STDERR_MAX_LINE && strlen(list.lines[2]) == 10;
+    free(text);
+    clear_lines(&list);
+    print_test_result("Overlong lines are split, a NULL path writes no file", ok);
+}
+
+static void test_overflow(void) {
+    char path[256];
+    log_path(path, sizeof(path), "overflow");
+
+    // More than the ring holds at once: only the newest 16 bytes are kept
+    MCPStderrLog *log = mcp_stderr_open(path, 16, NULL, NULL);
+    int ok = log != NULL;
+    mcp_stderr_append(log, "0123456789abcdefghijklmnopqrstuvwxyzABCD", 40, 1);
+
+    MCPStderrStats stats;
+    mcp_stderr_stats(log, 1, &stats);
+    ok = ok && stats.bytes == 40 && stats.dropped == 24;
+    mcp_stderr_close(log);
+
+    char *data = read_file(path);
+    ok = ok && data && strstr(data, "[24 bytes of stderr dropped]") != NULL;
+    ok = ok && data && strlen(data) >= 16 &&
+         strcmp(data + strlen(data) - 16, "opqrstuvwxyzABCD") == 0;
+    ok = ok && data && strstr(data, "0123") == NULL;
+    free(data);
+    unlink(path);
+    print_test_result("The oldest output is dropped when the ring overflows", ok);
+}
+
+static void test_rate(void) {
+    MCPStderrLog *log = mcp_stderr_open(NULL, MCP_STDERR_RING_SIZE, NULL, NULL);
+    char chunk[2048];
+    memset(chunk, 'x', sizeof(chunk));
+
+    MCPStderrStats stats;
+    mcp_stderr_stats(log, 500, &stats);
+    int ok = log != NULL && stats.bytes == 0 && stats.bytes_per_sec <= 0.0;
+
+    // 4 KB in the first second
+    mcp_stderr_append(log, chunk, 2048, 1000);
+    mcp_stderr_append(log, chunk, 2048, 1500);
+    mcp_stderr_append(log, chunk, 1024, 2000);
+    mcp_stderr_stats(log, 2500, &stats);
+    ok = ok && stats.bytes == 5120 && stats.bytes_per_sec > 4095.0 && stats.bytes_per_sec < 4097.0;
+
+    // Quiet since: the last 1 KB averages out over the time gone by
+    mcp_stderr_stats(log, 4000, &stats);
+    ok = ok && stats.bytes_per_sec > 511.0 && stats.bytes_per_sec < 513.0;
+    mcp_stderr_stats(log, 1002000, &stats);
+    ok = ok && stats.bytes_per_sec < 1.1;
+
+    mcp_stderr_close(log);
+    print_test_result("The byte rate covers the last second and decays when quiet", ok);
+}
+
+static void test_null(void) {
+    MCPStderrStats stats;
+    mcp_stderr_append(NULL, "x", 1, 0);
+    mcp_stderr_stats(NULL, 0, &stats);
+    mcp_stderr_close(NULL);
+    int ok = stats.bytes == 0 && stats.dropped == 0 && stats.bytes_per_sec <= 0.0;
+    ok = ok && mcp_stderr_open(NULL, 0, NULL, NULL) == NULL;
+    print_test_result("A NULL log is accepted everywhere", ok);
+}
+
+int main(void) {
+    printf(COLOR_CYAN "Running MCP Stderr tests..." COLOR_RESET "\n\n");
+
+    test_lines();
+    test_long_line();
+    test_overflow();
+    test_rate();
+    test_null();
+
+    print_summary();
+    return tests_failed > 0 ? 1 : 0;
+}
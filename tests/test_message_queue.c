@@ -3,7 +3,9 @@
  *
  * Tests both TUI message queue and AI instruction queue with:
  * - Basic enqueue/dequeue operations
- * - Overflow behavior
+ * - Overflow behavior (backpressure, drop counting, overflow marker)
+ * - Inline storage of short message text
+ * - Priority lanes (urgent messages bypass bulk output)
  * - Thread safety (concurrent access)
  * - Shutdown behavior
  * - Memory leak checks
@@ -49,9 +51,10 @@ static void test_tui_msg_queue_init_free(void) {
 
     TUIMessageQueue queue = {0};
     ASSERT(tui_msg_queue_init(&queue, 10) == 0);
-    ASSERT(queue.capacity == 10);
-    ASSERT(queue.count == 0);
-    ASSERT(queue.messages != NULL);
+    ASSERT(queue.lanes[TUI_PRIORITY_BULK].capacity == 10);
+    ASSERT(queue.lanes[TUI_PRIORITY_URGENT].capacity == TUI_MSG_URGENT_CAPACITY);
+    ASSERT(tui_msg_queue_depth(&queue, TUI_PRIORITY_BULK) == 0);
+    ASSERT(queue.lanes[TUI_PRIORITY_BULK].messages != NULL);
 
     tui_msg_queue_free(&queue);
 
@@ -66,16 +69,16 @@ static void test_tui_msg_post_and_poll(void) {
 
     /* Post a message */
     ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "Hello, World!") == 0);
-    ASSERT(queue.count == 1);
+    ASSERT(tui_msg_queue_depth(&queue, TUI_PRIORITY_BULK) == 1);
 
     /* Poll the message */
     TUIMessage msg = {0};
     ASSERT(poll_tui_message(&queue, &msg) == 1);
     ASSERT(msg.type == TUI_MSG_ADD_LINE);
     ASSERT(strcmp(msg.text, "Hello, World!") == 0);
-    ASSERT(queue.count == 0);
+    ASSERT(tui_msg_queue_depth(&queue, TUI_PRIORITY_BULK) == 0);
 
-    free(msg.text);
+    tui_message_release(&msg);
     tui_msg_queue_free(&queue);
 
     TEST_PASS();
@@ -101,32 +104,214 @@ static void test_tui_msg_queue_overflow(void) {
 
     TUIMessageQueue queue = {0};
     ASSERT(tui_msg_queue_init(&queue, 3) == 0);
+    queue.post_timeout_ms = 20;
 
     /* Fill queue to capacity */
     ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "Message 1") == 0);
     ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "Message 2") == 0);
     ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "Message 3") == 0);
-    ASSERT(queue.count == 3);
+    ASSERT(tui_msg_queue_depth(&queue, TUI_PRIORITY_BULK) == 3);
+
+    /* Nobody consumes, so the post waits for space and is then dropped */
+    ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "Message 4") == -1);
+    ASSERT(tui_msg_queue_depth(&queue, TUI_PRIORITY_BULK) == 3);
+
+    /* The consumer has not moved since, so this one drops without waiting */
+    ASSERT(post_tui_message(&queue, TUI_MSG_CLEAR, NULL) == -1);
+
+    /* The urgent lane has its own room */
+    ASSERT(post_token_update(&queue, 1, 2, 3) == 0);
 
-    /* Overflow should drop oldest (Message 1) */
-    ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "Message 4") == 0);
-    ASSERT(queue.count == 3);
+    TUIMessageQueueStats stats;
+    tui_msg_queue_get_stats(&queue, &stats);
+    ASSERT(stats.lanes[TUI_PRIORITY_BULK].posted == 3);
+    ASSERT(stats.lanes[TUI_PRIORITY_BULK].dropped == 2);
+    ASSERT(stats.lanes[TUI_PRIORITY_BULK].waited == 1);
+    ASSERT(stats.lanes[TUI_PRIORITY_URGENT].posted == 1);
+    ASSERT(stats.dropped == 2);
 
-    /* First message should be "Message 2" */
+    /* Urgent first, then queued messages in order, nothing is evicted */
     TUIMessage msg = {0};
+    ASSERT(poll_tui_message(&queue, &msg) == 1);
+    ASSERT(msg.type == TUI_MSG_TOKEN_UPDATE);
+
+    ASSERT(poll_tui_message(&queue, &msg) == 1);
+    ASSERT(strcmp(msg.text, "Message 1") == 0);
+    tui_message_release(&msg);
+
     ASSERT(poll_tui_message(&queue, &msg) == 1);
     ASSERT(strcmp(msg.text, "Message 2") == 0);
-    free(msg.text);
+    tui_message_release(&msg);
 
-    /* Second message should be "Message 3" */
     ASSERT(poll_tui_message(&queue, &msg) == 1);
     ASSERT(strcmp(msg.text, "Message 3") == 0);
-    free(msg.text);
+    tui_message_release(&msg);
+
+    /* Then the loss is reported once */
+    ASSERT(tui_msg_queue_pending(&queue));
+    ASSERT(poll_tui_message(&queue, &msg) == 1);
+    ASSERT(msg.type == TUI_MSG_ERROR);
+    ASSERT(strstr(msg.text, "2 message(s) dropped") != NULL);
+    tui_message_release(&msg);
+
+    ASSERT(!tui_msg_queue_pending(&queue));
+    ASSERT(poll_tui_message(&queue, &msg) == 0);
+
+    tui_msg_queue_free(&queue);
+
+    TEST_PASS();
+}
+
+static void test_tui_msg_queue_overflow_marker_order(void) {
+    TEST(test_tui_msg_queue_overflow_marker_order);
+
+    TUIMessageQueue queue = {0};
+    ASSERT(tui_msg_queue_init(&queue, 2) == 0);
+    queue.post_timeout_ms = 0;
+
+    ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "A") == 0);
+    ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "B") == 0);
+    ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "lost") == -1);
+
+    TUIMessage msg = {0};
+    ASSERT(poll_tui_message(&queue, &msg) == 1);
+    ASSERT(strcmp(msg.text, "A") == 0);
+    tui_message_release(&msg);
+    ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "C") == 0);
+
+    /* The marker appears where the message went missing: after B, before C */
+    ASSERT(poll_tui_message(&queue, &msg) == 1);
+    ASSERT(strcmp(msg.text, "B") == 0);
+    tui_message_release(&msg);
+    ASSERT(poll_tui_message(&queue, &msg) == 1);
+    ASSERT(msg.type == TUI_MSG_ERROR);
+    ASSERT(strstr(msg.text, "1 message(s) dropped") != NULL);
+    tui_message_release(&msg);
+    ASSERT(poll_tui_message(&queue, &msg) == 1);
+    ASSERT(strcmp(msg.text, "C") == 0);
+    tui_message_release(&msg);
+    ASSERT(poll_tui_message(&queue, &msg) == 0);
+
+    tui_msg_queue_free(&queue);
+
+    TEST_PASS();
+}
+
+static void test_tui_msg_queue_priority_lanes(void) {
+    TEST(test_tui_msg_queue_priority_lanes);
+
+    TUIMessageQueue queue = {0};
+    ASSERT(tui_msg_queue_init(&queue, 8) == 0);
+    queue.post_timeout_ms = 0;
+
+    ASSERT(tui_message_priority(TUI_MSG_ADD_LINE) == TUI_PRIORITY_BULK);
+    ASSERT(tui_message_priority(TUI_MSG_CLEAR) == TUI_PRIORITY_BULK);
+    ASSERT(tui_message_priority(TUI_MSG_STATUS) == TUI_PRIORITY_URGENT);
+    ASSERT(tui_message_priority(TUI_MSG_ERROR) == TUI_PRIORITY_URGENT);
+    ASSERT(tui_message_priority(TUI_MSG_TOKEN_UPDATE) == TUI_PRIORITY_URGENT);
+
+    /* Bulk output fills its lane; status and errors still get through */
+    for (int i = 0; i < 8; i++) {
+        ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "line") == 0);
+    }
+    ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "lost") == -1);
+    ASSERT(post_tui_message(&queue, TUI_MSG_STATUS, "Working") == 0);
+    ASSERT(post_tui_message(&queue, TUI_MSG_ERROR, "Boom") == 0);
+    ASSERT(tui_msg_queue_depth(&queue, TUI_PRIORITY_URGENT) == 2);
 
-    /* Third message should be "Message 4" */
+    /* Urgent messages come out first, in their own order */
+    TUIMessage msg = {0};
+    ASSERT(poll_tui_message(&queue, &msg) == 1);
+    ASSERT(msg.type == TUI_MSG_STATUS && msg.priority == TUI_PRIORITY_URGENT);
+    tui_message_release(&msg);
     ASSERT(poll_tui_message(&queue, &msg) == 1);
-    ASSERT(strcmp(msg.text, "Message 4") == 0);
-    free(msg.text);
+    ASSERT(msg.type == TUI_MSG_ERROR && strcmp(msg.text, "Boom") == 0);
+    tui_message_release(&msg);
+
+    /* A single lane can be polled on its own */
+    ASSERT(poll_tui_message_lane(&queue, TUI_PRIORITY_URGENT, &msg) == 0);
+    ASSERT(poll_tui_message_lane(&queue, TUI_PRIORITY_BULK, &msg) == 1);
+    ASSERT(msg.type == TUI_MSG_ADD_LINE && msg.priority == TUI_PRIORITY_BULK);
+    tui_message_release(&msg);
+
+    int lines = 0;
+    int markers = 0;
+    while (poll_tui_message(&queue, &msg) == 1) {
+        if (msg.type == TUI_MSG_ERROR) {
+            markers++;
+        } else {
+            lines++;
+        }
+        tui_message_release(&msg);
+    }
+    ASSERT(lines == 7);
+    ASSERT(markers == 1);
+
+    TUIMessageQueueStats stats;
+    tui_msg_queue_get_stats(&queue, &stats);
+    ASSERT(stats.lanes[TUI_PRIORITY_URGENT].delivered == 2);
+    ASSERT(stats.lanes[TUI_PRIORITY_URGENT].dropped == 0);
+    ASSERT(stats.lanes[TUI_PRIORITY_BULK].delivered == 8);
+    ASSERT(stats.lanes[TUI_PRIORITY_BULK].dropped == 1);
+    ASSERT(stats.lanes[TUI_PRIORITY_BULK].latency_max_ns >=
+           stats.lanes[TUI_PRIORITY_BULK].latency_avg_ns);
+
+    tui_msg_queue_free(&queue);
+
+    TEST_PASS();
+}
+
+static void test_tui_msg_queue_inline_text(void) {
+    TEST(test_tui_msg_queue_inline_text);
+
+    TUIMessageQueue queue = {0};
+    ASSERT(tui_msg_queue_init(&queue, 4) == 0);
+
+    char long_text[TUI_MSG_INLINE_TEXT * 3];
+    memset(long_text, 'x', sizeof(long_text) - 1);
+    long_text[sizeof(long_text) - 1] = '\0';
+
+    ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, "short") == 0);
+    ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, long_text) == 0);
+
+    TUIMessageQueueStats stats;
+    tui_msg_queue_get_stats(&queue, &stats);
+    ASSERT(stats.heap_text == 1);
+
+    /* Short text lives inside the caller's message */
+    TUIMessage msg = {0};
+    ASSERT(poll_tui_message(&queue, &msg) == 1);
+    ASSERT(msg.text == msg.inline_text);
+    ASSERT(strcmp(msg.text, "short") == 0);
+    tui_message_release(&msg);
+    ASSERT(msg.text == NULL);
+
+    ASSERT(poll_tui_message(&queue, &msg) == 1);
+    ASSERT(msg.text != msg.inline_text);
+    ASSERT(strcmp(msg.text, long_text) == 0);
+    tui_message_release(&msg);
+
+    /* Unconsumed heap text is freed with the queue */
+    ASSERT(post_tui_message(&queue, TUI_MSG_ADD_LINE, long_text) == 0);
+    tui_msg_queue_free(&queue);
+
+    TEST_PASS();
+}
+
+static void test_tui_msg_queue_token_update(void) {
+    TEST(test_tui_msg_queue_token_update);
+
+    TUIMessageQueue queue = {0};
+    ASSERT(tui_msg_queue_init(&queue, 4) == 0);
+    ASSERT(post_token_update(&queue, 1200, 345, 67) == 0);
+
+    TUIMessage msg = {0};
+    ASSERT(poll_tui_message(&queue, &msg) == 1);
+    ASSERT(msg.type == TUI_MSG_TOKEN_UPDATE);
+    ASSERT(msg.text == NULL);
+    ASSERT(msg.prompt_tokens == 1200);
+    ASSERT(msg.completion_tokens == 345);
+    ASSERT(msg.cached_tokens == 67);
 
     tui_msg_queue_free(&queue);
 
@@ -174,7 +359,7 @@ static void* tui_msg_consumer(void *arg) {
     while (consumed < 100) {
         TUIMessage msg = {0};
         if (poll_tui_message(queue, &msg) == 1) {
-            free(msg.text);
+            tui_message_release(&msg);
             consumed++;
         }
         usleep(100);
@@ -201,6 +386,81 @@ static void test_tui_msg_queue_concurrent(void) {
     TEST_PASS();
 }
 
+/* Several producers against a small queue: backpressure, not loss */
+#define TUI_STRESS_PRODUCERS 4
+#define TUI_STRESS_MESSAGES 2000
+
+typedef struct {
+    TUIMessageQueue *queue;
+    int id;
+} TUIStressArg;
+
+static void* tui_msg_stress_producer(void *arg) {
+    TUIStressArg *stress = (TUIStressArg*)arg;
+
+    for (int i = 0; i < TUI_STRESS_MESSAGES; i++) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%d %d", stress->id, i);
+        while (post_tui_message(stress->queue, TUI_MSG_ADD_LINE, buf) != 0) {
+            usleep(100);
+        }
+    }
+
+    return NULL;
+}
+
+static void test_tui_msg_queue_multi_producer(void) {
+    TEST(test_tui_msg_queue_multi_producer);
+
+    TUIMessageQueue queue = {0};
+    ASSERT(tui_msg_queue_init(&queue, 16) == 0);
+    queue.post_timeout_ms = 1000;
+
+    pthread_t producers[TUI_STRESS_PRODUCERS];
+    TUIStressArg args[TUI_STRESS_PRODUCERS];
+    for (int i = 0; i < TUI_STRESS_PRODUCERS; i++) {
+        args[i].queue = &queue;
+        args[i].id = i;
+        ASSERT(pthread_create(&producers[i], NULL, tui_msg_stress_producer, &args[i]) == 0);
+    }
+
+    /* Every message arrives once, in order per producer */
+    int next[TUI_STRESS_PRODUCERS] = {0};
+    int received = 0;
+    int in_order = 1;
+    while (received < TUI_STRESS_PRODUCERS * TUI_STRESS_MESSAGES) {
+        TUIMessage msg = {0};
+        if (poll_tui_message(&queue, &msg) != 1) {
+            continue;
+        }
+        int id = -1;
+        int seq = -1;
+        if (msg.type != TUI_MSG_ADD_LINE || sscanf(msg.text, "%d %d", &id, &seq) != 2 ||
+            id < 0 || id >= TUI_STRESS_PRODUCERS || seq != next[id]) {
+            in_order = 0;
+        } else {
+            next[id]++;
+        }
+        tui_message_release(&msg);
+        received++;
+    }
+
+    for (int i = 0; i < TUI_STRESS_PRODUCERS; i++) {
+        pthread_join(producers[i], NULL);
+    }
+
+    ASSERT(in_order);
+    ASSERT(tui_msg_queue_depth(&queue, TUI_PRIORITY_BULK) == 0);
+
+    TUIMessageQueueStats stats;
+    tui_msg_queue_get_stats(&queue, &stats);
+    ASSERT(stats.posted == (size_t)(TUI_STRESS_PRODUCERS * TUI_STRESS_MESSAGES));
+
+    tui_msg_queue_free(&queue);
+
+    TEST_PASS();
+}
+
 static void test_tui_msg_queue_shutdown(void) {
     TEST(test_tui_msg_queue_shutdown);
 
@@ -455,8 +715,13 @@ int main(void) {
     test_tui_msg_post_and_poll();
     test_tui_msg_queue_empty_poll();
     test_tui_msg_queue_overflow();
+    test_tui_msg_queue_overflow_marker_order();
+    test_tui_msg_queue_priority_lanes();
+    test_tui_msg_queue_inline_text();
+    test_tui_msg_queue_token_update();
     test_tui_msg_queue_null_text();
     test_tui_msg_queue_concurrent();
+    test_tui_msg_queue_multi_producer();
     test_tui_msg_queue_shutdown();
 
     /* AI Instruction Queue Tests */
@@ -0,0 +1,329 @@
+/*
+ * Unit Tests for the conversation search index
+ *
+ * Tests the trigram search index including:
+ * - Case-insensitive matches and their offsets across document parts
+ * - Queries shorter than a trigram
+ * - Patterns with no match and resetting the index
+ * - Random documents and queries compared with a plain scan
+ * - Many documents added one at a time
+ * - Text supplied by the caller only when candidates are verified
+ *
+ * Compilation: make test-search-index
+ * Usage: ./test_search_index
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/search_index.h"
+
+// Test framework colors
+#define COLOR_RESET "\033[0m"
+#define COLOR_GREEN "\033[32m"
+#define COLOR_RED "\033[31m"
+#define COLOR_CYAN "\033[36m"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void print_test_result(const char *test_name, int passed) {
+    tests_run++;
+    if (passed) {
+        tests_passed++;
+        printf(COLOR_GREEN "✓ PASS" COLOR_RESET " %s\n", test_name);
+    } else {
+        tests_failed++;
+        printf(COLOR_RED "✗ FAIL" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_summary(void) {
+    printf("\n" COLOR_CYAN "Test Summary:" COLOR_RESET "\n");
+    printf("Tests run: %d\n", tests_run);
+    printf(COLOR_GREEN "Tests passed: %d\n" COLOR_RESET, tests_passed);
+    if (tests_failed > 0) {
+        printf(COLOR_RED "Tests failed: %d\n" COLOR_RESET, tests_failed);
+    } else {
+        printf(COLOR_GREEN "All tests passed!\n" COLOR_RESET);
+    }
+}
+
+// Document text by id, handed back to the index when it verifies candidates
+#define MAX_TEST_DOCS 20000
+
+typedef struct {
+    char *parts[SEARCH_INDEX_MAX_PARTS];
+    int nparts;
+} TestDoc;
+
+static TestDoc test_docs[MAX_TEST_DOCS];
+
+static int get_test_text(void *ctx, int id, const char **parts) {
+    (void)ctx;
+    for (int p = 0; p < test_docs[id].nparts; p++) {
+        parts[p] = test_docs[id].parts[p];
+    }
+    return test_docs[id].nparts;
+}
+
+static void clear_test_docs(void) {
+    for (int i = 0; i < MAX_TEST_DOCS; i++) {
+        for (int p = 0; p < test_docs[i].nparts; p++) {
+            free(test_docs[i].parts[p]);
+        }
+        test_docs[i].nparts = 0;
+    }
+}
+
+static int add_parts(SearchIndex *index, int id, const char *const *parts, int nparts) {
+    for (int p = 0; p < test_docs[id].nparts; p++) {
+        free(test_docs[id].parts[p]);
+    }
+    for (int p = 0; p < nparts; p++) {
+        test_docs[id].parts[p] = strdup(parts[p]);
+    }
+    test_docs[id].nparts = nparts;
+    return search_index_add(index, id, parts, nparts);
+}
+
+static int add_text(SearchIndex *index, int id, const char *text) {
+    const char *parts[1] = {text};
+    return add_parts(index, id, parts, 1);
+}
+
+static int find(const SearchIndex *index, const char *query, SearchMatches *out) {
+    return search_index_find(index, query, get_test_text, NULL, out);
+}
+
+static int match_is(const SearchMatches *m, int i, int id, int offset, int len) {
+    return i < m->count && m->items[i].id == id && m->items[i].offset == offset &&
+           m->items[i].len == len;
+}
+
+static void test_basic_matches(void) {
+    SearchIndex index;
+    SearchMatches matches = {0};
+    search_index_init(&index);
+
+    const char *entry0[3] = {"[User]", " ", "Where is the Config file?"};
+    const char *entry1[3] = {"[Assistant]", " ", "config.json holds the CONFIG; see config/"};
+    int ok = add_parts(&index, 0, entry0, 3) == 0;
+    ok = ok && add_parts(&index, 1, entry1, 3) == 0;
+
+    // Offsets count across the parts: "[User] " is 7 bytes
+    ok = ok && find(&index, "config", &matches) == 4;
+    ok = ok && match_is(&matches, 0, 0, 20, 6);
+    ok = ok && match_is(&matches, 1, 1, 12, 6);
+    ok = ok && match_is(&matches, 2, 1, 34, 6);
+    ok = ok && match_is(&matches, 3, 1, 46, 6);
+
+    // A match may span the prefix and the separator
+    ok = ok && find(&index, "USER] wh", &matches) == 1 && match_is(&matches, 0, 0, 1, 8);
+
+    // Non-overlapping occurrences
+    ok = ok && add_text(&index, 2, "aaaaa") == 0;
+    ok = ok && find(&index, "aaa", &matches) == 1 && match_is(&matches, 0, 2, 0, 3);
+
+    search_matches_free(&matches);
+    search_index_free(&index);
+    clear_test_docs();
+    print_test_result("Matches are case-insensitive with offsets across parts", ok);
+}
+
+static void test_short_queries(void) {
+    SearchIndex index;
+    SearchMatches matches = {0};
+    search_index_init(&index);
+
+    int ok = add_text(&index, 0, "ab") == 0;
+    ok = ok && add_text(&index, 1, "x") == 0;
+    ok = ok && add_text(&index, 2, "") == 0;
+    ok = ok && add_text(&index, 3, "cab") == 0;
+
+    ok = ok && find(&index, "AB", &matches) == 2 &&
+         match_is(&matches, 0, 0, 0, 2) && match_is(&matches, 1, 3, 1, 2);
+    ok = ok && find(&index, "x", &matches) == 1 && match_is(&matches, 0, 1, 0, 1);
+    ok = ok && find(&index, "", &matches) == 0;
+
+    search_matches_free(&matches);
+    search_index_free(&index);
+    clear_test_docs();
+    print_test_result("Queries shorter than a trigram scan every document", ok);
+}
+
+static void test_no_match_and_reset(void) {
+    SearchIndex index;
+    SearchMatches matches = {0};
+    search_index_init(&index);
+
+    // "abd" and "bcd" are both present, but never together as "abcd"
+    int ok = add_text(&index, 0, "abd xyz") == 0;
+    ok = ok && add_text(&index, 1, "bcd abc") == 0;
+    ok = ok && find(&index, "abcd", &matches) == 0;
+    ok = ok && find(&index, "qqq", &matches) == 0;
+    ok = ok && find(&index, "abc", &matches) == 1;
+
+    search_index_reset(&index);
+    ok = ok && find(&index, "abc", &matches) == 0 && matches.count == 0;
+    ok = ok && add_text(&index, 0, "abc again") == 0;
+    ok = ok && find(&index, "ABC", &matches) == 1 && match_is(&matches, 0, 0, 0, 3);
+
+    search_matches_free(&matches);
+    search_index_free(&index);
+    clear_test_docs();
+    print_test_result("Missing patterns find nothing and reset empties the index", ok);
+}
+
+// Tiny deterministic PRNG so failures reproduce
+static unsigned int rng_state = 777;
+static unsigned int rng(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (rng_state >> 16) & 0x7fff;
+}
+
+// Reference: lowercase both sides and strstr every document
+static int scan_all(char docs[][64], int ndocs, const char *query, SearchMatches *out) {
+    char q[16];
+    int qlen = (int)strlen(query);
+    for (int i = 0; i <= qlen; i++) {
+        q[i] = (query[i] >= 'A' && query[i] <= 'Z') ? (char)(query[i] - 'A' + 'a') : query[i];
+    }
+    out->count = 0;
+    for (int d = 0; d < ndocs; d++) {
+        char lower[64];
+        for (int i = 0; i < 64; i++) {
+            lower[i] = (docs[d][i] >= 'A' && docs[d][i] <= 'Z') ? (char)(docs[d][i] - 'A' + 'a') : docs[d][i];
+        }
+        const char *p = lower;
+        while ((p = strstr(p, q)) != NULL) {
+            if (out->count < out->capacity) {
+                out->items[out->count].id = d * 2;
+                out->items[out->count].offset = (int)(p - lower);
+                out->items[out->count].len = qlen;
+            }
+            out->count++;
+            p += qlen;
+        }
+    }
+    return out->count;
+}
+
+static void test_random_against_scan(void) {
+    static const char alphabet[] = "abcAB ";
+    static char docs[400][64];
+    SearchIndex index;
+    SearchMatches got = {0};
+    SearchMatches want = {0};
+    want.capacity = 400 * 64;
+    want.items = malloc((size_t)want.capacity * sizeof(SearchMatch));
+    search_index_init(&index);
+
+    int ok = want.items != NULL;
+    int ndocs = 0;
+    for (int round = 0; round < 2000 && ok; round++) {
+        // Grow the index between queries, as the conversation would
+        if (ndocs < 400 && rng() % 3 == 0) {
+            int len = (int)(rng() % 40);
+            for (int i = 0; i < len; i++) {
+                docs[ndocs][i] = alphabet[rng() % 6];
+            }
+            docs[ndocs][len] = '\0';
+            ok = add_text(&index, ndocs * 2, docs[ndocs]) == 0;
+            ndocs++;
+        }
+
+        char query[8];
+        int qlen = 1 + (int)(rng() % 5);
+        for (int i = 0; i < qlen; i++) {
+            query[i] = alphabet[rng() % 6];
+        }
+        query[qlen] = '\0';
+
+        int n = find(&index, query, &got);
+        ok = ok && n == scan_all(docs, ndocs, query, &want) && n == got.count;
+        for (int i = 0; ok && i < n; i++) {
+            ok = match_is(&got, i, want.items[i].id, want.items[i].offset, want.items[i].len);
+        }
+    }
+
+    free(want.items);
+    search_matches_free(&got);
+    search_index_free(&index);
+    clear_test_docs();
+    print_test_result("Random documents and queries match a plain scan", ok);
+}
+
+static void test_many_entries(void) {
+    SearchIndex index;
+    SearchMatches matches = {0};
+    search_index_init(&index);
+
+    int ok = 1;
+    for (int i = 0; i < 20000 && ok; i++) {
+        char text[128];
+        snprintf(text, sizeof(text), "Tool output line %d: compiled module_%d.o without warnings%s",
+                 i, i % 97, i % 5000 == 1234 ? " (needle-in-haystack)" : "");
+        ok = add_text(&index, i, text) == 0;
+    }
+
+    ok = ok && find(&index, "Needle-In", &matches) == 4;
+    for (int k = 0; ok && k < 4; k++) {
+        ok = matches.items[k].id == 1234 + k * 5000;
+    }
+    ok = ok && find(&index, "module_42.o", &matches) == 206;
+    ok = ok && find(&index, "line 19999:", &matches) == 1 && matches.items[0].id == 19999;
+
+    search_matches_free(&matches);
+    search_index_free(&index);
+    clear_test_docs();
+    print_test_result("Thousands of entries are indexed and searched", ok);
+}
+
+static void test_large_repetitive_entry(void) {
+    SearchIndex index;
+    SearchMatches matches = {0};
+    search_index_init(&index);
+
+    // 8 MB of tool output with only a few dozen distinct trigrams
+    size_t len = 8u << 20;
+    char *text = malloc(len + 1);
+    const char *line = "ok 0123456789\n";
+    size_t line_len = strlen(line);
+    for (size_t i = 0; i < len; i++) {
+        text[i] = line[i % line_len];
+    }
+    text[len] = '\0';
+
+    int ok = add_text(&index, 0, text) == 0;
+    ok = ok && add_text(&index, 1, "a different entry") == 0;
+
+    // The table is sized by distinct trigrams, not by document length
+    ok = ok && index.slot_used < 64 && index.slot_count == 1024;
+    ok = ok && find(&index, "789\nok", &matches) > 0 && matches.items[0].id == 0;
+    ok = ok && find(&index, "different", &matches) == 1 && match_is(&matches, 0, 1, 2, 9);
+
+    free(text);
+    search_matches_free(&matches);
+    search_index_free(&index);
+    clear_test_docs();
+    print_test_result("A large repetitive entry does not grow the table", ok);
+}
+
+int main(void) {
+    printf(COLOR_CYAN "Running Search Index tests..." COLOR_RESET "\n\n");
+
+    test_basic_matches();
+    test_short_queries();
+    test_no_match_and_reset();
+    test_random_against_scan();
+    test_many_entries();
+    test_large_repetitive_entry();
+
+    print_summary();
+    return tests_failed > 0 ? 1 : 0;
+}
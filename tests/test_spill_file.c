@@ -0,0 +1,136 @@
+/*
+ * Unit Tests for the conversation spill file
+ *
+ * Tests the append-only spill file including:
+ * - Appending text and reading it back by offset
+ * - Growing past the mapping and remapping
+ * - Releasing mapped pages and reading them again
+ * - Resetting and reusing the file
+ *
+ * Compilation: make test-spill-file
+ * Usage: ./test_spill_file
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/spill_file.h"
+
+// Test framework colors
+#define COLOR_RESET "\033[0m"
+#define COLOR_GREEN "\033[32m"
+#define COLOR_RED "\033[31m"
+#define COLOR_CYAN "\033[36m"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void print_test_result(const char *test_name, int passed) {
+    tests_run++;
+    if (passed) {
+        tests_passed++;
+        printf(COLOR_GREEN "✓ PASS" COLOR_RESET " %s\n", test_name);
+    } else {
+        tests_failed++;
+        printf(COLOR_RED "✗ FAIL" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_summary(void) {
+    printf("\n" COLOR_CYAN "Test Summary:" COLOR_RESET "\n");
+    printf("Tests run: %d\n", tests_run);
+    printf(COLOR_GREEN "Tests passed: %d\n" COLOR_RESET, tests_passed);
+    if (tests_failed > 0) {
+        printf(COLOR_RED "Tests failed: %d\n" COLOR_RESET, tests_failed);
+    } else {
+        printf(COLOR_GREEN "All tests passed!\n" COLOR_RESET);
+    }
+}
+
+static void test_append_and_get(void) {
+    SpillFile spill;
+    size_t a = 1, b = 1, c = 1;
+    spill_file_init(&spill);
+
+    // Nothing can be stored before the file is opened
+    int ok = spill_file_append(&spill, "x", 1, &a) == -1;
+    ok = ok && spill_file_open(&spill, NULL) == 0 && spill.fd >= 0;
+    ok = ok && spill_file_append(&spill, "hello", 5, &a) == 0;
+    ok = ok && spill_file_append(&spill, "", 0, &b) == 0;
+    ok = ok && spill_file_append(&spill, "grep output\nline 2", 18, &c) == 0;
+    ok = ok && a == 0 && b == 6 && c == 7;
+    ok = ok && strcmp(spill_file_get(&spill, a), "hello") == 0;
+    ok = ok && strcmp(spill_file_get(&spill, b), "") == 0;
+    ok = ok && strcmp(spill_file_get(&spill, c), "grep output\nline 2") == 0;
+
+    // Offsets past the end read as empty text
+    ok = ok && strcmp(spill_file_get(&spill, spill.size + 10), "") == 0;
+    spill_file_close(&spill);
+    ok = ok && spill.fd == -1 && spill.map == NULL;
+    print_test_result("Appended text reads back by offset", ok);
+}
+
+static void test_growth(void) {
+    SpillFile spill;
+    spill_file_init(&spill);
+    spill.map_min = 4096;  // Force several remaps
+
+    int ok = spill_file_open(&spill, NULL) == 0;
+    size_t offsets[200];
+    char text[1024];
+    for (int i = 0; i < 200 && ok; i++) {
+        int n = snprintf(text, sizeof(text), "entry %d ", i);
+        memset(text + n, 'a' + i % 26, (size_t)(500 + i) - (size_t)n);
+        text[500 + i] = '\0';
+        ok = spill_file_append(&spill, text, strlen(text), &offsets[i]) == 0;
+    }
+    ok = ok && spill.map_size >= spill.size && spill.map_size > 4096;
+
+    // Every entry survives the remaps and a release of the mapped pages
+    for (int pass = 0; pass < 2 && ok; pass++) {
+        for (int i = 0; i < 200 && ok; i++) {
+            const char *got = spill_file_get(&spill, offsets[i]);
+            char want[32];
+            snprintf(want, sizeof(want), "entry %d ", i);
+            ok = strlen(got) == (size_t)(500 + i) && strncmp(got, want, strlen(want)) == 0 &&
+                 got[499 + i] == 'a' + i % 26;
+        }
+        spill_file_release(&spill);
+    }
+    spill_file_close(&spill);
+    print_test_result("Text survives remapping and released pages", ok);
+}
+
+static void test_reset(void) {
+    SpillFile spill;
+    size_t offset = 99;
+    spill_file_init(&spill);
+    int ok = spill_file_reset(&spill) == 0;  // Not open yet: nothing to do
+    ok = ok && spill_file_open(&spill, NULL) == 0;
+    ok = ok && spill_file_append(&spill, "first", 5, &offset) == 0;
+    ok = ok && spill_file_reset(&spill) == 0 && spill.size == 0;
+    ok = ok && strcmp(spill_file_get(&spill, 0), "") == 0;
+    ok = ok && spill_file_append(&spill, "second", 6, &offset) == 0 && offset == 0;
+    ok = ok && strcmp(spill_file_get(&spill, offset), "second") == 0;
+    spill_file_close(&spill);
+
+    // An unusable directory fails cleanly
+    spill_file_init(&spill);
+    ok = ok && spill_file_open(&spill, "/nonexistent-spill-dir") == -1 && spill.fd == -1;
+    print_test_result("Reset empties the file and it can be reused", ok);
+}
+
+int main(void) {
+    printf(COLOR_CYAN "Running Spill File tests..." COLOR_RESET "\n\n");
+
+    test_append_and_get();
+    test_growth();
+    test_reset();
+
+    print_summary();
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,275 @@
+/*
+ * Unit Tests for the tool registry
+ *
+ * Tests the name-indexed tool table including:
+ * - Built-in and MCP tools resolved by name
+ * - Names that are already taken
+ * - Dropping MCP tools while built-in ones stay
+ * - Entries kept in the order they were added
+ * - Many tools added one at a time
+ * - Definitions from get_tool_definitions() outliving the turn arena
+ *
+ * Compilation: make test-tool-registry
+ * Usage: ./test_tool_registry
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/tool_registry.h"
+#include "../src/claude_internal.h"
+#include "../src/arena.h"
+
+// Test framework colors
+#define COLOR_RESET "\033[0m"
+#define COLOR_GREEN "\033[32m"
+#define COLOR_RED "\033[31m"
+#define COLOR_CYAN "\033[36m"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void print_test_result(const char *test_name, int passed) {
+    tests_run++;
+    if (passed) {
+        tests_passed++;
+        printf(COLOR_GREEN "✓ PASS" COLOR_RESET " %s\n", test_name);
+    } else {
+        tests_failed++;
+        printf(COLOR_RED "✗ FAIL" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_summary(void) {
+    printf("\n" COLOR_CYAN "Test Summary:" COLOR_RESET "\n");
+    printf("Tests run: %d\n", tests_run);
+    printf(COLOR_GREEN "Tests passed: %d\n" COLOR_RESET, tests_passed);
+    if (tests_failed > 0) {
+        printf(COLOR_RED "Tests failed: %d\n" COLOR_RESET, tests_failed);
+    } else {
+        printf(COLOR_GREEN "All tests passed!\n" COLOR_RESET);
+    }
+}
+
+static cJSON* handler_a(cJSON *params, struct ConversationState *state) {
+    (void)params;
+    (void)state;
+    return NULL;
+}
+
+static cJSON* handler_b(cJSON *params, struct ConversationState *state) {
+    (void)params;
+    (void)state;
+    return NULL;
+}
+
+// Stand-ins for MCP servers; the registry only stores the pointers
+static char server_one;
+static char server_two;
+#define SERVER_ONE ((struct MCPServer *)(void *)&server_one)
+#define SERVER_TWO ((struct MCPServer *)(void *)&server_two)
+
+static cJSON* make_definition(const char *name) {
+    cJSON *definition = cJSON_CreateObject();
+    cJSON *func = cJSON_CreateObject();
+    cJSON_AddStringToObject(func, "name", name);
+    cJSON_AddItemToObject(definition, "function", func);
+    return definition;
+}
+
+static int definition_is(const ToolEntry *entry, const char *name) {
+    const cJSON *func = cJSON_GetObjectItem(entry->definition, "function");
+    const cJSON *def_name = cJSON_GetObjectItem(func, "name");
+    return cJSON_IsString(def_name) && strcmp(def_name->valuestring, name) == 0;
+}
+
+static void test_find_builtin_and_mcp(void) {
+    ToolRegistry registry;
+    tool_registry_init(&registry);
+
+    int ok = tool_registry_find(&registry, "Bash") == NULL;
+    ok = ok && tool_registry_add_builtin(&registry, "Bash", handler_a, 0, make_definition("Bash")) == 0;
+    ok = ok && tool_registry_add_builtin(&registry, "CallMcpTool", handler_b, 1, NULL) == 0;
+    ok = ok && tool_registry_add_mcp(&registry, "mcp_one_search", SERVER_ONE, "search",
+                                     make_definition("mcp_one_search")) == 0;
+    ok = ok && tool_registry_add_mcp(&registry, "mcp_two_search_repos", SERVER_TWO, "search_repos",
+                                     make_definition("mcp_two_search_repos")) == 0;
+
+    const ToolEntry *bash = tool_registry_find(&registry, "Bash");
+    ok = ok && bash && bash->kind == TOOL_KIND_BUILTIN && bash->handler == handler_a &&
+         !bash->needs_mcp && definition_is(bash, "Bash");
+
+    const ToolEntry *call = tool_registry_find(&registry, "CallMcpTool");
+    ok = ok && call && call->handler == handler_b && call->needs_mcp && !call->definition;
+
+    const ToolEntry *repos = tool_registry_find(&registry, "mcp_two_search_repos");
+    ok = ok && repos && repos->kind == TOOL_KIND_MCP && repos->server == SERVER_TWO &&
+         strcmp(repos->mcp_name, "search_repos") == 0 && definition_is(repos, "mcp_two_search_repos");
+
+    const ToolEntry *search = tool_registry_find(&registry, "mcp_one_search");
+    ok = ok && search && search->server == SERVER_ONE && strcmp(search->mcp_name, "search") == 0;
+
+    ok = ok && tool_registry_find(&registry, "bash") == NULL;
+    ok = ok && tool_registry_find(&registry, "mcp_one") == NULL;
+    ok = ok && registry.count == 4 && registry.builtin_count == 2;
+
+    tool_registry_free(&registry);
+    ok = ok && registry.count == 0 && tool_registry_find(&registry, "Bash") == NULL;
+    print_test_result("Built-in and MCP tools resolve by name", ok);
+}
+
+static void test_duplicates_rejected(void) {
+    ToolRegistry registry;
+    tool_registry_init(&registry);
+
+    int ok = tool_registry_add_builtin(&registry, "Read", handler_a, 0, make_definition("Read")) == 0;
+    ok = ok && tool_registry_add_builtin(&registry, "Read", handler_b, 0, make_definition("Read")) == -1;
+    ok = ok && tool_registry_add_mcp(&registry, "mcp_one_read", SERVER_ONE, "read", NULL) == 0;
+    ok = ok && tool_registry_add_mcp(&registry, "mcp_one_read", SERVER_TWO, "read", make_definition("x")) == -1;
+    ok = ok && tool_registry_add_mcp(&registry, "Read", SERVER_TWO, "Read", NULL) == -1;
+
+    // The first tool added under a name keeps it
+    const ToolEntry *read = tool_registry_find(&registry, "Read");
+    ok = ok && read && read->handler == handler_a;
+    const ToolEntry *mcp_read = tool_registry_find(&registry, "mcp_one_read");
+    ok = ok && mcp_read && mcp_read->server == SERVER_ONE;
+    ok = ok && registry.count == 2 && registry.builtin_count == 1;
+
+    tool_registry_free(&registry);
+    print_test_result("Names already taken are rejected", ok);
+}
+
+static void test_clear_mcp(void) {
+    ToolRegistry registry;
+    tool_registry_init(&registry);
+
+    int ok = tool_registry_add_builtin(&registry, "Sleep", handler_a, 0, make_definition("Sleep")) == 0;
+    ok = ok && tool_registry_add_builtin(&registry, "Glob", handler_b, 0, make_definition("Glob")) == 0;
+    ok = ok && tool_registry_add_mcp(&registry, "mcp_one_a", SERVER_ONE, "a", make_definition("mcp_one_a")) == 0;
+    ok = ok && tool_registry_add_mcp(&registry, "mcp_one_b", SERVER_ONE, "b", make_definition("mcp_one_b")) == 0;
+
+    // Built-in tools can only be added before MCP ones
+    ok = ok && tool_registry_add_builtin(&registry, "Late", handler_a, 0, make_definition("Late")) == -1;
+
+    tool_registry_clear_mcp(&registry);
+    ok = ok && registry.count == 2;
+    ok = ok && tool_registry_find(&registry, "mcp_one_a") == NULL;
+    ok = ok && tool_registry_find(&registry, "mcp_one_b") == NULL;
+    const ToolEntry *glob = tool_registry_find(&registry, "Glob");
+    ok = ok && glob && glob->handler == handler_b;
+
+    // A new set of MCP tools, possibly reusing old names
+    ok = ok && tool_registry_add_mcp(&registry, "mcp_one_b", SERVER_TWO, "b", make_definition("mcp_one_b")) == 0;
+    ok = ok && tool_registry_add_mcp(&registry, "mcp_two_c", SERVER_TWO, "c", make_definition("mcp_two_c")) == 0;
+    const ToolEntry *b = tool_registry_find(&registry, "mcp_one_b");
+    ok = ok && b && b->server == SERVER_TWO;
+
+    // Entries stay in the order they were added
+    ok = ok && registry.count == 4;
+    ok = ok && definition_is(&registry.entries[0], "Sleep") && definition_is(&registry.entries[1], "Glob");
+    ok = ok && definition_is(&registry.entries[2], "mcp_one_b") && definition_is(&registry.entries[3], "mcp_two_c");
+
+    tool_registry_clear_mcp(&registry);
+    tool_registry_clear_mcp(&registry);
+    ok = ok && registry.count == 2 && tool_registry_find(&registry, "Sleep") != NULL;
+
+    tool_registry_free(&registry);
+    print_test_result("Dropping MCP tools keeps the built-in ones", ok);
+}
+
+static void test_many_tools(void) {
+    ToolRegistry registry;
+    tool_registry_init(&registry);
+
+    enum { BUILTINS = 20, MCP_TOOLS = 5000 };
+    char name[64];
+    int ok = 1;
+    for (int i = 0; i < BUILTINS && ok; i++) {
+        snprintf(name, sizeof(name), "Builtin%d", i);
+        ok = tool_registry_add_builtin(&registry, name, (i % 2) ? handler_a : handler_b, 0,
+                                       make_definition(name)) == 0;
+    }
+    for (int round = 0; round < 2 && ok; round++) {
+        tool_registry_clear_mcp(&registry);
+        for (int i = 0; i < MCP_TOOLS && ok; i++) {
+            snprintf(name, sizeof(name), "mcp_srv%d_tool_%d", i % 7, i);
+            ok = tool_registry_add_mcp(&registry, name, (i % 2) ? SERVER_ONE : SERVER_TWO,
+                                       name + 9, make_definition(name)) == 0;
+        }
+    }
+    ok = ok && registry.count == BUILTINS + MCP_TOOLS;
+    ok = ok && registry.slot_count > 2 * registry.count;
+
+    for (int i = 0; i < BUILTINS && ok; i++) {
+        snprintf(name, sizeof(name), "Builtin%d", i);
+        const ToolEntry *entry = tool_registry_find(&registry, name);
+        ok = entry && entry == &registry.entries[i] && entry->handler == ((i % 2) ? handler_a : handler_b);
+    }
+    for (int i = 0; i < MCP_TOOLS && ok; i++) {
+        snprintf(name, sizeof(name), "mcp_srv%d_tool_%d", i % 7, i);
+        const ToolEntry *entry = tool_registry_find(&registry, name);
+        ok = entry && entry == &registry.entries[BUILTINS + i] &&
+             entry->server == ((i % 2) ? SERVER_ONE : SERVER_TWO) &&
+             strcmp(entry->mcp_name, name + 9) == 0;
+    }
+    snprintf(name, sizeof(name), "mcp_srv0_tool_%d", MCP_TOOLS);
+    ok = ok && tool_registry_find(&registry, name) == NULL;
+
+    tool_registry_free(&registry);
+    print_test_result("Thousands of tools resolve after the table grows", ok);
+}
+
+// The timeout property of the Bash definition in a get_tool_definitions() array
+static int bash_definition_has_timeout(cJSON *tool_defs) {
+    cJSON *def = NULL;
+    cJSON_ArrayForEach(def, tool_defs) {
+        cJSON *func = cJSON_GetObjectItem(def, "function");
+        cJSON *name = cJSON_GetObjectItem(func, "name");
+        if (cJSON_IsString(name) && strcmp(name->valuestring, "Bash") == 0) {
+            cJSON *params = cJSON_GetObjectItem(func, "parameters");
+            cJSON *props = cJSON_GetObjectItem(params, "properties");
+            return cJSON_GetObjectItem(props, "timeout") != NULL;
+        }
+    }
+    return 0;
+}
+
+static void test_definitions_outlive_turn(void) {
+    // Providers build each request inside the turn arena, which is reset at
+    // the end of the turn; the definitions kept for the whole process must
+    // not come from it
+    int ok = 1;
+    for (int turn = 0; turn < 2; turn++) {
+        Arena *prev = arena_cjson_push(arena_turn());
+        if (turn > 0) {
+            // Reuse the arena memory the first turn handed out
+            for (int i = 0; i < 2000; i++) {
+                cJSON_Delete(cJSON_CreateString("overwrite the previous turn's nodes"));
+            }
+        }
+        cJSON *tool_defs = get_tool_definitions(NULL, 0);
+        ok = ok && tool_defs && bash_definition_has_timeout(tool_defs);
+        cJSON_Delete(tool_defs);
+        arena_cjson_pop(prev);
+        arena_turn_reset();
+    }
+    print_test_result("Tool definitions outlive the turn arena", ok);
+}
+
+int main(void) {
+    printf(COLOR_CYAN "Running Tool Registry tests..." COLOR_RESET "\n\n");
+    arena_cjson_init();
+
+    test_find_builtin_and_mcp();
+    test_duplicates_rejected();
+    test_clear_mcp();
+    test_many_tools();
+    test_definitions_outlive_turn();
+
+    print_summary();
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * Unit Tests for Chrome trace-event export
+ *
+ * Tests the trace writer including:
+ * - No output when tracing is disabled
+ * - Output is a valid JSON array of trace events
+ * - Span fields (ph, ts, dur, args)
+ * - Escaping of span names
+ * - Distinct thread ids per thread
+ *
+ * Compilation: make test-trace
+ * Usage: ./test_trace
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <cjson/cJSON.h>
+
+#include "../src/trace.h"
+
+// Test framework colors
+#define COLOR_RESET "\033[0m"
+#define COLOR_GREEN "\033[32m"
+#define COLOR_RED "\033[31m"
+#define COLOR_CYAN "\033[36m"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void print_test_result(const char *test_name, int passed) {
+    tests_run++;
+    if (passed) {
+        tests_passed++;
+        printf(COLOR_GREEN "✓ PASS" COLOR_RESET " %s\n", test_name);
+    } else {
+        tests_failed++;
+        printf(COLOR_RED "✗ FAIL" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_summary(void) {
+    printf("\n" COLOR_CYAN "Test Summary:" COLOR_RESET "\n");
+    printf("Tests run: %d\n", tests_run);
+    printf(COLOR_GREEN "Tests passed: %d\n" COLOR_RESET, tests_passed);
+    if (tests_failed > 0) {
+        printf(COLOR_RED "Tests failed: %d\n" COLOR_RESET, tests_failed);
+    } else {
+        printf(COLOR_GREEN "All tests passed!\n" COLOR_RESET);
+    }
+}
+
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc((size_t)size + 1);
+    if (buf) {
+        size_t n = fread(buf, 1, (size_t)size, f);
+        buf[n] = '\0';
+    }
+    fclose(f);
+    return buf;
+}
+
+static cJSON *find_event(cJSON *events, const char *name) {
+    cJSON *ev = NULL;
+    cJSON_ArrayForEach(ev, events) {
+        cJSON *n = cJSON_GetObjectItem(ev, "name");
+        if (cJSON_IsString(n) && strcmp(n->valuestring, name) == 0) {
+            return ev;
+        }
+    }
+    return NULL;
+}
+
+static void *worker_span(void *arg) {
+    (void)arg;
+    TraceSpan span;
+    trace_span_begin(&span, "worker", "test");
+    trace_span_end(&span, NULL);
+    return NULL;
+}
+
+// Test cases
+
+static void test_disabled_is_noop(void) {
+    TraceSpan span;
+    trace_span_begin(&span, "ignored", "test");
+    trace_span_end(&span, "\"x\":%d", 1);
+    trace_complete("ignored", "test", 0, 10, NULL);
+    print_test_result("Disabled tracing records nothing", !trace_enabled() && span.start_us < 0);
+}
+
+static void test_trace_file(void) {
+    char path[] = "/tmp/test_trace_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        print_test_result("Create temporary trace file", 0);
+        return;
+    }
+    close(fd);
+
+    print_test_result("trace_init opens file", trace_init(path) == 0 && trace_enabled());
+
+    TraceSpan span;
+    trace_span_begin(&span, "build_request", "api");
+    usleep(2000);
+    trace_span_end(&span, "\"messages\":%d", 42);
+
+    trace_complete("quote\"name\\", "test", 5, 7, NULL);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, worker_span, NULL);
+    pthread_join(thread, NULL);
+
+    trace_shutdown();
+    print_test_result("trace_shutdown disables tracing", !trace_enabled());
+
+    char *content = read_file(path);
+    cJSON *events = content ? cJSON_Parse(content) : NULL;
+    print_test_result("Trace file is a valid JSON array", cJSON_IsArray(events));
+
+    cJSON *build = find_event(events, "build_request");
+    int build_ok = build != NULL;
+    if (build_ok) {
+        cJSON *ph = cJSON_GetObjectItem(build, "ph");
+        cJSON *dur = cJSON_GetObjectItem(build, "dur");
+        cJSON *args = cJSON_GetObjectItem(build, "args");
+        cJSON *messages = args ? cJSON_GetObjectItem(args, "messages") : NULL;
+        build_ok = cJSON_IsString(ph) && strcmp(ph->valuestring, "X") == 0 &&
+                   cJSON_IsNumber(dur) && dur->valuedouble >= 1000 &&
+                   cJSON_IsNumber(messages) && messages->valueint == 42;
+    }
+    print_test_result("Span has complete-event fields and args", build_ok);
+
+    cJSON *quoted = find_event(events, "quote\"name\\");
+    int quoted_ok = quoted != NULL;
+    if (quoted_ok) {
+        cJSON *ts = cJSON_GetObjectItem(quoted, "ts");
+        cJSON *dur = cJSON_GetObjectItem(quoted, "dur");
+        quoted_ok = cJSON_IsNumber(ts) && ts->valueint == 5 &&
+                    cJSON_IsNumber(dur) && dur->valueint == 7;
+    }
+    print_test_result("Names are JSON-escaped", quoted_ok);
+
+    cJSON *worker = find_event(events, "worker");
+    int tid_ok = worker && build &&
+                 cJSON_GetObjectItem(worker, "tid")->valueint !=
+                 cJSON_GetObjectItem(build, "tid")->valueint;
+    print_test_result("Threads get distinct tids", tid_ok);
+
+    cJSON_Delete(events);
+    free(content);
+    unlink(path);
+}
+
+int main(void) {
+    printf(COLOR_CYAN "Running Trace Export Tests\n" COLOR_RESET);
+    printf("==========================\n\n");
+
+    test_disabled_is_noop();
+    test_trace_file();
+
+    print_summary();
+    return tests_failed > 0 ? 1 : 0;
+}
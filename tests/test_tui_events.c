@@ -0,0 +1,187 @@
+/*
+ * Unit Tests for the TUI event sources
+ *
+ * Tests the event set the TUI main loop blocks on, including:
+ * - Timing out with nothing ready (idle loop does not spin)
+ * - Terminal input readiness (left unread for the caller)
+ * - Message queue wakeups on a lane's empty -> non-empty transition
+ * - SIGWINCH delivery as a resize event
+ * - Periodic timer arming and disarming
+ *
+ * Compilation: make test-tui-events
+ * Usage: ./test_tui_events
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../src/tui_events.h"
+#include "../src/message_queue.h"
+
+// Test framework colors
+#define COLOR_RESET "\033[0m"
+#define COLOR_GREEN "\033[32m"
+#define COLOR_RED "\033[31m"
+#define COLOR_CYAN "\033[36m"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void print_test_result(const char *test_name, int passed) {
+    tests_run++;
+    if (passed) {
+        tests_passed++;
+        printf(COLOR_GREEN "✓ PASS" COLOR_RESET " %s\n", test_name);
+    } else {
+        tests_failed++;
+        printf(COLOR_RED "✗ FAIL" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_summary(void) {
+    printf("\n" COLOR_CYAN "Test Summary:" COLOR_RESET "\n");
+    printf("Tests run: %d\n", tests_run);
+    printf(COLOR_GREEN "Tests passed: %d\n" COLOR_RESET, tests_passed);
+    if (tests_failed > 0) {
+        printf(COLOR_RED "Tests failed: %d\n" COLOR_RESET, tests_failed);
+    } else {
+        printf(COLOR_GREEN "All tests passed!\n" COLOR_RESET);
+    }
+}
+
+static long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+static void handle_winch(int sig) {
+    (void)sig;
+    tui_events_notify_resize();
+}
+
+static void test_idle_timeout(void) {
+    TUIEvents events;
+    int ok = tui_events_init(&events, -1, -1) == 0;
+    long start = now_ms();
+    ok = ok && tui_events_wait(&events, 50) == 0;
+    ok = ok && now_ms() - start >= 45;
+    tui_events_free(&events);
+    print_test_result("Waiting with nothing ready sleeps until the timeout", ok);
+}
+
+static void test_input_ready(void) {
+    int fds[2];
+    int ok = pipe(fds) == 0;
+    TUIEvents events;
+    ok = ok && tui_events_init(&events, fds[0], -1) == 0;
+    ok = ok && write(fds[1], "k", 1) == 1;
+    ok = ok && tui_events_wait(&events, 1000) == TUI_EVENT_INPUT;
+
+    // Input is left for the caller, so it is still ready
+    ok = ok && tui_events_wait(&events, 0) == TUI_EVENT_INPUT;
+    char c = 0;
+    ok = ok && read(fds[0], &c, 1) == 1 && c == 'k';
+    ok = ok && tui_events_wait(&events, 0) == 0;
+
+    tui_events_free(&events);
+    close(fds[0]);
+    close(fds[1]);
+    print_test_result("Terminal input is reported but not consumed", ok);
+}
+
+static void test_queue_wakeup(void) {
+    TUIMessageQueue queue;
+    TUIEvents events;
+    TUIMessage msg;
+    int ok = tui_msg_queue_init(&queue, 8) == 0;
+    ok = ok && tui_msg_queue_wakeup_fd(&queue) >= 0;
+    ok = ok && tui_events_init(&events, -1, tui_msg_queue_wakeup_fd(&queue)) == 0;
+
+    ok = ok && tui_events_wait(&events, 0) == 0;
+    post_tui_message(&queue, TUI_MSG_ADD_LINE, "one");
+    post_tui_message(&queue, TUI_MSG_ADD_LINE, "two");
+    ok = ok && tui_events_wait(&events, 1000) == TUI_EVENT_MESSAGE;
+
+    // Consumed by the wait; more posts into a non-empty lane stay quiet
+    ok = ok && tui_events_wait(&events, 0) == 0;
+    post_tui_message(&queue, TUI_MSG_ADD_LINE, "three");
+    ok = ok && tui_events_wait(&events, 0) == 0;
+
+    // The urgent lane was empty, so it signals on its own
+    post_token_update(&queue, 1, 2, 3);
+    ok = ok && tui_events_wait(&events, 1000) == TUI_EVENT_MESSAGE;
+
+    while (poll_tui_message(&queue, &msg) == 1) {
+        tui_message_release(&msg);
+    }
+    post_tui_message(&queue, TUI_MSG_STATUS, "again");
+    ok = ok && tui_events_wait(&events, 1000) == TUI_EVENT_MESSAGE;
+
+    // Shutdown wakes the reader too
+    while (poll_tui_message(&queue, &msg) == 1) {
+        tui_message_release(&msg);
+    }
+    tui_msg_queue_shutdown(&queue);
+    ok = ok && tui_events_wait(&events, 1000) == TUI_EVENT_MESSAGE;
+
+    tui_events_free(&events);
+    tui_msg_queue_free(&queue);
+    print_test_result("Queue wakeup fires on empty -> non-empty and on shutdown", ok);
+}
+
+static void test_resize_signal(void) {
+    TUIEvents events;
+    signal(SIGWINCH, handle_winch);
+    tui_events_capture_resize();
+    int ok = tui_events_init(&events, -1, -1) == 0 && events.resize_fd >= 0;
+
+    ok = ok && raise(SIGWINCH) == 0;
+    ok = ok && tui_events_wait(&events, 1000) == TUI_EVENT_RESIZE;
+    ok = ok && tui_events_wait(&events, 0) == 0;
+
+    tui_events_free(&events);
+    print_test_result("SIGWINCH is delivered as a resize event", ok);
+}
+
+static void test_timer(void) {
+    TUIEvents events;
+    int ok = tui_events_init(&events, -1, -1) == 0;
+
+    tui_events_set_timer(&events, 20ULL * 1000000ULL);
+    int ticks = 0;
+    long start = now_ms();
+    while (ticks < 3 && now_ms() - start < 2000) {
+        if (tui_events_wait(&events, 1000) & TUI_EVENT_TIMER) {
+            ticks++;
+        }
+    }
+    long elapsed = now_ms() - start;
+    ok = ok && ticks == 3 && elapsed >= 55 && elapsed < 1000;
+
+    tui_events_set_timer(&events, 0);
+    ok = ok && tui_events_wait(&events, 60) == 0;
+
+    tui_events_free(&events);
+    print_test_result("Periodic timer ticks while armed and stops when disarmed", ok);
+}
+
+int main(void) {
+    printf(COLOR_CYAN "Running TUI Event Source tests..." COLOR_RESET "\n\n");
+
+    test_idle_timeout();
+    test_input_ready();
+    test_queue_wakeup();
+    test_resize_signal();
+    test_timer();
+
+    print_summary();
+    return tests_failed > 0 ? 1 : 0;
+}
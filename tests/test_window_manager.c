@@ -1,9 +1,29 @@
 #include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <ncurses.h>
 #include "../src/window_manager.h"
 
-static void test_pad_capacity_growth(void) {
+// Renderer that writes each content line's number into the pad and records
+// how many lines it has been asked to draw
+static int g_rendered_lines = 0;
+
+static void number_renderer(void *ctx, WINDOW *pad, int first_line, int pad_row, int count) {
+    (void)ctx;
+    for (int i = 0; i < count; i++) {
+        mvwprintw(pad, pad_row + i, 0, "%d", first_line + i);
+    }
+    g_rendered_lines += count;
+}
+
+// Read back the number drawn at the top of the viewport
+static int viewport_top_number(WindowManager *wm) {
+    char buf[32] = {0};
+    mvwinnstr(wm->conv_pad, wm->conv_scroll_offset - wm->conv_pad_first_line, 0, buf, 16);
+    return atoi(buf);
+}
+
+static void test_virtual_viewport(void) {
     WindowManager wm = {0};
 
     // Initialize curses and WM
@@ -15,14 +35,83 @@ static void test_pad_capacity_growth(void) {
     assert(rc == 0);
     assert(wm.is_initialized);
     assert(wm.conv_pad != NULL);
+    window_manager_set_conversation_renderer(&wm, number_renderer, NULL);
+
+    // Pad is sized to the viewport, not the content
+    int pad_rows = wm.conv_pad_capacity;
+    assert(pad_rows == wm.conv_viewport_height + 2 * wm.config.render_margin);
+
+    window_manager_set_content_lines(&wm, 100000);
+    window_manager_scroll_to_bottom(&wm);
+    assert(wm.conv_pad_capacity == pad_rows);
+    assert(g_rendered_lines <= pad_rows);
+    assert(viewport_top_number(&wm) == window_manager_get_max_scroll(&wm));
+
+    // Scrolling inside the margin only moves the viewport
+    int before = g_rendered_lines;
+    window_manager_scroll(&wm, -1);
+    assert(g_rendered_lines == before);
+    assert(viewport_top_number(&wm) == window_manager_get_max_scroll(&wm) - 1);
+
+    // Jumping far away redraws only around the new viewport
+    before = g_rendered_lines;
+    window_manager_scroll_to_top(&wm);
+    assert(g_rendered_lines - before <= pad_rows);
+    assert(wm.conv_pad_first_line == 0);
+    assert(viewport_top_number(&wm) == 0);
+
+    // Appending while the pad covers the end draws just the new lines
+    window_manager_set_content_lines(&wm, 0);
+    window_manager_refresh_conversation(&wm);
+    before = g_rendered_lines;
+    window_manager_set_content_lines(&wm, 3);
+    assert(g_rendered_lines - before == 3);
 
-    int initial_cap = wm.conv_pad_capacity;
-    int request = initial_cap * 2 + 123;
+    window_manager_destroy(&wm);
+    endwin();
+}
 
-    rc = window_manager_ensure_pad_capacity(&wm, request);
+// Layout hook that grows the content once, like a stale entry being wrapped
+static int layout_calls = 0;
+static int layout_first = -1;
+static int layout_last = -1;
+static int grow_layout(void *ctx, int first_line, int last_line) {
+    WindowManager *wm = (WindowManager *)ctx;
+    layout_calls++;
+    layout_first = first_line;
+    layout_last = last_line;
+    if (layout_calls > 1) {
+        return 0;
+    }
+    window_manager_set_content_lines(wm, window_manager_get_content_lines(wm) + 50);
+    return 1;
+}
+
+static void test_layout_hook(void) {
+    initscr();
+    cbreak();
+    noecho();
+    keypad(stdscr, TRUE);
+
+    WindowManager wm = {0};
+    int rc = window_manager_init(&wm, NULL);
     assert(rc == 0);
-    assert(wm.conv_pad_capacity >= request);
-    assert(wm.conv_pad != NULL);
+
+    window_manager_set_conversation_renderer(&wm, number_renderer, &wm);
+    window_manager_set_conversation_layout(&wm, grow_layout);
+    window_manager_set_content_lines(&wm, 100);
+    wm.conv_scroll_offset = 40;
+    window_manager_refresh_conversation(&wm);
+
+    // Asked about the lines it is about to draw, then again after the change
+    assert(layout_calls == 2);
+    assert(layout_first <= 40 && layout_last > 40 + wm.conv_viewport_height);
+    assert(window_manager_get_content_lines(&wm) == 150);
+    assert(wm.conv_pad_valid);
+
+    // Nothing stale: the hook is not consulted while the pad covers the view
+    window_manager_refresh_conversation(&wm);
+    assert(layout_calls == 2);
 
     window_manager_destroy(&wm);
     endwin();
@@ -69,8 +158,10 @@ static void test_input_resize_affects_layout(void) {
 }
 
 int main(void) {
-    printf("[WM TEST] pad capacity growth...\n");
-    test_pad_capacity_growth();
+    printf("[WM TEST] virtual viewport...\n");
+    test_virtual_viewport();
+    printf("[WM TEST] layout hook...\n");
+    test_layout_hook();
     printf("[WM TEST] input resize affects layout...\n");
     test_input_resize_affects_layout();
     printf("[WM TEST] all tests passed.\n");
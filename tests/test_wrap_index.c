@@ -0,0 +1,265 @@
+/*
+ * Unit Tests for the conversation line-wrap index
+ *
+ * Tests the wrap index including:
+ * - Row counts for ASCII, newlines, tabs and control characters
+ * - Wide (East Asian) and combining characters
+ * - Malformed UTF-8
+ * - Multi-part text (prefix + separator + body)
+ * - LRU cache of layouts for recent widths
+ * - Drawing from a checkpoint matches drawing from the start
+ *
+ * Compilation: make test-wrap-index
+ * Usage: ./test_wrap_index
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+
+#include "../src/wrap_index.h"
+
+// Test framework colors
+#define COLOR_RESET "\033[0m"
+#define COLOR_GREEN "\033[32m"
+#define COLOR_RED "\033[31m"
+#define COLOR_CYAN "\033[36m"
+
+// Test counters
+static int tests_run = 0;
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+static void print_test_result(const char *test_name, int passed) {
+    tests_run++;
+    if (passed) {
+        tests_passed++;
+        printf(COLOR_GREEN "✓ PASS" COLOR_RESET " %s\n", test_name);
+    } else {
+        tests_failed++;
+        printf(COLOR_RED "✗ FAIL" COLOR_RESET " %s\n", test_name);
+    }
+}
+
+static void print_summary(void) {
+    printf("\n" COLOR_CYAN "Test Summary:" COLOR_RESET "\n");
+    printf("Tests run: %d\n", tests_run);
+    printf(COLOR_GREEN "Tests passed: %d\n" COLOR_RESET, tests_passed);
+    if (tests_failed > 0) {
+        printf(COLOR_RED "Tests failed: %d\n" COLOR_RESET, tests_failed);
+    } else {
+        printf(COLOR_GREEN "All tests passed!\n" COLOR_RESET);
+    }
+}
+
+static WrapText single(const char *s) {
+    WrapText text;
+    memset(&text, 0, sizeof(text));
+    text.parts[0] = s;
+    text.nparts = 1;
+    return text;
+}
+
+static int rows_of(const char *s, int width) {
+    WrapIndex index;
+    memset(&index, 0, sizeof(index));
+    WrapText text = single(s);
+    int rows = wrap_index_rows(&index, &text, width);
+    wrap_index_free(&index);
+    return rows;
+}
+
+// Records drawn glyphs as "row:col:part:cells:bytes;" for comparison
+typedef struct {
+    char buf[65536];
+    size_t len;
+    char offsets[1024];         // Source offset of each glyph kept, "n,"
+    size_t offsets_len;
+    int min_row;                // Only rows in [min_row, max_row) are kept
+    int max_row;
+} Capture;
+
+static void capture_glyph(void *ctx, int part, int offset, int row, int col,
+                          const char *bytes, int len, int cells) {
+    Capture *cap = ctx;
+    char glyph[16] = "";
+    if (cap->max_row > 0 && (row < cap->min_row || row >= cap->max_row)) {
+        return;
+    }
+    if (bytes) {
+        memcpy(glyph, bytes, (size_t)len);
+        glyph[len] = '\0';
+    }
+    int n = snprintf(cap->buf + cap->len, sizeof(cap->buf) - cap->len,
+                     "%d:%d:%d:%d:%s;", row, col, part, cells, glyph);
+    if (n > 0 && (size_t)n < sizeof(cap->buf) - cap->len) {
+        cap->len += (size_t)n;
+    }
+    n = snprintf(cap->offsets + cap->offsets_len, sizeof(cap->offsets) - cap->offsets_len,
+                 "%d,", offset);
+    if (n > 0 && (size_t)n < sizeof(cap->offsets) - cap->offsets_len) {
+        cap->offsets_len += (size_t)n;
+    }
+}
+
+static void test_ascii_rows(void) {
+    int ok = rows_of("abcdefghij", 4) == 3 &&
+             rows_of("abcd", 4) == 1 &&      // Exactly full: no blank row
+             rows_of("abcde", 4) == 2 &&
+             rows_of("", 10) == 1 &&
+             rows_of("a\nb\n", 10) == 3 &&
+             rows_of("line\r\nnext", 10) == 2;
+    print_test_result("ASCII text, newlines and CRLF wrap to the right row count", ok);
+}
+
+static void test_tabs_and_controls(void) {
+    Capture cap;
+    memset(&cap, 0, sizeof(cap));
+    WrapIndex index;
+    memset(&index, 0, sizeof(index));
+    WrapText text = single("\tX\x01");
+    wrap_index_draw(&index, &text, 20, 0, 10, capture_glyph, &cap);
+    int ok = strcmp(cap.buf, "0:0:0:8:;0:8:0:1:X;0:9:0:2:^A;") == 0;
+    ok = ok && strcmp(cap.offsets, "0,1,2,") == 0;  // ^A is drawn from a copy
+    wrap_index_free(&index);
+
+    ok = ok && rows_of("abcdef\tX", 8) == 2;
+    print_test_result("Tabs stop every 8 cells and controls show as ^X", ok);
+}
+
+static void test_wide_and_combining(void) {
+    int ok = wrap_codepoint_width('a') == 1 &&
+             wrap_codepoint_width(0x6F22) == 2 &&     // 漢
+             wrap_codepoint_width(0xFF21) == 2 &&     // Fullwidth A
+             wrap_codepoint_width(0x0301) == 0 &&     // Combining acute
+             wrap_codepoint_width(0x07) == -1;
+
+    // Three wide characters: a wide glyph never straddles the edge
+    ok = ok && rows_of("漢字漢", 6) == 1 &&
+         rows_of("漢字漢", 5) == 2 &&
+         rows_of("漢字漢", 3) == 3 &&
+         rows_of("e\xcc\x81" "e\xcc\x81", 2) == 1;   // Combining marks take no cells
+    print_test_result("Wide characters take two cells, combining marks none", ok);
+}
+
+static void test_malformed_utf8(void) {
+    Capture cap;
+    memset(&cap, 0, sizeof(cap));
+    WrapIndex index;
+    memset(&index, 0, sizeof(index));
+    WrapText text = single("a\xff\xe6\xbcz");
+    wrap_index_draw(&index, &text, 10, 0, 1, capture_glyph, &cap);
+    int ok = strcmp(cap.buf, "0:0:0:1:a;0:1:0:1:?;0:2:0:1:?;0:3:0:1:?;0:4:0:1:z;") == 0;
+    ok = ok && strcmp(cap.offsets, "0,1,2,3,4,") == 0;
+    wrap_index_free(&index);
+    print_test_result("Malformed UTF-8 bytes are shown as one-cell '?'", ok);
+}
+
+static void test_parts(void) {
+    Capture cap;
+    memset(&cap, 0, sizeof(cap));
+    WrapIndex index;
+    memset(&index, 0, sizeof(index));
+    WrapText text;
+    memset(&text, 0, sizeof(text));
+    text.parts[0] = "[U]";
+    text.parts[1] = " ";
+    text.parts[2] = "hi";
+    text.nparts = 3;
+
+    int ok = wrap_index_rows(&index, &text, 5) == 2;
+    wrap_index_draw(&index, &text, 5, 1, 1, capture_glyph, &cap);
+    ok = ok && strcmp(cap.buf, "1:0:2:1:i;") == 0 && strcmp(cap.offsets, "1,") == 0;
+    wrap_index_free(&index);
+    print_test_result("Parts are laid out as one stream and reported per glyph", ok);
+}
+
+static int has_width(const WrapIndex *index, int width) {
+    for (int i = 0; i < WRAP_INDEX_WIDTHS; i++) {
+        if (index->slots[i].width == width) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void test_lru_cache(void) {
+    WrapIndex index;
+    memset(&index, 0, sizeof(index));
+    WrapText text = single("the quick brown fox jumps over the lazy dog");
+
+    int ok = 1;
+    for (int w = 10; w < 10 + WRAP_INDEX_WIDTHS; w++) {
+        ok = ok && wrap_index_rows(&index, &text, w) > 1;
+    }
+    // Touch width 10 so width 11 becomes least recently used
+    ok = ok && wrap_index_rows(&index, &text, 10) == 5;
+    wrap_index_rows(&index, &text, 80);
+
+    ok = ok && has_width(&index, 10) && !has_width(&index, 11) && has_width(&index, 80);
+    ok = ok && wrap_index_cached_rows(&index, 10) == 5 && wrap_index_cached_rows(&index, 11) == -1;
+    wrap_index_free(&index);
+    print_test_result("Layouts are cached for the most recently used widths", ok);
+}
+
+static void test_checkpoint_draw(void) {
+    // Long mixed text spanning many checkpoints
+    size_t cap_size = 64 * 1024;
+    char *s = malloc(cap_size);
+    size_t len = 0;
+    for (int i = 0; i < 400 && len + 64 < cap_size; i++) {
+        len += (size_t)snprintf(s + len, cap_size - len, "%d\t漢字 row text %s", i,
+                                i % 3 == 0 ? "\n" : "");
+    }
+
+    WrapIndex index;
+    memset(&index, 0, sizeof(index));
+    WrapText text = single(s);
+    int width = 23;
+    int rows = wrap_index_rows(&index, &text, width);
+    int ok = rows > 4 * WRAP_INDEX_CHECKPOINT;
+
+    Capture *full = calloc(1, sizeof(Capture));
+    Capture *part = calloc(1, sizeof(Capture));
+    for (int first = 0; ok && first < rows; first += 7) {
+        memset(full, 0, sizeof(Capture));
+        memset(part, 0, sizeof(Capture));
+
+        // Reference: walk everything, keep only the requested rows
+        full->min_row = first;
+        full->max_row = first + 5;
+        WrapIndex fresh;
+        memset(&fresh, 0, sizeof(fresh));
+        wrap_index_draw(&fresh, &text, width, 0, rows, capture_glyph, full);
+        wrap_index_free(&fresh);
+
+        wrap_index_draw(&index, &text, width, first, 5, capture_glyph, part);
+
+        ok = part->len > 0 && strcmp(full->buf, part->buf) == 0;
+    }
+
+    free(full);
+    free(part);
+    wrap_index_free(&index);
+    free(s);
+    print_test_result("Drawing from a checkpoint matches drawing from the start", ok);
+}
+
+int main(void) {
+    setlocale(LC_CTYPE, "C.UTF-8");
+
+    printf(COLOR_CYAN "Running Wrap Index tests..." COLOR_RESET "\n\n");
+
+    test_ascii_rows();
+    test_tabs_and_controls();
+    test_wide_and_combining();
+    test_malformed_utf8();
+    test_parts();
+    test_lru_cache();
+    test_checkpoint_draw();
+
+    print_summary();
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -21,7 +21,7 @@
 // External functions from claude.c (exposed via TEST_BUILD)
 extern int write_file(const char *path, const char *content);
 extern char* read_file(const char *path);
-extern int show_diff(const char *file_path, const char *original_content);
+extern int show_diff(const char *file_path, const char *original_content, const char *new_content);
 extern cJSON* tool_write(cJSON *params, ConversationState *state);
 
 